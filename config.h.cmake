@@ -5,4 +5,6 @@
 #cmakedefine DLL_UDUNITS2
 #cmakedefine DLL_EXPORT
 #cmakedefine HAVE_UNISTD_H 
-#cmakedefine YY_NO_UNISTD_H 
\ No newline at end of file
+#cmakedefine YY_NO_UNISTD_H 
+#define UT_THREAD_LOCAL @UT_THREAD_LOCAL@
+#cmakedefine UT_NO_ERROR_MESSAGES
@@ -0,0 +1,252 @@
+/*
+ * benchLookup.c — micro-benchmark for identifier lookups in a unit-system.
+ *
+ * Collects every unit name and symbol that the XML unit database defines and
+ * times ut_get_unit_by_name(), ut_lookup_unit_by_name(),
+ * ut_get_unit_by_symbol(), ut_get_name() and ut_get_symbol() over them.  Names
+ * are also looked up in upper case to exercise the case-insensitive path.  Build it against two versions of the
+ * library to compare their lookup speed:
+ *
+ *   cmake -DUDUNITS_BENCHMARKS=ON ... && make benchLookup
+ *   ./benchLookup udunits2.xml [rounds]
+ *
+ * The program is not a test: it exits 0 whenever the database can be read.
+ */
+
+#include <ctype.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "udunits2.h"
+
+#define MAX_IDS 8192
+
+typedef struct {
+    char*   names[MAX_IDS];
+    size_t  nameCount;
+    char*   symbols[MAX_IDS];
+    size_t  symbolCount;
+} Ids;
+
+static int
+silent_handler(const char* fmt, va_list args)
+{
+    (void)fmt;
+    (void)args;
+    return 0;
+}
+
+static char*
+read_file(const char* path)
+{
+    FILE*   file = fopen(path, "rb");
+    char*   buf = NULL;
+    long    size;
+
+    if (file != NULL) {
+        if (fseek(file, 0, SEEK_END) == 0 && (size = ftell(file)) >= 0 &&
+                fseek(file, 0, SEEK_SET) == 0) {
+            buf = malloc((size_t)size + 1);
+            if (buf != NULL) {
+                size_t n = fread(buf, 1, (size_t)size, file);
+                buf[n] = 0;
+            }
+        }
+        (void)fclose(file);
+    }
+
+    return buf;
+}
+
+/*
+ * Appends the content of every "<tag>content</tag>" element in "text" that
+ * contains no character reference to "ids".
+ */
+static void
+collect(const char* text, const char* tag, char** ids, size_t* count)
+{
+    char        open[32];
+    char        close[32];
+    const char* cp = text;
+
+    (void)snprintf(open, sizeof(open), "<%s>", tag);
+    (void)snprintf(close, sizeof(close), "</%s>", tag);
+
+    while ((cp = strstr(cp, open)) != NULL && *count < MAX_IDS) {
+        const char* start = cp + strlen(open);
+        const char* end = strstr(start, close);
+
+        if (end == NULL)
+            break;
+        if (memchr(start, '&', (size_t)(end - start)) == NULL &&
+                end > start) {
+            char* id = malloc((size_t)(end - start) + 1);
+            if (id != NULL) {
+                memcpy(id, start, (size_t)(end - start));
+                id[end - start] = 0;
+                ids[(*count)++] = id;
+            }
+        }
+        cp = end;
+    }
+}
+
+/*
+ * Collects identifiers from a database file and the files it imports.
+ */
+static void
+collect_file(const char* path, Ids* ids)
+{
+    char*       text = read_file(path);
+    const char* cp;
+
+    if (text == NULL)
+        return;
+
+    collect(text, "singular", ids->names, &ids->nameCount);
+    collect(text, "plural", ids->names, &ids->nameCount);
+    collect(text, "symbol", ids->symbols, &ids->symbolCount);
+
+    for (cp = text; (cp = strstr(cp, "<import>")) != NULL; ) {
+        const char* start = cp + strlen("<import>");
+        const char* end = strstr(start, "</import>");
+        const char* slash = strrchr(path, '/');
+        char        imported[4096];
+
+        if (end == NULL)
+            break;
+        (void)snprintf(imported, sizeof(imported), "%.*s%.*s",
+            slash == NULL || *start == '/' ? 0 : (int)(slash - path + 1), path,
+            (int)(end - start), start);
+        collect_file(imported, ids);
+        cp = end;
+    }
+
+    free(text);
+}
+
+static double
+seconds(clock_t start)
+{
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+static void
+report(const char* what, size_t lookups, size_t hits, double secs)
+{
+    (void)printf("%-28s %10lu lookups %10lu hits %8.1f ns/lookup\n", what,
+        (unsigned long)lookups, (unsigned long)hits,
+        lookups == 0 ? 0.0 : 1e9 * secs / lookups);
+}
+
+int
+main(int argc, char** argv)
+{
+    const char* xmlPath = (argc > 1) ? argv[1] : getenv("UDUNITS2_XML_PATH");
+    int         rounds = (argc > 2) ? atoi(argv[2]) : 200;
+    ut_system*  system;
+    ut_unit**   units;
+    char**      upper;
+    Ids*        ids = calloc(1, sizeof(Ids));
+    size_t      i;
+    size_t      hits;
+    int         round;
+    clock_t     start;
+
+    ut_set_error_message_handler(silent_handler);
+
+    system = ut_read_xml(xmlPath);
+    if (system == NULL || ids == NULL) {
+        (void)fprintf(stderr, "benchLookup: could not read unit database\n");
+        return EXIT_FAILURE;
+    }
+    collect_file(xmlPath != NULL ? xmlPath : ut_get_path_xml(NULL, NULL),
+        ids);
+
+    units = calloc(ids->nameCount + 1, sizeof(ut_unit*));
+    upper = calloc(ids->nameCount + 1, sizeof(char*));
+    if (units == NULL || upper == NULL)
+        return EXIT_FAILURE;
+    for (i = 0; i < ids->nameCount; i++) {
+        char* cp;
+
+        units[i] = ut_get_unit_by_name(system, ids->names[i]);
+        upper[i] = strdup(ids->names[i]);
+        for (cp = upper[i]; cp != NULL && *cp; cp++)
+            *cp = (char)toupper((unsigned char)*cp);
+    }
+
+    (void)printf("%lu names, %lu symbols, %d rounds\n",
+        (unsigned long)ids->nameCount, (unsigned long)ids->symbolCount,
+        rounds);
+
+    start = clock();
+    for (hits = 0, round = 0; round < rounds; round++) {
+        for (i = 0; i < ids->nameCount; i++) {
+            ut_unit* unit = ut_get_unit_by_name(system, ids->names[i]);
+            hits += unit != NULL;
+            ut_free(unit);
+        }
+    }
+    report("ut_get_unit_by_name", rounds * ids->nameCount, hits,
+        seconds(start));
+
+    start = clock();
+    for (hits = 0, round = 0; round < rounds; round++) {
+        for (i = 0; i < ids->nameCount; i++) {
+            ut_unit* unit = ut_get_unit_by_name(system, upper[i]);
+            hits += unit != NULL;
+            ut_free(unit);
+        }
+    }
+    report("ut_get_unit_by_name (upper)", rounds * ids->nameCount, hits,
+        seconds(start));
+
+    start = clock();
+    for (hits = 0, round = 0; round < rounds; round++) {
+        for (i = 0; i < ids->nameCount; i++)
+            hits += ut_lookup_unit_by_name(system, ids->names[i]) != NULL;
+    }
+    report("ut_lookup_unit_by_name", rounds * ids->nameCount, hits,
+        seconds(start));
+
+    start = clock();
+    for (hits = 0, round = 0; round < rounds; round++) {
+        for (i = 0; i < ids->symbolCount; i++) {
+            ut_unit* unit = ut_get_unit_by_symbol(system, ids->symbols[i]);
+            hits += unit != NULL;
+            ut_free(unit);
+        }
+    }
+    report("ut_get_unit_by_symbol", rounds * ids->symbolCount, hits,
+        seconds(start));
+
+    start = clock();
+    for (hits = 0, round = 0; round < rounds; round++) {
+        for (i = 0; i < ids->nameCount; i++) {
+            if (units[i] != NULL) {
+                hits += ut_get_name(units[i], UT_ASCII) != NULL;
+                hits += ut_get_symbol(units[i], UT_UTF8) != NULL;
+            }
+        }
+    }
+    report("ut_get_name/ut_get_symbol", 2 * rounds * ids->nameCount, hits,
+        seconds(start));
+
+    for (i = 0; i < ids->nameCount; i++) {
+        ut_free(units[i]);
+        free(upper[i]);
+        free(ids->names[i]);
+    }
+    for (i = 0; i < ids->symbolCount; i++)
+        free(ids->symbols[i]);
+    free(units);
+    free(upper);
+    free(ids);
+    ut_free_system(system);
+
+    return EXIT_SUCCESS;
+}
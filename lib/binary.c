@@ -0,0 +1,1070 @@
+/*
+ * Copyright 2020 University Corporation for Atmospheric Research
+ *
+ * This file is part of the UDUNITS-2 package.  See the file COPYRIGHT
+ * in the top-level source-directory of the package for copying and
+ * redistribution conditions.
+ */
+/*
+ * Binary unit-databases: ut_write_binary() and ut_read_binary().
+ *
+ * A binary unit-database is a snapshot of a fully-built unit-system.  It
+ * contains only offsets and indexes -- no pointers -- so it's mapped into
+ * memory and read in place: nothing is parsed, neither XML nor unit
+ * specifications.  It's written in the byte-order and floating-point format of
+ * the host and is rejected by a host that differs.
+ *
+ * Layout (every section starts at a multiple of 8 bytes):
+ *
+ *	BinHeader
+ *	BinUnit[]	Units.  The first "basicCount" are the basic-units in
+ *			index order; every other unit follows the unit it's
+ *			based on.
+ *	BinPrefix[]	Name-prefixes, then symbol-prefixes.
+ *	BinIdToUnit[]	Name-to-unit mappings, then symbol-to-unit mappings.
+ *	BinUnitToId[]	Unit-to-name mappings, then unit-to-symbol mappings.
+ *	short[]		Basic-unit indexes of product-units, then their powers.
+ *	char[]		NUL-terminated identifiers.
+ *
+ * This module is thread-compatible but not thread-safe.
+ */
+
+/*LINTLIBRARY*/
+
+#include "config.h"
+
+#include "udunits2.h"
+#include "binary.h"
+#include "hashTable.h"
+#include "idToUnitMap.h"
+#include "lazyUnits.h"
+#include "prefix.h"
+#include "unitToIdMap.h"
+#include "unitcore.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#ifndef _MSC_VER
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#define BIN_MAGIC	"UDUNITS2"	/* not NUL-terminated in the file */
+#define BIN_VERSION	1		/* increment on any layout change */
+#define BIN_BYTE_ORDER	UINT32_C(0x01020304)
+#define BIN_NONE	UINT32_MAX	/* no unit */
+#define BIN_ALIGNMENT	8
+
+typedef enum {
+    SECTION_UNITS = 0,
+    SECTION_NAME_PREFIXES,
+    SECTION_SYMBOL_PREFIXES,
+    SECTION_NAME_TO_UNIT,
+    SECTION_SYMBOL_TO_UNIT,
+    SECTION_UNIT_TO_NAME,
+    SECTION_UNIT_TO_SYMBOL,
+    SECTION_FACTOR_INDEXES,
+    SECTION_FACTOR_POWERS,
+    SECTION_STRINGS,
+    SECTION_COUNT
+} SectionId;
+
+typedef struct {
+    uint64_t	offset;		/* from the start of the file */
+    uint64_t	count;		/* number of elements */
+} BinSection;
+
+typedef struct {
+    char	magic[8];	/* BIN_MAGIC */
+    uint32_t	version;	/* BIN_VERSION */
+    uint32_t	byteOrder;	/* BIN_BYTE_ORDER */
+    uint16_t	shortSize;	/* sizeof(short) */
+    uint16_t	doubleSize;	/* sizeof(double) */
+    uint32_t	basicCount;	/* number of basic-units */
+    uint32_t	second;		/* unit-index of the second or BIN_NONE */
+    uint32_t	reserved;
+    BinSection	sections[SECTION_COUNT];
+} BinHeader;
+
+typedef struct {
+    uint32_t	kind;		/* CoreUnitKind */
+    uint32_t	arg;		/* basic: 1 if dimensionless; product: index
+				 * of first factor; else: unit-index of the
+				 * underlying or reference unit */
+    uint32_t	count;		/* product: number of factors */
+    uint32_t	reserved;
+    double	value;		/* galilean: scale; timestamp: origin;
+				 * log: base */
+    double	offset;		/* galilean: offset */
+} BinUnit;
+
+typedef struct {
+    uint32_t	id;		/* string offset */
+    uint32_t	reserved;
+    double	value;
+} BinPrefix;
+
+typedef struct {
+    uint32_t	id;		/* string offset */
+    uint32_t	unit;		/* unit-index */
+} BinIdToUnit;
+
+typedef struct {
+    uint32_t	unit;		/* unit-index */
+    uint32_t	encoding;	/* ut_encoding */
+    uint32_t	id;		/* string offset */
+} BinUnitToId;
+
+static const size_t	elementSizes[SECTION_COUNT] = {
+    sizeof(BinUnit),
+    sizeof(BinPrefix),
+    sizeof(BinPrefix),
+    sizeof(BinIdToUnit),
+    sizeof(BinIdToUnit),
+    sizeof(BinUnitToId),
+    sizeof(BinUnitToId),
+    sizeof(short),
+    sizeof(short),
+    sizeof(char)
+};
+
+
+/******************************************************************************
+ * Writing:
+ ******************************************************************************/
+
+typedef struct {
+    char*	data;
+    size_t	size;
+    size_t	capacity;
+} Buffer;
+
+typedef struct {
+    const ut_unit*	unit;
+    uint32_t		index;
+} UnitIndex;
+
+typedef struct {
+    const char*		string;
+    uint32_t		offset;
+} StringOffset;
+
+typedef struct {
+    const ut_system*	system;
+    Buffer		sections[SECTION_COUNT];
+    HashTable*		unitIndexes;	/* UnitIndex entries */
+    HashTable*		stringOffsets;	/* StringOffset entries */
+    SectionId		sectionId;	/* section being walked */
+} Writer;
+
+
+/*
+ * Appends bytes to a buffer.
+ *
+ * Returns:
+ *	 0	Success.
+ *	-1	Failure.  See "errno".
+ */
+static int
+bufAppend(
+    Buffer* const	buf,
+    const void* const	bytes,
+    const size_t	nbytes)
+{
+    if (buf->size + nbytes > buf->capacity) {
+	size_t	capacity = buf->capacity == 0 ? 4096 : buf->capacity;
+	char*	data;
+
+	while (capacity < buf->size + nbytes)
+	    capacity *= 2;
+
+	data = realloc(buf->data, capacity);
+
+	if (data == NULL)
+	    return -1;
+
+	buf->data = data;
+	buf->capacity = capacity;
+    }
+
+    (void)memcpy(buf->data + buf->size, bytes, nbytes);
+    buf->size += nbytes;
+
+    return 0;
+}
+
+
+static int
+compareUnitIndexes(
+    const void* const	key,
+    const void* const	entry)
+{
+    return ut_compare(((const UnitIndex*)key)->unit,
+	((const UnitIndex*)entry)->unit);
+}
+
+
+static int
+compareStringOffsets(
+    const void* const	key,
+    const void* const	entry)
+{
+    return strcmp(((const StringOffset*)key)->string,
+	((const StringOffset*)entry)->string);
+}
+
+
+/*
+ * Returns the offset of a string in the string-section, adding the string if
+ * necessary.
+ *
+ * Returns:
+ *	 0	Success.
+ *	-1	Failure.  See "errno".
+ */
+static int
+addString(
+    Writer* const	writer,
+    const char* const	string,
+    uint32_t* const	offset)
+{
+    Buffer* const	strings = &writer->sections[SECTION_STRINGS];
+    StringOffset	key;
+    StringOffset**	entry;
+    uint64_t		hash = htHashString(string);
+
+    key.string = string;
+    entry = (StringOffset**)htFind(writer->stringOffsets, hash, &key,
+	compareStringOffsets);
+
+    if (entry != NULL) {
+	*offset = (*entry)->offset;
+    }
+    else {
+	StringOffset*	newEntry = malloc(sizeof(StringOffset));
+
+	if (newEntry == NULL)
+	    return -1;
+
+	newEntry->string = string;
+	newEntry->offset = (uint32_t)strings->size;
+
+	if (bufAppend(strings, string, strlen(string)+1) ||
+		htSearch(writer->stringOffsets, hash, newEntry,
+		    compareStringOffsets) == NULL) {
+	    free(newEntry);
+	    return -1;
+	}
+
+	*offset = newEntry->offset;
+    }
+
+    return 0;
+}
+
+
+/*
+ * Returns the index of a unit in the unit-section, adding the unit -- and the
+ * units it's based on -- if necessary.  Units for which ut_compare() returns 0
+ * share an index.
+ *
+ * Returns:
+ *	 0	Success.
+ *	-1	Failure.  See "errno".
+ */
+static int
+addUnit(
+    Writer* const		writer,
+    const ut_unit* const	unit,
+    uint32_t* const		index)
+{
+    Buffer* const	units = &writer->sections[SECTION_UNITS];
+    UnitIndex		key;
+    UnitIndex**		entry;
+    uint64_t		hash = coreHash(unit);
+
+    key.unit = unit;
+    entry = (UnitIndex**)htFind(writer->unitIndexes, hash, &key,
+	compareUnitIndexes);
+
+    if (entry != NULL) {
+	*index = (*entry)->index;
+    }
+    else {
+	CoreUnitDescription	description;
+	BinUnit			record;
+	UnitIndex*		newEntry;
+
+	coreDescribeUnit(unit, &description);
+	(void)memset(&record, 0, sizeof(record));
+	record.kind = (uint32_t)description.kind;
+
+	switch (description.kind) {
+	case CORE_BASIC:
+	    record.arg = (uint32_t)description.isDimensionless;
+	    break;
+	case CORE_PRODUCT: {
+	    Buffer* const	indexes =
+		&writer->sections[SECTION_FACTOR_INDEXES];
+	    const size_t	nbytes = sizeof(short)*description.count;
+
+	    record.arg = (uint32_t)(indexes->size / sizeof(short));
+	    record.count = (uint32_t)description.count;
+
+	    if (bufAppend(indexes, description.indexes, nbytes) ||
+		    bufAppend(&writer->sections[SECTION_FACTOR_POWERS],
+			description.powers, nbytes))
+		return -1;
+	    break;
+	}
+	default:
+	    if (addUnit(writer, description.unit, &record.arg))
+		return -1;
+
+	    record.value = description.value;
+	    record.offset = description.offset;
+	}
+
+	newEntry = malloc(sizeof(UnitIndex));
+
+	if (newEntry == NULL)
+	    return -1;
+
+	newEntry->unit = unit;
+	newEntry->index = (uint32_t)(units->size / sizeof(BinUnit));
+
+	if (bufAppend(units, &record, sizeof(record)) ||
+		htSearch(writer->unitIndexes, hash, newEntry,
+		    compareUnitIndexes) == NULL) {
+	    free(newEntry);
+	    return -1;
+	}
+
+	*index = newEntry->index;
+    }
+
+    return 0;
+}
+
+
+static int
+writePrefix(
+    const char* const	prefix,
+    const double	value,
+    void* const		arg)
+{
+    Writer* const	writer = (Writer*)arg;
+    BinPrefix		record;
+
+    (void)memset(&record, 0, sizeof(record));
+    record.value = value;
+
+    return addString(writer, prefix, &record.id) ||
+	bufAppend(&writer->sections[writer->sectionId], &record,
+	    sizeof(record));
+}
+
+
+static int
+writeIdToUnit(
+    const char* const		id,
+    const ut_unit* const	unit,
+    void* const			arg)
+{
+    Writer* const	writer = (Writer*)arg;
+    BinIdToUnit		record;
+
+    return addString(writer, id, &record.id) ||
+	addUnit(writer, unit, &record.unit) ||
+	bufAppend(&writer->sections[writer->sectionId], &record,
+	    sizeof(record));
+}
+
+
+static int
+writeUnitToId(
+    const ut_unit* const	unit,
+    const ut_encoding		encoding,
+    const char* const		id,
+    void* const			arg)
+{
+    Writer* const	writer = (Writer*)arg;
+    BinUnitToId		record;
+
+    record.encoding = (uint32_t)encoding;
+
+    return addUnit(writer, unit, &record.unit) ||
+	addString(writer, id, &record.id) ||
+	bufAppend(&writer->sections[writer->sectionId], &record,
+	    sizeof(record));
+}
+
+
+/*
+ * Serializes a unit-system into the sections of a writer.
+ *
+ * Returns:
+ *	 0		Success.
+ *	-1		Failure.  See "errno".
+ */
+static int
+serialize(
+    Writer* const	writer,
+    BinHeader* const	header)
+{
+    const ut_system* const	system = writer->system;
+    const ut_unit* const	second = coreGetSecond(system);
+    int				i;
+
+    /*
+     * The basic-units come first so that a unit's index in the file is its
+     * index in the unit-system.  The second comes next so that it can be set
+     * before any timestamp-unit is created.
+     */
+    header->basicCount = (uint32_t)coreGetBasicCount(system);
+
+    for (i = 0; i < (int)header->basicCount; i++) {
+	uint32_t	index;
+
+	if (addUnit(writer, coreGetBasicUnit(system, i), &index))
+	    return -1;
+    }
+
+    header->second = BIN_NONE;
+
+    if (second != NULL && addUnit(writer, second, &header->second))
+	return -1;
+
+    writer->sectionId = SECTION_NAME_PREFIXES;
+    if (utWalkPrefixes(system, SYSTEM_NAME_PREFIXES, writePrefix, writer))
+	return -1;
+
+    writer->sectionId = SECTION_SYMBOL_PREFIXES;
+    if (utWalkPrefixes(system, SYSTEM_SYMBOL_PREFIXES, writePrefix, writer))
+	return -1;
+
+    writer->sectionId = SECTION_NAME_TO_UNIT;
+    if (itumWalk(system, SYSTEM_NAME_TO_UNIT, writeIdToUnit, writer))
+	return -1;
+
+    writer->sectionId = SECTION_SYMBOL_TO_UNIT;
+    if (itumWalk(system, SYSTEM_SYMBOL_TO_UNIT, writeIdToUnit, writer))
+	return -1;
+
+    writer->sectionId = SECTION_UNIT_TO_NAME;
+    if (utimWalk(system, SYSTEM_UNIT_TO_NAME, writeUnitToId, writer))
+	return -1;
+
+    writer->sectionId = SECTION_UNIT_TO_SYMBOL;
+    if (utimWalk(system, SYSTEM_UNIT_TO_SYMBOL, writeUnitToId, writer))
+	return -1;
+
+    return 0;
+}
+
+
+/*
+ * Writes the header and sections of a writer to a file.
+ *
+ * Returns:
+ *	 0		Success.
+ *	-1		Failure.  See "errno".
+ */
+static int
+writeFile(
+    const Writer* const	writer,
+    BinHeader* const	header,
+    FILE* const		file)
+{
+    static const char	padding[BIN_ALIGNMENT];
+    uint64_t		offset = sizeof(BinHeader);
+    int			i;
+
+    (void)memcpy(header->magic, BIN_MAGIC, sizeof(header->magic));
+    header->version = BIN_VERSION;
+    header->byteOrder = BIN_BYTE_ORDER;
+    header->shortSize = (uint16_t)sizeof(short);
+    header->doubleSize = (uint16_t)sizeof(double);
+
+    for (i = 0; i < SECTION_COUNT; i++) {
+	offset = (offset + BIN_ALIGNMENT - 1) & ~(uint64_t)(BIN_ALIGNMENT - 1);
+	header->sections[i].offset = offset;
+	header->sections[i].count = writer->sections[i].size / elementSizes[i];
+	offset += writer->sections[i].size;
+    }
+
+    if (fwrite(header, sizeof(BinHeader), 1, file) != 1)
+	return -1;
+
+    offset = sizeof(BinHeader);
+
+    for (i = 0; i < SECTION_COUNT; i++) {
+	const Buffer* const	section = &writer->sections[i];
+	const size_t		npad =
+	    (size_t)(header->sections[i].offset - offset);
+
+	if ((npad > 0 && fwrite(padding, 1, npad, file) != npad) ||
+		(section->size > 0 &&
+		    fwrite(section->data, section->size, 1, file) != 1))
+	    return -1;
+
+	offset = header->sections[i].offset + section->size;
+    }
+
+    return 0;
+}
+
+
+/*
+ * Writes a unit-system to a binary unit-database that ut_read_binary() can
+ * read.  The file is written in the byte-order and floating-point format of
+ * the host.  Deferred unit-definitions (see ut_read_xml_lazy()) are resolved
+ * first.  That modifies "system" but doesn't change the units that it
+ * defines, so "system" is logically const.
+ *
+ * Arguments:
+ *	system		Pointer to the unit-system.
+ *	path		Pathname of the file to be written.  An existing file
+ *			is replaced.
+ * Returns:
+ *	UT_SUCCESS	Success.
+ *	UT_BAD_ARG	"system" or "path" is NULL, or "system" is an
+ *			overlay (see ut_new_overlay_system()).
+ *	UT_PARSE	A deferred unit-definition couldn't be parsed.
+ *	UT_OS		Operating-system error.  See "errno".
+ */
+ut_status
+ut_write_binary(
+    const ut_system* const	system,
+    const char* const		path)
+{
+    ut_set_status(UT_SUCCESS);
+
+    if (system == NULL || path == NULL) {
+	ut_set_status(UT_BAD_ARG);
+	ut_handle_error_message("ut_write_binary(): NULL argument");
+    }
+    else if (coreGetBaseSystem(system) != NULL) {
+	ut_set_status(UT_BAD_ARG);
+	ut_handle_error_message(
+	    "ut_write_binary(): Can't write an overlay unit-system");
+    }
+    else if (luResolveAll((ut_system*)system) != UT_SUCCESS) {
+	ut_set_status(UT_PARSE);
+	ut_handle_error_message(
+	    "ut_write_binary(): Couldn't resolve deferred unit-definitions");
+    }
+    else {
+	Writer		writer;
+	BinHeader	header;
+	int		i;
+
+	(void)memset(&writer, 0, sizeof(writer));
+	(void)memset(&header, 0, sizeof(header));
+	writer.system = system;
+	writer.unitIndexes = htNew();
+	writer.stringOffsets = htNew();
+
+	if (writer.unitIndexes == NULL || writer.stringOffsets == NULL ||
+		serialize(&writer, &header)) {
+	    ut_set_status(UT_OS);
+	    ut_handle_error_message(strerror(errno));
+	    ut_handle_error_message(
+		"ut_write_binary(): Couldn't serialize unit-system");
+	}
+	else {
+	    FILE*	file = fopen(path, "wb");
+
+	    if (file == NULL) {
+		ut_set_status(UT_OS);
+		ut_handle_error_message(strerror(errno));
+		ut_handle_error_message(
+		    "ut_write_binary(): Couldn't open \"%s\"", path);
+	    }
+	    else {
+		int	error = writeFile(&writer, &header, file);
+
+		if (fclose(file) != 0)
+		    error = 1;
+
+		if (error) {
+		    ut_set_status(UT_OS);
+		    ut_handle_error_message(strerror(errno));
+		    ut_handle_error_message(
+			"ut_write_binary(): Couldn't write \"%s\"", path);
+		    (void)remove(path);
+		}
+	    }
+	}
+
+	htFree(writer.unitIndexes, free);
+	htFree(writer.stringOffsets, free);
+
+	for (i = 0; i < SECTION_COUNT; i++)
+	    free(writer.sections[i].data);
+    }
+
+    return ut_get_status();
+}
+
+
+/******************************************************************************
+ * Reading:
+ ******************************************************************************/
+
+typedef struct {
+    const char*		data;
+    size_t		size;
+} Mapping;
+
+
+/*
+ * Maps a file into memory read-only.
+ *
+ * Returns:
+ *	 0	Success.
+ *	-1	Failure.  See "errno".
+ */
+static int
+mapFile(
+    const char* const	path,
+    Mapping* const	mapping)
+{
+    int		status = -1;
+#ifndef _MSC_VER
+    int		fd = open(path, O_RDONLY);
+
+    if (fd >= 0) {
+	struct stat	info;
+
+	if (fstat(fd, &info) == 0) {
+	    mapping->size = (size_t)info.st_size;
+
+	    if (mapping->size == 0) {
+		mapping->data = NULL;
+		status = 0;
+	    }
+	    else {
+		void* const	data = mmap(NULL, mapping->size, PROT_READ,
+		    MAP_PRIVATE, fd, 0);
+
+		if (data != MAP_FAILED) {
+		    mapping->data = data;
+		    status = 0;
+		}
+	    }
+	}
+
+	(void)close(fd);
+    }
+#else
+    FILE*	file = fopen(path, "rb");
+
+    if (file != NULL) {
+	if (fseek(file, 0, SEEK_END) == 0) {
+	    const long	size = ftell(file);
+
+	    if (size >= 0 && fseek(file, 0, SEEK_SET) == 0) {
+		char* const	data = malloc(size == 0 ? 1 : (size_t)size);
+
+		if (data != NULL) {
+		    if (fread(data, 1, (size_t)size, file) == (size_t)size) {
+			mapping->data = data;
+			mapping->size = (size_t)size;
+			status = 0;
+		    }
+		    else {
+			free(data);
+		    }
+		}
+	    }
+	}
+
+	(void)fclose(file);
+    }
+#endif
+
+    return status;
+}
+
+
+static void
+unmapFile(
+    Mapping* const	mapping)
+{
+#ifndef _MSC_VER
+    if (mapping->data != NULL)
+	(void)munmap((void*)mapping->data, mapping->size);
+#else
+    free((void*)mapping->data);
+#endif
+    mapping->data = NULL;
+}
+
+
+/*
+ * Validates the header and the indexes of a binary unit-database so that
+ * building a unit-system from it can't access memory outside the file.
+ *
+ * Arguments:
+ *	data	Pointer to the contents of the file.  Shall be suitably aligned
+ *		for a BinHeader.
+ *	size	Size of the file in bytes.
+ * Returns:
+ *	NULL	The file is valid.
+ *	else	Description of the first problem found.
+ */
+static const char*
+validate(
+    const char* const	data,
+    const size_t	size)
+{
+    const BinHeader*	header = (const BinHeader*)data;
+    const BinUnit*	units;
+    uint64_t		unitCount;
+    uint64_t		factorCount;
+    uint64_t		stringCount;
+    uint64_t		i;
+    int			id;
+
+    if (size < sizeof(BinHeader) ||
+	    memcmp(header->magic, BIN_MAGIC, sizeof(header->magic)) != 0)
+	return "Not a binary unit-database";
+    if (header->version != BIN_VERSION)
+	return "Unsupported version of binary unit-database";
+    if (header->byteOrder != BIN_BYTE_ORDER ||
+	    header->shortSize != sizeof(short) ||
+	    header->doubleSize != sizeof(double))
+	return "Binary unit-database was written by an incompatible host";
+
+    for (id = 0; id < SECTION_COUNT; id++) {
+	const BinSection* const	section = &header->sections[id];
+
+	if (section->offset % BIN_ALIGNMENT != 0 || section->offset > size ||
+		section->count > (size - section->offset) / elementSizes[id])
+	    return "Section lies outside of file";
+    }
+
+    units = (const BinUnit*)(data + header->sections[SECTION_UNITS].offset);
+    unitCount = header->sections[SECTION_UNITS].count;
+    factorCount = header->sections[SECTION_FACTOR_INDEXES].count;
+    stringCount = header->sections[SECTION_STRINGS].count;
+
+    if (unitCount >= BIN_NONE || header->basicCount > unitCount ||
+	    factorCount != header->sections[SECTION_FACTOR_POWERS].count)
+	return "Inconsistent section sizes";
+    if (header->second != BIN_NONE && header->second >= unitCount)
+	return "Invalid index of second";
+    if (stringCount > 0 && data[header->sections[SECTION_STRINGS].offset +
+	    stringCount - 1] != 0)
+	return "Unterminated string";
+
+    for (i = 0; i < unitCount; i++) {
+	const BinUnit* const	unit = units + i;
+
+	if ((unit->kind == CORE_BASIC) != (i < header->basicCount))
+	    return "Basic-units are out of order";
+
+	switch (unit->kind) {
+	case CORE_BASIC:
+	    break;
+	case CORE_PRODUCT:
+	    if (unit->arg > factorCount || unit->count > factorCount - unit->arg)
+		return "Invalid factors of product-unit";
+	    break;
+	case CORE_GALILEAN:
+	case CORE_TIMESTAMP:
+	case CORE_LOG:
+	    if (unit->arg >= i)
+		return "Unit precedes the unit it's based on";
+	    break;
+	default:
+	    return "Unknown kind of unit";
+	}
+    }
+
+    for (id = SECTION_NAME_PREFIXES; id <= SECTION_UNIT_TO_SYMBOL; id++) {
+	const char* const	base = data + header->sections[id].offset;
+
+	for (i = 0; i < header->sections[id].count; i++) {
+	    uint32_t	string;
+	    uint32_t	unit = 0;
+
+	    if (id <= SECTION_SYMBOL_PREFIXES) {
+		string = ((const BinPrefix*)base)[i].id;
+	    }
+	    else if (id <= SECTION_SYMBOL_TO_UNIT) {
+		string = ((const BinIdToUnit*)base)[i].id;
+		unit = ((const BinIdToUnit*)base)[i].unit;
+	    }
+	    else {
+		const BinUnitToId* const	record =
+		    (const BinUnitToId*)base + i;
+
+		if (record->encoding != UT_ASCII &&
+			record->encoding != UT_LATIN1 &&
+			record->encoding != UT_UTF8)
+		    return "Invalid encoding";
+
+		string = record->id;
+		unit = record->unit;
+	    }
+
+	    if (string >= stringCount)
+		return "Invalid string offset";
+	    if (unit >= unitCount)
+		return "Invalid unit-index";
+	}
+    }
+
+    return NULL;
+}
+
+
+/*
+ * Adds the contents of a valid binary unit-database to an empty unit-system.
+ *
+ * Arguments:
+ *	system		Pointer to the empty unit-system.
+ *	data		Pointer to the validated contents of the file.
+ * Returns:
+ *	NULL		Success.
+ *	else		Description of the problem.  "ut_get_status()" is set.
+ */
+static const char*
+build(
+    ut_system* const	system,
+    const char* const	data)
+{
+    const BinHeader* const	header = (const BinHeader*)data;
+    const BinSection* const	sections = header->sections;
+    const BinUnit* const	records =
+	(const BinUnit*)(data + sections[SECTION_UNITS].offset);
+    const short* const		indexes =
+	(const short*)(data + sections[SECTION_FACTOR_INDEXES].offset);
+    const short* const		powers =
+	(const short*)(data + sections[SECTION_FACTOR_POWERS].offset);
+    const char* const		strings = data + sections[SECTION_STRINGS].offset;
+    const size_t		unitCount =
+	(size_t)sections[SECTION_UNITS].count;
+    ut_unit** const		units = calloc(unitCount + 1, sizeof(ut_unit*));
+    const char*			problem = NULL;
+    size_t			i;
+    int				id;
+
+    if (units == NULL) {
+	ut_set_status(UT_OS);
+	return strerror(errno);
+    }
+
+    for (i = 0; i < unitCount && problem == NULL; i++) {
+	const BinUnit* const	record = records + i;
+	CoreUnitDescription	description;
+
+	if (record->kind == CORE_BASIC) {
+	    ut_unit* const	basic = record->arg
+		? ut_new_dimensionless_unit(system)
+		: ut_new_base_unit(system);
+
+	    ut_free(basic);
+
+	    if (basic == NULL)
+		problem = "Couldn't create basic-unit";
+	}
+
+	if (problem == NULL) {
+	    (void)memset(&description, 0, sizeof(description));
+	    description.kind = (CoreUnitKind)record->kind;
+	    description.index = (int)i;
+	    description.count = (int)record->count;
+	    description.indexes = indexes + record->arg;
+	    description.powers = powers + record->arg;
+	    description.unit = record->kind == CORE_BASIC ||
+		    record->kind == CORE_PRODUCT
+		? NULL
+		: units[record->arg];
+	    description.value = record->value;
+	    description.offset = record->offset;
+
+	    units[i] = coreNewUnit(system, &description);
+
+	    if (units[i] == NULL) {
+		problem = "Couldn't create unit";
+	    }
+	    else if (i == header->second &&
+		    ut_set_second(units[i]) != UT_SUCCESS) {
+		problem = "Couldn't set second";
+	    }
+	}
+    }
+
+    if (problem == NULL) {
+	const BinPrefix*	prefix;
+	const BinIdToUnit*	idToUnit;
+	const BinUnitToId*	unitToId;
+
+	for (id = SECTION_NAME_PREFIXES; id <= SECTION_SYMBOL_PREFIXES &&
+		problem == NULL; id++) {
+	    prefix = (const BinPrefix*)(data + sections[id].offset);
+
+	    for (i = 0; i < sections[id].count; i++, prefix++) {
+		if ((id == SECTION_NAME_PREFIXES
+			? ut_add_name_prefix(system, strings + prefix->id,
+			    prefix->value)
+			: ut_add_symbol_prefix(system, strings + prefix->id,
+			    prefix->value)) != UT_SUCCESS) {
+		    problem = "Couldn't add prefix";
+		    break;
+		}
+	    }
+	}
+
+	for (id = SECTION_NAME_TO_UNIT; id <= SECTION_SYMBOL_TO_UNIT &&
+		problem == NULL; id++) {
+	    idToUnit = (const BinIdToUnit*)(data + sections[id].offset);
+
+	    for (i = 0; i < sections[id].count; i++, idToUnit++) {
+		if ((id == SECTION_NAME_TO_UNIT
+			? ut_map_name_to_unit(strings + idToUnit->id, UT_UTF8,
+			    units[idToUnit->unit])
+			: ut_map_symbol_to_unit(strings + idToUnit->id, UT_UTF8,
+			    units[idToUnit->unit])) != UT_SUCCESS) {
+		    problem = "Couldn't map identifier to unit";
+		    break;
+		}
+	    }
+	}
+
+	for (id = SECTION_UNIT_TO_NAME; id <= SECTION_UNIT_TO_SYMBOL &&
+		problem == NULL; id++) {
+	    unitToId = (const BinUnitToId*)(data + sections[id].offset);
+
+	    for (i = 0; i < sections[id].count; i++, unitToId++) {
+		const ut_encoding	encoding = (ut_encoding)unitToId->encoding;
+
+		if ((id == SECTION_UNIT_TO_NAME
+			? ut_map_unit_to_name(units[unitToId->unit],
+			    strings + unitToId->id, encoding)
+			: ut_map_unit_to_symbol(units[unitToId->unit],
+			    strings + unitToId->id, encoding)) != UT_SUCCESS) {
+		    problem = "Couldn't map unit to identifier";
+		    break;
+		}
+	    }
+	}
+    }
+
+    for (i = 0; i < unitCount; i++)
+	ut_free(units[i]);
+
+    free(units);
+
+    return problem;
+}
+
+
+/*
+ * Returns the unit-system of the in-memory image of a binary unit-database.
+ */
+ut_system*
+binReadImage(
+    const void* const	data,
+    const size_t	size,
+    const char** const	problem)
+{
+    ut_system*	system = NULL;
+
+    ut_set_status(UT_SUCCESS);
+
+    *problem = size < sizeof(BinHeader)
+	? "Not a binary unit-database"
+	: validate(data, size);
+
+    if (*problem != NULL) {
+	ut_set_status(UT_PARSE);
+    }
+    else {
+	system = ut_new_system();
+
+	if (system == NULL) {
+	    *problem = "Couldn't create unit-system";
+	}
+	else {
+	    *problem = build(system, data);
+
+	    if (*problem != NULL) {
+		ut_free_system(system);
+		system = NULL;
+
+		if (ut_get_status() == UT_SUCCESS)
+		    ut_set_status(UT_PARSE);
+	    }
+	}
+    }
+
+    return system;
+}
+
+
+/*
+ * Returns the unit-system of a binary unit-database written by
+ * ut_write_binary().  The file is mapped into memory and read in place, so
+ * this is much faster than ut_read_xml().
+ *
+ * Arguments:
+ *	path		Pathname of the binary unit-database.
+ * Returns:
+ *	NULL		Failure.  "ut_get_status()" will be
+ *			    UT_BAD_ARG		"path" is NULL.
+ *			    UT_OPEN_ARG		The file couldn't be opened.
+ *						See "errno" for the reason.
+ *			    UT_PARSE		The file isn't a valid binary
+ *						unit-database for this host.
+ *			    UT_OS		Operating-system error.  See
+ *						"errno".
+ *	else		Pointer to the unit-system.  The client should pass it
+ *			to ut_free_system() when it's no longer needed.
+ */
+ut_system*
+ut_read_binary(
+    const char* const	path)
+{
+    ut_system*	system = NULL;
+
+    ut_set_status(UT_SUCCESS);
+
+    if (path == NULL) {
+	ut_set_status(UT_BAD_ARG);
+	ut_handle_error_message("ut_read_binary(): NULL pathname argument");
+    }
+    else {
+	Mapping	mapping;
+
+	if (mapFile(path, &mapping)) {
+	    ut_set_status(UT_OPEN_ARG);
+	    ut_handle_error_message(strerror(errno));
+	    ut_handle_error_message("ut_read_binary(): Couldn't open \"%s\"",
+		path);
+	}
+	else {
+	    const char*	problem;
+
+	    system = binReadImage(mapping.data, mapping.size, &problem);
+
+	    if (system == NULL)
+		ut_handle_error_message("ut_read_binary(): %s: \"%s\"",
+		    problem, path);
+
+	    unmapFile(&mapping);
+	}
+    }
+
+    return system;
+}
@@ -0,0 +1,48 @@
+/*
+ * Copyright 2020 University Corporation for Atmospheric Research
+ *
+ * This file is part of the UDUNITS-2 package.  See the file COPYRIGHT
+ * in the top-level source-directory of the package for copying and
+ * redistribution conditions.
+ */
+#ifndef UT_BINARY_H_INCLUDED
+#define UT_BINARY_H_INCLUDED
+
+#include <stddef.h>
+
+#include "udunits2.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ * Returns the unit-system of the in-memory image of a binary unit-database
+ * (see ut_write_binary()).  The image is only read.
+ *
+ * Arguments:
+ *	data		Pointer to the image.  Shall be aligned for a "double".
+ *	size		Size of the image in bytes.
+ *	problem		Pointer to a description of the problem.  Set on
+ *			failure.
+ * Returns:
+ *	NULL		Failure.  "ut_get_status()" will be
+ *			    UT_PARSE		The image isn't a valid binary
+ *						unit-database for this host.
+ *			    UT_OS		Operating-system error.  See
+ *						"errno".
+ *	else		Pointer to the unit-system.
+ */
+ut_system*
+binReadImage(
+    const void* const	data,
+    const size_t	size,
+    const char** const	problem);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,466 @@
+/*
+ * Copyright 2020 University Corporation for Atmospheric Research
+ *
+ * This file is part of the UDUNITS-2 package.  See the file COPYRIGHT
+ * in the top-level source-directory of the package for copying and
+ * redistribution conditions.
+ */
+/*
+ * Canonical keys of units: ut_canonical_key() and ut_canonical_hash().
+ *
+ * A key is built from the structure of a unit rather than from its identifiers,
+ * so every specification of the same unit (e.g., "m/s", "meter per second",
+ * "m.s-1") has the same key.  Grammar:
+ *
+ *	key	:= product
+ *		 | "G(" scale "," offset ")" key	galilean-unit
+ *		 | "T(" origin ")" key			timestamp-unit
+ *		 | "L(" base ")" key			logarithmic-unit
+ *	product	:= "1"					dimensionless one
+ *		 | factor ("." factor)*
+ *	factor	:= basic [power]			power if not 1
+ *	basic	:= ASCII symbol | ASCII name | "#" index
+ *	number	:= integer				integral value
+ *		 | integer "p" integer			m*2^e, m odd
+ *
+ * Numbers are exact, so different values have different keys.  The key is
+ * printed piecewise rather than via printf(3) because it's meant to be cheap.
+ *
+ * This module has no static or shared mutable state: ut_canonical_key() and
+ * ut_canonical_hash() are reentrant and may be called concurrently for the units
+ * of a frozen unit-system without locking.
+ */
+
+/*LINTLIBRARY*/
+
+#include "config.h"
+
+#include "udunits2.h"
+#include "hashTable.h"
+#include "unitcore.h"
+
+#include <float.h>
+#include <limits.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * Output of a key:
+ */
+typedef struct {
+    char*	buf;
+    size_t	size;
+    size_t	nchar;		/* would-be length excluding NUL */
+    int		failed;
+} Key;
+
+
+/*
+ * Appends characters to a key.  Characters that don't fit are counted but not
+ * written.  The key is kept NUL-terminated.
+ *
+ * Arguments:
+ *	key	Pointer to the key.
+ *	chars	Pointer to the characters.
+ *	count	Number of characters.
+ */
+static void
+appendChars(
+    Key* const		key,
+    const char* const	chars,
+    const size_t	count)
+{
+    if (key->nchar < key->size) {
+	const size_t	room = key->size - key->nchar - 1;
+	const size_t	n = count < room ? count : room;
+
+	(void)memcpy(key->buf + key->nchar, chars, n);
+	key->buf[key->nchar + n] = 0;
+    }
+
+    key->nchar += count;
+}
+
+
+/*
+ * Appends a string to a key.
+ *
+ * Arguments:
+ *	key	Pointer to the key.
+ *	string	Pointer to the string.
+ */
+static void
+appendString(
+    Key* const		key,
+    const char* const	string)
+{
+    appendChars(key, string, strlen(string));
+}
+
+
+/*
+ * Appends a decimal integer to a key.
+ *
+ * Arguments:
+ *	key	Pointer to the key.
+ *	value	The integer.
+ */
+static void
+appendInteger(
+    Key* const		key,
+    const long long	value)
+{
+    char		digits[24];
+    char*		cp = digits + sizeof(digits);
+    unsigned long long	magnitude = value < 0
+	? 0 - (unsigned long long)value
+	: (unsigned long long)value;
+
+    do {
+	*--cp = (char)('0' + magnitude % 10);
+	magnitude /= 10;
+    } while (magnitude > 0);
+
+    if (value < 0)
+	*--cp = '-';
+
+    appendChars(key, cp, (size_t)(digits + sizeof(digits) - cp));
+}
+
+
+/*
+ * Indicates whether a number can be part of a key.  NaN and infinite numbers
+ * can't, so units with them have neither a key nor a hash-value.
+ */
+static int
+isKeyable(
+    const double	value)
+{
+    return value == value && fabs(value) <= DBL_MAX;
+}
+
+
+/*
+ * Appends a number to a key.  Integral values are printed as integers.  Other
+ * values are printed exactly as "<m>p<e>", meaning m*2^e, where "m" is odd.
+ * This is cheaper than a decimal conversion by printf(3) and the same on every
+ * platform.  Both zeros are printed as "0".
+ *
+ * Arguments:
+ *	key	Pointer to the key.
+ *	value	The number.
+ */
+static void
+appendValue(
+    Key* const		key,
+    const double	value)
+{
+    if (value == floor(value) && fabs(value) < 1e15) {
+	appendInteger(key, (long long)value);
+    }
+    else if (!isKeyable(value)) {
+	key->failed = 1;
+    }
+    else {
+	int		exponent;
+	long long	mantissa = (long long)ldexp(frexp(value, &exponent),
+	    DBL_MANT_DIG);
+
+	exponent -= DBL_MANT_DIG;
+
+	while ((mantissa & 1) == 0) {
+	    mantissa /= 2;
+	    exponent++;
+	}
+
+	appendInteger(key, mantissa);
+	appendChars(key, "p", 1);
+	appendInteger(key, exponent);
+    }
+}
+
+
+/*
+ * Returns the identifier of a basic-unit in a key.
+ *
+ * Arguments:
+ *	system	Pointer to the unit-system.
+ *	index	Index of the basic-unit.
+ *	buf	Buffer for the identifier if the basic-unit has neither an
+ *		ASCII symbol nor an ASCII name.
+ *	size	Size of "buf" in bytes.
+ * Returns:
+ *	Pointer to the identifier.
+ */
+static const char*
+basicId(
+    const ut_system* const	system,
+    const int			index,
+    char* const			buf,
+    const size_t		size)
+{
+    const ut_unit* const	basic = coreGetBasicUnit(system, index);
+    const char*			id = ut_get_symbol(basic, UT_ASCII);
+
+    if (id == NULL)
+	id = ut_get_name(basic, UT_ASCII);
+
+    if (id == NULL) {
+	(void)snprintf(buf, size, "#%d", index);
+	id = buf;
+    }
+
+    return id;
+}
+
+
+/*
+ * Appends the key of a unit.
+ *
+ * Arguments:
+ *	key	Pointer to the key.
+ *	unit	Pointer to the unit.
+ */
+static void
+appendUnit(
+    Key* const			key,
+    const ut_unit* const	unit)
+{
+    const ut_system* const	system = ut_get_system(unit);
+    CoreUnitDescription		description;
+    char			buf[32];
+
+    coreDescribeUnit(unit, &description);
+
+    switch (description.kind) {
+    case CORE_BASIC:
+	appendString(key, basicId(system, description.index, buf,
+	    sizeof(buf)));
+	break;
+    case CORE_PRODUCT:
+	if (description.count == 0) {
+	    appendChars(key, "1", 1);
+	}
+	else {
+	    int	i;
+
+	    for (i = 0; i < description.count; i++) {
+		if (i > 0)
+		    appendChars(key, ".", 1);
+
+		appendString(key, basicId(system, description.indexes[i], buf,
+		    sizeof(buf)));
+
+		if (description.powers[i] != 1)
+		    appendInteger(key, description.powers[i]);
+	    }
+	}
+	break;
+    case CORE_GALILEAN:
+	appendChars(key, "G(", 2);
+	appendValue(key, description.value);
+	appendChars(key, ",", 1);
+	appendValue(key, description.offset);
+	appendChars(key, ")", 1);
+	appendUnit(key, description.unit);
+	break;
+    case CORE_TIMESTAMP:
+	appendChars(key, "T(", 2);
+	appendValue(key, description.value);
+	appendChars(key, ")", 1);
+	appendUnit(key, description.unit);
+	break;
+    case CORE_LOG:
+	appendChars(key, "L(", 2);
+	appendValue(key, description.value);
+	appendChars(key, ")", 1);
+	appendUnit(key, description.unit);
+	break;
+    }
+}
+
+
+/*
+ * Returns the hash-value of the key of a unit without forming the key.
+ *
+ * Arguments:
+ *	hash	Hash-value so far.
+ *	unit	Pointer to the unit.
+ *	failed	Pointer to the failure indicator.  Set if the unit has no key
+ *		(see appendValue()).
+ * Returns:
+ *	The hash-value of "unit" combined with "hash".
+ */
+static uint64_t
+hashUnit(
+    uint64_t			hash,
+    const ut_unit* const	unit,
+    int* const			failed)
+{
+    const ut_system* const	system = ut_get_system(unit);
+    CoreUnitDescription		description;
+    char			buf[32];
+
+    coreDescribeUnit(unit, &description);
+
+    switch (description.kind) {
+    case CORE_BASIC:
+	/*
+	 * Same as the product-unit of the basic-unit.
+	 */
+	hash = htHashMix(hash, CORE_PRODUCT);
+	hash = htHashMix(hash, htHashString(basicId(system, description.index,
+	    buf, sizeof(buf))));
+	hash = htHashMix(hash, 1);
+	break;
+    case CORE_PRODUCT: {
+	int	i;
+
+	hash = htHashMix(hash, CORE_PRODUCT);
+
+	for (i = 0; i < description.count; i++) {
+	    hash = htHashMix(hash, htHashString(basicId(system,
+		description.indexes[i], buf, sizeof(buf))));
+	    hash = htHashMix(hash, (uint64_t)(int64_t)description.powers[i]);
+	}
+	break;
+    }
+    case CORE_GALILEAN:
+	if (!isKeyable(description.value) || !isKeyable(description.offset))
+	    *failed = 1;
+	hash = htHashMix(hash, CORE_GALILEAN);
+	hash = htHashDouble(hash, description.value);
+	hash = htHashDouble(hash, description.offset);
+	hash = hashUnit(hash, description.unit, failed);
+	break;
+    case CORE_TIMESTAMP:
+	if (!isKeyable(description.value))
+	    *failed = 1;
+	hash = htHashMix(hash, CORE_TIMESTAMP);
+	hash = htHashDouble(hash, description.value);
+	hash = hashUnit(hash, description.unit, failed);
+	break;
+    case CORE_LOG:
+	if (!isKeyable(description.value))
+	    *failed = 1;
+	hash = htHashMix(hash, CORE_LOG);
+	hash = htHashDouble(hash, description.value);
+	hash = hashUnit(hash, description.unit, failed);
+	break;
+    }
+
+    return hash;
+}
+
+
+/******************************************************************************
+ * Public API:
+ ******************************************************************************/
+
+/*
+ * Returns the canonical key of a unit.  Units that are specified differently but
+ * have the same structure (e.g., "m/s", "meter per second", and "m.s-1") have
+ * the same key.  The key is formed from the ASCII identifiers of the basic-units
+ * and the numeric parameters of the unit, so it doesn't depend on the encoding
+ * and is the same in unit-systems whose basic-units have the same identifiers.
+ *
+ * Arguments:
+ *	unit		Pointer to the unit.
+ *	buf		Pointer to the buffer into which to print the key.
+ *	size		Size of the buffer in bytes.
+ * Returns:
+ *	-1		Failure:  "ut_get_status()" will be
+ *			    UT_BAD_ARG		"unit" or "buf" is NULL.
+ *			    UT_CANT_FORMAT	The key couldn't be printed.
+ *	else		Success.  Number of bytes that would be printed if
+ *			"size" were sufficiently large excluding the
+ *			terminating NUL.
+ */
+int
+ut_canonical_key(
+    const ut_unit* const	unit,
+    char* const			buf,
+    const size_t		size)
+{
+    int		nchar = -1;	/* failure */
+
+    if (unit == NULL || buf == NULL) {
+	ut_set_status(UT_BAD_ARG);
+	ut_handle_error_message("ut_canonical_key(): NULL argument");
+    }
+    else {
+	Key	key;
+
+	key.buf = buf;
+	key.size = size;
+	key.nchar = 0;
+	key.failed = 0;
+
+	if (size > 0)
+	    buf[0] = 0;
+
+	appendUnit(&key, unit);
+
+	if (key.failed || key.nchar > INT_MAX) {
+	    ut_set_status(UT_CANT_FORMAT);
+	    ut_handle_error_message("ut_canonical_key(): "
+		"Couldn't print key");
+	}
+	else {
+	    ut_set_status(UT_SUCCESS);
+	    nchar = (int)key.nchar;
+	}
+    }
+
+    return nchar;
+}
+
+
+/*
+ * Returns the 64-bit hash-value of the canonical key of a unit (see
+ * ut_canonical_key()) without forming the key.  Units with the same key have
+ * the same hash-value in every process.
+ *
+ * Arguments:
+ *	unit		Pointer to the unit.
+ * Returns:
+ *	0		Failure.  "ut_get_status()" will be
+ *			    UT_BAD_ARG		"unit" is NULL.
+ *			    UT_CANT_FORMAT	The unit has no key (see
+ *						ut_canonical_key()).
+ *	else		The hash-value.  Only its low-order 64 bits are used.
+ */
+unsigned long long
+ut_canonical_hash(
+    const ut_unit* const	unit)
+{
+    uint64_t	hash = 0;
+
+    if (unit == NULL) {
+	ut_set_status(UT_BAD_ARG);
+	ut_handle_error_message("ut_canonical_hash(): NULL unit argument");
+    }
+    else {
+	int	failed = 0;
+
+	hash = hashUnit(htHashString(""), unit, &failed);
+
+	if (failed) {
+	    hash = 0;
+	    ut_set_status(UT_CANT_FORMAT);
+	    ut_handle_error_message("ut_canonical_hash(): "
+		"Unit has no key");
+	}
+	else {
+	    if (hash == 0)
+		hash = 1;
+
+	    ut_set_status(UT_SUCCESS);
+	}
+    }
+
+    return (unsigned long long)hash;
+}
@@ -0,0 +1,350 @@
+/*
+ * Copyright 2020 University Corporation for Atmospheric Research
+ *
+ * This file is part of the UDUNITS-2 package.  See the file COPYRIGHT
+ * in the top-level source-directory of the package for copying and
+ * redistribution conditions.
+ */
+/*
+ * Contexts of the UDUNITS2(3) library: ut_new_context() and the "_r" variants
+ * of functions.
+ *
+ * A context has its own status and error-message handler.  A function called
+ * through a context uses the handler of the context, saves its status in the
+ * context, and leaves the status and handler of the calling thread as they
+ * were.  Independent clients of the library in one process (e.g., two
+ * libraries that both use it) can therefore use it without seeing each other's
+ * errors.  The library keeps no other mutable state between calls: parsing and
+ * formatting use only the stack, and the state of a read of a unit database is
+ * thread-local.
+ *
+ * A context may be used by one thread at a time.
+ */
+
+/*LINTLIBRARY*/
+
+#include "config.h"
+
+#include "udunits2.h"
+
+#include <stdlib.h>
+
+struct ut_context {
+    ut_error_message_handler	handler;	/* NULL => thread's or process's */
+    ut_status			status;		/* of last call */
+};
+
+/*
+ * State of the calling thread that's replaced during a call through a context.
+ */
+typedef struct {
+    ut_error_message_handler	handler;
+    ut_status			status;
+    int				haveHandler;
+} Saved;
+
+
+/*
+ * Prepares the calling thread for a call through a context.
+ *
+ * Arguments:
+ *	context		Pointer to the context.
+ *	saved		Pointer to the saved state of the calling thread.
+ */
+static void
+enter(
+    const ut_context* const	context,
+    Saved* const		saved)
+{
+    saved->status = ut_get_status();
+    saved->haveHandler = context->handler != NULL;
+
+    if (saved->haveHandler)
+	saved->handler = ut_set_thread_error_message_handler(context->handler);
+}
+
+
+/*
+ * Finishes a call through a context:  saves the status of the call in the
+ * context and restores the state of the calling thread.
+ *
+ * Arguments:
+ *	context		Pointer to the context.
+ *	saved		Pointer to the saved state of the calling thread.
+ */
+static void
+leave(
+    ut_context* const		context,
+    const Saved* const		saved)
+{
+    context->status = ut_get_status();
+
+    if (saved->haveHandler)
+	(void)ut_set_thread_error_message_handler(saved->handler);
+
+    ut_set_status(saved->status);
+}
+
+
+/*
+ * Handles a NULL context argument.
+ *
+ * Arguments:
+ *	func	Name of the function.
+ */
+static void
+nullContext(
+    const char* const	func)
+{
+    ut_set_status(UT_BAD_ARG);
+    ut_handle_error_message("%s(): NULL context argument", func);
+}
+
+
+/******************************************************************************
+ * Public API:
+ ******************************************************************************/
+
+/*
+ * Returns a new context.  Its status is UT_SUCCESS and it uses the
+ * error-message handler of the calling thread until
+ * ut_set_context_error_message_handler() is called.  The status of the calling
+ * thread is only set on failure.
+ *
+ * Returns:
+ *	NULL	Failure.  "ut_get_status()" will be
+ *		    UT_OS	Operating-system error.  See "errno".
+ *	else	Pointer to the new context.  The client should call
+ *		ut_free_context() when it's no longer needed.
+ */
+ut_context*
+ut_new_context(void)
+{
+    ut_context*	context = malloc(sizeof(ut_context));
+
+    if (context == NULL) {
+	ut_set_status(UT_OS);
+	ut_handle_error_message("ut_new_context(): Couldn't allocate context");
+    }
+    else {
+	context->handler = NULL;
+	context->status = UT_SUCCESS;
+    }
+
+    return context;
+}
+
+
+/*
+ * Frees a context.  Units, unit-systems, and converters that were obtained
+ * through the context are unaffected.
+ *
+ * Arguments:
+ *	context		Pointer to the context or NULL.
+ */
+void
+ut_free_context(
+    ut_context* const	context)
+{
+    free(context);
+}
+
+
+/*
+ * Returns the status of the last call through a context.
+ *
+ * Arguments:
+ *	context		Pointer to the context.
+ * Returns:
+ *	UT_BAD_ARG	"context" is NULL.
+ *	else		The status of the last call through "context".
+ */
+ut_status
+ut_get_context_status(
+    const ut_context* const	context)
+{
+    return context == NULL ? UT_BAD_ARG : context->status;
+}
+
+
+/*
+ * Returns the previous error-message handler of a context and sets a new one.
+ *
+ * Arguments:
+ *	context		Pointer to the context.
+ *	handler		Pointer to the error-message handler for calls through
+ *			"context" or NULL to have them use the handler of the
+ *			calling thread.
+ * Returns:
+ *	NULL		The context used the handler of the calling thread or
+ *			"context" is NULL.
+ *	else		Pointer to the previous handler of the context.
+ */
+ut_error_message_handler
+ut_set_context_error_message_handler(
+    ut_context* const			context,
+    const ut_error_message_handler	handler)
+{
+    ut_error_message_handler	prev = NULL;
+
+    if (context == NULL) {
+	nullContext("ut_set_context_error_message_handler");
+    }
+    else {
+	prev = context->handler;
+	context->handler = handler;
+    }
+
+    return prev;
+}
+
+
+/*
+ * Returns the unit-system corresponding to an XML file like ut_read_xml() but
+ * through a context.
+ *
+ * Arguments:
+ *	context		Pointer to the context.
+ *	path		As for ut_read_xml().
+ * Returns:
+ *	NULL		Failure.  "ut_get_context_status()" will be as for
+ *			ut_read_xml() or UT_BAD_ARG if "context" is NULL, in
+ *			which case "ut_get_status()" will be UT_BAD_ARG.
+ *	else		Pointer to the unit-system defined by "path".
+ */
+ut_system*
+ut_read_xml_r(
+    ut_context* const	context,
+    const char* const	path)
+{
+    ut_system*	system = NULL;
+
+    if (context == NULL) {
+	nullContext("ut_read_xml_r");
+    }
+    else {
+	Saved	saved;
+
+	enter(context, &saved);
+	system = ut_read_xml(path);
+	leave(context, &saved);
+    }
+
+    return system;
+}
+
+
+/*
+ * Returns the unit corresponding to a string like ut_parse() but through a
+ * context.
+ *
+ * Arguments:
+ *	context		Pointer to the context.
+ *	system		As for ut_parse().
+ *	string		As for ut_parse().
+ *	encoding	As for ut_parse().
+ * Returns:
+ *	NULL		Failure.  "ut_get_context_status()" will be as for
+ *			ut_parse() or UT_BAD_ARG if "context" is NULL, in which
+ *			case "ut_get_status()" will be UT_BAD_ARG.
+ *	else		Pointer to the unit corresponding to "string".
+ */
+ut_unit*
+ut_parse_r(
+    ut_context* const		context,
+    const ut_system* const	system,
+    const char* const		string,
+    const ut_encoding		encoding)
+{
+    ut_unit*	unit = NULL;
+
+    if (context == NULL) {
+	nullContext("ut_parse_r");
+    }
+    else {
+	Saved	saved;
+
+	enter(context, &saved);
+	unit = ut_parse(system, string, encoding);
+	leave(context, &saved);
+    }
+
+    return unit;
+}
+
+
+/*
+ * Formats a unit like ut_format() but through a context.
+ *
+ * Arguments:
+ *	context		Pointer to the context.
+ *	unit		As for ut_format().
+ *	buf		As for ut_format().
+ *	size		As for ut_format().
+ *	opts		As for ut_format().
+ * Returns:
+ *	-1		Failure.  "ut_get_context_status()" will be as for
+ *			ut_format() or UT_BAD_ARG if "context" is NULL, in
+ *			which case "ut_get_status()" will be UT_BAD_ARG.
+ *	else		As for ut_format().
+ */
+int
+ut_format_r(
+    ut_context* const		context,
+    const ut_unit* const	unit,
+    char*			buf,
+    size_t			size,
+    unsigned			opts)
+{
+    int		nchar = -1;
+
+    if (context == NULL) {
+	nullContext("ut_format_r");
+    }
+    else {
+	Saved	saved;
+
+	enter(context, &saved);
+	nchar = ut_format(unit, buf, size, opts);
+	leave(context, &saved);
+    }
+
+    return nchar;
+}
+
+
+/*
+ * Returns a converter of numeric values between two units like
+ * ut_get_converter() but through a context.
+ *
+ * Arguments:
+ *	context		Pointer to the context.
+ *	from		As for ut_get_converter().
+ *	to		As for ut_get_converter().
+ * Returns:
+ *	NULL		Failure.  "ut_get_context_status()" will be as for
+ *			ut_get_converter() or UT_BAD_ARG if "context" is NULL,
+ *			in which case "ut_get_status()" will be UT_BAD_ARG.
+ *	else		Pointer to the appropriate converter.
+ */
+cv_converter*
+ut_get_converter_r(
+    ut_context* const	context,
+    ut_unit* const	from,
+    ut_unit* const	to)
+{
+    cv_converter*	converter = NULL;
+
+    if (context == NULL) {
+	nullContext("ut_get_converter_r");
+    }
+    else {
+	Saved	saved;
+
+	enter(context, &saved);
+	converter = ut_get_converter(from, to);
+	leave(context, &saved);
+    }
+
+    return converter;
+}
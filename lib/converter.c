@@ -14,6 +14,7 @@
 #include "config.h"
 
 #include "udunits2.h" // Accommodates Windows & includes "converter.h"
+#include "converterMemory.h"
 
 #include <math.h>
 #include <stddef.h>
@@ -1277,6 +1278,37 @@ cv_free(
 }
 
 
+/*
+ * Returns the number of bytes allocated for a converter, including the
+ * converters of which it's composed.
+ *
+ * Arguments:
+ *	conv	Pointer to the converter or NULL.
+ *	count	Pointer to the number of allocated converters.  Incremented by
+ *		the number of allocated converters of "conv".
+ * Returns:
+ *	The number of bytes allocated for "conv".
+ */
+size_t
+cvGetMemory(
+    const cv_converter* const	conv,
+    size_t* const		count)
+{
+    size_t	nbytes = 0;
+
+    if (conv != NULL && !IS_TRIVIAL(conv) && !IS_RECIPROCAL(conv)) {
+	(*count)++;
+	nbytes = sizeof(cv_converter);
+
+	if (conv->ops == &compositeOps)
+	    nbytes += cvGetMemory(conv->composite.first, count) +
+		cvGetMemory(conv->composite.second, count);
+    }
+
+    return nbytes;
+}
+
+
 /*
  * Converts a float.
  *
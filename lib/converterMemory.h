@@ -0,0 +1,46 @@
+/*
+ * Copyright 2020 University Corporation for Atmospheric Research
+ *
+ * This file is part of the UDUNITS-2 package.  See the file COPYRIGHT
+ * in the top-level source-directory of the package for copying and
+ * redistribution conditions.
+ */
+/*
+ * Library-internal memory accounting of the converter module (see
+ * ut_get_memory_stats()).
+ */
+#ifndef CV_CONVERTER_MEMORY_H_INCLUDED
+#define CV_CONVERTER_MEMORY_H_INCLUDED
+
+#include "converter.h"
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ * Returns the number of bytes allocated for a converter, including the
+ * converters of which it's composed.  The trivial and reciprocal converters
+ * are static and so take no memory.
+ *
+ * Arguments:
+ *	conv	Pointer to the converter or NULL.
+ *	count	Pointer to the number of allocated converters.  Incremented by
+ *		the number of allocated converters of "conv".
+ * Returns:
+ *	The number of bytes allocated for "conv".
+ */
+size_t
+cvGetMemory(
+    const cv_converter* const	conv,
+    size_t* const		count);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
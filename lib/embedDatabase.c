@@ -0,0 +1,167 @@
+/*
+ * Copyright 2020 University Corporation for Atmospheric Research
+ *
+ * This file is part of the UDUNITS-2 package.  See the file COPYRIGHT
+ * in the top-level source-directory of the package for copying and
+ * redistribution conditions.
+ */
+/*
+ * Build-time generator of the compiled-in default unit-database (see
+ * embeddedDatabase.h):
+ *
+ *	embedDatabase <XML_file> <C_file>
+ *
+ * The XML database is read and written as a binary unit-database whose image
+ * becomes the initializer of a byte-array in the C file.  Because the image is
+ * specific to the host, the generator must run on the target; cross-compiling
+ * isn't supported.
+ */
+
+#include "config.h"
+
+#include "udunits2.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Writes the C definitions of an image.
+ *
+ * Returns:
+ *	 0	Success.
+ *	-1	Failure.  See "errno".
+ */
+static int
+writeSource(
+    const unsigned char* const	image,
+    const size_t		size,
+    FILE* const			out,
+    const char* const		xmlPath)
+{
+    size_t	i;
+
+    (void)fprintf(out,
+	"/*\n"
+	" * Generated by embedDatabase from \"%s\".  Don't edit.\n"
+	" */\n"
+	"#include \"embeddedDatabase.h\"\n"
+	"\n"
+	"static const union {\n"
+	"    unsigned char\tbytes[%lu];\n"
+	"    double\t\talign;\n"
+	"} image = {{\n", xmlPath, (unsigned long)size);
+
+    for (i = 0; i < size; i++)
+	(void)fprintf(out, i % 12 == 0 ? "    0x%02x," : " 0x%02x,%s", image[i],
+	    i % 12 == 11 ? "\n" : "");
+
+    (void)fprintf(out,
+	"%s}};\n"
+	"\n"
+	"const unsigned char* const\tutEmbeddedDatabase = image.bytes;\n"
+	"const size_t\t\t\tutEmbeddedDatabaseSize = sizeof(image.bytes);\n",
+	size % 12 == 0 ? "" : "\n");
+
+    return ferror(out) ? -1 : 0;
+}
+
+
+/*
+ * Returns the contents of a file.
+ *
+ * Returns:
+ *	NULL	Failure.  See "errno".
+ *	else	Pointer to the contents.  The caller should free() it.
+ */
+static unsigned char*
+readFile(
+    const char* const	path,
+    size_t* const	size)
+{
+    unsigned char*	data = NULL;
+    FILE*		file = fopen(path, "rb");
+
+    if (file != NULL) {
+	if (fseek(file, 0, SEEK_END) == 0) {
+	    const long	length = ftell(file);
+
+	    if (length > 0 && fseek(file, 0, SEEK_SET) == 0) {
+		data = malloc((size_t)length);
+
+		if (data != NULL &&
+			fread(data, 1, (size_t)length, file) != (size_t)length) {
+		    free(data);
+		    data = NULL;
+		}
+
+		*size = (size_t)length;
+	    }
+	}
+
+	(void)fclose(file);
+    }
+
+    return data;
+}
+
+
+int
+main(
+    const int		argc,
+    const char* const*	argv)
+{
+    int		exitStatus = EXIT_FAILURE;
+
+    if (argc != 3) {
+	(void)fprintf(stderr, "Usage: %s <XML_file> <C_file>\n", argv[0]);
+    }
+    else {
+	ut_system*	system;
+
+	(void)ut_set_error_message_handler(ut_ignore);
+	system = ut_read_xml(argv[1]);
+	(void)ut_set_error_message_handler(ut_write_to_stderr);
+
+	if (system == NULL) {
+	    (void)fprintf(stderr, "%s: Couldn't read \"%s\"\n", argv[0],
+		argv[1]);
+	}
+	else {
+	    char* const	binPath = malloc(strlen(argv[2]) + 5);
+
+	    if (binPath != NULL) {
+		(void)strcat(strcpy(binPath, argv[2]), ".bin");
+
+		if (ut_write_binary(system, binPath) == UT_SUCCESS) {
+		    size_t		size;
+		    unsigned char*	image = readFile(binPath, &size);
+		    FILE*		out = image == NULL
+			? NULL
+			: fopen(argv[2], "w");
+
+		    if (out == NULL) {
+			(void)fprintf(stderr, "%s: %s\n", argv[0],
+			    strerror(errno));
+		    }
+		    else {
+			if (writeSource(image, size, out, argv[1]) == 0)
+			    exitStatus = EXIT_SUCCESS;
+			if (fclose(out) != 0)
+			    exitStatus = EXIT_FAILURE;
+		    }
+
+		    free(image);
+		    (void)remove(binPath);
+		}
+
+		free(binPath);
+	    }
+
+	    ut_free_system(system);
+	}
+    }
+
+    return exitStatus;
+}
@@ -0,0 +1,38 @@
+/*
+ * Copyright 2020 University Corporation for Atmospheric Research
+ *
+ * This file is part of the UDUNITS-2 package.  See the file COPYRIGHT
+ * in the top-level source-directory of the package for copying and
+ * redistribution conditions.
+ */
+/*
+ * The default unit-database compiled into the library.  It exists only if the
+ * library was built with the UDUNITS_EMBED_DATABASE option, in which case
+ * UT_EMBEDDED_DATABASE is defined and embedDatabase.c generated the
+ * definitions.
+ */
+#ifndef UT_EMBEDDED_DATABASE_H_INCLUDED
+#define UT_EMBEDDED_DATABASE_H_INCLUDED
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Image of the binary unit-database (see ut_write_binary()).  Aligned for a
+ * "double".
+ */
+extern const unsigned char* const	utEmbeddedDatabase;
+
+/*
+ * Size of "utEmbeddedDatabase" in bytes.
+ */
+extern const size_t			utEmbeddedDatabaseSize;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
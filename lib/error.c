@@ -6,8 +6,9 @@
  * redistribution conditions.
  */
 /*
- * This module is thread-compatible but not thread-safe.  Multi-threaded
- * access must be externally synchronized.
+ * Error-message handling.  There's a handler for the whole process and each
+ * thread may override it with its own handler.  The process-wide handler
+ * should be set before other threads are started.
  */
 
 /*LINTLIBRARY*/
@@ -15,6 +16,7 @@
 #include "config.h"
 
 #include "udunits2.h"
+#include "errorMessages.h"
 
 #include <stdarg.h>
 #include <stdio.h>
@@ -63,12 +65,33 @@ ut_ignore(
 }
 
 
+#ifndef UT_THREAD_LOCAL
+#   define UT_THREAD_LOCAL
+#endif
+
+/*
+ * The handler of the process and the calling thread's override of it (NULL if
+ * the thread uses the handler of the process).
+ */
 static ut_error_message_handler	errorMessageHandler = ut_write_to_stderr;
+static UT_THREAD_LOCAL ut_error_message_handler	threadHandler = NULL;
+
+
+/*
+ * Returns the error-message handler of the calling thread.
+ */
+static ut_error_message_handler
+getHandler(void)
+{
+    return threadHandler != NULL ? threadHandler : errorMessageHandler;
+}
 
 
 /*
- * Returns the previously-installed error-message handler and optionally
- * installs a new handler.  The initial handler is "ut_write_to_stderr()".
+ * Returns the previously-installed error-message handler of the process and
+ * optionally installs a new one.  The initial handler is "ut_write_to_stderr()".
+ * Threads that have their own handler (see
+ * ut_set_thread_error_message_handler()) aren't affected.
  *
  * Arguments:
  *      handler		NULL or pointer to the error-message handler.  If NULL,
@@ -91,7 +114,33 @@ ut_set_error_message_handler(
 
 
 /*
- * Handles an error-message.
+ * Sets or removes the calling thread's own error-message handler, which
+ * overrides the handler of the process (see ut_set_error_message_handler())
+ * for the calling thread only.
+ *
+ * Arguments:
+ *      handler		Pointer to the error-message handler of the calling
+ *			thread or NULL to have the thread use the handler of the
+ *			process again.
+ * Returns:
+ *	NULL		The calling thread didn't have its own handler.
+ *	else		Pointer to the previous handler of the calling thread.
+ */
+ut_error_message_handler
+ut_set_thread_error_message_handler(
+    ut_error_message_handler	handler)
+{
+    ut_error_message_handler	prev = threadHandler;
+
+    threadHandler = handler;
+
+    return prev;
+}
+
+
+/*
+ * Handles an error-message.  Does nothing if error-messages are discarded (see
+ * errMessagesWanted()).
  *
  * Arguments:
  *	fmt	The format for the error-message.
@@ -99,21 +148,46 @@ ut_set_error_message_handler(
  * Returns:
  *	<0	An output error was encountered.
  *	else	The number of bytes of "fmt" and "arg" written excluding any
- *		terminating NUL.
+ *		terminating NUL.  0 if the message was discarded.
  */
 int
 ut_handle_error_message(
     const char* const	fmt,
     ...)
 {
-    int			nbytes;
-    va_list		args;
+    int			nbytes = 0;
+
+    if (errMessagesWanted()) {
+	va_list		args;
 
-    va_start(args, fmt);
+	va_start(args, fmt);
 
-    nbytes = errorMessageHandler(fmt, args);
+	nbytes = getHandler()(fmt, args);
 
-    va_end(args);
+	va_end(args);
+    }
 
     return nbytes;
 }
+
+
+/*
+ * Indicates if error-messages are wanted by the calling thread.  The message
+ * arguments are passed to the handler unformatted, so the only cost of a
+ * discarded message is the call of ut_handle_error_message().
+ *
+ * Returns:
+ *	0	Error-messages are discarded: the library was built without them
+ *		(UT_NO_ERROR_MESSAGES) or the calling thread's handler is
+ *		ut_ignore().
+ *	else	Error-messages are wanted.
+ */
+int
+errMessagesWanted(void)
+{
+#ifdef UT_NO_ERROR_MESSAGES
+    return 0;
+#else
+    return getHandler() != ut_ignore;
+#endif
+}
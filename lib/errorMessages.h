@@ -0,0 +1,38 @@
+/*
+ * Copyright 2020 University Corporation for Atmospheric Research
+ *
+ * This file is part of the UDUNITS-2 package.  See the file COPYRIGHT
+ * in the top-level source-directory of the package for copying and
+ * redistribution conditions.
+ */
+/*
+ * Internal interface of the error-message module (error.c).
+ */
+#ifndef UT_ERROR_MESSAGES_H_INCLUDED
+#define UT_ERROR_MESSAGES_H_INCLUDED
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ * Indicates if error-messages are wanted by the calling thread, i.e., if
+ * ut_handle_error_message() would pass a message to a handler.  Code that must do work to compose a
+ * message (e.g., format a unit) should do it only if this function returns
+ * true.
+ *
+ * Returns:
+ *	0	Error-messages are discarded: the library was built without them
+ *		or the calling thread's handler is ut_ignore().
+ *	else	Error-messages are wanted.
+ */
+int
+errMessagesWanted(void);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
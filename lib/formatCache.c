@@ -0,0 +1,625 @@
+/*
+ * Copyright 2020 University Corporation for Atmospheric Research
+ *
+ * This file is part of the UDUNITS-2 package.  See the file COPYRIGHT
+ * in the top-level source-directory of the package for copying and
+ * redistribution conditions.
+ */
+/*
+ * Cache of formatted units of a unit-system.
+ *
+ * Entries are keyed on the hash-value of a unit and the formatting options.
+ * Changing the identifiers to which a unit maps makes stale only the entries
+ * whose formatting uses that unit (see fcInvalidate()).  A stale entry is
+ * formatted anew on its next look-up.  If that yields a different string, then
+ * the previous one is kept by the entry -- and freed with it and its clone of
+ * the unit -- so that the strings returned by ut_get_format() stay valid; a
+ * string that the entry already had is returned again rather than kept twice.
+ *
+ * This module is thread-safe: a cache has its own lock.
+ */
+
+/*LINTLIBRARY*/
+
+#include "config.h"
+
+#include "udunits2.h"
+#include "formatCache.h"		/* this module's API */
+#include "hashTable.h"
+#include "unitcore.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+
+typedef SRWLOCK			Lock;
+#   define LOCK_INIT(lock)	InitializeSRWLock(lock)
+#   define LOCK_DESTROY(lock)
+#   define LOCK(lock)		AcquireSRWLockExclusive(lock)
+#   define UNLOCK(lock)		ReleaseSRWLockExclusive(lock)
+#else
+#include <pthread.h>
+
+typedef pthread_mutex_t		Lock;
+#   define LOCK_INIT(lock)	(void)pthread_mutex_init(lock, NULL)
+#   define LOCK_DESTROY(lock)	(void)pthread_mutex_destroy(lock)
+#   define LOCK(lock)		(void)pthread_mutex_lock(lock)
+#   define UNLOCK(lock)		(void)pthread_mutex_unlock(lock)
+#endif
+
+typedef struct Superseded {
+    struct Superseded*	next;
+    char*		string;
+} Superseded;
+
+typedef struct {
+    ut_unit*		unit;		/* clone of the formatted unit */
+    unsigned		opts;		/* formatting options */
+    char*		string;		/* formatted unit */
+    Superseded*		superseded;	/* previous strings of the entry */
+    int			stale;		/* set by fcInvalidate() */
+} FormatEntry;
+
+typedef struct {
+    HashTable*		table;
+    unsigned long	generation;	/* incremented by fcInvalidate() */
+    Lock		lock;		/* guards the above */
+} FormatCache;
+
+
+static int
+compareEntries(
+    const void* const	key,
+    const void* const	entry)
+{
+    const FormatEntry* const	entry1 = (const FormatEntry*)key;
+    const FormatEntry* const	entry2 = (const FormatEntry*)entry;
+
+    return entry1->opts != entry2->opts ||
+	ut_compare(entry1->unit, entry2->unit) != 0;
+}
+
+
+static void
+freeEntry(
+    void* const	entry)
+{
+    FormatEntry* const	formatEntry = (FormatEntry*)entry;
+
+    while (formatEntry->superseded != NULL) {
+	Superseded* const	next = formatEntry->superseded->next;
+
+	free(formatEntry->superseded->string);
+	free(formatEntry->superseded);
+	formatEntry->superseded = next;
+    }
+
+    ut_free(formatEntry->unit);
+    free(formatEntry->string);
+    free(formatEntry);
+}
+
+
+static FormatCache*
+getCache(
+    const ut_system* const	system)
+{
+    return *(FormatCache**)coreGetSystemMap(system, SYSTEM_FORMAT_CACHE);
+}
+
+
+/*
+ * Returns the hash-value of a unit and formatting options.
+ */
+static uint64_t
+hashKey(
+    const ut_unit* const	unit,
+    const unsigned		opts)
+{
+    return htHashMix(coreHash(unit), opts);
+}
+
+
+/*
+ * Returns a formatted unit in newly-allocated memory.
+ *
+ * Arguments:
+ *	unit		Pointer to the unit.
+ *	opts		Formatting options.  See ut_format().
+ * Returns:
+ *	NULL		Failure.  "ut_get_status()" will be as for ut_format()
+ *			or UT_OS.
+ *	else		Pointer to the formatted unit.  The caller should free
+ *			it.
+ */
+static char*
+formatNew(
+    const ut_unit* const	unit,
+    const unsigned		opts)
+{
+    char	buf[256];
+    char*	string = NULL;
+    const int	nchar = ut_format(unit, buf, sizeof(buf), opts);
+
+    if (nchar >= 0) {
+	string = malloc((size_t)nchar + 1);
+
+	if (string == NULL) {
+	    ut_set_status(UT_OS);
+	    ut_handle_error_message(strerror(errno));
+	    ut_handle_error_message(
+		"Couldn't allocate %d-byte formatted unit", nchar + 1);
+	}
+	else if ((size_t)nchar < sizeof(buf)) {
+	    (void)memcpy(string, buf, (size_t)nchar + 1);
+	}
+	else {
+	    (void)ut_format(unit, string, (size_t)nchar + 1, opts);
+	}
+    }
+
+    return string;
+}
+
+
+/*
+ * Brings a stale entry up to date with a string formatted anew.  The current
+ * string of the entry is kept unless it's the same.  The cache shall be locked.
+ *
+ * Arguments:
+ *	entry		Pointer to the entry.
+ *	string		Pointer to the formatted unit.  Belongs to the entry
+ *			on success.
+ * Returns:
+ *	NULL		Failure.  See "errno".
+ *	else		Pointer to the current string of the entry.  Might be
+ *			an earlier string of the entry rather than "string",
+ *			which is then freed.
+ */
+static const char*
+update(
+    FormatEntry* const	entry,
+    char* const		string)
+{
+    Superseded*	superseded;
+
+    if (strcmp(entry->string, string) == 0) {
+	free(string);
+    }
+    else {
+	for (superseded = entry->superseded; superseded != NULL;
+		superseded = superseded->next) {
+	    if (strcmp(superseded->string, string) == 0)
+		break;
+	}
+
+	if (superseded != NULL) {
+	    /*
+	     * The entry had the string before: swap it back in.
+	     */
+	    char* const	previous = superseded->string;
+
+	    free(string);
+	    superseded->string = entry->string;
+	    entry->string = previous;
+	}
+	else {
+	    superseded = malloc(sizeof(Superseded));
+
+	    if (superseded == NULL)
+		return NULL;
+
+	    superseded->string = entry->string;
+	    superseded->next = entry->superseded;
+	    entry->superseded = superseded;
+	    entry->string = string;
+	}
+    }
+
+    return entry->string;
+}
+
+
+/*
+ * Adds a formatted unit to a cache or brings a stale entry up to date.  The
+ * cache shall be locked.
+ *
+ * Arguments:
+ *	cache		Pointer to the cache.
+ *	unit		Pointer to the unit.
+ *	opts		Formatting options.
+ *	string		Pointer to the formatted unit.  Belongs to the cache
+ *			on success.
+ *	generation	The generation of the cache when "string" was
+ *			formatted.  If the cache has been invalidated since,
+ *			then the entry is left stale.
+ * Returns:
+ *	NULL		Failure.  "ut_get_status()" will be UT_OS.
+ *	else		Pointer to the cached string.  Might differ from
+ *			"string", which is then freed.
+ */
+static const char*
+addEntry(
+    FormatCache* const		cache,
+    const ut_unit* const	unit,
+    const unsigned		opts,
+    char* const			string,
+    const unsigned long		generation)
+{
+    const char*		cached = NULL;	/* failure */
+    FormatEntry		key;
+    FormatEntry**	found;
+
+    key.unit = (ut_unit*)unit;
+    key.opts = opts;
+    found = (FormatEntry**)htFind(cache->table, hashKey(unit, opts), &key,
+	compareEntries);
+
+    if (found != NULL) {
+	FormatEntry* const	entry = *found;
+
+	if (!entry->stale) {
+	    /*
+	     * Another thread got here first.
+	     */
+	    free(string);
+	    cached = entry->string;
+	}
+	else if ((cached = update(entry, string)) != NULL) {
+	    entry->stale = generation != cache->generation;
+	}
+    }
+    else {
+	FormatEntry* const	entry = malloc(sizeof(FormatEntry));
+
+	if (entry != NULL) {
+	    entry->unit = ut_clone(unit);
+
+	    if (entry->unit == NULL) {
+		free(entry);
+	    }
+	    else {
+		entry->opts = opts;
+		entry->string = string;
+		entry->superseded = NULL;
+		entry->stale = generation != cache->generation;
+
+		if (htSearch(cache->table, hashKey(unit, opts), entry,
+			compareEntries) == NULL) {
+		    ut_free(entry->unit);
+		    free(entry);
+		}
+		else {
+		    cached = string;
+		}
+	    }
+	}
+    }
+
+    if (cached == NULL) {
+	ut_set_status(UT_OS);
+	ut_handle_error_message(strerror(errno));
+	ut_handle_error_message("Couldn't cache formatted unit");
+	free(string);
+    }
+
+    return cached;
+}
+
+
+/******************************************************************************
+ * Public API:
+ ******************************************************************************/
+
+
+/*
+ * Enables the caching of formatted units of a unit-system by ut_get_format().
+ * Enabling an enabled cache has no effect.  Shall be called before the
+ * unit-system is shared between threads.
+ *
+ * Arguments:
+ *	system		Pointer to the unit-system.  May be frozen.
+ * Returns:
+ *	UT_SUCCESS	Success.
+ *	UT_BAD_ARG	"system" is NULL.
+ *	UT_OS		Operating-system error.  See "errno".
+ */
+ut_status
+ut_enable_format_cache(
+    ut_system* const	system)
+{
+    ut_set_status(UT_SUCCESS);
+
+    if (system == NULL) {
+	ut_set_status(UT_BAD_ARG);
+	ut_handle_error_message("ut_enable_format_cache(): NULL unit-system");
+    }
+    else {
+	FormatCache** const	slot =
+	    (FormatCache**)coreGetSystemMap(system, SYSTEM_FORMAT_CACHE);
+
+	if (*slot == NULL) {
+	    FormatCache* const	cache = calloc(1, sizeof(FormatCache));
+
+	    if (cache == NULL || (cache->table = htNew()) == NULL) {
+		ut_set_status(UT_OS);
+		ut_handle_error_message(strerror(errno));
+		ut_handle_error_message(
+		    "ut_enable_format_cache(): Couldn't create cache");
+		free(cache);
+	    }
+	    else {
+		LOCK_INIT(&cache->lock);
+		*slot = cache;
+	    }
+	}
+    }
+
+    return ut_get_status();
+}
+
+
+/*
+ * Returns a unit formatted as by ut_format().  The string is formatted once
+ * and cached by the unit-system of the unit; later calls with an equal unit and
+ * the same options return the same string without formatting the unit.
+ * Mapping or unmapping an identifier of the unit, or of a unit from which it's
+ * formed, makes the next call format the unit anew.  This function may be
+ * called concurrently for the units of a frozen unit-system.
+ *
+ * Arguments:
+ *	unit		Pointer to the unit.  Its unit-system shall have been
+ *			passed to ut_enable_format_cache().
+ *	opts		Formatting options.  See ut_format().
+ * Returns:
+ *	NULL		Failure.  "ut_get_status()" will be
+ *			    UT_BAD_ARG		"unit" is NULL, the format cache
+ *						of its unit-system isn't
+ *						enabled, or both UT_LATIN1 and
+ *						UT_UTF8 are specified.
+ *			    UT_CANT_FORMAT	"unit" can't be formatted in
+ *						the desired manner.
+ *			    UT_OS		Operating-system error.  See
+ *						"errno".
+ *	else		Pointer to the formatted unit.  It belongs to the
+ *			unit-system and is valid until the unit-system is
+ *			freed.  Unless the identifiers of the unit change, it's
+ *			the string returned by earlier calls.
+ */
+const char*
+ut_get_format(
+    const ut_unit* const	unit,
+    const unsigned		opts)
+{
+    const char*		string = NULL;	/* failure */
+
+    ut_set_status(UT_SUCCESS);
+
+    if (unit == NULL) {
+	ut_set_status(UT_BAD_ARG);
+	ut_handle_error_message("ut_get_format(): NULL unit argument");
+    }
+    else {
+	FormatCache* const	cache = getCache(ut_get_system(unit));
+
+	if (cache == NULL) {
+	    ut_set_status(UT_BAD_ARG);
+	    ut_handle_error_message(
+		"ut_get_format(): Format cache of unit-system isn't enabled");
+	}
+	else {
+	    FormatEntry		key;
+	    FormatEntry**	found;
+	    unsigned long	generation;
+
+	    key.unit = (ut_unit*)unit;
+	    key.opts = opts;
+
+	    LOCK(&cache->lock);
+	    found = (FormatEntry**)htFind(cache->table, hashKey(unit, opts),
+		&key, compareEntries);
+	    generation = cache->generation;
+
+	    if (found != NULL && !(*found)->stale)
+		string = (*found)->string;
+	    UNLOCK(&cache->lock);
+
+	    if (string == NULL) {
+		/*
+		 * The unit is formatted without holding the lock so that
+		 * other threads aren't blocked.
+		 */
+		char* const	formatted = formatNew(unit, opts);
+
+		if (formatted != NULL) {
+		    LOCK(&cache->lock);
+		    string = addEntry(cache, unit, opts, formatted, generation);
+		    UNLOCK(&cache->lock);
+		}
+	    }
+	}
+    }
+
+    return string;
+}
+
+
+/******************************************************************************
+ * Library-internal API:
+ ******************************************************************************/
+
+
+/*
+ * Indicates whether formatting a unit uses the identifiers of another unit:
+ * the unit itself, the unit underlying it, or a basic-unit of its product.
+ *
+ * Arguments:
+ *	unit		Pointer to the unit.
+ *	changed		Pointer to the other unit.
+ *	basic		Index of "changed" if it's a basic-unit; otherwise, -1.
+ * Returns:
+ *	0		No.
+ *	else		Yes.
+ */
+static int
+usesUnit(
+    const ut_unit* const	unit,
+    const ut_unit* const	changed,
+    const int			basic)
+{
+    CoreUnitDescription	description;
+    int			uses = ut_compare(unit, changed) == 0;
+
+    if (!uses) {
+	coreDescribeUnit(unit, &description);
+
+	switch (description.kind) {
+	case CORE_BASIC:
+	    break;
+	case CORE_PRODUCT: {
+	    int	i;
+
+	    for (i = 0; !uses && i < description.count; i++)
+		uses = description.indexes[i] == basic;
+	    break;
+	}
+	default:
+	    uses = usesUnit(description.unit, changed, basic);
+	    break;
+	}
+    }
+
+    return uses;
+}
+
+
+typedef struct {
+    const ut_unit*	unit;
+    int			basic;
+} Invalidation;
+
+
+static int
+invalidateEntry(
+    void* const	entry,
+    void* const	arg)
+{
+    FormatEntry* const		formatEntry = (FormatEntry*)entry;
+    const Invalidation* const	invalidation = (const Invalidation*)arg;
+
+    if (!formatEntry->stale && usesUnit(formatEntry->unit, invalidation->unit,
+	    invalidation->basic))
+	formatEntry->stale = 1;
+
+    return 0;
+}
+
+
+/*
+ * Makes stale the cached strings of a unit-system whose formatting uses the
+ * identifiers of a unit.
+ *
+ * Arguments:
+ *	unit		Pointer to the unit whose identifiers changed.
+ */
+void
+fcInvalidate(
+    const ut_unit* const	unit)
+{
+    FormatCache* const	cache = getCache(ut_get_system(unit));
+
+    if (cache != NULL) {
+	CoreUnitDescription	description;
+	Invalidation		invalidation;
+
+	coreDescribeUnit(unit, &description);
+	invalidation.unit = unit;
+	invalidation.basic = description.kind == CORE_BASIC
+	    ? description.index
+	    : -1;
+
+	LOCK(&cache->lock);
+	cache->generation++;
+	(void)htWalk(cache->table, invalidateEntry, &invalidation);
+	UNLOCK(&cache->lock);
+    }
+}
+
+
+static int
+addEntryMemory(
+    void* const	entry,
+    void* const	arg)
+{
+    const FormatEntry* const	formatEntry = (const FormatEntry*)entry;
+    ut_memory_stats* const	stats = (ut_memory_stats*)arg;
+    const Superseded*		superseded;
+
+    stats->formats.bytes += sizeof(FormatEntry) +
+	strlen(formatEntry->string) + 1;
+    stats->formats.count++;
+
+    for (superseded = formatEntry->superseded; superseded != NULL;
+	    superseded = superseded->next) {
+	stats->formats.bytes += sizeof(Superseded) +
+	    strlen(superseded->string) + 1;
+	stats->formats.count++;
+    }
+
+    coreAddUnitMemory(formatEntry->unit, stats);
+
+    return 0;
+}
+
+
+/*
+ * Adds the memory of the format cache of a unit-system to the memory
+ * statistics of the unit-system.
+ *
+ * Arguments:
+ *	system		Pointer to the unit-system.
+ *	stats		Pointer to the statistics to be augmented.
+ */
+void
+fcGetMemory(
+    const ut_system* const	system,
+    ut_memory_stats* const	stats)
+{
+    FormatCache* const	cache = getCache(system);
+
+    if (cache != NULL) {
+	LOCK(&cache->lock);
+	stats->formats.bytes += sizeof(FormatCache) +
+	    htGetMemory(cache->table);
+	(void)htWalk(cache->table, addEntryMemory, stats);
+	UNLOCK(&cache->lock);
+    }
+}
+
+
+/*
+ * Frees the format cache of a unit-system.
+ *
+ * Arguments:
+ *	system		Pointer to the unit-system.
+ */
+void
+fcFreeSystem(
+    ut_system*	system)
+{
+    if (system != NULL) {
+	FormatCache** const	slot =
+	    (FormatCache**)coreGetSystemMap(system, SYSTEM_FORMAT_CACHE);
+	FormatCache* const	cache = *slot;
+
+	if (cache != NULL) {
+	    htFree(cache->table, freeEntry);
+	    LOCK_DESTROY(&cache->lock);
+	    free(cache);
+	    *slot = NULL;
+	}
+    }
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright 2020 University Corporation for Atmospheric Research
+ *
+ * This file is part of the UDUNITS-2 package.  See the file COPYRIGHT
+ * in the top-level source-directory of the package for copying and
+ * redistribution conditions.
+ */
+/*
+ * Cache of formatted units of a unit-system (see ut_enable_format_cache()).
+ */
+#ifndef UT_FORMAT_CACHE_H_INCLUDED
+#define UT_FORMAT_CACHE_H_INCLUDED
+
+#include "udunits2.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ * Makes stale the cached strings of the unit-system of a unit whose formatting
+ * uses the identifiers of the unit because those identifiers have changed.
+ * Other cached strings are unaffected.  Strings that were returned by
+ * ut_get_format() remain valid.
+ *
+ * Arguments:
+ *	unit		Pointer to the unit whose identifiers changed.
+ */
+void
+fcInvalidate(
+    const ut_unit* const	unit);
+
+
+/*
+ * Adds the memory of the format cache of a unit-system to the memory
+ * statistics of the unit-system (see ut_get_memory_stats()).
+ *
+ * Arguments:
+ *	system		Pointer to the unit-system.
+ *	stats		Pointer to the statistics to be augmented.
+ */
+void
+fcGetMemory(
+    const ut_system* const	system,
+    ut_memory_stats* const	stats);
+
+
+/*
+ * Frees the format cache of a unit-system.
+ *
+ * Arguments:
+ *	system		Pointer to the unit-system to have its format cache
+ *			freed.
+ */
+void
+fcFreeSystem(
+    ut_system*	system);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
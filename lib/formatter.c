@@ -20,6 +20,7 @@
 #endif
 
 #include <ctype.h>
+#include <errno.h>
 #include <float.h>
 #include <limits.h>
 #include <math.h>
@@ -132,6 +133,75 @@ getSymbol(
 }
 
 
+/*
+ * Initializes the parameters for formatting units.  The parameters may be used
+ * to format any number of units.
+ *
+ * Arguments:
+ *	formatPar	Pointer to the formatting parameters to be initialized.
+ *	useNames	Use unit names rather than unit symbols.
+ *	getDefinition	Returns the definition of a unit in terms of basic
+ *			units.
+ *	encoding	The type of encoding to use.
+ *	addParens	Whether or not to add bracketing parentheses if
+ *			whitespace is printed.
+ */
+static void
+initFormatPar(
+    FormatPar* const	        formatPar,
+    const int		        useNames,
+    const int		        getDefinition,
+    const ut_encoding	        encoding,
+    const int		        addParens)
+{
+    formatPar->buf = NULL;
+    formatPar->size = 0;
+    formatPar->getId = useNames ? getName : getSymbol;
+    formatPar->getDefinition = getDefinition;
+    formatPar->encoding = encoding;
+    formatPar->printProduct =
+	encoding == UT_ASCII
+	    ? asciiPrintProduct
+	    : encoding == UT_LATIN1
+		? latin1PrintProduct
+		: utf8PrintProduct;
+    formatPar->addParens = addParens;
+    formatPar->nchar = 0;
+}
+
+
+/*
+ * Formats a unit using initialized formatting parameters.
+ *
+ * Arguments:
+ *	unit		Pointer to the unit to be formatted.  Shall not be NULL.
+ *	formatPar	Pointer to the formatting parameters.
+ *	buf		Pointer to the buffer into which to print the formatted
+ *			unit.  Shall not be NULL.
+ *	size		Size of the buffer.
+ * Returns:
+ *	-1	        Failure.
+ *	else	        Success. Number of bytes that would be printed if
+ *	                "size" were sufficiently large excluding the
+ *	                terminating NUL.
+ */
+static int
+formatWith(
+    const ut_unit* const	unit,
+    FormatPar* const	        formatPar,
+    char* const		        buf,
+    const size_t	        size)
+{
+    formatPar->buf = buf;
+    formatPar->size = size;
+    formatPar->nchar = 0;
+
+    return ut_accept_visitor(unit, &formatter, formatPar) == UT_SUCCESS
+	? formatPar->nchar
+	: -1;
+}
+
+
 /*
  * Formats a unit.
  *
@@ -176,22 +246,9 @@ format(
     else {
 	FormatPar	formatPar;
 
-	formatPar.buf = buf;
-	formatPar.size = size;
-	formatPar.getId = useNames ? getName : getSymbol;
-	formatPar.getDefinition = getDefinition;
-	formatPar.encoding = encoding;
-	formatPar.printProduct =
-	    encoding == UT_ASCII
-		? asciiPrintProduct
-		: encoding == UT_LATIN1
-		    ? latin1PrintProduct
-		    : utf8PrintProduct;
-	formatPar.addParens = addParens;
-	formatPar.nchar = 0;
-
-	if (ut_accept_visitor(unit, &formatter, &formatPar) == UT_SUCCESS)
-	    nchar = formatPar.nchar;
+	initFormatPar(&formatPar, useNames, getDefinition, encoding, addParens);
+
+	nchar = formatWith(unit, &formatPar, buf, size);
     }
 
     return nchar;
@@ -464,36 +521,30 @@ utf8PrintProduct(
                      * Append UTF-8 encoding of exponent magnitude.
                      */
                     {
-                        static int*	digit = NULL;
-
-                        digit = realloc(digit, (size_t)((sizeof(powers[0])*
-                                        CHAR_BIT*(M_LOG10E/M_LOG2E)) + 1));
-
-                        if (digit == NULL) {
-                            nchar = -1;
-                        }
-                        else {
-                            int	idig = 0;
-
-                            for (; power > 0; power /= 10)
-                                digit[idig++] = power % 10;
+                        /*
+                         * A decimal digit needs at least one bit.
+                         */
+                        int	digit[sizeof(powers[0])*CHAR_BIT];
+                        int	idig = 0;
 
-                            while (idig-- > 0) {
-                                n = snprintf(buf+nchar, size, "%s",
-                                        exponentStrings[digit[idig]]);
+                        for (; power > 0; power /= 10)
+                            digit[idig++] = power % 10;
 
-                                if (n < 0) {
-                                    nchar = n;
-                                    break;
-                                }
+                        while (idig-- > 0) {
+                            n = snprintf(buf+nchar, size, "%s",
+                                    exponentStrings[digit[idig]]);
 
-                                nchar += n;
-                                size = SUBTRACT_SIZET(size, n);
+                            if (n < 0) {
+                                nchar = n;
+                                break;
                             }
 
-                            if (nchar < 0)
-                                break;
+                            nchar += n;
+                            size = SUBTRACT_SIZET(size, n);
                         }
+
+                        if (nchar < 0)
+                            break;
                     }		/* exponent digits block */
                 }		/* must print exponent */
             }			/* must print basic-unit */
@@ -504,18 +555,6 @@ utf8PrintProduct(
 }
 
 
-static const int*	globalPowers = NULL;
-
-
-static int
-compareExponents(
-    const void*	i,
-    const void*	j)
-{
-    return globalPowers[*(const int*)j] - globalPowers[*(const int*)i];
-}
-
-
 /*
  * Returns the order of basic-unit powers in decreasing order.
  *
@@ -557,9 +596,20 @@ getBasicOrder(
 
     *negativeCount = nNeg;
     *positiveCount = nPos;
-    globalPowers = powers;
 
-    qsort(order, n, sizeof(int), compareExponents);
+    /*
+     * Stable insertion-sort by decreasing power.  There are few basic-units
+     * and this avoids the shared state that qsort(3) would need.
+     */
+    for (i = 1; i < n; i++) {
+	const int	index = order[i];
+	int		j;
+
+	for (j = i; j > 0 && powers[order[j-1]] < powers[index]; j--)
+	    order[j] = order[j-1];
+
+	order[j] = index;
+    }
 }
 
 
@@ -810,8 +860,7 @@ formatProduct(
 	/*
 	 * The dimensionless unit one is special.
 	 */
-	(void)strncpy(formatPar->buf, "1", formatPar->size);
-	nchar = formatPar->size > 0 ? 1 : 0;
+	nchar = snprintf(formatPar->buf, formatPar->size, "%s", "1");
     }
     else {
 	if (formatPar->getDefinition) {
@@ -1364,3 +1413,141 @@ ut_format(
 
     return nchar;
 }
+
+
+/*
+ * Formats units back to back into a single buffer.  The buffer is grown by at
+ * most one reallocation.
+ *
+ * Arguments:
+ *	units		Pointer to the units to be formatted.
+ *	count		Number of units to be formatted.
+ *	opts		Formatting options (see ut_format()).
+ *	buf		Pointer to the pointer to the buffer.  "*buf" may be
+ *			NULL if "*size" is zero; otherwise, it must have been
+ *			allocated by malloc(3) and will be reallocated if it's
+ *			too small.  The client should free(3) "*buf" when it's
+ *			no longer needed.
+ *	size		Pointer to the size of "*buf" in bytes.  Set if "*buf"
+ *			is reallocated.
+ *	offsets		Pointer to "count" offsets.  On return, the NUL-
+ *			terminated string of "units[i]" starts at
+ *			"*buf + offsets[i]" for every "i" less than the
+ *			returned value.
+ * Returns:
+ *	count		Success.
+ *	else		Failure.  The number of units that were formatted
+ *			before the failure.  "ut_get_status()" will be
+ *			    UT_BAD_ARG		"units", "buf", "size", or
+ *						"offsets" is NULL, "*buf" is
+ *						NULL but "*size" isn't zero,
+ *						or both UT_LATIN1 and UT_UTF8
+ *						are specified.
+ *			    UT_BAD_ARG		"units[i]" is NULL, where "i"
+ *						is the returned value.
+ *			    UT_CANT_FORMAT	"units[i]" can't be formatted
+ *						in the desired manner, where
+ *						"i" is the returned value.
+ *			    UT_OS		Operating-system failure.  See
+ *						"errno".
+ */
+size_t
+ut_format_many(
+    const ut_unit* const* const	units,
+    const size_t	        count,
+    const unsigned	        opts,
+    char** const	        buf,
+    size_t* const	        size,
+    size_t* const	        offsets)
+{
+    size_t		nformatted = 0;
+    const ut_encoding	encoding =
+        (ut_encoding)(opts & (unsigned)(UT_ASCII | UT_LATIN1 | UT_UTF8));
+
+    if (units == NULL || buf == NULL || size == NULL || offsets == NULL ||
+            (*buf == NULL && *size != 0)) {
+	ut_set_status(UT_BAD_ARG);
+	ut_handle_error_message("ut_format_many(): Invalid argument");
+    }
+    else if ((encoding & UT_LATIN1) && (encoding & UT_UTF8)) {
+	ut_set_status(UT_BAD_ARG);
+	ut_handle_error_message("Both UT_LATIN1 and UT_UTF8 specified");
+    }
+    else {
+	FormatPar	formatPar;
+	char		empty[1];
+	size_t		length = 0;	/* bytes needed so far */
+	size_t		firstTruncated = count;
+	size_t		i;
+
+	initFormatPar(&formatPar, opts & UT_NAMES, opts & UT_DEFINITION,
+	    encoding, 0);
+
+	/*
+	 * Format each unit into the space that's left.  Once the space is
+	 * exhausted, only measure the remaining units.
+	 */
+	for (i = 0; i < count; i++) {
+	    const size_t	left = SUBTRACT_SIZET(*size, length);
+	    int			nchar;
+
+	    if (units[i] == NULL) {
+		ut_set_status(UT_BAD_ARG);
+		ut_handle_error_message("ut_format_many(): NULL unit");
+		break;
+	    }
+
+	    nchar = firstTruncated < count
+		? formatWith(units[i], &formatPar, empty, 0)
+		: formatWith(units[i], &formatPar, *buf + length, left);
+
+	    if (nchar < 0) {
+		ut_set_status(UT_CANT_FORMAT);
+		ut_handle_error_message("Couldn't format unit");
+		break;
+	    }
+
+	    if (firstTruncated == count && (size_t)nchar >= left)
+		firstTruncated = i;
+
+	    offsets[i] = length;
+	    length += (size_t)nchar + 1;
+	}
+
+	nformatted = i < firstTruncated ? i : firstTruncated;
+
+	if (firstTruncated < count) {
+	    /*
+	     * Grow the buffer once to hold everything that was measured and
+	     * format the truncated units again.
+	     */
+	    const size_t	newSize = length > 2 * *size ? length : 2 * *size;
+	    char*		newBuf = realloc(*buf, newSize);
+
+	    if (newBuf == NULL) {
+		ut_set_status(UT_OS);
+		ut_handle_error_message(strerror(errno));
+		ut_handle_error_message("ut_format_many(): "
+		    "Couldn't grow buffer to %lu bytes",
+		    (unsigned long)newSize);
+	    }
+	    else {
+		const size_t	end = i;
+
+		*buf = newBuf;
+		*size = newSize;
+
+		for (i = firstTruncated; i < end; i++)
+		    (void)formatWith(units[i], &formatPar, *buf + offsets[i],
+			newSize - offsets[i]);
+
+		nformatted = end;
+	    }
+	}
+
+	if (nformatted == count)
+	    ut_set_status(UT_SUCCESS);
+    }
+
+    return nformatted;
+}
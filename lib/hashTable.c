@@ -0,0 +1,358 @@
+/*
+ * Copyright 2020 University Corporation for Atmospheric Research
+ *
+ * This file is part of the UDUNITS-2 package.  See the file COPYRIGHT
+ * in the top-level source-directory of the package for copying and
+ * redistribution conditions.
+ */
+/*
+ * Open-addressing hash-table with linear probing.
+ *
+ * Removal shifts subsequent entries of the probe sequence backwards, so the
+ * table never contains tombstones and a lookup stops at the first empty slot.
+ *
+ * This module is thread-compatible but not thread-safe.
+ */
+
+/*LINTLIBRARY*/
+
+#include "config.h"
+
+#include "hashTable.h"
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INITIAL_CAPACITY	64	/* must be a power of two */
+#define FNV_OFFSET		UINT64_C(14695981039346656037)
+#define FNV_PRIME		UINT64_C(1099511628211)
+
+typedef struct {
+    uint64_t	hash;
+    void*	entry;			/* NULL => empty slot */
+} Slot;
+
+struct HashTable {
+    Slot*	slots;
+    size_t	capacity;		/* number of slots; a power of two */
+    size_t	count;			/* number of entries */
+};
+
+
+/*
+ * Returns the home slot-index of a hash-value.  The bits are mixed first so
+ * that hash-values that differ only in their high-order bits don't collide.
+ *
+ * Arguments:
+ *	table	Pointer to the hash-table.
+ *	hash	The hash-value.
+ * Returns:
+ *	The index of the first slot to probe.
+ */
+static size_t
+homeIndex(
+    const HashTable* const	table,
+    uint64_t			hash)
+{
+    hash ^= hash >> 33;
+    hash *= UINT64_C(0xff51afd7ed558ccd);
+    hash ^= hash >> 33;
+
+    return (size_t)hash & (table->capacity - 1);
+}
+
+
+/*
+ * Doubles the capacity of a hash-table.  Stored hash-values are reused.
+ *
+ * Arguments:
+ *	table	Pointer to the hash-table.
+ * Returns:
+ *	 0	Success.
+ *	-1	Failure.  See "errno".  "table" is unchanged.
+ */
+static int
+grow(
+    HashTable* const	table)
+{
+    const size_t	oldCapacity = table->capacity;
+    Slot* const		oldSlots = table->slots;
+    Slot* const		newSlots = calloc(2*oldCapacity, sizeof(Slot));
+    size_t		i;
+
+    if (newSlots == NULL)
+	return -1;
+
+    table->slots = newSlots;
+    table->capacity = 2*oldCapacity;
+
+    for (i = 0; i < oldCapacity; i++) {
+	if (oldSlots[i].entry != NULL) {
+	    size_t	j = homeIndex(table, oldSlots[i].hash);
+
+	    while (newSlots[j].entry != NULL)
+		j = (j + 1) & (table->capacity - 1);
+
+	    newSlots[j] = oldSlots[i];
+	}
+    }
+
+    free(oldSlots);
+
+    return 0;
+}
+
+
+/*
+ * Returns the index of the slot that contains an entry matching a key or, if
+ * there's no such entry, the index of the empty slot that terminated the probe
+ * sequence.
+ */
+static size_t
+probe(
+    const HashTable* const	table,
+    const uint64_t		hash,
+    const void* const		key,
+    int				(*compare)(const void*, const void*))
+{
+    const size_t	mask = table->capacity - 1;
+    size_t		i = homeIndex(table, hash);
+
+    for (; table->slots[i].entry != NULL; i = (i + 1) & mask) {
+	if (table->slots[i].hash == hash &&
+		compare(key, table->slots[i].entry) == 0)
+	    break;
+    }
+
+    return i;
+}
+
+
+HashTable*
+htNew(void)
+{
+    HashTable*	table = malloc(sizeof(HashTable));
+
+    if (table != NULL) {
+	table->slots = calloc(INITIAL_CAPACITY, sizeof(Slot));
+
+	if (table->slots == NULL) {
+	    free(table);
+	    table = NULL;
+	}
+	else {
+	    table->capacity = INITIAL_CAPACITY;
+	    table->count = 0;
+	}
+    }
+
+    return table;
+}
+
+
+void
+htFree(
+    HashTable* const	table,
+    void		(*freeEntry)(void*))
+{
+    if (table != NULL) {
+	if (freeEntry != NULL) {
+	    size_t	i;
+
+	    for (i = 0; i < table->capacity; i++)
+		if (table->slots[i].entry != NULL)
+		    freeEntry(table->slots[i].entry);
+	}
+
+	free(table->slots);
+	free(table);
+    }
+}
+
+
+void**
+htSearch(
+    HashTable* const	table,
+    const uint64_t	hash,
+    const void* const	key,
+    int			(*compare)(const void*, const void*))
+{
+    size_t	i = probe(table, hash, key, compare);
+
+    if (table->slots[i].entry == NULL) {
+	/*
+	 * Keep the load-factor at or below one half so that probe sequences
+	 * stay short.
+	 */
+	if (2*(table->count + 1) > table->capacity) {
+	    if (grow(table))
+		return NULL;
+
+	    i = probe(table, hash, key, compare);
+	}
+
+	table->slots[i].hash = hash;
+	table->slots[i].entry = (void*)key;
+	table->count++;
+    }
+
+    return &table->slots[i].entry;
+}
+
+
+void**
+htFind(
+    const HashTable* const	table,
+    const uint64_t		hash,
+    const void* const		key,
+    int				(*compare)(const void*, const void*))
+{
+    void**	entry = NULL;		/* not found */
+
+    if (table != NULL) {
+	size_t	i = probe(table, hash, key, compare);
+
+	if (table->slots[i].entry != NULL)
+	    entry = &table->slots[i].entry;
+    }
+
+    return entry;
+}
+
+
+void*
+htRemove(
+    HashTable* const	table,
+    const uint64_t	hash,
+    const void* const	key,
+    int			(*compare)(const void*, const void*))
+{
+    void*	entry = NULL;		/* not found */
+
+    if (table != NULL) {
+	const size_t	mask = table->capacity - 1;
+	size_t		i = probe(table, hash, key, compare);
+
+	if (table->slots[i].entry != NULL) {
+	    size_t	j;
+
+	    entry = table->slots[i].entry;
+	    table->slots[i].entry = NULL;
+	    table->count--;
+
+	    /*
+	     * Backward-shift deletion: move each following entry of the probe
+	     * sequence into the hole unless its home slot lies cyclically in
+	     * (hole, entry], in which case moving it would hide it.
+	     */
+	    for (j = (i + 1) & mask; table->slots[j].entry != NULL;
+		    j = (j + 1) & mask) {
+		const size_t	home = homeIndex(table, table->slots[j].hash);
+		const int	stays = i <= j
+		    ? (i < home && home <= j)
+		    : (i < home || home <= j);
+
+		if (!stays) {
+		    table->slots[i] = table->slots[j];
+		    table->slots[j].entry = NULL;
+		    i = j;
+		}
+	    }
+	}
+    }
+
+    return entry;
+}
+
+
+int
+htWalk(
+    const HashTable* const	table,
+    int				(*action)(void* entry, void* arg),
+    void* const			arg)
+{
+    int		status = 0;
+
+    if (table != NULL) {
+	size_t	i;
+
+	for (i = 0; i < table->capacity && status == 0; i++)
+	    if (table->slots[i].entry != NULL)
+		status = action(table->slots[i].entry, arg);
+    }
+
+    return status;
+}
+
+
+size_t
+htCount(
+    const HashTable* const	table)
+{
+    return table == NULL ? 0 : table->count;
+}
+
+
+size_t
+htGetMemory(
+    const HashTable* const	table)
+{
+    return table == NULL ? 0 : sizeof(HashTable) +
+	table->capacity*sizeof(Slot);
+}
+
+
+uint64_t
+htHashString(
+    const char*	string)
+{
+    uint64_t	hash = FNV_OFFSET;
+
+    for (; *string; string++)
+	hash = (hash ^ (unsigned char)*string) * FNV_PRIME;
+
+    return hash;
+}
+
+
+uint64_t
+htHashStringNoCase(
+    const char*	string)
+{
+    uint64_t	hash = FNV_OFFSET;
+
+    /*
+     * tolower(3) is the folding that strcasecmp(3) uses.
+     */
+    for (; *string; string++)
+	hash = (hash ^ (unsigned char)tolower((unsigned char)*string)) *
+	    FNV_PRIME;
+
+    return hash;
+}
+
+
+uint64_t
+htHashMix(
+    const uint64_t	hash,
+    const uint64_t	value)
+{
+    uint64_t	v = value * UINT64_C(0x9e3779b97f4a7c15);
+
+    return (hash ^ (v ^ (v >> 32))) * FNV_PRIME;
+}
+
+
+uint64_t
+htHashDouble(
+    const uint64_t	hash,
+    const double	value)
+{
+    const double	normalized = value == 0 ? 0.0 : value;
+    uint64_t		bits;
+
+    (void)memcpy(&bits, &normalized, sizeof(bits));
+
+    return htHashMix(hash, bits);
+}
@@ -0,0 +1,229 @@
+/*
+ * Copyright 2020 University Corporation for Atmospheric Research
+ *
+ * This file is part of the UDUNITS-2 package.  See the file COPYRIGHT
+ * in the top-level source-directory of the package for copying and
+ * redistribution conditions.
+ */
+/*
+ * Open-addressing hash-table of opaque entries.
+ *
+ * The interface mirrors tsearch(3): the caller supplies the key's hash-value
+ * and a comparison function that returns 0 when a key matches an entry.  The
+ * hash-value of every entry is stored alongside it, so a probe only calls the
+ * comparison function on a full hash match and the table never has to rehash
+ * an entry when it grows.
+ */
+#ifndef UT_HASH_TABLE_H_INCLUDED
+#define UT_HASH_TABLE_H_INCLUDED
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct HashTable	HashTable;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ * Returns a new, empty hash-table.
+ *
+ * Returns:
+ *	NULL	Failure.  See "errno".
+ *	else	Pointer to the new hash-table.
+ */
+HashTable*
+htNew(void);
+
+
+/*
+ * Frees a hash-table.
+ *
+ * Arguments:
+ *	table		Pointer to the hash-table or NULL.
+ *	freeEntry	Pointer to a function that frees an entry or NULL.
+ */
+void
+htFree(
+    HashTable* const	table,
+    void		(*freeEntry)(void*));
+
+
+/*
+ * Finds an entry in a hash-table; adds the key as a new entry if it's not
+ * found (cf. tsearch(3)).
+ *
+ * Arguments:
+ *	table		Pointer to the hash-table.
+ *	hash		The hash-value of "key".
+ *	key		Pointer to the key.  Becomes an entry if not found.
+ *	compare		Pointer to a function that returns 0 if and only if
+ *			its first argument (a key) matches its second argument
+ *			(an entry).
+ * Returns:
+ *	NULL		Failure.  See "errno".
+ *	else		Address of the entry that matches "key".  The entry
+ *			is "key" if "key" was added.
+ */
+void**
+htSearch(
+    HashTable* const	table,
+    const uint64_t	hash,
+    const void* const	key,
+    int			(*compare)(const void*, const void*));
+
+
+/*
+ * Finds an entry in a hash-table (cf. tfind(3)).
+ *
+ * Arguments:
+ *	table		Pointer to the hash-table or NULL.
+ *	hash		The hash-value of "key".
+ *	key		Pointer to the key.
+ *	compare		Pointer to the comparison function (see htSearch()).
+ * Returns:
+ *	NULL		No entry matches "key".
+ *	else		Address of the entry that matches "key".
+ */
+void**
+htFind(
+    const HashTable* const	table,
+    const uint64_t		hash,
+    const void* const		key,
+    int				(*compare)(const void*, const void*));
+
+
+/*
+ * Removes an entry from a hash-table (cf. tdelete(3)).  The entry itself is
+ * not freed.
+ *
+ * Arguments:
+ *	table		Pointer to the hash-table or NULL.
+ *	hash		The hash-value of "key".
+ *	key		Pointer to the key.
+ *	compare		Pointer to the comparison function (see htSearch()).
+ * Returns:
+ *	NULL		No entry matches "key".
+ *	else		The removed entry.
+ */
+void*
+htRemove(
+    HashTable* const	table,
+    const uint64_t	hash,
+    const void* const	key,
+    int			(*compare)(const void*, const void*));
+
+
+/*
+ * Calls a function on every entry of a hash-table in unspecified order.  The
+ * function must not add or remove entries.
+ *
+ * Arguments:
+ *	table		Pointer to the hash-table or NULL.
+ *	action		Pointer to the function to call.  Iteration stops at
+ *			the first non-zero return-value.
+ *	arg		Argument passed to "action".
+ * Returns:
+ *	0		"action" returned 0 for every entry.
+ *	else		The first non-zero value returned by "action".
+ */
+int
+htWalk(
+    const HashTable* const	table,
+    int				(*action)(void* entry, void* arg),
+    void* const			arg);
+
+
+/*
+ * Returns the number of entries in a hash-table.
+ *
+ * Arguments:
+ *	table		Pointer to the hash-table or NULL.
+ * Returns:
+ *	The number of entries in "table".
+ */
+size_t
+htCount(
+    const HashTable* const	table);
+
+
+/*
+ * Returns the number of bytes allocated for a hash-table itself.  The entries
+ * aren't included.
+ *
+ * Arguments:
+ *	table		Pointer to the hash-table or NULL.
+ * Returns:
+ *	The number of bytes allocated for "table".
+ */
+size_t
+htGetMemory(
+    const HashTable* const	table);
+
+
+/*
+ * Returns the hash-value of a string.  Two strings that compare equal via
+ * strcmp(3) have the same hash-value.
+ *
+ * Arguments:
+ *	string	Pointer to the string.
+ * Returns:
+ *	The hash-value of "string".
+ */
+uint64_t
+htHashString(
+    const char*	string);
+
+
+/*
+ * Returns the case-insensitive hash-value of a string.  Two strings that
+ * compare equal via strcasecmp(3) have the same hash-value.
+ *
+ * Arguments:
+ *	string	Pointer to the string.
+ * Returns:
+ *	The case-insensitive hash-value of "string".
+ */
+uint64_t
+htHashStringNoCase(
+    const char*	string);
+
+
+/*
+ * Combines a hash-value with an integral value.
+ *
+ * Arguments:
+ *	hash	The hash-value to be augmented.
+ *	value	The value to be added to "hash".
+ * Returns:
+ *	The combined hash-value.
+ */
+uint64_t
+htHashMix(
+    const uint64_t	hash,
+    const uint64_t	value);
+
+
+/*
+ * Combines a hash-value with a floating-point value.  Values that compare
+ * equal (e.g., 0.0 and -0.0) contribute identically.
+ *
+ * Arguments:
+ *	hash	The hash-value to be augmented.
+ *	value	The value to be added to "hash".
+ * Returns:
+ *	The combined hash-value.
+ */
+uint64_t
+htHashDouble(
+    const uint64_t	hash,
+    const double	value);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
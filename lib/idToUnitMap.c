@@ -14,16 +14,14 @@
 #include "config.h"
 
 #include "udunits2.h"
+#include "hashTable.h"
+#include "idToUnitMap.h"		/* this module's API */
+#include "lazyUnits.h"
 #include "unitAndId.h"
-#include "systemMap.h"
+#include "unitcore.h"
 
 #include <assert.h>
-#ifdef _MSC_VER
-#include "tsearch.h"
-#else
-#include <search.h>
-#endif
-
+#include <errno.h>
 #include <stdlib.h>
 
 #include <string.h>
@@ -33,12 +31,10 @@
 
 typedef struct {
     int			(*compare)(const void*, const void*);
-    void*		tree;
+    uint64_t		(*hash)(const char*);
+    HashTable*		table;
 } IdToUnitMap;
 
-static SystemMap*	systemToNameToUnit;
-static SystemMap*	systemToSymbolToUnit;
-
 
 static int
 sensitiveCompare(
@@ -60,21 +56,50 @@ insensitiveCompare(
 }
 
 
+/*
+ * Returns a new identifier-to-unit map.
+ *
+ * Arguments:
+ *	compare		Pointer to the function for comparing identifiers.
+ *	hash		Pointer to the hash function for identifiers.  Two
+ *			identifiers that "compare" deems equal shall have the
+ *			same hash-value.
+ * Returns:
+ *	NULL		Failure.  See "errno".
+ *	else		Pointer to the new identifier-to-unit map.
+ */
 static IdToUnitMap*
 itumNew(
-    int		(*compare)(const void*, const void*))
+    int		(*compare)(const void*, const void*),
+    uint64_t	(*hash)(const char*))
 {
     IdToUnitMap*	map = (IdToUnitMap*)malloc(sizeof(IdToUnitMap));
 
     if (map != NULL) {
-	map->tree = NULL;
-	map->compare = compare;
+	map->table = htNew();
+
+	if (map->table == NULL) {
+	    free(map);
+	    map = NULL;
+	}
+	else {
+	    map->compare = compare;
+	    map->hash = hash;
+	}
     }
 
     return map;
 }
 
 
+static void
+freeEntry(
+    void* const	entry)
+{
+    uaiFree((UnitAndId*)entry);
+}
+
+
 /*
  * Frees an identifier-to-unit map.  All entries are freed.
  *
@@ -87,13 +112,7 @@ itumFree(
     IdToUnitMap*	map)
 {
     if (map != NULL) {
-	while (map->tree != NULL) {
-	    UnitAndId*	uai = *(UnitAndId**)map->tree;
-
-	    (void)tdelete(uai, &map->tree, map->compare);
-	    uaiFree(uai);
-	}
-
+	htFree(map->table, freeEntry);
 	free(map);
     }					/* valid arguments */
 }
@@ -130,15 +149,18 @@ itumAdd(
         status = ut_get_status();
     }
     else {
-	UnitAndId**	treeEntry = tsearch(targetEntry, &map->tree,
-	    map->compare);
+	UnitAndId**	tableEntry = (UnitAndId**)htSearch(map->table,
+	    map->hash(id), targetEntry, map->compare);
 
-	if (treeEntry == NULL) {
-	    uaiFree(targetEntry);
+	if (tableEntry == NULL) {
 	    status = UT_OS;
+	    ut_set_status(status);
+	    ut_handle_error_message(strerror(errno));
+	    ut_handle_error_message("Couldn't add hash-table entry");
+	    uaiFree(targetEntry);
 	}
 	else {
-	    if (ut_compare((*treeEntry)->unit, unit) == 0) {
+	    if (ut_compare((*tableEntry)->unit, unit) == 0) {
 		status = UT_SUCCESS;
 	    }
 	    else {
@@ -148,7 +170,7 @@ itumAdd(
 		    "\"%s\" already maps to existing but different unit", id);
 	    }
 
-            if (targetEntry != *treeEntry)
+            if (targetEntry != *tableEntry)
                 uaiFree(targetEntry);
 	}				/* found entry */
     }					/* "targetEntry" allocated */
@@ -172,20 +194,13 @@ itumRemove(
     const char* const	id)
 {
     UnitAndId		targetEntry;
-    UnitAndId**		treeEntry;
 
     assert(map != NULL);
     assert(id != NULL);
 
     targetEntry.id = (char*)id;
-    treeEntry = tfind(&targetEntry, &map->tree, map->compare);
-
-    if (treeEntry != NULL) {
-	UnitAndId*	uai = *treeEntry;
-
-	(void)tdelete(uai, &map->tree, map->compare);
-	uaiFree(uai);
-    }
+    uaiFree((UnitAndId*)htRemove(map->table, map->hash(id), &targetEntry,
+	map->compare));
 
     return UT_SUCCESS;
 }
@@ -210,16 +225,17 @@ itumFind(
 {
     UnitAndId*		entry = NULL;	/* failure */
     UnitAndId		targetEntry;
-    UnitAndId**		treeEntry;
+    UnitAndId**		tableEntry;
 
     assert(map != NULL);
     assert(id != NULL);
 
     targetEntry.id = (char*)id;
-    treeEntry = tfind(&targetEntry, &map->tree, map->compare);
+    tableEntry = (UnitAndId**)htFind(map->table, map->hash(id), &targetEntry,
+	map->compare);
 
-    if (treeEntry != NULL)
-	entry = *treeEntry;
+    if (tableEntry != NULL)
+	entry = *tableEntry;
 
     return entry;
 }
@@ -229,21 +245,24 @@ itumFind(
  * Adds to a particular unit-system a mapping from an identifier to a unit.
  *
  * Arguments:
- *	systemMap	Address of the pointer to the system-map.
+ *	mapId		Identifier of the unit-system's identifier-to-unit map.
  *	id		Pointer to the identifier.  May be freed upon return.
  *	unit		Pointer to the unit.  May be freed upon return.
  *	compare		Pointer to comparison function for unit-identifiers.
+ *	hash		Pointer to hash function for unit-identifiers.
  * Returns:
  *	UT_BAD_ARG	"id" is NULL or "unit" is NULL.
  *	UT_OS		Operating-sytem failure.  See "errno".
  *	UT_SUCCESS	Success.
+ *	UT_FROZEN	The unit-system is frozen.
  */
 static ut_status
 mapIdToUnit(
-    SystemMap** const		systemMap,
+    const SystemMapId		mapId,
     const char* const		id,
     const ut_unit* const	unit,
-    int				(*compare)(const void*, const void*))
+    int				(*compare)(const void*, const void*),
+    uint64_t			(*hash)(const char*))
 {
     ut_status		status = UT_SUCCESS;
 
@@ -253,35 +272,23 @@ mapIdToUnit(
     else if (unit == NULL) {
 	status = UT_BAD_ARG;
     }
+    else if (coreIsFrozen(ut_get_system(unit))) {
+	status = UT_FROZEN;
+	ut_handle_error_message("Unit-system is frozen");
+    }
     else {
-	ut_system*	system = ut_get_system(unit);
+	IdToUnitMap** const	idToUnit =
+	    (IdToUnitMap**)coreGetSystemMap(ut_get_system(unit), mapId);
 
-	if (*systemMap == NULL) {
-	    *systemMap = smNew();
+	if (*idToUnit == NULL) {
+	    *idToUnit = itumNew(compare, hash);
 
-	    if (*systemMap == NULL)
+	    if (*idToUnit == NULL)
 		status = UT_OS;
 	}
 
-	if (*systemMap != NULL) {
-	    IdToUnitMap** const	idToUnit =
-		(IdToUnitMap**)smSearch(*systemMap, system);
-
-	    if (idToUnit == NULL) {
-		status = UT_OS;
-	    }
-	    else {
-		if (*idToUnit == NULL) {
-		    *idToUnit = itumNew(compare);
-
-		    if (*idToUnit == NULL)
-			status = UT_OS;
-		}
-
-		if (*idToUnit != NULL)
-		    status = itumAdd(*idToUnit, id, unit);
-	    }				/* have system-map entry */
-	}				/* have system-map */
+	if (*idToUnit != NULL)
+	    status = itumAdd(*idToUnit, id, unit);
     }					/* valid arguments */
 
     return status;
@@ -292,32 +299,37 @@ mapIdToUnit(
  * Removes the mapping from an identifier to a unit.
  *
  * Arguments:
- *	systemMap	Address of the pointer to the system-map.
+ *	mapId		Identifier of the unit-system's identifier-to-unit map.
  *	id		Pointer to the identifier.  May be freed upon return.
  *	system		Pointer to the unit-system associated with the mapping.
  * Returns:
- *	UT_BAD_ARG	"id" is NULL, "system" is NULL, or "compare" is NULL.
+ *	UT_BAD_ARG	"id" is NULL or "system" is NULL.
  *	UT_SUCCESS	Success.
+ *	UT_FROZEN	The unit-system is frozen.
  */
 static ut_status
 unmapId(
-    SystemMap* const	systemMap,
+    const SystemMapId	mapId,
     const char* const	id,
     ut_system*		system)
 {
     ut_status		status;
 
-    if (systemMap == NULL || id == NULL || system == NULL) {
+    if (id == NULL || system == NULL) {
 	status = UT_BAD_ARG;
     }
+    else if (coreIsFrozen(system)) {
+	status = UT_FROZEN;
+	ut_handle_error_message("Unit-system is frozen");
+    }
     else {
-	IdToUnitMap** const	idToUnit =
-	    (IdToUnitMap**)smFind(systemMap, system);
+	IdToUnitMap* const	idToUnit =
+	    *(IdToUnitMap**)coreGetSystemMap(system, mapId);
 
 	status =
-	    (idToUnit == NULL || *idToUnit == NULL)
+	    idToUnit == NULL
 		? UT_SUCCESS
-		: itumRemove(*idToUnit, id);
+		: itumRemove(idToUnit, id);
     }					/* valid arguments */
 
     return status;
@@ -338,6 +350,7 @@ unmapId(
  *	UT_OS		Operating-system error.  See "errno".
  *	UT_EXISTS	"name" already maps to a different unit.
  *	UT_SUCCESS	Success.
+ *	UT_FROZEN	The unit-system is frozen.
  */
 ut_status
 ut_map_name_to_unit(
@@ -346,7 +359,8 @@ ut_map_name_to_unit(
     const ut_unit* const	unit)
 {
     ut_set_status(
-	mapIdToUnit(&systemToNameToUnit, name, unit, insensitiveCompare));
+	mapIdToUnit(SYSTEM_NAME_TO_UNIT, name, unit, insensitiveCompare,
+	    htHashStringNoCase));
 
     return ut_get_status();
 }
@@ -363,6 +377,7 @@ ut_map_name_to_unit(
  * Returns:
  *	UT_SUCCESS	Success.
  *	UT_BAD_ARG	"system" or "name" is NULL.
+ *	UT_FROZEN	The unit-system is frozen.
  */
 ut_status
 ut_unmap_name_to_unit(
@@ -370,7 +385,7 @@ ut_unmap_name_to_unit(
     const char* const	name,
     const ut_encoding   encoding)
 {
-    ut_set_status(unmapId(systemToNameToUnit, name, system));
+    ut_set_status(unmapId(SYSTEM_NAME_TO_UNIT, name, system));
 
     return ut_get_status();
 }
@@ -390,6 +405,7 @@ ut_unmap_name_to_unit(
  *	UT_OS		Operating-system error.  See "errno".
  *	UT_EXISTS	"symbol" already maps to a different unit.
  *	UT_SUCCESS	Success.
+ *	UT_FROZEN	The unit-system is frozen.
  */
 ut_status
 ut_map_symbol_to_unit(
@@ -398,7 +414,8 @@ ut_map_symbol_to_unit(
     const ut_unit* const	unit)
 {
     ut_set_status(
-	mapIdToUnit(&systemToSymbolToUnit, symbol, unit, sensitiveCompare));
+	mapIdToUnit(SYSTEM_SYMBOL_TO_UNIT, symbol, unit, sensitiveCompare,
+	    htHashString));
 
     return ut_get_status();
 }
@@ -415,6 +432,7 @@ ut_map_symbol_to_unit(
  * Returns:
  *	UT_SUCCESS	Success.
  *	UT_BAD_ARG	"system" or "symbol" is NULL.
+ *	UT_FROZEN	The unit-system is frozen.
  */
 ut_status
 ut_unmap_symbol_to_unit(
@@ -422,7 +440,7 @@ ut_unmap_symbol_to_unit(
     const char* const	symbol,
     const ut_encoding   encoding)
 {
-    ut_set_status(unmapId(systemToSymbolToUnit, symbol, system));
+    ut_set_status(unmapId(SYSTEM_SYMBOL_TO_UNIT, symbol, system));
 
     return ut_get_status();
 }
@@ -432,41 +450,57 @@ ut_unmap_symbol_to_unit(
  * Returns the unit to which an identifier maps in a particular unit-system.
  *
  * Arguments:
- *	systemMap	NULL or pointer to the system-map.  If NULL, then
- *			NULL will be returned.
+ *	mapId		Identifier of the unit-system's identifier-to-unit map.
  *	system		Pointer to the unit-system.
  *	id		Pointer to the identifier.
  * Returns:
  *	NULL	Failure.  "ut_get_status()" will be:
  *		    UT_BAD_ARG	        "system" is NULL or "id" is NULL.
  *	else	Pointer to the unit in "system" with the identifier "id".
- *		Should be passed to ut_free() when no longer needed.
+ *		The unit is owned by the map and must not be freed.
  */
-static ut_unit*
-getUnitById(
-    const SystemMap* const	systemMap,
+static const ut_unit*
+findUnitById(
+    const SystemMapId		mapId,
     const ut_system* const	system,
     const char* const		id)
 {
-    ut_unit*	unit = NULL;		/* failure */
+    const ut_unit*	unit = NULL;	/* failure */
 
     if (system == NULL) {
 	ut_set_status(UT_BAD_ARG);
-	ut_handle_error_message("getUnitById(): NULL unit-system argument");
+	ut_handle_error_message("findUnitById(): NULL unit-system argument");
     }
     else if (id == NULL) {
 	ut_set_status(UT_BAD_ARG);
-	ut_handle_error_message("getUnitById(): NULL identifier argument");
+	ut_handle_error_message("findUnitById(): NULL identifier argument");
     }
-    else if (systemMap != NULL) {
-	IdToUnitMap** const	idToUnit =
-	    (IdToUnitMap**)smFind(systemMap, system);
-
-	if (idToUnit != NULL) {
-	    const UnitAndId*	uai = itumFind(*idToUnit, id);
+    else {
+	const ut_system*	sys;
+
+	/*
+	 * An overlay's own mappings hide those of the unit-system it overlays.
+	 */
+	for (sys = system; unit == NULL && sys != NULL;
+		sys = coreGetBaseSystem(sys)) {
+	    IdToUnitMap**	idToUnit =
+		(IdToUnitMap**)coreGetSystemMap(sys, mapId);
+	    const UnitAndId*	uai =
+		*idToUnit == NULL ? NULL : itumFind(*idToUnit, id);
+
+	    /*
+	     * A miss might be an identifier of a deferred unit-definition.
+	     * Resolving it modifies the unit-system, but only by creating a
+	     * unit that the unit-system already defines, so the look-up is
+	     * logically const.  A frozen unit-system has no deferred units, so
+	     * concurrent look-ups in one never get here.
+	     */
+	    if (uai == NULL && luResolve((ut_system*)sys, mapId, id) &&
+		    *idToUnit != NULL)
+		uai = itumFind(*idToUnit, id);
 
 	    if (uai != NULL)
-		unit = ut_clone(uai->unit);
+		unit = uai->unit;
 	}
     }					/* valid arguments */
 
@@ -474,6 +508,41 @@ getUnitById(
 }
 
 
+/*
+ * Returns a copy of the unit to which an identifier maps in a particular
+ * unit-system.
+ *
+ * Arguments:
+ *	mapId		Identifier of the unit-system's identifier-to-unit map.
+ *	system		Pointer to the unit-system.
+ *	id		Pointer to the identifier.
+ * Returns:
+ *	NULL	Failure.  "ut_get_status()" will be:
+ *		    UT_BAD_ARG	        "system" is NULL or "id" is NULL.
+ *		    UT_OS		Operating-system error.  See "errno".
+ *	else	Pointer to the unit in "system" with the identifier "id".
+ *		Should be passed to ut_free() when no longer needed.
+ */
+static ut_unit*
+getUnitById(
+    const SystemMapId		mapId,
+    const ut_system* const	system,
+    const char* const		id)
+{
+    const ut_unit*	unit = findUnitById(mapId, system, id);
+    ut_unit*		clone = unit == NULL ? NULL : ut_clone(unit);
+
+    /*
+     * A unit of the unit-system that "system" overlays is returned as one of
+     * "system" so that identifiers mapped to it are added to "system".
+     */
+    if (clone != NULL && ut_get_system(clone) != system)
+	clone = coreAdoptUnit(system, clone);
+
+    return clone;
+}
+
+
 /*
  * Returns the unit with a given name from a unit-system.  Name comparisons
  * are case-insensitive.
@@ -497,7 +566,7 @@ ut_get_unit_by_name(
 {
     ut_set_status(UT_SUCCESS);
 
-    return getUnitById(systemToNameToUnit, system, name);
+    return getUnitById(SYSTEM_NAME_TO_UNIT, system, name);
 }
 
 
@@ -525,7 +594,161 @@ ut_get_unit_by_symbol(
 {
     ut_set_status(UT_SUCCESS);
 
-    return getUnitById(systemToSymbolToUnit, system, symbol);
+    return getUnitById(SYSTEM_SYMBOL_TO_UNIT, system, symbol);
+}
+
+
+/*
+ * Returns the unit with a given name from a unit-system without copying it.
+ * Name comparisons are case-insensitive.
+ *
+ * Arguments:
+ *	system	Pointer to the unit-system.
+ *	name	Pointer to the name of the unit to be returned.
+ * Returns:
+ *	NULL	Failure.  "ut_get_status()" will be
+ *		    UT_SUCCESS		"name" doesn't map to a unit of
+ *					"system".
+ *		    UT_BAD_ARG		"system" or "name" is NULL.
+ *	else	Pointer to the unit of the unit-system with the given name.
+ *		The unit belongs to the unit-system: it must not be passed to
+ *		ut_free() and it remains valid until "name" is unmapped or the
+ *		unit-system is freed.
+ */
+const ut_unit*
+ut_lookup_unit_by_name(
+    const ut_system* const	system,
+    const char* const		name)
+{
+    ut_set_status(UT_SUCCESS);
+
+    return findUnitById(SYSTEM_NAME_TO_UNIT, system, name);
+}
+
+
+/*
+ * Returns the unit with a given symbol from a unit-system without copying it.
+ * Symbol comparisons are case-sensitive.
+ *
+ * Arguments:
+ *	system		Pointer to the unit-system.
+ *	symbol		Pointer to the symbol associated with the unit to be
+ *			returned.
+ * Returns:
+ *	NULL	Failure.  "ut_get_status()" will be
+ *		    UT_SUCCESS		"symbol" doesn't map to a unit of
+ *					"system".
+ *		    UT_BAD_ARG		"system" or "symbol" is NULL.
+ *	else	Pointer to the unit in the unit-system with the given symbol.
+ *		The unit belongs to the unit-system: it must not be passed to
+ *		ut_free() and it remains valid until "symbol" is unmapped or
+ *		the unit-system is freed.
+ */
+const ut_unit*
+ut_lookup_unit_by_symbol(
+    const ut_system* const	system,
+    const char* const		symbol)
+{
+    ut_set_status(UT_SUCCESS);
+
+    return findUnitById(SYSTEM_SYMBOL_TO_UNIT, system, symbol);
+}
+
+
+static int
+initEntryUnit(
+    void* const	entry,
+    void* const	arg)
+{
+    (void)arg;
+
+    return coreInitUnit(((UnitAndId*)entry)->unit);
+}
+
+
+/*
+ * Initializes the lazily-created state of every unit to which an identifier of
+ * a unit-system maps.  Afterwards, the units that ut_lookup_unit_by_name() and
+ * ut_lookup_unit_by_symbol() return aren't modified by their use.
+ *
+ * Arguments:
+ *	system		Pointer to the unit-system.
+ * Returns:
+ *	UT_SUCCESS	Success.
+ *	else		Failure.
+ */
+ut_status
+itumFreezeSystem(
+    ut_system*	system)
+{
+    const SystemMapId	mapIds[] = {SYSTEM_NAME_TO_UNIT, SYSTEM_SYMBOL_TO_UNIT};
+    ut_status		status = UT_SUCCESS;
+    int			i;
+
+    for (i = 0; i < 2 && status == UT_SUCCESS; i++) {
+	IdToUnitMap* const	idToUnit =
+	    *(IdToUnitMap**)coreGetSystemMap(system, mapIds[i]);
+
+	if (idToUnit != NULL)
+	    status = (ut_status)htWalk(idToUnit->table, initEntryUnit, NULL);
+    }
+
+    return status;
+}
+
+
+typedef struct {
+    int		(*action)(const char*, const ut_unit*, void*);
+    void*	arg;
+} WalkArg;
+
+
+static int
+walkEntry(
+    void* const	entry,
+    void* const	arg)
+{
+    const UnitAndId* const	uai = (const UnitAndId*)entry;
+    const WalkArg* const	walkArg = (const WalkArg*)arg;
+
+    return walkArg->action(uai->id, uai->unit, walkArg->arg);
+}
+
+
+/*
+ * Calls a function on every mapping of an identifier-to-unit map of a
+ * unit-system in unspecified order.
+ *
+ * Arguments:
+ *	system		Pointer to the unit-system.
+ *	mapId		SYSTEM_NAME_TO_UNIT or SYSTEM_SYMBOL_TO_UNIT.
+ *	action		Pointer to the function to call with an identifier,
+ *			the unit to which it maps, and "arg".  It must not
+ *			modify the map.  Iteration stops at the first non-zero
+ *			return-value.
+ *	arg		Argument passed to "action".
+ * Returns:
+ *	0		"action" returned 0 for every mapping.
+ *	else		The first non-zero value returned by "action".
+ */
+int
+itumWalk(
+    const ut_system* const	system,
+    const SystemMapId		mapId,
+    int				(*action)(const char* id,
+					  const ut_unit* unit, void* arg),
+    void* const			arg)
+{
+    IdToUnitMap* const	idToUnit =
+	*(IdToUnitMap**)coreGetSystemMap(system, mapId);
+    WalkArg		walkArg;
+
+    assert(mapId == SYSTEM_NAME_TO_UNIT || mapId == SYSTEM_SYMBOL_TO_UNIT);
+
+    walkArg.action = action;
+    walkArg.arg = arg;
+
+    return idToUnit == NULL ? 0 : htWalk(idToUnit->table, walkEntry, &walkArg);
 }
 
 
@@ -541,22 +764,61 @@ itumFreeSystem(
     ut_system*	system)
 {
     if (system != NULL) {
-	SystemMap*	systemMaps[2];
-	int		i;
-
-	systemMaps[0] = systemToNameToUnit;
-	systemMaps[1] = systemToSymbolToUnit;
+	const SystemMapId	mapIds[] = {SYSTEM_NAME_TO_UNIT,
+				    SYSTEM_SYMBOL_TO_UNIT};
+	int			i;
 
 	for (i = 0; i < 2; i++) {
-	    if (systemMaps[i] != NULL) {
-		IdToUnitMap** const	idToUnit =
-		    (IdToUnitMap**)smFind(systemMaps[i], system);
-
-		if (idToUnit != NULL)
-		    itumFree(*idToUnit);
+	    IdToUnitMap** const	idToUnit =
+		(IdToUnitMap**)coreGetSystemMap(system, mapIds[i]);
 
-		smRemove(systemMaps[i], system);
-	    }
+	    itumFree(*idToUnit);
+	    *idToUnit = NULL;
 	}
     }					/* valid arguments */
 }
+
+
+static int
+addEntryMemory(
+    void* const	entry,
+    void* const	arg)
+{
+    const UnitAndId* const	uai = (const UnitAndId*)entry;
+    ut_memory_stats* const	stats = (ut_memory_stats*)arg;
+
+    stats->idMaps.bytes += sizeof(UnitAndId) + strlen(uai->id) + 1;
+    stats->idMaps.count++;
+    coreAddUnitMemory(uai->unit, stats);
+
+    return 0;
+}
+
+
+/*
+ * Adds the memory of the identifier-to-unit maps of a unit-system to the memory
+ * statistics of the unit-system.
+ *
+ * Arguments:
+ *	system		Pointer to the unit-system.
+ *	stats		Pointer to the statistics to be augmented.
+ */
+void
+itumGetMemory(
+    const ut_system* const	system,
+    ut_memory_stats* const	stats)
+{
+    const SystemMapId	mapIds[] = {SYSTEM_NAME_TO_UNIT, SYSTEM_SYMBOL_TO_UNIT};
+    int			i;
+
+    for (i = 0; i < 2; i++) {
+	const IdToUnitMap* const	idToUnit =
+	    *(IdToUnitMap**)coreGetSystemMap(system, mapIds[i]);
+
+	if (idToUnit != NULL) {
+	    stats->idMaps.bytes += sizeof(IdToUnitMap) +
+		htGetMemory(idToUnit->table);
+	    (void)htWalk(idToUnit->table, addEntryMemory, stats);
+	}
+    }
+}
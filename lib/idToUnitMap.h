@@ -9,6 +9,7 @@
 #define UT_ID_TO_UNIT_MAP_H_INCLUDED
 
 #include "udunits2.h"
+#include "unitcore.h"
 
 
 #ifdef __cplusplus
@@ -16,6 +17,45 @@ extern "C" {
 #endif
 
 
+/*
+ * Initializes the lazily-created state of every unit to which an identifier of
+ * a unit-system maps.
+ *
+ * Arguments:
+ *	system		Pointer to the unit-system.
+ * Returns:
+ *	UT_SUCCESS	Success.
+ *	else		Failure.
+ */
+ut_status
+itumFreezeSystem(
+    ut_system*	system);
+
+
+/*
+ * Calls a function on every mapping of an identifier-to-unit map of a
+ * unit-system in unspecified order.
+ *
+ * Arguments:
+ *	system		Pointer to the unit-system.
+ *	mapId		SYSTEM_NAME_TO_UNIT or SYSTEM_SYMBOL_TO_UNIT.
+ *	action		Pointer to the function to call with an identifier,
+ *			the unit to which it maps, and "arg".  Iteration stops
+ *			at the first non-zero return-value.
+ *	arg		Argument passed to "action".
+ * Returns:
+ *	0		"action" returned 0 for every mapping.
+ *	else		The first non-zero value returned by "action".
+ */
+int
+itumWalk(
+    const ut_system* const	system,
+    const SystemMapId		mapId,
+    int				(*action)(const char* id,
+					  const ut_unit* unit, void* arg),
+    void* const			arg);
+
+
 /*
  * Frees resources associated with a unit-system.
  *
@@ -28,6 +68,20 @@ itumFreeSystem(
     ut_system*	system);
 
 
+/*
+ * Adds the memory of the identifier-to-unit maps of a unit-system to the memory
+ * statistics of the unit-system (see ut_get_memory_stats()).
+ *
+ * Arguments:
+ *	system		Pointer to the unit-system.
+ *	stats		Pointer to the statistics to be augmented.
+ */
+void
+itumGetMemory(
+    const ut_system* const	system,
+    ut_memory_stats* const	stats);
+
+
 #ifdef __cplusplus
 }
 #endif
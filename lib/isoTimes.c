@@ -0,0 +1,456 @@
+/*
+ * Copyright 2020 University Corporation for Atmospheric Research
+ *
+ * This file is part of the UDUNITS-2 package.  See the file COPYRIGHT
+ * in the top-level source-directory of the package for copying and
+ * redistribution conditions.
+ */
+/*
+ * Bulk encoding of ISO 8601 timestamps:  ut_encode_iso_times().
+ *
+ * Timestamps are scanned by hand rather than by the unit-string parser, which
+ * would create and free a unit for each one.  The components are validated by
+ * ut_check_date() and ut_check_clock() and are combined with the same
+ * arithmetic as the timestamp rules of the parser, so a timestamp has the same
+ * encoded value however it's given.
+ */
+
+/*LINTLIBRARY*/
+
+#include "config.h"
+
+#include "udunits2.h"
+
+#include <math.h>
+#include <stddef.h>
+
+/*
+ * Components of a timestamp:
+ */
+typedef struct {
+    int		year;
+    int		month;
+    int		day;
+    int		hour;
+    int		minute;
+    double	second;
+    double	offset;		/* of the time-zone in seconds */
+    int		hasClock;
+} Timestamp;
+
+
+static int
+isDigit(
+    const int	c)
+{
+    return c >= '0' && c <= '9';
+}
+
+
+static int
+isBlank(
+    const int	c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+
+/*
+ * Returns the number of consecutive decimal digits.
+ *
+ * Arguments:
+ *	cp	Pointer to the first character.
+ */
+static int
+countDigits(
+    const char*	cp)
+{
+    int	n = 0;
+
+    while (isDigit(cp[n]))
+	n++;
+
+    return n;
+}
+
+
+/*
+ * Reads an unsigned decimal integer.
+ *
+ * Arguments:
+ *	cp	Pointer to the first digit.
+ *	min	Minimum number of digits.
+ *	max	Maximum number of digits.  Shall be at most 9.
+ *	value	Pointer to the value of the digits.
+ * Returns:
+ *	NULL	The number of digits isn't in [min, max].
+ *	else	Pointer to the character after the digits.
+ */
+static const char*
+readDigits(
+    const char*		cp,
+    const int		min,
+    const int		max,
+    int* const		value)
+{
+    int	n = 0;
+    int	v = 0;
+
+    while (isDigit(cp[n])) {
+	if (n == max)
+	    return NULL;
+
+	v = 10 * v + (cp[n++] - '0');
+    }
+
+    if (n < min)
+	return NULL;
+
+    *value = v;
+
+    return cp + n;
+}
+
+
+/*
+ * Reads a fixed number of decimal digits that are known to be present.
+ *
+ * Arguments:
+ *	cp	Pointer to the first digit.
+ *	count	Number of digits.
+ *	value	Pointer to the value of the digits.
+ * Returns:
+ *	Pointer to the character after the digits.
+ */
+static const char*
+readFixed(
+    const char*		cp,
+    const int		count,
+    int* const		value)
+{
+    int	v = 0;
+    int	i;
+
+    for (i = 0; i < count; i++)
+	v = 10 * v + (cp[i] - '0');
+
+    *value = v;
+
+    return cp + count;
+}
+
+
+/*
+ * Reads an optional decimal fraction and adds it to a number of seconds.
+ *
+ * Arguments:
+ *	cp	Pointer to the character that might start the fraction.
+ *	second	Pointer to the number of seconds.
+ * Returns:
+ *	Pointer to the character after the fraction.
+ */
+static const char*
+readFraction(
+    const char*		cp,
+    double* const	second)
+{
+    if ((*cp == '.' || *cp == ',') && isDigit(cp[1])) {
+	double	fraction = 0;
+	double	scale = 1;
+
+	for (cp++; isDigit(*cp); cp++) {
+	    fraction = 10 * fraction + (*cp - '0');
+	    scale *= 10;
+	}
+
+	*second += fraction / scale;
+    }
+
+    return cp;
+}
+
+
+/*
+ * Scans the date of a timestamp.
+ *
+ * Returns:
+ *	NULL	Syntax error.
+ *	else	Pointer to the character after the date.
+ */
+static const char*
+scanDate(
+    const char*		cp,
+    Timestamp* const	ts)
+{
+    int	sign = 1;
+    int	n;
+
+    if (*cp == '+' || *cp == '-')
+	sign = *cp++ == '-' ? -1 : 1;
+
+    n = countDigits(cp);
+
+    if (cp[n] == '-') {
+	if ((cp = readDigits(cp, 1, 7, &ts->year)) == NULL || *cp++ != '-' ||
+		(cp = readDigits(cp, 1, 2, &ts->month)) == NULL ||
+		*cp++ != '-' ||
+		(cp = readDigits(cp, 1, 2, &ts->day)) == NULL)
+	    return NULL;
+    }
+    else if (n == 8) {
+	cp = readFixed(cp, 4, &ts->year);
+	cp = readFixed(cp, 2, &ts->month);
+	cp = readFixed(cp, 2, &ts->day);
+    }
+    else {
+	return NULL;
+    }
+
+    ts->year *= sign;
+
+    return cp;
+}
+
+
+/*
+ * Scans the clock-time of a timestamp.
+ *
+ * Returns:
+ *	NULL	Syntax error.
+ *	else	Pointer to the character after the clock-time.
+ */
+static const char*
+scanClock(
+    const char*		cp,
+    Timestamp* const	ts)
+{
+    const int	n = countDigits(cp);
+    int		second;
+
+    if (cp[n] == ':') {
+	if ((cp = readDigits(cp, 1, 2, &ts->hour)) == NULL || *cp++ != ':' ||
+		(cp = readDigits(cp, 1, 2, &ts->minute)) == NULL)
+	    return NULL;
+
+	if (*cp == ':') {
+	    if ((cp = readDigits(cp + 1, 1, 2, &second)) == NULL)
+		return NULL;
+
+	    ts->second = second;
+	    cp = readFraction(cp, &ts->second);
+	}
+    }
+    else if (n == 2 || n == 4 || n == 6) {
+	cp = readFixed(cp, 2, &ts->hour);
+
+	if (n >= 4)
+	    cp = readFixed(cp, 2, &ts->minute);
+
+	if (n == 6) {
+	    cp = readFixed(cp, 2, &second);
+	    ts->second = second;
+	    cp = readFraction(cp, &ts->second);
+	}
+    }
+    else {
+	return NULL;
+    }
+
+    ts->hasClock = 1;
+
+    return cp;
+}
+
+
+/*
+ * Scans the time-zone of a timestamp.  The range rules are those of the
+ * unit-string parser:  at most 14:00 and not -00:00.
+ *
+ * Returns:
+ *	NULL	Syntax or range error.
+ *	else	Pointer to the character after the time-zone.
+ */
+static const char*
+scanZone(
+    const char*		cp,
+    Timestamp* const	ts)
+{
+    int	sign;
+    int	hour;
+    int	minute = 0;
+    int	n;
+
+    if (*cp == 'Z' || *cp == 'z')
+	return cp + 1;
+
+    if (*cp != '+' && *cp != '-')
+	return NULL;
+
+    sign = *cp++ == '-' ? -1 : 1;
+    n = countDigits(cp);
+
+    if (cp[n] == ':') {
+	if ((cp = readDigits(cp, 1, 2, &hour)) == NULL || *cp++ != ':' ||
+		(cp = readDigits(cp, 1, 2, &minute)) == NULL)
+	    return NULL;
+    }
+    else if (n == 2 || n == 4) {
+	cp = readFixed(cp, 2, &hour);
+
+	if (n == 4)
+	    cp = readFixed(cp, 2, &minute);
+    }
+    else {
+	return NULL;
+    }
+
+    if (hour > 14 || (hour == 14 && minute > 0) || minute > 59 ||
+	    (sign < 0 && hour == 0 && minute == 0))
+	return NULL;
+
+    ts->offset = sign * (hour*3600.0 + minute*60.0);
+
+    return cp;
+}
+
+
+/*
+ * Scans a timestamp.  The components aren't validated.
+ *
+ * Arguments:
+ *	cp	Pointer to the timestamp.
+ *	ts	Pointer to the components.
+ * Returns:
+ *	0	Syntax error.
+ *	1	Success.
+ */
+static int
+scanTimestamp(
+    const char*		cp,
+    Timestamp* const	ts)
+{
+    ts->hour = ts->minute = 0;
+    ts->second = ts->offset = 0;
+    ts->hasClock = 0;
+
+    while (isBlank(*cp))
+	cp++;
+
+    if ((cp = scanDate(cp, ts)) == NULL)
+	return 0;
+
+    if (*cp == 'Z' || *cp == 'z') {
+	cp++;
+    }
+    else if (*cp == 'T' || *cp == 't' || isBlank(*cp)) {
+	if (*cp == 'T' || *cp == 't') {
+	    cp++;
+
+	    if (!isDigit(*cp))
+		return 0;
+	}
+	else {
+	    while (isBlank(*cp))
+		cp++;
+	}
+
+	if (isDigit(*cp)) {
+	    if ((cp = scanClock(cp, ts)) == NULL)
+		return 0;
+
+	    while (isBlank(*cp))
+		cp++;
+
+	    if (*cp != 0 && (cp = scanZone(cp, ts)) == NULL)
+		return 0;
+	}
+    }
+
+    while (isBlank(*cp))
+	cp++;
+
+    return *cp == 0;
+}
+
+
+/******************************************************************************
+ * Public API:
+ ******************************************************************************/
+
+/*
+ * Encodes ISO 8601 timestamps.  See udunits2.h for the syntax.
+ *
+ * Arguments:
+ *	strings		Pointer to the timestamps.
+ *	count		Number of timestamps.
+ *	values		Pointer to the encoded times.  Shall have "count"
+ *			elements.
+ * Returns:
+ *	UT_SUCCESS	Success.
+ *	UT_BAD_ARG	"strings" or "values" is NULL.
+ *	UT_SYNTAX	At least one timestamp is NULL, malformed, or has an
+ *			invalid component, in which case its value is NaN.  The
+ *			other timestamps are encoded.
+ */
+ut_status
+ut_encode_iso_times(
+    const char* const* const	strings,
+    const size_t		count,
+    double* const		values)
+{
+    if (count > 0 && (strings == NULL || values == NULL)) {
+	ut_set_status(UT_BAD_ARG);
+	ut_handle_error_message("ut_encode_iso_times(): NULL argument");
+    }
+    else {
+	Timestamp	ts;
+	double		date = 0;	/* encoded prevYear-prevMonth-prevDay */
+	int		haveDate = 0;
+	int		prevYear = 0;
+	int		prevMonth = 0;
+	int		prevDay = 0;
+	size_t		nbad = 0;
+	size_t		i;
+
+	for (i = 0; i < count; i++) {
+	    double	clock;
+
+	    values[i] = NAN;
+
+	    if (strings[i] == NULL || !scanTimestamp(strings[i], &ts)) {
+		ut_handle_error_message("ut_encode_iso_times(): Invalid "
+		    "timestamp \"%s\"", strings[i] == NULL ? "(null)" :
+		    strings[i]);
+		nbad++;
+		continue;
+	    }
+
+	    /*
+	     * The validators emit their own error-messages.
+	     */
+	    if (ut_check_date(ts.year, ts.month, ts.day) != UT_SUCCESS ||
+		    (ts.hasClock &&
+		     ut_check_clock(ts.hour, ts.minute, ts.second) !=
+			UT_SUCCESS)) {
+		nbad++;
+		continue;
+	    }
+
+	    if (!haveDate || ts.day != prevDay || ts.month != prevMonth ||
+		    ts.year != prevYear) {
+		date = ut_encode_date(ts.year, ts.month, ts.day);
+		prevYear = ts.year;
+		prevMonth = ts.month;
+		prevDay = ts.day;
+		haveDate = 1;
+	    }
+
+	    clock = ts.hour*3600.0 + ts.minute*60.0 + ts.second;
+	    values[i] = date + (clock - ts.offset);
+	}
+
+	ut_set_status(nbad == 0 ? UT_SUCCESS : UT_SYNTAX);
+    }
+
+    return ut_get_status();
+}
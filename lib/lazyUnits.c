@@ -0,0 +1,821 @@
+/*
+ * Copyright 2020 University Corporation for Atmospheric Research
+ *
+ * This file is part of the UDUNITS-2 package.  See the file COPYRIGHT
+ * in the top-level source-directory of the package for copying and
+ * redistribution conditions.
+ */
+/*
+ * Deferred unit-definitions of a unit-system.
+ *
+ * The identifiers that map to deferred units are kept in a case-insensitive
+ * table of names and a case-sensitive table of symbols -- just like the
+ * identifier-to-unit maps -- so that a lookup that misses the identifier-to-unit
+ * map of a unit-system can resolve the deferred unit and try again (see
+ * idToUnitMap.c).  A deferred unit leaves both tables when it's resolved.
+ */
+
+/*LINTLIBRARY*/
+
+#include "config.h"
+
+#include "udunits2.h"
+#include "hashTable.h"
+#include "lazyUnits.h"			/* this module's API */
+#include "unitcore.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _MSC_VER
+#include <strings.h>
+#endif
+
+typedef enum {
+    LU_PENDING = 0,
+    LU_RESOLVING,
+    LU_RESOLVED,
+    LU_FAILED
+} LazyState;
+
+typedef struct {
+    char*	id;
+    ut_encoding	encoding;
+    int		isName;
+    int		toUnit;			/* maps to the unit rather than from */
+} LazyId;
+
+struct LazyUnit {
+    char*	definition;		/* NULL once resolved */
+    LazyId*	ids;			/* in order of addition */
+    size_t	count;
+    size_t	capacity;
+    ut_encoding	encoding;
+    LazyState	state;
+    int		isSecond;
+};
+
+typedef int	(*Compare)(const void*, const void*);
+
+typedef struct {
+    const char*	id;			/* belongs to "unit" */
+    LazyUnit*	unit;
+} LazyEntry;
+
+typedef struct {
+    HashTable*	names;			/* case-insensitive */
+    HashTable*	symbols;
+    LazyUnit**	units;			/* in order of addition */
+    size_t	count;
+    size_t	capacity;
+} LazyUnits;
+
+
+static int
+sensitiveCompare(
+    const void* const	key,
+    const void* const	entry)
+{
+    return strcmp(((const LazyEntry*)key)->id, ((const LazyEntry*)entry)->id);
+}
+
+
+static int
+insensitiveCompare(
+    const void* const	key,
+    const void* const	entry)
+{
+    return strcasecmp(((const LazyEntry*)key)->id,
+	((const LazyEntry*)entry)->id);
+}
+
+
+static HashTable*
+getTable(
+    const LazyUnits* const	lazy,
+    const int			isName)
+{
+    return isName ? lazy->names : lazy->symbols;
+}
+
+
+static uint64_t
+hashId(
+    const char* const	id,
+    const int		isName)
+{
+    return isName ? htHashStringNoCase(id) : htHashString(id);
+}
+
+
+static Compare
+getCompare(
+    const int	isName)
+{
+    return isName ? insensitiveCompare : sensitiveCompare;
+}
+
+
+/*
+ * Returns the deferred units of a unit-system.
+ *
+ * Arguments:
+ *	system		Pointer to the unit-system.
+ *	create		Whether or not to create them if they don't exist.
+ * Returns:
+ *	NULL		The unit-system has no deferred units and "create" is
+ *			false or creation failed.  See "errno".
+ *	else		Pointer to the deferred units.
+ */
+static LazyUnits*
+getLazyUnits(
+    const ut_system* const	system,
+    const int			create)
+{
+    LazyUnits** const	slot =
+	(LazyUnits**)coreGetSystemMap(system, SYSTEM_DEFERRED_UNITS);
+
+    if (*slot == NULL && create) {
+	LazyUnits* const	lazy = (LazyUnits*)calloc(1, sizeof(LazyUnits));
+
+	if (lazy != NULL) {
+	    lazy->names = htNew();
+	    lazy->symbols = htNew();
+
+	    if (lazy->names == NULL || lazy->symbols == NULL) {
+		htFree(lazy->names, NULL);
+		htFree(lazy->symbols, NULL);
+		free(lazy);
+	    }
+	    else {
+		*slot = lazy;
+	    }
+	}
+    }
+
+    return *slot;
+}
+
+
+static LazyUnit*
+findUnit(
+    const LazyUnits* const	lazy,
+    const int			isName,
+    const char* const		id)
+{
+    LazyEntry		key;
+    LazyEntry**		entry;
+
+    key.id = id;
+    entry = (LazyEntry**)htFind(getTable(lazy, isName), hashId(id, isName),
+	&key, getCompare(isName));
+
+    return entry == NULL ? NULL : (*entry)->unit;
+}
+
+
+/*
+ * Frees the identifiers of a deferred unit after removing them from the tables
+ * of identifiers.
+ */
+static void
+forgetIds(
+    LazyUnits* const	lazy,
+    LazyUnit* const	unit)
+{
+    size_t	i;
+
+    for (i = 0; i < unit->count; i++) {
+	const LazyId* const	lazyId = unit->ids + i;
+
+	if (lazyId->toUnit) {
+	    LazyEntry		key;
+	    LazyEntry*		entry;
+
+	    key.id = lazyId->id;
+	    entry = (LazyEntry*)htRemove(getTable(lazy, lazyId->isName),
+		hashId(lazyId->id, lazyId->isName), &key,
+		getCompare(lazyId->isName));
+
+	    free(entry);
+	}
+    }
+
+    for (i = 0; i < unit->count; i++)
+	free(unit->ids[i].id);
+
+    free(unit->ids);
+    unit->ids = NULL;
+    unit->count = unit->capacity = 0;
+}
+
+
+static void
+freeUnit(
+    LazyUnit* const	unit)
+{
+    size_t	i;
+
+    for (i = 0; i < unit->count; i++)
+	free(unit->ids[i].id);
+
+    free(unit->ids);
+    free(unit->definition);
+    free(unit);
+}
+
+
+/*
+ * Returns the encoding under which a unit-to-identifier map stores an
+ * identifier: an ASCII identifier with non-ASCII characters is stored as
+ * Latin-1 and a Latin-1 identifier without them as ASCII.
+ */
+static ut_encoding
+storedEncoding(
+    const char*		id,
+    const ut_encoding	encoding)
+{
+    if (encoding == UT_ASCII || encoding == UT_LATIN1) {
+	for (; *id && (*id & 0x80U) == 0; id++)
+	    ;
+
+	return *id ? UT_LATIN1 : UT_ASCII;
+    }
+
+    return encoding;
+}
+
+
+/*
+ * Removes the first mappings of the identifiers of a deferred unit.  The loader
+ * rejects a duplicate identifier, so the mappings belong to the deferred unit.
+ *
+ * Arguments:
+ *	lazyUnit	Pointer to the deferred unit.
+ *	unit		Pointer to the unit that it defines.
+ *	count		Number of identifiers whose mappings are removed.
+ */
+static void
+unmapIds(
+    const LazyUnit* const	lazyUnit,
+    const ut_unit* const	unit,
+    size_t			count)
+{
+    const ut_status	status = ut_get_status();
+
+    while (count-- > 0) {
+	const LazyId* const	lazyId = lazyUnit->ids + count;
+
+	if (lazyId->toUnit) {
+	    ut_system* const	system = ut_get_system(unit);
+
+	    (void)(lazyId->isName
+		? ut_unmap_name_to_unit(system, lazyId->id, lazyId->encoding)
+		: ut_unmap_symbol_to_unit(system, lazyId->id,
+		    lazyId->encoding));
+	}
+	else {
+	    const ut_encoding	encoding =
+		storedEncoding(lazyId->id, lazyId->encoding);
+
+	    (void)(lazyId->isName
+		? ut_unmap_unit_to_name(unit, encoding)
+		: ut_unmap_unit_to_symbol(unit, encoding));
+	}
+    }
+
+    ut_set_status(status);
+}
+
+
+/*
+ * Maps the identifiers of a deferred unit to and from the unit that it
+ * defines.  If an identifier can't be mapped, then the identifiers that were
+ * already mapped are unmapped so that the unit-system isn't left with only some
+ * of them.
+ *
+ * Returns:
+ *	0	Failure.
+ *	else	Success.
+ */
+static int
+mapIds(
+    const LazyUnit* const	lazyUnit,
+    const ut_unit* const	unit)
+{
+    int		success = 1;
+    size_t	i;
+
+    for (i = 0; success && i < lazyUnit->count; i++) {
+	const LazyId* const	lazyId = lazyUnit->ids + i;
+	ut_status		status;
+
+	if (lazyId->toUnit) {
+	    status = lazyId->isName
+		? ut_map_name_to_unit(lazyId->id, lazyId->encoding, unit)
+		: ut_map_symbol_to_unit(lazyId->id, lazyId->encoding, unit);
+	}
+	else {
+	    status = lazyId->isName
+		? ut_map_unit_to_name(unit, lazyId->id, lazyId->encoding)
+		: ut_map_unit_to_symbol(unit, lazyId->id, lazyId->encoding);
+	}
+
+	if (status != UT_SUCCESS) {
+	    ut_set_status(UT_PARSE);
+	    ut_handle_error_message("Couldn't map deferred unit %s \"%s\"",
+		lazyId->isName ? "name" : "symbol", lazyId->id);
+	    unmapIds(lazyUnit, unit, i);
+	    success = 0;
+	}
+    }
+
+    return success;
+}
+
+
+/*
+ * Resolves a deferred unit.
+ *
+ * Returns:
+ *	0	The deferred unit isn't pending or couldn't be resolved.
+ *	else	The deferred unit was resolved.
+ */
+static int
+resolve(
+    ut_system* const		system,
+    LazyUnits* const		lazy,
+    LazyUnit* const		lazyUnit)
+{
+    if (lazyUnit->state == LU_RESOLVING) {
+	ut_set_status(UT_PARSE);
+	ut_handle_error_message("Unit definition \"%s\" depends on itself",
+	    lazyUnit->definition);
+    }
+    else if (lazyUnit->state == LU_PENDING) {
+	ut_unit*	unit;
+
+	lazyUnit->state = LU_RESOLVING;
+	unit = ut_parse(system, lazyUnit->definition, lazyUnit->encoding);
+
+	if (unit == NULL) {
+	    ut_set_status(UT_PARSE);
+	    ut_handle_error_message(
+		"Couldn't parse deferred unit specification \"%s\"",
+		lazyUnit->definition);
+	    lazyUnit->state = LU_FAILED;
+	}
+	else {
+	    lazyUnit->state = LU_FAILED;
+
+	    if (mapIds(lazyUnit, unit)) {
+		if (!lazyUnit->isSecond || ut_set_second(unit) == UT_SUCCESS) {
+		    lazyUnit->state = LU_RESOLVED;
+		}
+		else {
+		    unmapIds(lazyUnit, unit, lazyUnit->count);
+		}
+	    }
+
+	    ut_free(unit);
+	}
+
+	forgetIds(lazy, lazyUnit);
+
+	if (lazyUnit->state == LU_RESOLVED) {
+	    free(lazyUnit->definition);
+	    lazyUnit->definition = NULL;
+	}
+    }
+
+    return lazyUnit->state == LU_RESOLVED;
+}
+
+
+/*
+ * Adds a deferred unit to a unit-system.
+ *
+ * Arguments:
+ *	system		Pointer to the unit-system.
+ *	definition	Pointer to the unit specification.  May be freed upon
+ *			return.
+ *	encoding	The encoding of "definition".
+ * Returns:
+ *	NULL		Failure.  "ut_get_status()" will be UT_OS.
+ *	else		Pointer to the deferred unit.  It belongs to
+ *			"system".
+ */
+LazyUnit*
+luNew(
+    ut_system* const	system,
+    const char* const	definition,
+    const ut_encoding	encoding)
+{
+    LazyUnits* const	lazy = getLazyUnits(system, 1);
+    LazyUnit*		unit = NULL;
+
+    if (lazy != NULL) {
+	if (lazy->count == lazy->capacity) {
+	    const size_t	capacity =
+		lazy->capacity == 0 ? 256 : 2 * lazy->capacity;
+	    LazyUnit** const	units = (LazyUnit**)realloc(lazy->units,
+		capacity * sizeof(LazyUnit*));
+
+	    if (units != NULL) {
+		lazy->units = units;
+		lazy->capacity = capacity;
+	    }
+	}
+
+	if (lazy->count < lazy->capacity) {
+	    unit = (LazyUnit*)calloc(1, sizeof(LazyUnit));
+
+	    if (unit != NULL) {
+		unit->definition = strdup(definition);
+
+		if (unit->definition == NULL) {
+		    free(unit);
+		    unit = NULL;
+		}
+		else {
+		    unit->encoding = encoding;
+		    unit->state = LU_PENDING;
+		    lazy->units[lazy->count++] = unit;
+		}
+	    }
+	}
+    }
+
+    if (unit == NULL) {
+	ut_set_status(UT_OS);
+	ut_handle_error_message(strerror(errno));
+	ut_handle_error_message("luNew(): Couldn't add deferred unit");
+    }
+
+    return unit;
+}
+
+
+/*
+ * Appends an identifier to a deferred unit.
+ *
+ * Returns:
+ *	NULL	Failure.  See "errno".
+ *	else	Pointer to the copy of the identifier.
+ */
+static const char*
+addId(
+    LazyUnit* const	unit,
+    const char* const	id,
+    const ut_encoding	encoding,
+    const int		isName,
+    const int		toUnit)
+{
+    char*	copy = NULL;
+
+    if (unit->count == unit->capacity) {
+	const size_t	capacity = unit->capacity == 0 ? 4 : 2 * unit->capacity;
+	LazyId* const	ids = (LazyId*)realloc(unit->ids,
+	    capacity * sizeof(LazyId));
+
+	if (ids != NULL) {
+	    unit->ids = ids;
+	    unit->capacity = capacity;
+	}
+    }
+
+    if (unit->count < unit->capacity) {
+	copy = strdup(id);
+
+	if (copy != NULL) {
+	    LazyId* const	lazyId = unit->ids + unit->count++;
+
+	    lazyId->id = copy;
+	    lazyId->encoding = encoding;
+	    lazyId->isName = isName;
+	    lazyId->toUnit = toUnit;
+	}
+    }
+
+    return copy;
+}
+
+
+/*
+ * Adds a mapping from an identifier to a deferred unit.  The identifier is
+ * found by luGetDefinition() and luResolve() until the unit is resolved.
+ *
+ * Arguments:
+ *	system		Pointer to the unit-system of "unit".
+ *	unit		Pointer to the deferred unit.
+ *	id		Pointer to the identifier.  May be freed upon return.
+ *	encoding	The encoding of "id".
+ *	isName		Whether or not "id" is a name.
+ * Returns:
+ *	UT_SUCCESS	Success.
+ *	UT_EXISTS	"id" already maps to a deferred unit.
+ *	UT_OS		Operating-system error.  See "errno".
+ */
+ut_status
+luMapIdToUnit(
+    ut_system* const	system,
+    LazyUnit* const	unit,
+    const char* const	id,
+    const ut_encoding	encoding,
+    const int		isName)
+{
+    LazyUnits* const	lazy = getLazyUnits(system, 0);
+    const LazyUnit*	prev = findUnit(lazy, isName, id);
+    ut_status		status;
+
+    if (prev == unit) {
+	status = UT_SUCCESS;
+    }
+    else if (prev != NULL) {
+	status = UT_EXISTS;
+	ut_set_status(status);
+	ut_handle_error_message(
+	    "\"%s\" already maps to a different deferred unit", id);
+    }
+    else {
+	LazyEntry* const	entry = (LazyEntry*)malloc(sizeof(LazyEntry));
+	LazyEntry**		tableEntry = NULL;
+
+	if (entry != NULL) {
+	    entry->id = addId(unit, id, encoding, isName, 1);
+	    entry->unit = unit;
+
+	    if (entry->id != NULL) {
+		tableEntry = (LazyEntry**)htSearch(getTable(lazy, isName),
+		    hashId(id, isName), entry, getCompare(isName));
+
+		if (tableEntry == NULL)
+		    free(unit->ids[--unit->count].id);
+	    }
+
+	    if (tableEntry == NULL)
+		free(entry);
+	}
+
+	if (tableEntry != NULL) {
+	    status = UT_SUCCESS;
+	}
+	else {
+	    status = UT_OS;
+	    ut_set_status(status);
+	    ut_handle_error_message(strerror(errno));
+	    ut_handle_error_message(
+		"luMapIdToUnit(): Couldn't map \"%s\" to deferred unit", id);
+	}
+    }
+
+    return status;
+}
+
+
+/*
+ * Adds a mapping from a deferred unit to an identifier.
+ *
+ * Arguments:
+ *	unit		Pointer to the deferred unit.
+ *	id		Pointer to the identifier.  May be freed upon return.
+ *	encoding	The encoding of "id".
+ *	isName		Whether or not "id" is a name.
+ * Returns:
+ *	UT_SUCCESS	Success.
+ *	UT_OS		Operating-system error.  See "errno".
+ */
+ut_status
+luMapUnitToId(
+    LazyUnit* const	unit,
+    const char* const	id,
+    const ut_encoding	encoding,
+    const int		isName)
+{
+    ut_status	status = UT_SUCCESS;
+
+    if (addId(unit, id, encoding, isName, 0) == NULL) {
+	status = UT_OS;
+	ut_set_status(status);
+	ut_handle_error_message(strerror(errno));
+	ut_handle_error_message(
+	    "luMapUnitToId(): Couldn't map deferred unit to \"%s\"", id);
+    }
+
+    return status;
+}
+
+
+/*
+ * Makes the unit that a deferred unit defines the "second" unit of its
+ * unit-system when it's resolved.
+ *
+ * Arguments:
+ *	unit		Pointer to the deferred unit.
+ */
+void
+luSetSecond(
+    LazyUnit* const	unit)
+{
+    unit->isSecond = 1;
+}
+
+
+/*
+ * Returns the definition of the unresolved, deferred unit to which an
+ * identifier maps.  Nothing is resolved.
+ *
+ * Arguments:
+ *	system		Pointer to the unit-system.
+ *	mapId		SYSTEM_NAME_TO_UNIT or SYSTEM_SYMBOL_TO_UNIT.
+ *	id		Pointer to the identifier.
+ * Returns:
+ *	NULL		"id" doesn't map to an unresolved, deferred unit.
+ *	else		Pointer to the definition.
+ */
+const char*
+luGetDefinition(
+    const ut_system* const	system,
+    const SystemMapId		mapId,
+    const char* const		id)
+{
+    const LazyUnits* const	lazy = getLazyUnits(system, 0);
+    const LazyUnit* const	unit = lazy == NULL
+	? NULL
+	: findUnit(lazy, mapId == SYSTEM_NAME_TO_UNIT, id);
+
+    return unit == NULL ? NULL : unit->definition;
+}
+
+
+/*
+ * Resolves the deferred unit to which an identifier maps: its definition is
+ * parsed -- resolving the deferred units that it references -- and its
+ * identifiers are mapped to and from the resulting unit.  "ut_get_status()" is
+ * unchanged.
+ *
+ * Arguments:
+ *	system		Pointer to the unit-system.
+ *	mapId		SYSTEM_NAME_TO_UNIT or SYSTEM_SYMBOL_TO_UNIT.
+ *	id		Pointer to the identifier.
+ * Returns:
+ *	0		"id" doesn't map to an unresolved, deferred unit or the
+ *			unit couldn't be resolved.
+ *	else		The deferred unit was resolved.
+ */
+int
+luResolve(
+    ut_system* const		system,
+    const SystemMapId		mapId,
+    const char* const		id)
+{
+    LazyUnits* const	lazy = getLazyUnits(system, 0);
+    int			resolved = 0;
+
+    if (lazy != NULL) {
+	LazyUnit* const	unit = findUnit(lazy, mapId == SYSTEM_NAME_TO_UNIT, id);
+
+	if (unit != NULL) {
+	    const ut_status	prev = ut_get_status();
+
+	    resolved = resolve(system, lazy, unit);
+	    ut_set_status(prev);
+	}
+    }
+
+    return resolved;
+}
+
+
+/*
+ * Resolves every deferred unit of a unit-system.
+ *
+ * Arguments:
+ *	system		Pointer to the unit-system.
+ * Returns:
+ *	UT_SUCCESS	Success.
+ *	UT_PARSE	A deferred unit couldn't be resolved.
+ */
+ut_status
+luResolveAll(
+    ut_system* const	system)
+{
+    LazyUnits* const	lazy = getLazyUnits(system, 0);
+    ut_status		status = UT_SUCCESS;
+
+    if (lazy != NULL) {
+	const ut_status	prev = ut_get_status();
+	size_t		i;
+
+	for (i = 0; i < lazy->count; i++) {
+	    LazyUnit* const	unit = lazy->units[i];
+
+	    (void)resolve(system, lazy, unit);
+
+	    if (unit->state == LU_FAILED)
+		status = UT_PARSE;
+	}
+
+	ut_set_status(prev);
+    }
+
+    return status;
+}
+
+
+/*
+ * Resolves every deferred unit of a unit-system and frees the resources that
+ * were used to defer them.
+ *
+ * Arguments:
+ *	system		Pointer to the unit-system.
+ * Returns:
+ *	UT_SUCCESS	Success.
+ *	UT_PARSE	A deferred unit couldn't be resolved.  Nothing was
+ *			freed.
+ */
+ut_status
+luFreezeSystem(
+    ut_system*	system)
+{
+    const ut_status	status = luResolveAll(system);
+
+    if (status == UT_SUCCESS)
+	luFreeSystem(system);
+
+    return status;
+}
+
+
+/*
+ * Frees resources associated with a unit-system.
+ *
+ * Arguments:
+ *	system		Pointer to the unit-system to have its associated
+ *			resources freed.
+ */
+void
+luFreeSystem(
+    ut_system*	system)
+{
+    if (system != NULL) {
+	LazyUnits** const	slot =
+	    (LazyUnits**)coreGetSystemMap(system, SYSTEM_DEFERRED_UNITS);
+	LazyUnits* const	lazy = *slot;
+
+	if (lazy != NULL) {
+	    size_t	i;
+
+	    htFree(lazy->names, free);
+	    htFree(lazy->symbols, free);
+
+	    for (i = 0; i < lazy->count; i++)
+		freeUnit(lazy->units[i]);
+
+	    free(lazy->units);
+	    free(lazy);
+	    *slot = NULL;
+	}
+    }
+}
+
+
+/*
+ * Adds the memory of the deferred units of a unit-system to the memory
+ * statistics of the unit-system.
+ *
+ * Arguments:
+ *	system		Pointer to the unit-system.
+ *	stats		Pointer to the statistics to be augmented.
+ */
+void
+luGetMemory(
+    const ut_system* const	system,
+    ut_memory_stats* const	stats)
+{
+    const LazyUnits* const	lazy = getLazyUnits(system, 0);
+
+    if (lazy != NULL) {
+	size_t	i;
+
+	stats->deferred.bytes += sizeof(LazyUnits) +
+	    lazy->capacity*sizeof(LazyUnit*) +
+	    htGetMemory(lazy->names) + htGetMemory(lazy->symbols) +
+	    (htCount(lazy->names) + htCount(lazy->symbols))*sizeof(LazyEntry);
+	stats->deferred.count += lazy->count;
+
+	for (i = 0; i < lazy->count; i++) {
+	    const LazyUnit* const	unit = lazy->units[i];
+	    size_t			j;
+
+	    stats->deferred.bytes += sizeof(LazyUnit) +
+		unit->capacity*sizeof(LazyId);
+
+	    if (unit->definition != NULL)
+		stats->deferred.bytes += strlen(unit->definition) + 1;
+
+	    for (j = 0; j < unit->count; j++)
+		stats->deferred.bytes += strlen(unit->ids[j].id) + 1;
+	}
+    }
+}
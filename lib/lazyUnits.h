@@ -0,0 +1,208 @@
+/*
+ * Copyright 2020 University Corporation for Atmospheric Research
+ *
+ * This file is part of the UDUNITS-2 package.  See the file COPYRIGHT
+ * in the top-level source-directory of the package for copying and
+ * redistribution conditions.
+ */
+/*
+ * Deferred unit-definitions of a unit-system (see ut_read_xml_lazy()).
+ *
+ * A deferred unit is a definition that hasn't been parsed together with the
+ * identifiers that will map to and from the unit it defines.  The unit is
+ * created -- and its identifiers mapped -- the first time one of its
+ * identifiers is looked up.
+ */
+#ifndef UT_LAZY_UNITS_H_INCLUDED
+#define UT_LAZY_UNITS_H_INCLUDED
+
+#include "udunits2.h"
+#include "unitcore.h"
+
+typedef struct LazyUnit	LazyUnit;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ * Adds a deferred unit to a unit-system.
+ *
+ * Arguments:
+ *	system		Pointer to the unit-system.
+ *	definition	Pointer to the unit specification.  May be freed upon
+ *			return.
+ *	encoding	The encoding of "definition".
+ * Returns:
+ *	NULL		Failure.  "ut_get_status()" will be UT_OS.
+ *	else		Pointer to the deferred unit.  It belongs to
+ *			"system".
+ */
+LazyUnit*
+luNew(
+    ut_system* const	system,
+    const char* const	definition,
+    const ut_encoding	encoding);
+
+
+/*
+ * Adds a mapping from an identifier to a deferred unit.  The identifier is
+ * found by luGetDefinition() and luResolve() until the unit is resolved.
+ *
+ * Arguments:
+ *	system		Pointer to the unit-system of "unit".
+ *	unit		Pointer to the deferred unit.
+ *	id		Pointer to the identifier.  May be freed upon return.
+ *	encoding	The encoding of "id".
+ *	isName		Whether or not "id" is a name.
+ * Returns:
+ *	UT_SUCCESS	Success.
+ *	UT_EXISTS	"id" already maps to a deferred unit.
+ *	UT_OS		Operating-system error.  See "errno".
+ */
+ut_status
+luMapIdToUnit(
+    ut_system* const	system,
+    LazyUnit* const	unit,
+    const char* const	id,
+    const ut_encoding	encoding,
+    const int		isName);
+
+
+/*
+ * Adds a mapping from a deferred unit to an identifier.
+ *
+ * Arguments:
+ *	unit		Pointer to the deferred unit.
+ *	id		Pointer to the identifier.  May be freed upon return.
+ *	encoding	The encoding of "id".
+ *	isName		Whether or not "id" is a name.
+ * Returns:
+ *	UT_SUCCESS	Success.
+ *	UT_OS		Operating-system error.  See "errno".
+ */
+ut_status
+luMapUnitToId(
+    LazyUnit* const	unit,
+    const char* const	id,
+    const ut_encoding	encoding,
+    const int		isName);
+
+
+/*
+ * Makes the unit that a deferred unit defines the "second" unit of its
+ * unit-system when it's resolved.
+ *
+ * Arguments:
+ *	unit		Pointer to the deferred unit.
+ */
+void
+luSetSecond(
+    LazyUnit* const	unit);
+
+
+/*
+ * Returns the definition of the unresolved, deferred unit to which an
+ * identifier maps.  Nothing is resolved.
+ *
+ * Arguments:
+ *	system		Pointer to the unit-system.
+ *	mapId		SYSTEM_NAME_TO_UNIT or SYSTEM_SYMBOL_TO_UNIT.
+ *	id		Pointer to the identifier.
+ * Returns:
+ *	NULL		"id" doesn't map to an unresolved, deferred unit.
+ *	else		Pointer to the definition.
+ */
+const char*
+luGetDefinition(
+    const ut_system* const	system,
+    const SystemMapId		mapId,
+    const char* const		id);
+
+
+/*
+ * Resolves the deferred unit to which an identifier maps: its definition is
+ * parsed -- resolving the deferred units that it references -- and its
+ * identifiers are mapped to and from the resulting unit.  This modifies the
+ * unit-system.  "ut_get_status()" is unchanged.
+ *
+ * Arguments:
+ *	system		Pointer to the unit-system.  Shall not be frozen (a
+ *			frozen unit-system has no deferred units).
+ *	mapId		SYSTEM_NAME_TO_UNIT or SYSTEM_SYMBOL_TO_UNIT.
+ *	id		Pointer to the identifier.
+ * Returns:
+ *	0		"id" doesn't map to an unresolved, deferred unit or the
+ *			unit couldn't be resolved.
+ *	else		The deferred unit was resolved.
+ */
+int
+luResolve(
+    ut_system* const		system,
+    const SystemMapId		mapId,
+    const char* const		id);
+
+
+/*
+ * Resolves every deferred unit of a unit-system.  This modifies the
+ * unit-system.
+ *
+ * Arguments:
+ *	system		Pointer to the unit-system.  Shall not be frozen.
+ * Returns:
+ *	UT_SUCCESS	Success.
+ *	UT_PARSE	A deferred unit couldn't be resolved.
+ */
+ut_status
+luResolveAll(
+    ut_system* const	system);
+
+
+/*
+ * Resolves every deferred unit of a unit-system and frees the resources that
+ * were used to defer them.
+ *
+ * Arguments:
+ *	system		Pointer to the unit-system.
+ * Returns:
+ *	UT_SUCCESS	Success.
+ *	UT_PARSE	A deferred unit couldn't be resolved.  Nothing was
+ *			freed.
+ */
+ut_status
+luFreezeSystem(
+    ut_system*	system);
+
+
+/*
+ * Frees resources associated with a unit-system.
+ *
+ * Arguments:
+ *	system		Pointer to the unit-system to have its associated
+ *			resources freed.
+ */
+void
+luFreeSystem(
+    ut_system*	system);
+
+
+/*
+ * Adds the memory of the deferred units of a unit-system to the memory
+ * statistics of the unit-system (see ut_get_memory_stats()).
+ *
+ * Arguments:
+ *	system		Pointer to the unit-system.
+ *	stats		Pointer to the statistics to be augmented.
+ */
+void
+luGetMemory(
+    const ut_system* const	system,
+    ut_memory_stats* const	stats);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
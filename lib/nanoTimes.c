@@ -0,0 +1,591 @@
+/*
+ * Copyright 2020 University Corporation for Atmospheric Research
+ *
+ * This file is part of the UDUNITS-2 package.  See the file COPYRIGHT
+ * in the top-level source-directory of the package for copying and
+ * redistribution conditions.
+ */
+/*
+ * Times as 64-bit integer nanoseconds since 1970-01-01 00:00:00 UTC:
+ * ut_encode_time_ns(), ut_decode_time_ns(), and the conversion of values in
+ * timestamp-units to and from such times.
+ *
+ * Unlike encoded times (see ut_encode_time()), which are double-precision
+ * seconds since 2001-01-01 and lose sub-microsecond precision within a few
+ * years of that origin, these times are exact to the nanosecond over their
+ * whole range (1677-09-21 to 2262-04-11).  Calendar arithmetic is done with
+ * integers only.  The range lies entirely after the Gregorian reform, so the
+ * proleptic Gregorian algorithms below agree with the hybrid calendar of
+ * ut_encode_date().  As there, leap-seconds aren't counted.
+ *
+ * LLONG_MIN (UT_NS_INVALID) marks an invalid time, so it's never a valid
+ * encoding.
+ */
+
+/*LINTLIBRARY*/
+
+#include "config.h"
+
+#include "udunits2.h"
+#include "converter.h"
+#include "unitcore.h"
+
+#include <limits.h>
+#include <math.h>
+#include <stddef.h>
+
+#define NS_PER_SECOND	1000000000LL
+#define SECONDS_PER_DAY	86400LL
+/*
+ * Years outside this range can't be encoded (finer checks follow):
+ */
+#define MIN_NS_YEAR	1677
+#define MAX_NS_YEAR	2262
+/*
+ * 2001-01-01 (the origin of encoded times) in seconds since 1970-01-01:
+ */
+#define ORIGIN_SECONDS	978307200LL
+
+/*
+ * Conversion between a timestamp-unit and times in nanoseconds:
+ *	ns = origin + value*scale
+ */
+typedef struct {
+    long long	scale;		/* nanoseconds per unit */
+    long long	origin;		/* of the unit in nanoseconds */
+} NsMap;
+
+
+/*
+ * Returns the number of days from 1970-01-01 to a date in the proleptic
+ * Gregorian calendar.
+ *
+ * Arguments:
+ *	year	The year.  0 is 1 BCE.
+ *	month	The month (1-12).
+ *	day	The day.  Days past the end of the month continue into the next
+ *		month, as in ut_encode_date().
+ */
+static long long
+daysFromDate(
+    int		year,
+    const int	month,
+    const int	day)
+{
+    long long	era;
+    long long	yoe;		/* year of era */
+    long long	doy;		/* day of year starting in March */
+    long long	doe;		/* day of era */
+
+    year -= month <= 2;
+    era = (year >= 0 ? year : year - 399) / 400;
+    yoe = year - era * 400;
+    doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+
+    return era * 146097 + doe - 719468;
+}
+
+
+/*
+ * Returns the date in the proleptic Gregorian calendar of a number of days
+ * since 1970-01-01.
+ *
+ * Arguments:
+ *	days	The number of days.
+ *	year	Pointer to the year.
+ *	month	Pointer to the month.
+ *	day	Pointer to the day.
+ */
+static void
+dateFromDays(
+    long long		days,
+    int* const		year,
+    int* const		month,
+    int* const		day)
+{
+    long long	era;
+    long long	doe;		/* day of era */
+    long long	yoe;		/* year of era */
+    long long	doy;		/* day of year starting in March */
+    long long	mp;		/* month starting in March */
+
+    days += 719468;
+    era = (days >= 0 ? days : days - 146096) / 146097;
+    doe = days - era * 146097;
+    yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    mp = (5 * doy + 2) / 153;
+
+    *day = (int)(doy - (153 * mp + 2) / 5 + 1);
+    *month = (int)(mp < 10 ? mp + 3 : mp - 9);
+    *year = (int)(yoe + era * 400 + (*month <= 2));
+}
+
+
+/*
+ * Returns the sum of a product and a number if it's a valid time.
+ *
+ * Arguments:
+ *	a	The multiplicand.
+ *	b	The multiplier.  Shall be positive.
+ *	c	The addend.
+ *	result	Pointer to "a*b + c".
+ * Returns:
+ *	0	"a*b + c" is UT_NS_INVALID or can't be represented.
+ *	1	Success.
+ */
+static int
+mulAdd(
+    const long long		a,
+    const long long		b,
+    const long long		c,
+    long long* const		result)
+{
+    long long	product;
+
+    if (a > LLONG_MAX / b || a < -(LLONG_MAX / b))
+	return 0;
+
+    product = a * b;
+
+    if (c > 0 ? product > LLONG_MAX - c : product <= LLONG_MIN - c)
+	return 0;
+
+    *result = product + c;
+
+    return 1;
+}
+
+
+/*
+ * Returns the nanoseconds per unit and the origin of a timestamp-unit.
+ *
+ * Arguments:
+ *	func	Name of the calling function for error-messages.
+ *	unit	Pointer to the timestamp-unit.
+ *	map	Pointer to the conversion.
+ * Returns:
+ *	0	Failure.  "ut_get_status()" will be
+ *		    UT_BAD_ARG		"unit" is NULL.
+ *		    UT_MEANINGLESS	"unit" isn't a timestamp-unit, its
+ *					interval isn't a whole number of
+ *					nanoseconds, or its origin is outside
+ *					the range of times.
+ *		    UT_NO_SECOND	The unit-system has no second.
+ *		    UT_OS		Operating-system error.
+ *	1	Success.
+ */
+static int
+getNsMap(
+    const char* const		func,
+    const ut_unit* const	unit,
+    NsMap* const		map)
+{
+    CoreUnitDescription	description;
+    const ut_unit*	second;
+    cv_converter*	converter;
+    double		scale;
+    double		offset;
+    double		ns;
+    double		origin;
+
+    if (unit == NULL) {
+	ut_set_status(UT_BAD_ARG);
+	ut_handle_error_message("%s(): NULL unit argument", func);
+	return 0;
+    }
+
+    coreDescribeUnit(unit, &description);
+
+    if (description.kind != CORE_TIMESTAMP) {
+	ut_set_status(UT_MEANINGLESS);
+	ut_handle_error_message("%s(): Not a timestamp-unit", func);
+	return 0;
+    }
+
+    second = coreGetSecond(ut_get_system(unit));
+
+    if (second == NULL) {
+	ut_set_status(UT_NO_SECOND);
+	ut_handle_error_message("%s(): No \"second\" unit defined", func);
+	return 0;
+    }
+
+    converter = ut_get_converter((ut_unit*)description.unit, (ut_unit*)second);
+
+    if (converter == NULL)
+	return 0;
+
+    offset = cv_convert_double(converter, 0.0);
+    scale = cv_convert_double(converter, 1.0) - offset;
+    cv_free(converter);
+
+    /*
+     * The scale of a prefixed unit (e.g., 1e-3 for "ms") is the nearest double
+     * to a decimal value, so it's rounded to the nanosecond.
+     */
+    ns = scale * NS_PER_SECOND;
+
+    if (offset != 0 || !(ns >= 0.5 && ns < 0x1p62) ||
+	    fabs(ns - floor(ns + 0.5)) > 1e-9 * ns) {
+	ut_set_status(UT_MEANINGLESS);
+	ut_handle_error_message("%s(): Interval of unit isn't a whole number "
+	    "of nanoseconds", func);
+	return 0;
+    }
+
+    map->scale = (long long)floor(ns + 0.5);
+
+    /*
+     * The origin is an encoded time.  Those are exact to about a microsecond
+     * near 2001, so the origin is rounded to the microsecond.
+     */
+    origin = floor(description.value * 1e6 + 0.5);
+
+    if (!(fabs(origin) < 9e15) ||
+	    !mulAdd((long long)origin, 1000, ORIGIN_SECONDS * NS_PER_SECOND,
+		&map->origin)) {
+	ut_set_status(UT_MEANINGLESS);
+	ut_handle_error_message("%s(): Origin of unit is outside the range of "
+	    "64-bit nanosecond times", func);
+	return 0;
+    }
+
+    return 1;
+}
+
+
+/*
+ * Handles the invalid elements of a conversion.
+ *
+ * Arguments:
+ *	func	Name of the calling function.
+ *	nbad	Number of invalid elements.
+ */
+static void
+setConversionStatus(
+    const char* const	func,
+    const size_t	nbad)
+{
+    if (nbad == 0) {
+	ut_set_status(UT_SUCCESS);
+    }
+    else {
+	ut_set_status(UT_BAD_ARG);
+	ut_handle_error_message("%s(): %lu value(s) couldn't be converted",
+	    func, (unsigned long)nbad);
+    }
+}
+
+
+/******************************************************************************
+ * Public API:
+ ******************************************************************************/
+
+/*
+ * Encodes a time as nanoseconds since 1970-01-01 00:00:00 UTC.  See
+ * udunits2.h.
+ *
+ * Returns:
+ *	UT_SUCCESS	Success.
+ *	UT_BAD_ARG	"value" is NULL, a component is invalid, or the time is
+ *			outside the range of 64-bit nanoseconds.
+ */
+ut_status
+ut_encode_time_ns(
+    const int		year,
+    const int		month,
+    const int		day,
+    const int		hour,
+    const int		minute,
+    const int		second,
+    const long		nanosecond,
+    long long* const	value)
+{
+    if (value == NULL) {
+	ut_set_status(UT_BAD_ARG);
+	ut_handle_error_message("ut_encode_time_ns(): NULL value argument");
+    }
+    else if (ut_check_date(year, month, day) == UT_SUCCESS &&
+	    ut_check_clock(hour, minute, second) == UT_SUCCESS) {
+	if (nanosecond < 0 || nanosecond >= NS_PER_SECOND) {
+	    ut_set_status(UT_BAD_ARG);
+	    ut_handle_error_message("Invalid nanosecond %ld (must be "
+		"0-999999999)", nanosecond);
+	}
+	else {
+	    long long	seconds = 0;
+	    int		ok = year >= MIN_NS_YEAR && year <= MAX_NS_YEAR;
+
+	    if (ok) {
+		seconds = daysFromDate(year, month, day) * SECONDS_PER_DAY +
+		    (hour * 60LL + minute) * 60 + second;
+		/*
+		 * "seconds*10^9 + nanosecond" without intermediate overflow.
+		 */
+		ok = seconds < 0
+		    ? mulAdd(seconds + 1, NS_PER_SECOND,
+			nanosecond - NS_PER_SECOND, value)
+		    : mulAdd(seconds, NS_PER_SECOND, nanosecond, value);
+	    }
+
+	    if (ok) {
+		ut_set_status(UT_SUCCESS);
+	    }
+	    else {
+		ut_set_status(UT_BAD_ARG);
+		ut_handle_error_message("ut_encode_time_ns(): Time is outside "
+		    "the range of 64-bit nanoseconds");
+	    }
+	}
+    }
+
+    return ut_get_status();
+}
+
+
+/*
+ * Decodes a time in nanoseconds since 1970-01-01 00:00:00 UTC.  See
+ * udunits2.h.
+ *
+ * Returns:
+ *	UT_SUCCESS	Success.
+ *	UT_BAD_ARG	A pointer argument is NULL or "value" is UT_NS_INVALID.
+ */
+ut_status
+ut_decode_time_ns(
+    const long long	value,
+    int* const		year,
+    int* const		month,
+    int* const		day,
+    int* const		hour,
+    int* const		minute,
+    int* const		second,
+    long* const		nanosecond)
+{
+    if (year == NULL || month == NULL || day == NULL || hour == NULL ||
+	    minute == NULL || second == NULL || nanosecond == NULL) {
+	ut_set_status(UT_BAD_ARG);
+	ut_handle_error_message("ut_decode_time_ns(): NULL argument");
+    }
+    else if (value == UT_NS_INVALID) {
+	ut_set_status(UT_BAD_ARG);
+	ut_handle_error_message("ut_decode_time_ns(): Invalid time");
+    }
+    else {
+	long long	seconds = value / NS_PER_SECOND;
+	long long	ns = value % NS_PER_SECOND;
+	long long	days;
+	long long	clock;
+
+	if (ns < 0) {
+	    ns += NS_PER_SECOND;
+	    seconds--;
+	}
+
+	days = seconds / SECONDS_PER_DAY;
+	clock = seconds % SECONDS_PER_DAY;
+
+	if (clock < 0) {
+	    clock += SECONDS_PER_DAY;
+	    days--;
+	}
+
+	dateFromDays(days, year, month, day);
+	*hour = (int)(clock / 3600);
+	*minute = (int)(clock / 60 % 60);
+	*second = (int)(clock % 60);
+	*nanosecond = (long)ns;
+
+	ut_set_status(UT_SUCCESS);
+    }
+
+    return ut_get_status();
+}
+
+
+/*
+ * Converts values in a timestamp-unit to nanoseconds since 1970-01-01
+ * 00:00:00 UTC.  See udunits2.h.
+ *
+ * Returns:
+ *	UT_SUCCESS	Success.
+ *	UT_BAD_ARG	"values" or "ns" is NULL or at least one value isn't
+ *			finite or is out of range, in which case its time is
+ *			UT_NS_INVALID.
+ *	else		See getNsMap().
+ */
+ut_status
+ut_times_to_ns(
+    const ut_unit* const	unit,
+    const double* const		values,
+    const size_t		count,
+    long long* const		ns)
+{
+    NsMap	map;
+
+    if (getNsMap("ut_times_to_ns", unit, &map)) {
+	if (count > 0 && (values == NULL || ns == NULL)) {
+	    ut_set_status(UT_BAD_ARG);
+	    ut_handle_error_message("ut_times_to_ns(): NULL argument");
+	}
+	else {
+	    const double	scale = (double)map.scale;
+	    size_t		nbad = 0;
+	    size_t		i;
+
+	    for (i = 0; i < count; i++) {
+		/*
+		 * The whole and fractional units are converted separately so
+		 * that the result is exact for whole units and rounded to the
+		 * nanosecond otherwise.
+		 */
+		const double	whole = floor(values[i]);
+		long long	fraction;
+
+		ns[i] = UT_NS_INVALID;
+
+		if (!(fabs(whole) < 0x1p62)) {
+		    nbad++;
+		    continue;
+		}
+
+		fraction = (long long)floor((values[i] - whole) * scale + 0.5);
+
+		if (!mulAdd((long long)whole, map.scale, map.origin, &ns[i]) ||
+			(ns[i] > LLONG_MAX - fraction)) {
+		    ns[i] = UT_NS_INVALID;
+		    nbad++;
+		}
+		else {
+		    ns[i] += fraction;
+		}
+	    }
+
+	    setConversionStatus("ut_times_to_ns", nbad);
+	}
+    }
+
+    return ut_get_status();
+}
+
+
+/*
+ * Converts integral values in a timestamp-unit to nanoseconds since
+ * 1970-01-01 00:00:00 UTC.  See udunits2.h.
+ *
+ * Returns:
+ *	UT_SUCCESS	Success.
+ *	UT_BAD_ARG	"counts" or "ns" is NULL or at least one value is out
+ *			of range, in which case its time is UT_NS_INVALID.
+ *	else		See getNsMap().
+ */
+ut_status
+ut_counts_to_ns(
+    const ut_unit* const	unit,
+    const long long* const	counts,
+    const size_t		count,
+    long long* const		ns)
+{
+    NsMap	map;
+
+    if (getNsMap("ut_counts_to_ns", unit, &map)) {
+	if (count > 0 && (counts == NULL || ns == NULL)) {
+	    ut_set_status(UT_BAD_ARG);
+	    ut_handle_error_message("ut_counts_to_ns(): NULL argument");
+	}
+	else {
+	    size_t	nbad = 0;
+	    size_t	i;
+
+	    if (map.scale == 1) {
+		for (i = 0; i < count; i++) {
+		    if (counts[i] == UT_NS_INVALID || (map.origin > 0
+			    ? counts[i] > LLONG_MAX - map.origin
+			    : counts[i] <= LLONG_MIN - map.origin)) {
+			ns[i] = UT_NS_INVALID;
+			nbad++;
+		    }
+		    else {
+			ns[i] = counts[i] + map.origin;
+		    }
+		}
+	    }
+	    else {
+		for (i = 0; i < count; i++) {
+		    if (!mulAdd(counts[i], map.scale, map.origin, &ns[i])) {
+			ns[i] = UT_NS_INVALID;
+			nbad++;
+		    }
+		}
+	    }
+
+	    setConversionStatus("ut_counts_to_ns", nbad);
+	}
+    }
+
+    return ut_get_status();
+}
+
+
+/*
+ * Converts nanoseconds since 1970-01-01 00:00:00 UTC to integral values in a
+ * timestamp-unit.  See udunits2.h.
+ *
+ * Returns:
+ *	UT_SUCCESS	Success.
+ *	UT_BAD_ARG	"ns" or "counts" is NULL or at least one time is
+ *			UT_NS_INVALID or its value is out of range, in which
+ *			case its value is UT_NS_INVALID.
+ *	else		See getNsMap().
+ */
+ut_status
+ut_ns_to_counts(
+    const ut_unit* const	unit,
+    const long long* const	ns,
+    const size_t		count,
+    long long* const		counts)
+{
+    NsMap	map;
+
+    if (getNsMap("ut_ns_to_counts", unit, &map)) {
+	if (count > 0 && (ns == NULL || counts == NULL)) {
+	    ut_set_status(UT_BAD_ARG);
+	    ut_handle_error_message("ut_ns_to_counts(): NULL argument");
+	}
+	else {
+	    size_t	nbad = 0;
+	    size_t	i;
+
+	    for (i = 0; i < count; i++) {
+		long long	delta;
+
+		if (ns[i] == UT_NS_INVALID || (map.origin > 0
+			? ns[i] < LLONG_MIN + map.origin
+			: ns[i] > LLONG_MAX + map.origin)) {
+		    counts[i] = UT_NS_INVALID;
+		    nbad++;
+		    continue;
+		}
+
+		/*
+		 * Floor division, so that times before the origin round toward
+		 * earlier values like those after it.
+		 */
+		delta = ns[i] - map.origin;
+		counts[i] = delta / map.scale;
+
+		if (delta % map.scale < 0)
+		    counts[i]--;
+
+		if (counts[i] == UT_NS_INVALID)
+		    nbad++;
+	    }
+
+	    setConversionStatus("ut_ns_to_counts", nbad);
+	}
+    }
+
+    return ut_get_status();
+}
@@ -10,16 +10,19 @@
 /*
  * bison(1)-based parser for decoding formatted unit specifications.
  *
- * This module is thread-compatible but not thread-safe: multi-threaded access
- * must be externally synchronized.
+ * The parser is pure and the scanner is reentrant: all parsing state lives in
+ * a ParseState on the stack of ut_parse(), so concurrent parses don't interfere
+ * with one another.
  */
 
 /*LINTLIBRARY*/
 
 #include "config.h"
 
+#include "errorMessages.h"
 #include "prefix.h"
 #include "udunits2.h"
+#include "unitcore.h"
 
 #include <assert.h>
 #include <ctype.h>
@@ -32,30 +35,20 @@
 #include <strings.h>
 #endif
 
-extern int utlex (void);
-
-/*
- *  YACC error routine. Defined in the post-%% section so it can inspect
- *  yychar/yylval (declared by bison's generated yyparse). When the lookahead
- *  is an ERR token carrying a scanner-supplied message, emit that message
- *  instead of the generic "syntax error".
- */
-void uterror(const char *s);
+#ifndef YY_TYPEDEF_YY_SCANNER_T
+#define YY_TYPEDEF_YY_SCANNER_T
+typedef void* yyscan_t;			/* reentrant flex(1) scanner */
+#endif
 
 /*
  * Size of the error-message buffer carried on the ERR token. Used by
  * scanner.l and by the parser's uterror() routine. Bumping this value
  * automatically resizes the union member below and every snprintf that
- * writes into it, provided callers use sizeof(yylval.error_msg) or
+ * writes into it, provided callers use sizeof(yylval->error_msg) or
  * UT_ERR_MSG_LEN.
  */
 #define UT_ERR_MSG_LEN 256
 
-static ut_unit*		_finalUnit;	/* fully-parsed specification */
-static ut_system*	_unitSystem;	/* The unit-system to use */
-static ut_encoding	_encoding;	/* encoding of string to be parsed */
-static int		_restartScanner;/* restart scanner? */
-static int		_isTime;        /* product_exp is time? */
 
 
 /*
@@ -130,17 +123,18 @@ static void to_clock(
 /**
  * Indicates if a unit is a (non-offset) time unit.
  *
+ * @param[in] system    The unit-system of the parse.
  * @param[in] unit      The unit to be checked.
  * @retval    0         If and only if the unit is not a time unit.
  */
 static int isTime(
-    const ut_unit* const unit)
+    const ut_system* const system,
+    const ut_unit* const   unit)
 {
-    ut_status   prev = ut_get_status();
-    ut_unit*    second = ut_get_unit_by_name(_unitSystem, "second");
-    int         isTime = ut_are_convertible(unit, second);
+    ut_status           prev = ut_get_status();
+    const ut_unit*      second = ut_lookup_unit_by_name(system, "second");
+    int                 isTime = ut_are_convertible(unit, second);
 
-    ut_free(second);
     ut_set_status(prev);
     return isTime;
 }
@@ -155,6 +149,39 @@ static int isTime(
     char	error_msg[UT_ERR_MSG_LEN];	/* error message from lexer */
 }
 
+%code requires {
+typedef struct ParseState	ParseState;
+}
+
+%code {
+/*
+ * State of a single parse.  The scanner's "extra" data points to it.
+ */
+struct ParseState {
+    ut_system*		unitSystem;	/* The unit-system to use */
+    ut_unit*		finalUnit;	/* fully-parsed specification */
+    int			isTime;		/* product_exp is time? */
+    yyscan_t		scanner;	/* lexical scanner */
+    int			token;		/* last token returned by scanner */
+    const YYSTYPE*	value;		/* semantic value of "token" */
+    size_t		consumed;	/* bytes matched by scanner */
+};
+
+static int utlex(YYSTYPE* value, ParseState* state);
+
+/*
+ *  YACC error routine. Defined in the post-%% section so it can inspect the
+ *  lookahead token that the scanner last returned. When the lookahead is an
+ *  ERR token carrying a scanner-supplied message, emit that message instead
+ *  of the generic "syntax error".
+ */
+static void uterror(ParseState* state, const char *s);
+}
+
+%define api.pure full
+%parse-param	{ParseState* state}
+%lex-param	{ParseState* state}
+
 %token  <error_msg>	ERR
 %token		SHIFT
 %token  	MULTIPLY
@@ -220,11 +247,11 @@ static int isTime(
 %%
 
 unit_spec:      /* nothing */ {
-		    _finalUnit = ut_get_dimensionless_unit_one(_unitSystem);
+		    state->finalUnit = ut_get_dimensionless_unit_one(state->unitSystem);
 		    YYACCEPT;
 		} |
 		shift_exp {
-		    _finalUnit = $1;
+		    state->finalUnit = $1;
 		    YYACCEPT;
 		} |
 		error {
@@ -263,11 +290,11 @@ shift_exp:	product_exp {
 
 product_exp:	power_exp {
 		    $$ = $1;
-                    _isTime = isTime($$);
+                    state->isTime = isTime(state->unitSystem, $$);
 		} |
 		product_exp power_exp	{
 		    $$ = ut_multiply($1, $2);
-                    _isTime = isTime($$);
+                    state->isTime = isTime(state->unitSystem, $$);
 		    ut_free($1);
 		    ut_free($2);
 		    if ($$ == NULL)
@@ -281,7 +308,7 @@ product_exp:	power_exp {
 		} |
 		product_exp MULTIPLY power_exp	{
 		    $$ = ut_multiply($1, $3);
-                    _isTime = isTime($$);
+                    state->isTime = isTime(state->unitSystem, $$);
 		    ut_free($1);
 		    ut_free($3);
 		    if ($$ == NULL)
@@ -295,7 +322,7 @@ product_exp:	power_exp {
 		} |
 		product_exp DIVIDE power_exp	{
 		    $$ = ut_divide($1, $3);
-                    _isTime = isTime($$);
+                    state->isTime = isTime(state->unitSystem, $$);
 		    ut_free($1);
 		    ut_free($3);
 		    if ($$ == NULL)
@@ -333,34 +360,38 @@ power_exp:	basic_exp {
 		;
 
 basic_exp:	ID {
-		    double	prefix = 1;
-		    ut_unit*	unit = NULL;
-		    char*	cp = $1;
-		    int		symbolPrefixSeen = 0;
-
+		    double		prefix = 1;
+		    const ut_unit*	unit = NULL;
+		    char*		cp = $1;
+		    int			symbolPrefixSeen = 0;
+
+		    /*
+		     * The identifier units are borrowed from the unit-system;
+		     * only the scaled result is allocated.
+		     */
 		    while (*cp) {
 			size_t	nchar;
 			double	value;
 
-			unit = ut_get_unit_by_name(_unitSystem, cp);
+			unit = ut_lookup_unit_by_name(state->unitSystem, cp);
 
 			if (unit != NULL)
 			    break;
 
-			unit = ut_get_unit_by_symbol(_unitSystem, cp);
+			unit = ut_lookup_unit_by_symbol(state->unitSystem, cp);
 
 			if (unit != NULL)
 			    break;
 
-			if (utGetPrefixByName(_unitSystem, cp, &value, &nchar)
-				== UT_SUCCESS) {
+			if (utGetPrefixByName(state->unitSystem, cp, &value,
+				&nchar) == UT_SUCCESS) {
 			    prefix *= value;
 			    cp += nchar;
 			}
 			else {
 			    if (!symbolPrefixSeen &&
-				    utGetPrefixBySymbol(_unitSystem, cp, &value,
-					&nchar) == UT_SUCCESS) {
+				    utGetPrefixBySymbol(state->unitSystem, cp,
+					&value, &nchar) == UT_SUCCESS) {
 				symbolPrefixSeen = 1;
 				prefix *= value;
 				cp += nchar;
@@ -380,8 +411,6 @@ basic_exp:	ID {
 
 		    $$ = ut_scale(prefix, unit);
 
-		    ut_free(unit);
-
 		    if ($$ == NULL)
 			YYERROR;
 		} |
@@ -408,7 +437,7 @@ basic_exp:	ID {
 		} |
 		number {
 		    $$ = ut_scale($1,
-                        ut_get_dimensionless_unit_one(_unitSystem));
+                        ut_get_dimensionless_unit_one(state->unitSystem));
 		}
 		;
 
@@ -473,8 +502,6 @@ timestamp:      DATE {
 %%
 
 #define yymaxdepth	utmaxdepth
-#define yylval		utlval
-#define yychar		utchar
 #define yypact		utpact
 #define yyr1		utr1
 #define yyr2		utr2
@@ -511,12 +538,35 @@ timestamp:      DATE {
 #include "scanner.c"
 
 
+/*
+ * Returns the next token of the input.  Wraps the scanner so that the parser's
+ * error routine can see the lookahead token.
+ *
+ * Arguments:
+ *	value	Pointer to the semantic value of the token.  Set on return.
+ *	state	Pointer to the state of the parse.
+ * Returns:
+ *	The next token.
+ */
+static int
+utlex(
+    YYSTYPE* const	value,
+    ParseState* const	state)
+{
+    state->token = scanToken(value, state->scanner);
+    state->value = value;
+
+    return state->token;
+}
+
+
 /*
  *  YACC error routine.
  *
- *  Bison calls this with "syntax error" when the current lookahead (yychar)
+ *  Bison calls this with "syntax error" when the current lookahead token
  *  has no valid action in the current parser state. The scanner attaches a
- *  detailed message to yylval.error_msg for ERR tokens that diagnose
+ *  detailed message to the error_msg member of the semantic value of ERR
+ *  tokens that diagnose
  *  specific lexical problems (integer overflow, invalid date components,
  *  disallowed NaN/Inf, etc.). When such an ERR is unconsumed by any
  *  grammar production — i.e. it falls through to default error recovery —
@@ -527,16 +577,55 @@ timestamp:      DATE {
  *  message inline and then invoke YYERROR, which does not call yyerror.
  *  Those paths are unaffected.
  */
-void uterror(const char *s)
+static void uterror(ParseState* state, const char *s)
 {
-    if (yychar == ERR && yylval.error_msg[0] != '\0') {
-        ut_handle_error_message("%s", yylval.error_msg);
+    if (state->token == ERR && state->value->error_msg[0] != '\0') {
+        ut_handle_error_message("%s", state->value->error_msg);
     } else {
         ut_handle_error_message("%s", s);
     }
 }
 
 
+/*
+ * Reports text that follows a unit specification.  The text is truncated for
+ * display (~50 chars).
+ *
+ * Arguments:
+ *      leftover        Pointer to the UTF-8 text that follows the unit
+ *                      specification.
+ */
+static void
+reportLeftover(
+    const char* const   leftover)
+{
+    char        leftover_snippet[64];
+    size_t      leftover_len = strlen(leftover);
+
+    /*
+     * %.47s is a byte-count cap, so we must not stop in the middle of a UTF-8
+     * multi-byte sequence; walk back to the nearest lead byte (a
+     * non-continuation byte, i.e. (c & 0xC0) != 0x80).
+     */
+    if (leftover_len > 50) {
+        size_t cut = 47;
+        while (cut > 0 &&
+               ((unsigned char)leftover[cut] & 0xC0) == 0x80) {
+            --cut;
+        }
+        snprintf(leftover_snippet, sizeof(leftover_snippet),
+                 "%.*s...", (int)cut, leftover);
+    } else {
+        snprintf(leftover_snippet, sizeof(leftover_snippet),
+                 "%s", leftover);
+    }
+
+    ut_handle_error_message(
+        "Unexpected text after unit specification: \"%s\"",
+        leftover_snippet);
+}
+
+
 /*
  * Converts a string in the Latin-1 character set (ISO 8859-1) to the UTF-8
  * character set.
@@ -546,15 +635,14 @@ void uterror(const char *s)
  *                      upon return.
  * Returns:
  *      NULL            Failure.  ut_handle_error_message() was called.
- *      else            Pointer to UTF-8 representation of "string".  Must not
- *                      be freed.  Subsequent calls may overwrite.
+ *      else            Pointer to UTF-8 representation of "string".  The
+ *                      caller should free() it when it's no longer needed.
  */
-static const char*
+static char*
 latin1ToUtf8(
     const char* const   latin1String)
 {
-    static char*                utf8String = NULL;
-    static size_t               bufSize = 0;
+    char*                       utf8String;
     size_t                      size;
     const unsigned char*        in;
     unsigned char*              out;
@@ -562,22 +650,13 @@ latin1ToUtf8(
     assert(latin1String != NULL);
 
     size = 2 * strlen(latin1String) + 1;
+    utf8String = malloc(size);
 
-    if (size > bufSize) {
-        char*   buf = realloc(utf8String, size);
-
-        if (buf != NULL) {
-            utf8String = buf;
-            bufSize = size;
-        }
-        else {
-            ut_handle_error_message("Couldn't allocate %ld-byte buffer: %s",
-                (unsigned long)size, strerror(errno));
-            return NULL;
-        }
+    if (utf8String == NULL) {
+        ut_handle_error_message("Couldn't allocate %ld-byte buffer: %s",
+            (unsigned long)size, strerror(errno));
     }
-
-    if (utf8String) {
+    else {
         for (in = (const unsigned char*)latin1String,
                 out = (unsigned char*)utf8String; *in; ++in) {
 #           define IS_ASCII(c) (((c) & 0x80) == 0)
@@ -633,82 +712,73 @@ ut_parse(
     }
     else {
         const char*     utf8String;
+        char*           converted = NULL;
+        ParseState      state;
 
         if (encoding != UT_LATIN1) {
             utf8String = string;
         }
         else {
-            utf8String = latin1ToUtf8(string);
+            utf8String = converted = latin1ToUtf8(string);
             encoding = UT_UTF8;
 
             if (utf8String == NULL)
                 ut_set_status(UT_OS);
         }
 
-        if (utf8String != NULL) {
-            YY_BUFFER_STATE	buf = ut_scan_string(utf8String);
-
-            _unitSystem = (ut_system*)system;
-            _encoding = encoding;
-            _restartScanner = 1;
+        state.unitSystem = (ut_system*)system;
+        state.finalUnit = NULL;
+        state.isTime = 0;
+        state.token = 0;
+        state.value = NULL;
+        state.consumed = 0;
+
+        if (utf8String != NULL && utlex_init_extra(&state, &state.scanner)) {
+            ut_set_status(UT_OS);
+            ut_handle_error_message("Couldn't create scanner: %s",
+                strerror(errno));
+        }
+        else if (utf8String != NULL) {
+            YY_BUFFER_STATE	buf = ut_scan_string(utf8String, state.scanner);
 
 #if YYDEBUG
-            utdebug = 0;
-            ut_flex_debug = 0;
+            utset_debug(0, state.scanner);
 #endif
 
-            _finalUnit = NULL;
-
-            if (utparse() == 0) {
-                int       status;
-                ptrdiff_t n = yy_c_buf_p  - buf->yy_ch_buf;
+            if (utparse(&state) == 0) {
+                int             status;
+                const size_t    n = state.consumed;
 
                 if (n >= strlen(utf8String)) {
-                    unit = _finalUnit;	/* success */
+                    unit = state.finalUnit;	/* success */
+
+                    /*
+                     * The unit might be one of the unit-system that "system"
+                     * overlays.
+                     */
+                    if (ut_get_system(unit) != system)
+                        unit = coreAdoptUnit(system, unit);
                     status = UT_SUCCESS;
                 }
                 else {
                     /*
                      * Parsing terminated before the end of the string.
                      */
-					size_t consumed = (size_t)n;
-					const char* leftover = utf8String + consumed;
-
-					/*
-					 * Truncate leftover text for display (~50 chars).
-					 * %.47s is a byte-count cap, so we must not stop in
-					 * the middle of a UTF-8 multi-byte sequence; walk
-					 * back to the nearest lead byte (a non-continuation
-					 * byte, i.e. (c & 0xC0) != 0x80).
-					 */
-					char leftover_snippet[64];
-					size_t leftover_len = strlen(leftover);
-					if (leftover_len > 50) {
-					    size_t cut = 47;
-					    while (cut > 0 &&
-					           ((unsigned char)leftover[cut] & 0xC0) == 0x80) {
-					        --cut;
-					    }
-					    snprintf(leftover_snippet, sizeof(leftover_snippet),
-					             "%.*s...", (int)cut, leftover);
-					} else {
-					    snprintf(leftover_snippet, sizeof(leftover_snippet),
-					             "%s", leftover);
-					}
-
-					ut_handle_error_message(
-						"Unexpected text after unit specification: \"%s\"",
-						leftover_snippet);
-
-                    ut_free(_finalUnit);
+                    if (errMessagesWanted())
+                        reportLeftover(utf8String + n);
+
+                    ut_free(state.finalUnit);
                     status = UT_SYNTAX;
                 }
 
                 ut_set_status(status);
             }
 
-            ut_delete_buffer(buf);
-        }                               /* utf8String != NULL */
+            ut_delete_buffer(buf, state.scanner);
+            utlex_destroy(state.scanner);
+        }                               /* scanner created */
+
+        free(converted);
     }                                   /* valid arguments */
 
     return unit;
@@ -15,7 +15,7 @@
 
 #include "prefix.h"
 #include "udunits2.h"
-#include "systemMap.h"
+#include "unitcore.h"
 
 #include <ctype.h>
 #include <errno.h>
@@ -26,10 +26,22 @@
 #endif
 #include <stdlib.h>
 #include <string.h>
+#ifndef _MSC_VER
+#include <strings.h>
+#endif
+
+typedef struct {
+    char*	id;
+    double	value;
+} PrefixAndValue;
 
 typedef struct {
-    void*	tree;
-    int		(*compare)(const void*, const void*);
+    void*		tree;
+    int			(*compare)(const void*, const void*);
+    PrefixAndValue*	prefixes;	/* in order of addition */
+    size_t		count;		/* number of prefixes */
+    size_t		capacity;	/* capacity of "prefixes" */
+    size_t		nodes;		/* number of search-tree entries */
 } PrefixToValueMap;
 
 typedef struct {
@@ -39,9 +51,6 @@ typedef struct {
     int		character;
 } PrefixSearchEntry;
 
-static SystemMap*	systemToNameToValue = NULL;
-static SystemMap*	systemToSymbolToValue = NULL;
-
 
 /******************************************************************************
  * Prefix Search Entry:
@@ -120,12 +129,100 @@ ptvmNew(
     if (map != NULL) {
 	map->tree = NULL;
 	map->compare = compare;
+	map->prefixes = NULL;
+	map->count = 0;
+	map->capacity = 0;
+	map->nodes = 0;
     }
 
     return map;
 }
 
 
+/*
+ * Frees a prefix search-tree and all the search-trees beneath it.
+ *
+ * Arguments:
+ *	tree		Address of the root of the search-tree.  Set to NULL
+ *			on return.
+ *	compare		Prefix comparison function.
+ */
+static void
+freeTree(
+    void** const	tree,
+    int			(*compare)(const void*, const void*))
+{
+    while (*tree != NULL) {
+	PrefixSearchEntry*	entry = **(PrefixSearchEntry***)tree;
+
+	freeTree(&entry->nextTree, compare);
+	(void)tdelete(entry, tree, compare);
+	pseFree(entry);
+    }
+}
+
+
+static void
+ptvmFree(
+    PrefixToValueMap* const	map)
+{
+    if (map != NULL) {
+	size_t	i;
+
+	for (i = 0; i < map->count; i++)
+	    free(map->prefixes[i].id);
+
+	free(map->prefixes);
+	freeTree(&map->tree, map->compare);
+	free(map);
+    }
+}
+
+
+/*
+ * Appends a prefix to the list of a prefix-to-value map.
+ *
+ * Arguments:
+ *	map		Pointer to the prefix-to-value map.
+ *	id		The prefix identifier.  May be freed upon return.
+ *	value		The prefix value.
+ * Returns:
+ *	 0		Success.
+ *	-1		Failure.  See "errno".
+ */
+static int
+ptvmAppend(
+    PrefixToValueMap* const	map,
+    const char* const		id,
+    const double		value)
+{
+    char*	copy;
+
+    if (map->count == map->capacity) {
+	const size_t	capacity = map->capacity == 0 ? 32 : 2*map->capacity;
+	PrefixAndValue*	prefixes =
+	    realloc(map->prefixes, capacity*sizeof(PrefixAndValue));
+
+	if (prefixes == NULL)
+	    return -1;
+
+	map->prefixes = prefixes;
+	map->capacity = capacity;
+    }
+
+    copy = strdup(id);
+
+    if (copy == NULL)
+	return -1;
+
+    map->prefixes[map->count].id = copy;
+    map->prefixes[map->count].value = value;
+    map->count++;
+
+    return 0;
+}
+
+
 /*
  * Returns the prefix search-entry that matches an identifier.  Inserts a
  * new prefix search-entry if no matching element is found.  Note that the
@@ -174,15 +271,25 @@ ptvmSearch(
 
 		tree = &(*treeEntry)->nextTree;	/* next binary-search tree */
 
-		if (newEntry != *treeEntry)
+		if (newEntry != *treeEntry) {
 		    pseFree(newEntry);
+		}
+		else {
+		    map->nodes++;
+		}
 	    }
 
 	    if (i >= len) {
 		entry = *treeEntry;
 
-		if (entry->value == 0)
-		    entry->value = value;
+		if (entry->value == 0) {
+		    if (ptvmAppend(map, id, value)) {
+			entry = NULL;
+		    }
+		    else {
+			entry->value = value;
+		    }
+		}
 	    }
 	}
     }
@@ -243,6 +350,51 @@ ptvmFind(
 }
 
 
+/*
+ * Returns the prefix search-entry of a prefix.
+ *
+ * Arguments:
+ *	map		Pointer to the prefix-to-value map.
+ *	id		The prefix identifier.
+ * Returns:
+ *	NULL		"map" is NULL or "id" isn't a prefix of "map".
+ *	else		Pointer to the prefix-search-entry of "id".
+ */
+static PrefixSearchEntry*
+ptvmFindExact(
+    PrefixToValueMap* const	map,
+    const char* const		id)
+{
+    PrefixSearchEntry*	entry = NULL;
+
+    if (map != NULL) {
+	void**	tree = &map->tree;
+	size_t	i;
+
+	for (i = 0; id[i] != 0; i++) {
+	    PrefixSearchEntry		targetEntry;
+	    PrefixSearchEntry* const*	treeEntry;
+
+	    targetEntry.character = id[i];
+	    treeEntry = tfind(&targetEntry, tree, map->compare);
+
+	    if (treeEntry == NULL) {
+		entry = NULL;
+		break;
+	    }
+
+	    entry = *treeEntry;
+	    tree = &entry->nextTree;
+	}
+
+	if (entry != NULL && entry->value == 0)
+	    entry = NULL;
+    }
+
+    return entry;
+}
+
+
 /******************************************************************************
  * Public API:
  ******************************************************************************/
@@ -256,7 +408,7 @@ ptvmFind(
  *	prefix		Pointer to the prefix (e.g., "mega", "M").  May be freed
  *			upon return.
  *	value		The value of the prefix (e.g., 1e6).
- *	systemMap	Pointer to system-map.
+ *	mapId		Identifier of the unit-system's prefix-to-value map.
  *	compare		Prefix comparison function.
  * Returns:
  *	UT_SUCCESS	Success.
@@ -264,13 +416,14 @@ ptvmFind(
  *                      is 0.
  *	UT_EXISTS	"prefix" already maps to a different value.
  *	UT_OS		Operating-system failure.  See "errno".
+ *	UT_FROZEN	The unit-system is frozen.
  */
 static ut_status
 addPrefix(
     ut_system* const	system,
     const char* const	prefix,
     const double	value,
-    SystemMap** const	systemMap,
+    const SystemMapId	mapId,
     int			(*compare)(const void*, const void*))
 {
     ut_status		status;
@@ -284,42 +437,32 @@ addPrefix(
     else if (value == 0) {
 	status = UT_BAD_ARG;
     }
+    else if (coreIsFrozen(system)) {
+	status = UT_FROZEN;
+	ut_handle_error_message("Unit-system is frozen");
+    }
     else {
-	if (*systemMap == NULL) {
-	    *systemMap = smNew();
-
-	    if (*systemMap == NULL)
-		status = UT_OS;
-	}
+	PrefixToValueMap** const	prefixToValue =
+	    (PrefixToValueMap**)coreGetSystemMap(system, mapId);
 
-	if (*systemMap != NULL) {
-	    PrefixToValueMap** const	prefixToValue =
-		(PrefixToValueMap**)smSearch(*systemMap, system);
+	if (*prefixToValue == NULL) {
+	    *prefixToValue = ptvmNew(compare);
 
-	    if (prefixToValue == NULL) {
+	    if (*prefixToValue == NULL)
 		status = UT_OS;
-	    }
-	    else {
-		if (*prefixToValue == NULL) {
-		    *prefixToValue = ptvmNew(compare);
-
-		    if (*prefixToValue == NULL)
-			status = UT_OS;
-		}
-
-		if (*prefixToValue != NULL) {
-		    const PrefixSearchEntry*	entry =
-			ptvmSearch(*prefixToValue, prefix, value);
+	}
 
-		    status =
-			entry == NULL
-			    ? UT_OS
-			    : (entry->value == value)
-				? UT_SUCCESS
-				: UT_EXISTS;
-		}
-	    }				/* have system-map entry */
-	}				/* have system-map */
+	if (*prefixToValue != NULL) {
+	    const PrefixSearchEntry*	entry =
+		ptvmSearch(*prefixToValue, prefix, value);
+
+	    status =
+		entry == NULL
+		    ? UT_OS
+		    : (entry->value == value)
+			? UT_SUCCESS
+			: UT_EXISTS;
+	}
     }					/* valid arguments */
 
     return status;
@@ -340,6 +483,7 @@ addPrefix(
  *	UT_BAD_ARG	"system" or "name" is NULL, or "value" is 0.
  *	UT_EXISTS	"name" already maps to a different value.
  *	UT_OS		Operating-system failure.  See "errno".
+ *	UT_FROZEN	The unit-system is frozen.
  */
 ut_status
 ut_add_name_prefix(
@@ -347,7 +491,7 @@ ut_add_name_prefix(
     const char* const	name,
     const double	value)
 {
-    ut_set_status(addPrefix(system, name, value, &systemToNameToValue,
+    ut_set_status(addPrefix(system, name, value, SYSTEM_NAME_PREFIXES,
 	pseInsensitiveCompare));
 
     return ut_get_status();
@@ -369,6 +513,7 @@ ut_add_name_prefix(
  *	UT_BAD_ARG	"value" is 0.
  *	UT_EXISTS	"symbol" already maps to a different value.
  *	UT_OS		Operating-system failure.  See "errno".
+ *	UT_FROZEN	The unit-system is frozen.
  */
 ut_status
 ut_add_symbol_prefix(
@@ -376,7 +521,7 @@ ut_add_symbol_prefix(
     const char* const	symbol,
     const double	value)
 {
-    ut_set_status(addPrefix(system, symbol, value, &systemToSymbolToValue,
+    ut_set_status(addPrefix(system, symbol, value, SYSTEM_SYMBOL_PREFIXES,
 	pseSensitiveCompare));
 
     return ut_get_status();
@@ -388,9 +533,8 @@ ut_add_symbol_prefix(
  *
  * Arguments:
  *	system		Pointer to the unit-system.
- *	systemMap	Pointer to system-map.
+ *	mapId		Identifier of the unit-system's prefix-to-value map.
  *	string		Pointer to the string to be examined for a prefix.
- *	compare		Prefix comparison function.
  *	value		NULL or pointer to the memory location to receive the
  *			value of the name-prefix, if one is discovered.
  *	len		NULL or pointer to the memory location to receive the
@@ -399,8 +543,7 @@ ut_add_symbol_prefix(
  *
  * Returns:
  *	UT_SUCCESS	Success.
- *	UT_BAD_ARG	"system" is NULL, "systemMap" is NULL, "compare" is
- *                      NULL, "string" is NULL or empty, or "value" is 0.
+ *	UT_BAD_ARG	"system" is NULL, or "string" is NULL or empty.
  *	UT_OS		Operating-system failure.  See "errno".
  *	UT_UNKNOWN	No prefix-to-value map is associated with "system".
  *	UT_UNKNOWN	No prefix found in the prefix-to-value map associated
@@ -409,7 +552,7 @@ ut_add_symbol_prefix(
 static ut_status
 findPrefix(
     ut_system* const	system,
-    SystemMap* const	systemMap,
+    const SystemMapId	mapId,
     const char* const	string,
     double* const	value,
     size_t* const	len)
@@ -419,27 +562,27 @@ findPrefix(
     if (system == NULL) {
 	status = UT_BAD_ARG;
     }
-    else if (systemMap == NULL) {
-	status = UT_BAD_ARG;
-    }
     else if (string == NULL || strlen(string) == 0) {
 	status = UT_BAD_ARG;
     }
     else {
-	PrefixToValueMap** const	prefixToValue =
-	    (PrefixToValueMap**)smFind(systemMap, system);
-
-	if (prefixToValue == NULL) {
-	    status = UT_UNKNOWN;
-	}
-	else {
-	    const PrefixSearchEntry*	entry =
-		ptvmFind(*prefixToValue, string);
-
-	    if (entry == NULL) {
-		status = UT_UNKNOWN;
-	    }
-	    else {
+	const ut_system*	sys;
+
+	status = UT_UNKNOWN;
+
+	/*
+	 * An overlay's own prefixes are tried before those of the unit-system
+	 * it overlays.
+	 */
+	for (sys = system; status == UT_UNKNOWN && sys != NULL;
+		sys = coreGetBaseSystem(sys)) {
+	    PrefixToValueMap* const	prefixToValue =
+		*(PrefixToValueMap**)coreGetSystemMap(sys, mapId);
+	    const PrefixSearchEntry*	entry = prefixToValue == NULL
+		? NULL
+		: ptvmFind(prefixToValue, string);
+
+	    if (entry != NULL) {
 		if (value != NULL)
 		    *value = entry->value;
 
@@ -448,7 +591,7 @@ findPrefix(
 
 		status = UT_SUCCESS;
 	    }				/* have prefix entry */
-	}				/* have system-map entry */
+	}				/* unit-system loop */
     }					/* valid arguments */
 
     return status;
@@ -481,7 +624,7 @@ utGetPrefixByName(
     return
 	string == NULL
 	    ? UT_BAD_ARG
-	    : findPrefix(system, systemToNameToValue, string, value, len);
+	    : findPrefix(system, SYSTEM_NAME_PREFIXES, string, value, len);
 }
 
 
@@ -511,5 +654,212 @@ utGetPrefixBySymbol(
     return
 	string == NULL
 	    ? UT_BAD_ARG
-	    : findPrefix(system, systemToSymbolToValue, string, value, len);
+	    : findPrefix(system, SYSTEM_SYMBOL_PREFIXES, string, value, len);
+}
+
+
+/*
+ * Returns the value of a prefix of a unit-system.  Unlike utGetPrefixByName()
+ * and utGetPrefixBySymbol(), the whole string must be the prefix and the
+ * unit-systems that the unit-system overlays aren't searched.
+ *
+ * Arguments:
+ *	system	Pointer to the unit-system.
+ *	mapId	SYSTEM_NAME_PREFIXES or SYSTEM_SYMBOL_PREFIXES.
+ *	prefix	Pointer to the prefix.
+ *	value	Pointer to the memory location to receive the value of the
+ *		prefix.
+ * Returns:
+ *	UT_SUCCESS	Success.  "*value" is set.
+ *	UT_UNKNOWN	"prefix" isn't a prefix of "system".
+ */
+ut_status
+utFindPrefix(
+    const ut_system* const	system,
+    const SystemMapId		mapId,
+    const char* const		prefix,
+    double* const		value)
+{
+    const PrefixSearchEntry* const	entry = ptvmFindExact(
+	*(PrefixToValueMap**)coreGetSystemMap(system, mapId), prefix);
+
+    if (entry == NULL)
+	return UT_UNKNOWN;
+
+    *value = entry->value;
+
+    return UT_SUCCESS;
+}
+
+
+/*
+ * Changes the value of a prefix of a unit-system or removes the prefix.
+ *
+ * Arguments:
+ *	system	Pointer to the unit-system.
+ *	mapId	SYSTEM_NAME_PREFIXES or SYSTEM_SYMBOL_PREFIXES.
+ *	prefix	Pointer to the prefix.
+ *	value	The new value of the prefix or 0 to remove the prefix.
+ * Returns:
+ *	UT_SUCCESS	Success.
+ *	UT_UNKNOWN	"prefix" isn't a prefix of "system".
+ *	UT_FROZEN	"system" is frozen.
+ */
+ut_status
+utReplacePrefix(
+    ut_system* const	system,
+    const SystemMapId	mapId,
+    const char* const	prefix,
+    const double	value)
+{
+    ut_status	status;
+
+    if (coreIsFrozen(system)) {
+	status = UT_FROZEN;
+	ut_handle_error_message("Unit-system is frozen");
+    }
+    else {
+	PrefixToValueMap* const	map =
+	    *(PrefixToValueMap**)coreGetSystemMap(system, mapId);
+	PrefixSearchEntry* const	entry = ptvmFindExact(map, prefix);
+
+	if (entry == NULL) {
+	    status = UT_UNKNOWN;
+	}
+	else {
+	    size_t	i;
+
+	    /*
+	     * The search-tree path of a removed prefix is kept: it might be
+	     * shared with other prefixes.
+	     */
+	    entry->value = value;
+
+	    for (i = 0; i < map->count; i++) {
+		if ((map->compare == pseInsensitiveCompare
+			? strcasecmp(map->prefixes[i].id, prefix)
+			: strcmp(map->prefixes[i].id, prefix)) == 0)
+		    break;
+	    }
+
+	    if (i < map->count) {
+		if (value != 0) {
+		    map->prefixes[i].value = value;
+		}
+		else {
+		    free(map->prefixes[i].id);
+		    (void)memmove(map->prefixes + i, map->prefixes + i + 1,
+			(map->count - i - 1)*sizeof(PrefixAndValue));
+		    map->count--;
+		}
+	    }
+
+	    status = UT_SUCCESS;
+	}
+    }
+
+    return status;
+}
+
+
+/*
+ * Calls a function on every prefix of a unit-system in the order in which the
+ * prefixes were added.
+ *
+ * Arguments:
+ *	system	Pointer to the unit-system.
+ *	mapId	SYSTEM_NAME_PREFIXES or SYSTEM_SYMBOL_PREFIXES.
+ *	action	Pointer to the function to call with a prefix, its value, and
+ *		"arg".  It must not add prefixes.  Iteration stops at the first
+ *		non-zero return-value.
+ *	arg	Argument passed to "action".
+ * Returns:
+ *	0	"action" returned 0 for every prefix.
+ *	else	The first non-zero value returned by "action".
+ */
+int
+utWalkPrefixes(
+    const ut_system* const	system,
+    const SystemMapId		mapId,
+    int				(*action)(const char* prefix, double value,
+					  void* arg),
+    void* const			arg)
+{
+    const PrefixToValueMap* const	prefixToValue =
+	*(PrefixToValueMap**)coreGetSystemMap(system, mapId);
+    int					status = 0;
+
+    if (prefixToValue != NULL) {
+	size_t	i;
+
+	for (i = 0; i < prefixToValue->count && status == 0; i++)
+	    status = action(prefixToValue->prefixes[i].id,
+		prefixToValue->prefixes[i].value, arg);
+    }
+
+    return status;
+}
+
+
+/*
+ * Frees the prefixes associated with a unit-system.
+ *
+ * Arguments:
+ *	system		Pointer to the unit-system to have its associated
+ *			prefixes freed.
+ */
+void
+utFreeSystemPrefixes(
+    ut_system*	system)
+{
+    if (system != NULL) {
+	const SystemMapId	mapIds[] = {SYSTEM_NAME_PREFIXES,
+				    SYSTEM_SYMBOL_PREFIXES};
+	int			i;
+
+	for (i = 0; i < 2; i++) {
+	    PrefixToValueMap** const	prefixToValue =
+		(PrefixToValueMap**)coreGetSystemMap(system, mapIds[i]);
+
+	    ptvmFree(*prefixToValue);
+	    *prefixToValue = NULL;
+	}
+    }
+}
+
+
+/*
+ * Adds the memory of the prefixes of a unit-system to the memory statistics of
+ * the unit-system.  The size of a node of a tsearch(3) tree isn't known, so
+ * it's taken to be that of three pointers.
+ *
+ * Arguments:
+ *	system		Pointer to the unit-system.
+ *	stats		Pointer to the statistics to be augmented.
+ */
+void
+utGetPrefixMemory(
+    const ut_system* const	system,
+    ut_memory_stats* const	stats)
+{
+    const SystemMapId	mapIds[] = {SYSTEM_NAME_PREFIXES,
+			    SYSTEM_SYMBOL_PREFIXES};
+    int			i;
+
+    for (i = 0; i < 2; i++) {
+	const PrefixToValueMap* const	map =
+	    *(PrefixToValueMap**)coreGetSystemMap(system, mapIds[i]);
+
+	if (map != NULL) {
+	    size_t	j;
+
+	    stats->prefixes.bytes += sizeof(PrefixToValueMap) +
+		map->capacity*sizeof(PrefixAndValue) +
+		map->nodes*(sizeof(PrefixSearchEntry) + 3*sizeof(void*));
+	    stats->prefixes.count += map->nodes;
+
+	    for (j = 0; j < map->count; j++)
+		stats->prefixes.bytes += strlen(map->prefixes[j].id) + 1;
+	}
+    }
 }
@@ -6,6 +6,7 @@
 #define UT_PREFIX_H
 
 #include "udunits2.h"
+#include "unitcore.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -100,6 +101,94 @@ utGetPrefixBySymbol(
     double* const	value,
     size_t* const	len);
 
+/*
+ * Returns the value of a prefix of a unit-system.  Unlike utGetPrefixByName()
+ * and utGetPrefixBySymbol(), the whole string must be the prefix and the
+ * unit-systems that the unit-system overlays aren't searched.
+ *
+ * Arguments:
+ *	system	Pointer to the unit-system.
+ *	mapId	SYSTEM_NAME_PREFIXES or SYSTEM_SYMBOL_PREFIXES.
+ *	prefix	Pointer to the prefix.
+ *	value	Pointer to the memory location to receive the value of the
+ *		prefix.
+ * Returns:
+ *	UT_SUCCESS	Success.  "*value" is set.
+ *	UT_UNKNOWN	"prefix" isn't a prefix of "system".
+ */
+ut_status
+utFindPrefix(
+    const ut_system* const	system,
+    const SystemMapId		mapId,
+    const char* const		prefix,
+    double* const		value);
+
+/*
+ * Changes the value of a prefix of a unit-system or removes the prefix.
+ *
+ * Arguments:
+ *	system	Pointer to the unit-system.
+ *	mapId	SYSTEM_NAME_PREFIXES or SYSTEM_SYMBOL_PREFIXES.
+ *	prefix	Pointer to the prefix.
+ *	value	The new value of the prefix or 0 to remove the prefix.
+ * Returns:
+ *	UT_SUCCESS	Success.
+ *	UT_UNKNOWN	"prefix" isn't a prefix of "system".
+ *	UT_FROZEN	"system" is frozen.
+ */
+ut_status
+utReplacePrefix(
+    ut_system* const	system,
+    const SystemMapId	mapId,
+    const char* const	prefix,
+    const double	value);
+
+/*
+ * Calls a function on every prefix of a unit-system in the order in which the
+ * prefixes were added.
+ *
+ * Arguments:
+ *	system	Pointer to the unit-system.
+ *	mapId	SYSTEM_NAME_PREFIXES or SYSTEM_SYMBOL_PREFIXES.
+ *	action	Pointer to the function to call with a prefix, its value, and
+ *		"arg".  Iteration stops at the first non-zero return-value.
+ *	arg	Argument passed to "action".
+ * Returns:
+ *	0	"action" returned 0 for every prefix.
+ *	else	The first non-zero value returned by "action".
+ */
+int
+utWalkPrefixes(
+    const ut_system* const	system,
+    const SystemMapId		mapId,
+    int				(*action)(const char* prefix, double value,
+					  void* arg),
+    void* const			arg);
+
+/*
+ * Frees the prefixes associated with a unit-system.
+ *
+ * Arguments:
+ *	system		Pointer to the unit-system to have its associated
+ *			prefixes freed.
+ */
+void
+utFreeSystemPrefixes(
+    ut_system*	system);
+
+/*
+ * Adds the memory of the prefixes of a unit-system to the memory statistics of
+ * the unit-system (see ut_get_memory_stats()).
+ *
+ * Arguments:
+ *	system		Pointer to the unit-system.
+ *	stats		Pointer to the statistics to be augmented.
+ */
+void
+utGetPrefixMemory(
+    const ut_system* const	system,
+    ut_memory_stats* const	stats);
+
 #ifdef __cplusplus
 }
 #endif
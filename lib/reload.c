@@ -0,0 +1,987 @@
+/*
+ * Copyright 2020 University Corporation for Atmospheric Research
+ *
+ * This file is part of the UDUNITS-2 package.  See the file COPYRIGHT
+ * in the top-level source-directory of the package for copying and
+ * redistribution conditions.
+ */
+/*
+ * Incremental reloading of an XML unit database into a unit-system (see
+ * ut_reload_xml()).
+ *
+ * The database is read into a new unit-system and the identifiers of the two
+ * unit-systems are compared.  Units are compared by translating them from one
+ * unit-system into the other through their structure, which is exact: basic-
+ * units are matched by their symbols or names.  All differences are computed
+ * before any is applied so that a database that can't be reloaded leaves the
+ * unit-system unchanged.  Only the unit-to-identifier remappings affect the
+ * format cache of the unit-system; they invalidate just the cached strings of
+ * the remapped units (see fcInvalidate()).
+ */
+
+/*LINTLIBRARY*/
+
+#include "config.h"
+
+#include "idToUnitMap.h"
+#include "lazyUnits.h"
+#include "prefix.h"
+#include "udunits2.h"
+#include "unitToIdMap.h"
+#include "unitcore.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * A change to an identifier of the unit-system.
+ */
+typedef struct {
+    ut_id_diff	diff;
+    ut_unit*	unit;		/* new unit of a name or symbol or NULL */
+    double	value;		/* new value of a prefix */
+} Change;
+
+/*
+ * A change to a unit-to-identifier mapping of the unit-system.
+ */
+typedef struct {
+    ut_unit*	unit;		/* unit of the unit-system */
+    char*	id;		/* new identifier or NULL to remove */
+    char*	oldId;		/* previous identifier or NULL */
+    SystemMapId	mapId;
+    ut_encoding	encoding;
+} Remap;
+
+typedef struct {
+    ut_system*	system;		/* unit-system to be updated */
+    ut_system*	fresh;		/* reloaded database */
+    Change*	changes;
+    size_t	changeCount;
+    size_t	changeCapacity;
+    Remap*	remaps;
+    size_t	remapCount;
+    size_t	remapCapacity;
+    SystemMapId	mapId;		/* map being walked */
+    ut_status	status;		/* first failure */
+} Reload;
+
+typedef struct {
+    const ut_system*	system;	/* destination unit-system */
+    ut_unit*		unit;	/* translated unit */
+} Translation;
+
+
+/******************************************************************************
+ * Translation of units between unit-systems:
+ ******************************************************************************/
+
+
+static ut_unit*
+translate(
+    const ut_unit* const	unit,
+    const ut_system* const	system);
+
+
+static ut_status
+isBasic(
+    const ut_unit* const	unit,
+    void* const			arg)
+{
+    return UT_SUCCESS;
+}
+
+
+static ut_status
+notBasicProduct(
+    const ut_unit* const	unit,
+    const int			count,
+    const ut_unit* const* const	basicUnits,
+    const int* const		powers,
+    void* const			arg)
+{
+    return UT_VISIT_ERROR;
+}
+
+
+static ut_status
+notBasicGalilean(
+    const ut_unit* const	unit,
+    const double		scale,
+    const ut_unit* const	underlyingUnit,
+    const double		offset,
+    void* const			arg)
+{
+    return UT_VISIT_ERROR;
+}
+
+
+static ut_status
+notBasicTimestamp(
+    const ut_unit* const	unit,
+    const ut_unit* const	timeUnit,
+    const double		origin,
+    void* const			arg)
+{
+    return UT_VISIT_ERROR;
+}
+
+
+static ut_status
+notBasicLogarithmic(
+    const ut_unit* const	unit,
+    const double		base,
+    const ut_unit* const	reference,
+    void* const			arg)
+{
+    return UT_VISIT_ERROR;
+}
+
+
+static const ut_visitor	basicChecker = {isBasic, notBasicProduct,
+    notBasicGalilean, notBasicTimestamp, notBasicLogarithmic};
+
+
+/*
+ * Translates a basic-unit into the basic-unit of the destination unit-system
+ * that has the same symbol or, failing that, the same name.
+ */
+static ut_status
+translateBasic(
+    const ut_unit* const	unit,
+    void* const			arg)
+{
+    Translation* const	trans = (Translation*)arg;
+    const char* const	symbol = ut_get_symbol(unit, UT_UTF8);
+    const char* const	name = ut_get_name(unit, UT_UTF8);
+    const ut_unit*	basic = symbol == NULL
+	? NULL
+	: ut_lookup_unit_by_symbol(trans->system, symbol);
+
+    if (basic == NULL && name != NULL)
+	basic = ut_lookup_unit_by_name(trans->system, name);
+
+    if (basic == NULL || ut_accept_visitor(basic, &basicChecker, NULL) !=
+	    UT_SUCCESS) {
+	ut_handle_error_message("Basic-unit \"%s\" isn't in the other "
+	    "unit-system", symbol != NULL ? symbol : name != NULL ? name : "");
+	return UT_MEANINGLESS;
+    }
+
+    trans->unit = ut_clone(basic);
+
+    return trans->unit == NULL ? UT_OS : UT_SUCCESS;
+}
+
+
+static ut_status
+translateProduct(
+    const ut_unit* const	unit,
+    const int			count,
+    const ut_unit* const* const	basicUnits,
+    const int* const		powers,
+    void* const			arg)
+{
+    Translation* const	trans = (Translation*)arg;
+    ut_unit*		product = ut_get_dimensionless_unit_one(trans->system);
+    int			i;
+
+    for (i = 0; product != NULL && i < count; i++) {
+	ut_unit* const	basic = translate(basicUnits[i], trans->system);
+	ut_unit* const	power = basic == NULL
+	    ? NULL
+	    : ut_raise(basic, powers[i]);
+	ut_unit* const	next = power == NULL
+	    ? NULL
+	    : ut_multiply(product, power);
+
+	ut_free(basic);
+	ut_free(power);
+	ut_free(product);
+	product = next;
+    }
+
+    trans->unit = product;
+
+    return product == NULL ? ut_get_status() : UT_SUCCESS;
+}
+
+
+static ut_status
+translateGalilean(
+    const ut_unit* const	unit,
+    const double		scale,
+    const ut_unit* const	underlyingUnit,
+    const double		offset,
+    void* const			arg)
+{
+    Translation* const	trans = (Translation*)arg;
+    ut_unit* const	underlying = translate(underlyingUnit, trans->system);
+    ut_unit* const	scaled = underlying == NULL
+	? NULL
+	: ut_scale(scale, underlying);
+
+    trans->unit = scaled == NULL ? NULL : ut_offset(scaled, offset);
+
+    ut_free(underlying);
+    ut_free(scaled);
+
+    return trans->unit == NULL ? ut_get_status() : UT_SUCCESS;
+}
+
+
+static ut_status
+translateTimestamp(
+    const ut_unit* const	unit,
+    const ut_unit* const	timeUnit,
+    const double		origin,
+    void* const			arg)
+{
+    Translation* const	trans = (Translation*)arg;
+    ut_unit* const	underlying = translate(timeUnit, trans->system);
+
+    trans->unit = underlying == NULL
+	? NULL
+	: ut_offset_by_time(underlying, origin);
+
+    ut_free(underlying);
+
+    return trans->unit == NULL ? ut_get_status() : UT_SUCCESS;
+}
+
+
+static ut_status
+translateLogarithmic(
+    const ut_unit* const	unit,
+    const double		base,
+    const ut_unit* const	reference,
+    void* const			arg)
+{
+    Translation* const	trans = (Translation*)arg;
+    ut_unit* const	underlying = translate(reference, trans->system);
+
+    trans->unit = underlying == NULL ? NULL : ut_log(base, underlying);
+
+    ut_free(underlying);
+
+    return trans->unit == NULL ? ut_get_status() : UT_SUCCESS;
+}
+
+
+static const ut_visitor	translator = {translateBasic, translateProduct,
+    translateGalilean, translateTimestamp, translateLogarithmic};
+
+
+/*
+ * Returns the unit of a unit-system that's equal to a unit of another
+ * unit-system.
+ *
+ * Arguments:
+ *	unit		Pointer to the unit to be translated.
+ *	system		Pointer to the destination unit-system.
+ * Returns:
+ *	NULL		Failure.  "ut_get_status()" will be:
+ *			    UT_MEANINGLESS	A basic-unit of "unit" isn't
+ *						in "system".
+ *			    UT_OS		Operating-system error.  See
+ *						"errno".
+ *	else		Pointer to the translated unit.  The caller should
+ *			pass it to ut_free().
+ */
+static ut_unit*
+translate(
+    const ut_unit* const	unit,
+    const ut_system* const	system)
+{
+    Translation	trans;
+
+    trans.system = system;
+    trans.unit = NULL;
+
+    if (ut_accept_visitor(unit, &translator, &trans) != UT_SUCCESS) {
+	ut_status	status = ut_get_status();
+
+	ut_free(trans.unit);
+	ut_set_status(status);
+	trans.unit = NULL;
+    }
+
+    return trans.unit;
+}
+
+
+/******************************************************************************
+ * Computing the differences:
+ ******************************************************************************/
+
+
+/*
+ * Records a change to an identifier.
+ *
+ * Arguments:
+ *	reload		Pointer to the reload.
+ *	change		The kind of change.
+ *	type		The type of the identifier.
+ *	id		Pointer to the identifier.  May be freed upon return.
+ *	unit		The new unit of the identifier or NULL.  Becomes the
+ *			reload's.
+ *	value		The new value of a prefix.
+ * Returns:
+ *	0		Success.
+ *	else		Failure.  "reload->status" is UT_OS and "unit" is
+ *			freed.
+ */
+static int
+addChange(
+    Reload* const		reload,
+    const ut_id_change		change,
+    const ut_id_type		type,
+    const char* const		id,
+    ut_unit* const		unit,
+    const double		value)
+{
+    char*	copy = strdup(id);
+
+    if (copy != NULL && reload->changeCount == reload->changeCapacity) {
+	const size_t	capacity = reload->changeCapacity == 0
+	    ? 32
+	    : 2*reload->changeCapacity;
+	Change*		changes = realloc(reload->changes,
+	    capacity*sizeof(Change));
+
+	if (changes == NULL) {
+	    free(copy);
+	    copy = NULL;
+	}
+	else {
+	    reload->changes = changes;
+	    reload->changeCapacity = capacity;
+	}
+    }
+
+    if (copy == NULL) {
+	ut_free(unit);
+	reload->status = UT_OS;
+	ut_handle_error_message(strerror(errno));
+	ut_handle_error_message("ut_reload_xml(): Couldn't record change");
+	return -1;
+    }
+
+    reload->changes[reload->changeCount].diff.change = change;
+    reload->changes[reload->changeCount].diff.type = type;
+    reload->changes[reload->changeCount].diff.id = copy;
+    reload->changes[reload->changeCount].unit = unit;
+    reload->changes[reload->changeCount].value = value;
+    reload->changeCount++;
+
+    return 0;
+}
+
+
+/*
+ * Records a change to a unit-to-identifier mapping.
+ *
+ * Arguments:
+ *	reload		Pointer to the reload.
+ *	unit		Pointer to the unit of the unit-system.  Becomes the
+ *			reload's.
+ *	encoding	The encoding of the mapping.
+ *	id		Pointer to the new identifier or NULL to remove the
+ *			mapping.  May be freed upon return.
+ *	oldId		Pointer to the previous identifier or NULL.  May be
+ *			freed upon return.
+ * Returns:
+ *	0		Success.
+ *	else		Failure.  "reload->status" is UT_OS and "unit" is
+ *			freed.
+ */
+static int
+addRemap(
+    Reload* const		reload,
+    ut_unit* const		unit,
+    const ut_encoding		encoding,
+    const char* const		id,
+    const char* const		oldId)
+{
+    char*	copy = id == NULL ? NULL : strdup(id);
+    char*	oldCopy = oldId == NULL ? NULL : strdup(oldId);
+    int		error = (id != NULL && copy == NULL) ||
+	(oldId != NULL && oldCopy == NULL);
+
+    if (!error && reload->remapCount == reload->remapCapacity) {
+	const size_t	capacity = reload->remapCapacity == 0
+	    ? 32
+	    : 2*reload->remapCapacity;
+	Remap*		remaps = realloc(reload->remaps,
+	    capacity*sizeof(Remap));
+
+	if (remaps == NULL) {
+	    error = 1;
+	}
+	else {
+	    reload->remaps = remaps;
+	    reload->remapCapacity = capacity;
+	}
+    }
+
+    if (error) {
+	free(copy);
+	free(oldCopy);
+	ut_free(unit);
+	reload->status = UT_OS;
+	ut_handle_error_message(strerror(errno));
+	ut_handle_error_message("ut_reload_xml(): Couldn't record change");
+	return -1;
+    }
+
+    reload->remaps[reload->remapCount].unit = unit;
+    reload->remaps[reload->remapCount].id = copy;
+    reload->remaps[reload->remapCount].oldId = oldCopy;
+    reload->remaps[reload->remapCount].mapId = reload->mapId;
+    reload->remaps[reload->remapCount].encoding = encoding;
+    reload->remapCount++;
+
+    return 0;
+}
+
+
+static ut_id_type
+idType(
+    const SystemMapId	mapId)
+{
+    return mapId == SYSTEM_NAME_TO_UNIT
+	? UT_ID_NAME
+	: mapId == SYSTEM_SYMBOL_TO_UNIT
+	    ? UT_ID_SYMBOL
+	    : mapId == SYSTEM_NAME_PREFIXES
+		? UT_ID_NAME_PREFIX
+		: UT_ID_SYMBOL_PREFIX;
+}
+
+
+static const ut_unit*
+lookup(
+    const ut_system* const	system,
+    const SystemMapId		mapId,
+    const char* const		id)
+{
+    return mapId == SYSTEM_NAME_TO_UNIT
+	? ut_lookup_unit_by_name(system, id)
+	: ut_lookup_unit_by_symbol(system, id);
+}
+
+
+/*
+ * Records an identifier of the database that was added or whose unit changed.
+ */
+static int
+diffFreshId(
+    const char* const		id,
+    const ut_unit* const	freshUnit,
+    void* const			arg)
+{
+    Reload* const	reload = (Reload*)arg;
+    const ut_unit* const	unit = lookup(reload->system, reload->mapId, id);
+    ut_unit* const	newUnit = translate(freshUnit, reload->system);
+
+    if (newUnit == NULL) {
+	reload->status = ut_get_status();
+    }
+    else if (unit == NULL) {
+	(void)addChange(reload, UT_ID_ADDED, idType(reload->mapId), id,
+	    newUnit, 0);
+    }
+    else if (ut_compare(unit, newUnit) != 0) {
+	(void)addChange(reload, UT_ID_CHANGED, idType(reload->mapId), id,
+	    newUnit, 0);
+    }
+    else {
+	ut_free(newUnit);
+    }
+
+    return reload->status != UT_SUCCESS;
+}
+
+
+/*
+ * Records an identifier of the unit-system that was removed.
+ */
+static int
+diffOldId(
+    const char* const		id,
+    const ut_unit* const	unit,
+    void* const			arg)
+{
+    Reload* const	reload = (Reload*)arg;
+
+    if (lookup(reload->fresh, reload->mapId, id) == NULL)
+	(void)addChange(reload, UT_ID_REMOVED, idType(reload->mapId), id,
+	    NULL, 0);
+
+    return reload->status != UT_SUCCESS;
+}
+
+
+/*
+ * Records a prefix of the database that was added or whose value changed.
+ */
+static int
+diffFreshPrefix(
+    const char* const	prefix,
+    const double	value,
+    void* const		arg)
+{
+    Reload* const	reload = (Reload*)arg;
+    double		oldValue;
+
+    if (utFindPrefix(reload->system, reload->mapId, prefix, &oldValue) !=
+	    UT_SUCCESS) {
+	(void)addChange(reload, UT_ID_ADDED, idType(reload->mapId), prefix,
+	    NULL, value);
+    }
+    else if (oldValue != value) {
+	(void)addChange(reload, UT_ID_CHANGED, idType(reload->mapId), prefix,
+	    NULL, value);
+    }
+
+    return reload->status != UT_SUCCESS;
+}
+
+
+/*
+ * Records a prefix of the unit-system that was removed.
+ */
+static int
+diffOldPrefix(
+    const char* const	prefix,
+    const double	value,
+    void* const		arg)
+{
+    Reload* const	reload = (Reload*)arg;
+    double		newValue;
+
+    if (utFindPrefix(reload->fresh, reload->mapId, prefix, &newValue) !=
+	    UT_SUCCESS)
+	(void)addChange(reload, UT_ID_REMOVED, idType(reload->mapId), prefix,
+	    NULL, 0);
+
+    return reload->status != UT_SUCCESS;
+}
+
+
+static const char*
+getId(
+    const SystemMapId		mapId,
+    const ut_unit* const	unit,
+    const ut_encoding		encoding)
+{
+    return mapId == SYSTEM_UNIT_TO_NAME
+	? ut_get_name(unit, encoding)
+	: ut_get_symbol(unit, encoding);
+}
+
+
+/*
+ * Records a unit-to-identifier mapping of the database that the unit-system
+ * lacks.
+ */
+static int
+diffFreshMapping(
+    const ut_unit* const	freshUnit,
+    const ut_encoding		encoding,
+    const char* const		id,
+    void* const			arg)
+{
+    Reload* const	reload = (Reload*)arg;
+    ut_unit* const	unit = translate(freshUnit, reload->system);
+
+    if (unit == NULL) {
+	reload->status = ut_get_status();
+    }
+    else {
+	const char* const	oldId = getId(reload->mapId, unit, encoding);
+
+	if (oldId == NULL || strcmp(oldId, id) != 0) {
+	    (void)addRemap(reload, unit, encoding, id, oldId);
+	}
+	else {
+	    ut_free(unit);
+	}
+    }
+
+    return reload->status != UT_SUCCESS;
+}
+
+
+/*
+ * Records a unit-to-identifier mapping of the unit-system that the database
+ * lacks.
+ */
+static int
+diffOldMapping(
+    const ut_unit* const	unit,
+    const ut_encoding		encoding,
+    const char* const		id,
+    void* const			arg)
+{
+    Reload* const	reload = (Reload*)arg;
+    ut_unit* const	freshUnit = translate(unit, reload->fresh);
+
+    if (freshUnit == NULL) {
+	reload->status = ut_get_status();
+    }
+    else {
+	if (getId(reload->mapId, freshUnit, encoding) == NULL) {
+	    ut_unit* const	clone = ut_clone(unit);
+
+	    if (clone == NULL) {
+		reload->status = UT_OS;
+	    }
+	    else {
+		(void)addRemap(reload, clone, encoding, NULL, id);
+	    }
+	}
+
+	ut_free(freshUnit);
+    }
+
+    return reload->status != UT_SUCCESS;
+}
+
+
+static int
+compareChanges(
+    const void* const	change1,
+    const void* const	change2)
+{
+    const ut_id_diff* const	diff1 = &((const Change*)change1)->diff;
+    const ut_id_diff* const	diff2 = &((const Change*)change2)->diff;
+
+    const int			cmp = diff1->type != diff2->type
+	? (int)diff1->type - (int)diff2->type
+	: strcmp(diff1->id, diff2->id);
+
+    return cmp != 0 ? cmp : (int)diff1->change - (int)diff2->change;
+}
+
+
+/*
+ * Computes the differences between the unit-system and the database.
+ */
+static void
+diffSystems(
+    Reload* const	reload)
+{
+    static const SystemMapId	idMaps[] = {SYSTEM_NAME_TO_UNIT,
+	SYSTEM_SYMBOL_TO_UNIT};
+    static const SystemMapId	unitMaps[] = {SYSTEM_UNIT_TO_NAME,
+	SYSTEM_UNIT_TO_SYMBOL};
+    static const SystemMapId	prefixMaps[] = {SYSTEM_NAME_PREFIXES,
+	SYSTEM_SYMBOL_PREFIXES};
+    int				i;
+
+    for (i = 0; reload->status == UT_SUCCESS && i < 2; i++) {
+	reload->mapId = idMaps[i];
+	(void)itumWalk(reload->fresh, reload->mapId, diffFreshId, reload);
+
+	if (reload->status == UT_SUCCESS)
+	    (void)itumWalk(reload->system, reload->mapId, diffOldId, reload);
+    }
+
+    for (i = 0; reload->status == UT_SUCCESS && i < 2; i++) {
+	reload->mapId = prefixMaps[i];
+	(void)utWalkPrefixes(reload->fresh, reload->mapId, diffFreshPrefix,
+	    reload);
+
+	if (reload->status == UT_SUCCESS)
+	    (void)utWalkPrefixes(reload->system, reload->mapId, diffOldPrefix,
+		reload);
+    }
+
+    for (i = 0; reload->status == UT_SUCCESS && i < 2; i++) {
+	reload->mapId = unitMaps[i];
+	(void)utimWalk(reload->fresh, reload->mapId, diffFreshMapping, reload);
+
+	if (reload->status == UT_SUCCESS)
+	    (void)utimWalk(reload->system, reload->mapId, diffOldMapping,
+		reload);
+    }
+}
+
+
+/*
+ * Adds the unit-to-identifier remappings to the reported changes and sorts
+ * them.  A remapping is reported from the side of the identifier: one that a
+ * unit no longer maps to is removed, one that a unit now maps to is added, and
+ * one that moved from one unit to another is changed.  The changes shall have
+ * been applied.
+ */
+static void
+reportRemaps(
+    Reload* const	reload)
+{
+    size_t	i;
+    size_t	n;
+
+    for (i = 0; reload->status == UT_SUCCESS && i < reload->remapCount; i++) {
+	const Remap* const	remap = reload->remaps + i;
+	const ut_id_type	type = remap->mapId == SYSTEM_UNIT_TO_NAME
+	    ? UT_ID_UNIT_NAME
+	    : UT_ID_UNIT_SYMBOL;
+
+	if (remap->oldId != NULL)
+	    (void)addChange(reload, UT_ID_REMOVED, type, remap->oldId, NULL,
+		0);
+
+	if (reload->status == UT_SUCCESS && remap->id != NULL)
+	    (void)addChange(reload, UT_ID_ADDED, type, remap->id, NULL, 0);
+    }
+
+    if (reload->changeCount > 1)
+	qsort(reload->changes, reload->changeCount, sizeof(Change),
+	    compareChanges);
+
+    /*
+     * An identifier that was removed from one unit and added to another is
+     * adjacent to itself after sorting, as is one that's reported for more
+     * than one encoding.
+     */
+    for (i = n = 0; i < reload->changeCount; i++) {
+	Change* const	change = reload->changes + i;
+	Change* const	prev = reload->changes + n - 1;
+
+	if (n > 0 && change->diff.type == prev->diff.type &&
+		strcmp(change->diff.id, prev->diff.id) == 0) {
+	    if (change->diff.change != prev->diff.change)
+		prev->diff.change = UT_ID_CHANGED;
+	    free((char*)change->diff.id);
+	    ut_free(change->unit);
+	}
+	else {
+	    reload->changes[n++] = *change;
+	}
+    }
+
+    reload->changeCount = n;
+}
+
+
+/******************************************************************************
+ * Applying the differences:
+ ******************************************************************************/
+
+
+static ut_status
+applyChange(
+    ut_system* const		system,
+    const Change* const		change)
+{
+    const char* const	id = change->diff.id;
+    ut_status		status;
+
+    switch (change->diff.type) {
+    case UT_ID_NAME:
+	status = ut_unmap_name_to_unit(system, id, UT_UTF8);
+
+	if (status == UT_SUCCESS && change->unit != NULL)
+	    status = ut_map_name_to_unit(id, UT_UTF8, change->unit);
+	break;
+    case UT_ID_SYMBOL:
+	status = ut_unmap_symbol_to_unit(system, id, UT_UTF8);
+
+	if (status == UT_SUCCESS && change->unit != NULL)
+	    status = ut_map_symbol_to_unit(id, UT_UTF8, change->unit);
+	break;
+    default: {
+	const SystemMapId	mapId = change->diff.type == UT_ID_NAME_PREFIX
+	    ? SYSTEM_NAME_PREFIXES
+	    : SYSTEM_SYMBOL_PREFIXES;
+
+	if (change->diff.change == UT_ID_ADDED) {
+	    status = mapId == SYSTEM_NAME_PREFIXES
+		? ut_add_name_prefix(system, id, change->value)
+		: ut_add_symbol_prefix(system, id, change->value);
+	}
+	else {
+	    status = utReplacePrefix(system, mapId, id, change->value);
+	}
+	break;
+    }
+    }
+
+    return status;
+}
+
+
+static ut_status
+applyRemap(
+    const Remap* const	remap)
+{
+    ut_status	status = remap->mapId == SYSTEM_UNIT_TO_NAME
+	? ut_unmap_unit_to_name(remap->unit, remap->encoding)
+	: ut_unmap_unit_to_symbol(remap->unit, remap->encoding);
+
+    if (status == UT_SUCCESS && remap->id != NULL)
+	status = remap->mapId == SYSTEM_UNIT_TO_NAME
+	    ? ut_map_unit_to_name(remap->unit, remap->id, remap->encoding)
+	    : ut_map_unit_to_symbol(remap->unit, remap->id, remap->encoding);
+
+    return status;
+}
+
+
+/******************************************************************************
+ * Public API:
+ ******************************************************************************/
+
+
+/*
+ * Brings a unit-system up to date with a changed XML unit database by applying
+ * only the differences: names, symbols, and prefixes that were added, that were
+ * removed, or whose unit or value changed.  The mappings from units to names
+ * and symbols are updated likewise.  Units obtained from the unit-system
+ * before the call remain valid.  The base units and dimensionless units of the
+ * database must be those of the unit-system.
+ *
+ * Arguments:
+ *	system	Pointer to the unit-system.  It shall not be frozen.
+ *	path	As for ut_read_xml().
+ *	diff	NULL or pointer to the memory location to receive a pointer to
+ *		the differences that were applied.  The caller should pass
+ *		"*diff" to ut_free_diff() when it's no longer needed.
+ * Returns:
+ *	UT_SUCCESS	Success.
+ *	UT_BAD_ARG	"system" is NULL.
+ *	UT_FROZEN	"system" is frozen.
+ *	UT_MEANINGLESS	A base unit or dimensionless unit of the database or
+ *			of "system" isn't in the other.  "system" is
+ *			unchanged.
+ *	UT_PARSE	"system" has a deferred unit-definition (see
+ *			ut_read_xml_lazy()) that couldn't be parsed.  "system"
+ *			is unchanged.
+ *	UT_OS		Operating-system error.  See "errno".  "system" might
+ *			be partially updated.
+ *	else		As for ut_read_xml().  "system" is unchanged.
+ */
+ut_status
+ut_reload_xml(
+    ut_system* const	system,
+    const char* const	path,
+    ut_diff** const	diff)
+{
+    Reload	reload;
+    size_t	i;
+
+    (void)memset(&reload, 0, sizeof(reload));
+
+    if (diff != NULL)
+	*diff = NULL;
+
+    if (system == NULL) {
+	reload.status = UT_BAD_ARG;
+	ut_handle_error_message("ut_reload_xml(): NULL unit-system argument");
+    }
+    else if (coreIsFrozen(system)) {
+	reload.status = UT_FROZEN;
+	ut_handle_error_message("ut_reload_xml(): Unit-system is frozen");
+    }
+    else if (luResolveAll(system) != UT_SUCCESS) {
+	reload.status = UT_PARSE;
+	ut_handle_error_message(
+	    "ut_reload_xml(): Couldn't resolve deferred unit-definitions");
+    }
+    else if ((reload.fresh = ut_read_xml(path)) == NULL) {
+	reload.status = ut_get_status();
+    }
+    else {
+	reload.system = system;
+	reload.status = UT_SUCCESS;
+
+	diffSystems(&reload);
+
+	for (i = 0; reload.status == UT_SUCCESS && i < reload.changeCount; i++)
+	    reload.status = applyChange(system, reload.changes + i);
+
+	for (i = 0; reload.status == UT_SUCCESS && i < reload.remapCount; i++)
+	    reload.status = applyRemap(reload.remaps + i);
+
+	reportRemaps(&reload);
+
+	if (reload.status != UT_SUCCESS)
+	    ut_handle_error_message("ut_reload_xml(): Couldn't reload \"%s\"",
+		path == NULL ? "default database" : path);
+
+	ut_free_system(reload.fresh);
+    }
+
+    for (i = 0; i < reload.remapCount; i++) {
+	ut_free(reload.remaps[i].unit);
+	free(reload.remaps[i].id);
+	free(reload.remaps[i].oldId);
+    }
+
+    free(reload.remaps);
+
+    for (i = 0; i < reload.changeCount; i++)
+	ut_free(reload.changes[i].unit);
+
+    if (reload.status == UT_SUCCESS && diff != NULL) {
+	*diff = malloc(sizeof(ut_diff));
+
+	if (*diff != NULL) {
+	    (*diff)->count = reload.changeCount;
+	    (*diff)->entries = malloc((reload.changeCount + 1) *
+		sizeof(ut_id_diff));
+
+	    if ((*diff)->entries == NULL) {
+		free(*diff);
+		*diff = NULL;
+	    }
+	    else {
+		for (i = 0; i < reload.changeCount; i++)
+		    (*diff)->entries[i] = reload.changes[i].diff;
+
+		reload.changeCount = 0;		/* identifiers now "*diff"'s */
+	    }
+	}
+
+	if (*diff == NULL) {
+	    reload.status = UT_OS;
+	    ut_handle_error_message(strerror(errno));
+	    ut_handle_error_message(
+		"ut_reload_xml(): Couldn't allocate differences");
+	}
+    }
+
+    for (i = 0; i < reload.changeCount; i++)
+	free((char*)reload.changes[i].diff.id);
+
+    free(reload.changes);
+
+    ut_set_status(reload.status);
+
+    return reload.status;
+}
+
+
+/*
+ * Frees the differences returned by ut_reload_xml().
+ *
+ * Arguments:
+ *	diff	Pointer to the differences or NULL.
+ */
+void
+ut_free_diff(
+    ut_diff* const	diff)
+{
+    if (diff != NULL) {
+	size_t	i;
+
+	for (i = 0; i < diff->count; i++)
+	    free((char*)diff->entries[i].id);
+
+	free(diff->entries);
+	free(diff);
+    }
+}
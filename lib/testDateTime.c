@@ -1851,6 +1851,482 @@ static void test_decode_roundtrip_dense_sweep(void)
     }
 }
 
+/* ---------------------------------------------------------------------- */
+/*                    12. batch decoding (ut_decode_times)                 */
+/* ---------------------------------------------------------------------- */
+
+/*
+ * ut_decode_times() must give exactly what ut_decode_time() gives for each
+ * value, whether a date is stepped from the previous one or computed afresh.
+ */
+static void assert_decode_times_match(const double* values, size_t count)
+{
+    int*    Y = malloc(count * sizeof(int));
+    int*    M = malloc(count * sizeof(int));
+    int*    D = malloc(count * sizeof(int));
+    int*    H = malloc(count * sizeof(int));
+    int*    MI = malloc(count * sizeof(int));
+    double* S = malloc(count * sizeof(double));
+    size_t  nbad = 0;
+
+    CU_ASSERT_FATAL(Y && M && D && H && MI && S);
+    CU_ASSERT_EQUAL(ut_decode_times(values, count, Y, M, D, H, MI, S),
+        UT_SUCCESS);
+
+    for (size_t i = 0; i < count; i++) {
+        int    y, m, d, h, mi;
+        double sec, res;
+        ut_decode_time(values[i], &y, &m, &d, &h, &mi, &sec, &res);
+        if (y != Y[i] || m != M[i] || d != D[i] || h != H[i] ||
+                mi != MI[i] || sec != S[i]) {
+            if (nbad++ == 0)
+                fprintf(stderr, "assert_decode_times_match: value=%.17g "
+                    "expected=(%d-%02d-%02d %02d:%02d:%.17g) "
+                    "got=(%d-%02d-%02d %02d:%02d:%.17g)\n", values[i],
+                    y, m, d, h, mi, sec, Y[i], M[i], D[i], H[i], MI[i], S[i]);
+        }
+    }
+    CU_ASSERT_EQUAL(nbad, 0);
+
+    free(Y); free(M); free(D); free(H); free(MI); free(S);
+}
+
+static void test_decode_times_hourly(void)
+{
+    /* Ten years of hourly steps, including two leap days and a century. */
+    const size_t count = 10 * 366 * 24;
+    double*      values = malloc(count * sizeof(double));
+    double       origin = ut_encode_date(1996, 1, 1);
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL(values);
+    for (size_t i = 0; i < count; i++)
+        values[i] = origin + 3600.0 * i;
+    assert_decode_times_match(values, count);
+    free(values);
+}
+
+static void test_decode_times_irregular(void)
+{
+    /* Steps of up to a month and beyond, backwards steps, fractional
+       seconds, the Gregorian cutover, negative years, and the year cap. */
+    static const double steps[] = {
+        0.5, 86399.25, 86400.0, 29 * 86400.0, 31 * 86400.0 + 1,
+        32 * 86400.0, -86400.0, 400 * 86400.0 + 0.125,
+    };
+    const size_t count = 20000;
+    double*      values = malloc(count * sizeof(double));
+    double       value = ut_encode_date(1500, 2, 27);
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL(values);
+    for (size_t i = 0; i < count; i++) {
+        values[i] = value;
+        value += steps[(i * 7 + i / 3) % (sizeof(steps)/sizeof(steps[0]))];
+    }
+    assert_decode_times_match(values, count);
+
+    values[0] = ut_encode_date(-5000000, 1, 1);
+    values[1] = ut_encode_date(-1, 12, 31);
+    values[2] = ut_encode_date(1, 1, 1) - 0.5;
+    values[3] = ut_encode_date(1582, 10, 4) + 86399.0;
+    values[4] = ut_encode_date(1582, 10, 15);
+    values[5] = ut_encode_date(5000000, 12, 31) + 86399.5;
+    values[6] = nextafter(0.0, -1.0);
+    assert_decode_times_match(values, 7);
+    free(values);
+}
+
+static void test_decode_times_bad_values(void)
+{
+    const double values[] = {0.0, NAN, INFINITY, 1e300, 86400.0};
+    int          Y[5], M[5], D[5], H[5], MI[5];
+    double       S[5];
+
+    CU_ASSERT_EQUAL(ut_decode_times(values, 5, Y, M, D, H, MI, S),
+        UT_BAD_ARG);
+    CU_ASSERT_EQUAL(ut_get_status(), UT_BAD_ARG);
+    for (int i = 1; i <= 3; i++) {
+        CU_ASSERT_EQUAL(Y[i], 0);
+        CU_ASSERT_EQUAL(M[i], 0);
+        CU_ASSERT_EQUAL(D[i], 0);
+        CU_ASSERT_EQUAL(H[i], 0);
+        CU_ASSERT_EQUAL(MI[i], 0);
+        CU_ASSERT(isnan(S[i]));
+    }
+    /* The good values around them are still decoded. */
+    CU_ASSERT_EQUAL(Y[0], 2001);
+    CU_ASSERT_EQUAL(D[0], 1);
+    CU_ASSERT_EQUAL(Y[4], 2001);
+    CU_ASSERT_EQUAL(D[4], 2);
+
+    CU_ASSERT_EQUAL(ut_decode_times(NULL, 1, Y, M, D, H, MI, S), UT_BAD_ARG);
+    CU_ASSERT_EQUAL(ut_decode_times(NULL, 0, NULL, NULL, NULL, NULL, NULL,
+        NULL), UT_SUCCESS);
+}
+
+static void test_decode_times_tiny_negative(void)
+{
+    /* value - days*86400 rounds to exactly 86400 for these, which must be
+       carried into the next day as ut_decode_time() does. */
+    const double values[] = {-1e-20, -1e-13, -1e-12, -7e-12, -0.0,
+        86400.0 * 365 - 1e-11};
+    enum { N = sizeof(values)/sizeof(values[0]) };
+    int          Y[N], M[N], D[N], H[N], MI[N];
+    double       S[N];
+
+    CU_ASSERT_EQUAL(ut_decode_times(values, N, Y, M, D, H, MI, S),
+        UT_SUCCESS);
+    for (int i = 0; i < N; i++) {
+        int    y, m, d, h, mi;
+        double sec, res;
+
+        ut_decode_time(values[i], &y, &m, &d, &h, &mi, &sec, &res);
+        if (Y[i] != y || M[i] != m || D[i] != d || H[i] != h ||
+                MI[i] != mi || memcmp(&S[i], &sec, sizeof(sec)) != 0)
+            fprintf(stderr, "test_decode_times_tiny_negative: %g: expected "
+                "%d-%02d-%02d %02d:%02d:%g, got %d-%02d-%02d %02d:%02d:%g\n",
+                values[i], y, m, d, h, mi, sec, Y[i], M[i], D[i], H[i],
+                MI[i], S[i]);
+        CU_ASSERT(Y[i] == y && M[i] == m && D[i] == d && H[i] == h &&
+            MI[i] == mi && memcmp(&S[i], &sec, sizeof(sec)) == 0);
+        CU_ASSERT(H[i] < 24);
+    }
+    CU_ASSERT(Y[0] == 2001 && M[0] == 1 && D[0] == 1 && H[0] == 0);
+}
+
+/* ---------------------------------------------------------------------- */
+/*          13. batch encoding (ut_encode_times, ut_encode_iso_times)      */
+/* ---------------------------------------------------------------------- */
+
+/* Same value as ut_encode_time(), NaN included. */
+static int same_encoding(double a, double b)
+{
+    return (isnan(a) && isnan(b)) || memcmp(&a, &b, sizeof(a)) == 0;
+}
+
+static void test_encode_times_matches_encode_time(void)
+{
+    /* Hourly steps through a leap year, then awkward fields: months and
+       days out of range, the Gregorian cutover month, the year cap, and
+       clock components at and beyond the bounds of ut_encode_clock(). */
+    enum { NHOURLY = 366 * 24, NODD = 14, COUNT = NHOURLY + NODD };
+    static const int odd[NODD][5] = {
+        {2024,  0,  1,   0,  0}, {2024, 13,  1,   0,  0},
+        {2024,  2, 30,   0,  0}, {2024,  2, 40,  23, 59},
+        {2024,  2,  0,   0,  0}, {1582, 10,  4,  12,  0},
+        {1582, 10, 15,  12,  0}, {1582, 10, 10,  12,  0},
+        {5000000, 12, 31, 0, 0}, {5000001, 1,  1,  0,  0},
+        {2001,  1,  1,  24,  0}, {2001,  1,  1, -23, 59},
+        {2001,  1,  1,   0, 60}, {-1,  12, 31,   0,  0},
+    };
+    int*    Y = malloc(COUNT * sizeof(int));
+    int*    M = malloc(COUNT * sizeof(int));
+    int*    D = malloc(COUNT * sizeof(int));
+    int*    H = malloc(COUNT * sizeof(int));
+    int*    MI = malloc(COUNT * sizeof(int));
+    double* S = malloc(COUNT * sizeof(double));
+    double* values = malloc(COUNT * sizeof(double));
+    double  origin = ut_encode_date(2024, 1, 1);
+    size_t  nbad = 0;
+
+    CU_ASSERT_FATAL(Y && M && D && H && MI && S && values);
+    for (size_t i = 0; i < NHOURLY; i++)
+        values[i] = origin + 3600.0 * i + 0.5;
+    CU_ASSERT_EQUAL(ut_decode_times(values, NHOURLY, Y, M, D, H, MI, S),
+        UT_SUCCESS);
+    for (size_t i = 0; i < NODD; i++) {
+        Y[NHOURLY + i] = odd[i][0];
+        M[NHOURLY + i] = odd[i][1];
+        D[NHOURLY + i] = odd[i][2];
+        H[NHOURLY + i] = odd[i][3];
+        MI[NHOURLY + i] = odd[i][4];
+        S[NHOURLY + i] = i == 0 ? 62.5 : 0.25;
+    }
+
+    CU_ASSERT_EQUAL(ut_encode_times(Y, M, D, H, MI, S, COUNT, values),
+        UT_BAD_ARG);
+    for (size_t i = 0; i < COUNT; i++) {
+        double expected = ut_encode_time(Y[i], M[i], D[i], H[i], MI[i], S[i]);
+        if (!same_encoding(values[i], expected) && nbad++ == 0)
+            fprintf(stderr, "test_encode_times_matches_encode_time: "
+                "%d-%02d-%02d %02d:%02d:%g: expected %.17g, got %.17g\n",
+                Y[i], M[i], D[i], H[i], MI[i], S[i], expected, values[i]);
+    }
+    CU_ASSERT_EQUAL(nbad, 0);
+    /* The hourly part round-trips exactly. */
+    CU_ASSERT_EQUAL(values[0], origin + 0.5);
+    CU_ASSERT_EQUAL(values[NHOURLY - 1], origin + 3600.0 * (NHOURLY - 1) + 0.5);
+
+    free(Y); free(M); free(D); free(H); free(MI); free(S); free(values);
+}
+
+static void test_encode_times_dates_only(void)
+{
+    const int Y[] = {2024, 2024, 2024};
+    const int M[] = {2, 2, 3};
+    const int D[] = {28, 29, 1};
+    double    values[3];
+
+    CU_ASSERT_EQUAL(ut_encode_times(Y, M, D, NULL, NULL, NULL, 3, values),
+        UT_SUCCESS);
+    for (int i = 0; i < 3; i++)
+        CU_ASSERT_EQUAL(values[i], ut_encode_date(Y[i], M[i], D[i]));
+
+    CU_ASSERT_EQUAL(ut_encode_times(NULL, M, D, NULL, NULL, NULL, 3, values),
+        UT_BAD_ARG);
+    CU_ASSERT_EQUAL(ut_encode_times(NULL, NULL, NULL, NULL, NULL, NULL, 0,
+        NULL), UT_SUCCESS);
+}
+
+static void test_encode_iso_times_accept(void)
+{
+    static const char* strings[] = {
+        "2024-01-15T12:30:00Z",
+        "20240115T123000Z",
+        "2024-01-15 12:30",
+        "2024-01-15T12:30:00+01:00",
+        "20240115T1230-0530",
+        "2024-01-15T12:30:15.25",
+        "2024-01-15T123015,25",
+        "  2024-01-15T12:30\r\n",
+        "2024-01-15",
+        "2024-01-15Z",
+        "-44-03-15",
+        "2016-12-31T23:59:60Z",
+    };
+    const double base = ut_encode_time(2024, 1, 15, 12, 30, 0.0);
+    const double expected[] = {
+        base, base, base, base - 3600, base + 5.5 * 3600, base + 15.25,
+        base + 15.25, base, ut_encode_date(2024, 1, 15),
+        ut_encode_date(2024, 1, 15), ut_encode_date(-44, 3, 15),
+        ut_encode_date(2017, 1, 1),
+    };
+    const size_t count = sizeof(strings)/sizeof(strings[0]);
+    double       values[sizeof(strings)/sizeof(strings[0])];
+
+    CU_ASSERT_EQUAL(ut_encode_iso_times(strings, count, values), UT_SUCCESS);
+    for (size_t i = 0; i < count; i++) {
+        if (values[i] != expected[i])
+            fprintf(stderr, "test_encode_iso_times_accept: \"%s\": "
+                "expected %.17g, got %.17g\n", strings[i], expected[i],
+                values[i]);
+        CU_ASSERT_EQUAL(values[i], expected[i]);
+    }
+}
+
+static void test_encode_iso_times_reject(void)
+{
+    /* Malformed, or rejected by ut_check_date()/ut_check_clock() or the
+       time-zone rules of the parser. */
+    static const char* strings[] = {
+        "2024-13-01", "2024-04-31", "2024-01-15T24:00", "2024-01-15T12:60",
+        "2024-01-15T12:30:60", "2024-01-15T", "2024-01-15T12:30:00-00:00",
+        "2024-01-15T12:30:00+14:30", "20240115T1230.5", "2024-1-15x",
+        "202401", "", NULL, "2024-01-15T12:30:00Z junk",
+    };
+    const size_t count = sizeof(strings)/sizeof(strings[0]);
+    double       values[sizeof(strings)/sizeof(strings[0]) + 1];
+
+    values[count] = 1.0;
+    CU_ASSERT_EQUAL(ut_encode_iso_times(strings, count, values), UT_SYNTAX);
+    for (size_t i = 0; i < count; i++) {
+        if (!isnan(values[i]))
+            fprintf(stderr, "test_encode_iso_times_reject: \"%s\" "
+                "accepted\n", strings[i] ? strings[i] : "(null)");
+        CU_ASSERT(isnan(values[i]));
+    }
+    CU_ASSERT_EQUAL(values[count], 1.0);
+
+    CU_ASSERT_EQUAL(ut_encode_iso_times(NULL, 1, values), UT_BAD_ARG);
+}
+
+/* ---------------------------------------------------------------------- */
+/*                 14. 64-bit nanosecond times (ut_*_ns)                   */
+/* ---------------------------------------------------------------------- */
+
+#define NS_PER_S 1000000000LL
+
+static void test_time_ns_matches_encode_time(void)
+{
+    /* Whole seconds are exact in both encodings, so the integer encoding
+       must agree with ut_encode_time() over the whole 64-bit range, and
+       decode to the same fields as ut_decode_time(). */
+    size_t nbad = 0;
+
+    for (int y = 1678; y <= 2261; y++) {
+        for (int m = 1; m <= 12; m++) {
+            for (int d = 1; d <= 28; d += 9) {
+                const int h = (y + m) % 24, mi = (y * d) % 60, s = d % 60;
+                long long v;
+                int Y, M, D, H, MI, S;
+                long NS;
+
+                if (ut_encode_time_ns(y, m, d, h, mi, s, 999999999L, &v) !=
+                        UT_SUCCESS ||
+                    ut_decode_time_ns(v, &Y, &M, &D, &H, &MI, &S, &NS) !=
+                        UT_SUCCESS ||
+                    (double)((v - 999999999L) / NS_PER_S - 978307200LL) !=
+                        ut_encode_time(y, m, d, h, mi, s) ||
+                    Y != y || M != m || D != d || H != h || MI != mi ||
+                    S != s || NS != 999999999L) {
+                    if (nbad++ == 0)
+                        fprintf(stderr, "test_time_ns_matches_encode_time: "
+                            "%d-%02d-%02d %02d:%02d:%02d\n", y, m, d, h, mi,
+                            s);
+                }
+            }
+        }
+    }
+    CU_ASSERT_EQUAL(nbad, 0);
+}
+
+static void test_time_ns_epochs(void)
+{
+    long long v;
+    int       Y, M, D, H, MI, S;
+    long      NS;
+
+    CU_ASSERT_EQUAL(ut_encode_time_ns(1970, 1, 1, 0, 0, 0, 0, &v), UT_SUCCESS);
+    CU_ASSERT_EQUAL(v, 0);
+    CU_ASSERT_EQUAL(ut_encode_time_ns(2001, 1, 1, 0, 0, 0, 0, &v), UT_SUCCESS);
+    CU_ASSERT_EQUAL(v, 978307200LL * NS_PER_S);
+    CU_ASSERT_EQUAL(ut_encode_time_ns(1969, 12, 31, 23, 59, 59, 999999999L,
+        &v), UT_SUCCESS);
+    CU_ASSERT_EQUAL(v, -1);
+
+    CU_ASSERT_EQUAL(ut_decode_time_ns(-1, &Y, &M, &D, &H, &MI, &S, &NS),
+        UT_SUCCESS);
+    CU_ASSERT(Y == 1969 && M == 12 && D == 31 && H == 23 && MI == 59 &&
+        S == 59 && NS == 999999999L);
+
+    /* Leap-seconds aren't counted; day overflow rolls over like
+       ut_encode_date(). */
+    {
+        long long next;
+        CU_ASSERT_EQUAL(ut_encode_time_ns(2016, 12, 31, 23, 59, 60, 0, &v),
+            UT_SUCCESS);
+        CU_ASSERT_EQUAL(ut_encode_time_ns(2017, 1, 1, 0, 0, 0, 0, &next),
+            UT_SUCCESS);
+        CU_ASSERT_EQUAL(v, next);
+        CU_ASSERT_EQUAL(ut_encode_time_ns(2023, 2, 30, 0, 0, 0, 0, &v),
+            UT_SUCCESS);
+        CU_ASSERT_EQUAL(ut_encode_time_ns(2023, 3, 2, 0, 0, 0, 0, &next),
+            UT_SUCCESS);
+        CU_ASSERT_EQUAL(v, next);
+    }
+}
+
+static void test_time_ns_limits(void)
+{
+    long long v;
+    int       Y, M, D, H, MI, S;
+    long      NS;
+
+    CU_ASSERT_EQUAL(ut_encode_time_ns(2262, 4, 11, 23, 47, 16, 854775807L,
+        &v), UT_SUCCESS);
+    CU_ASSERT_EQUAL(v, LLONG_MAX);
+    CU_ASSERT_EQUAL(ut_encode_time_ns(2262, 4, 11, 23, 47, 16, 854775808L,
+        &v), UT_BAD_ARG);
+    CU_ASSERT_EQUAL(ut_encode_time_ns(1677, 9, 21, 0, 12, 43, 145224193L,
+        &v), UT_SUCCESS);
+    CU_ASSERT_EQUAL(v, LLONG_MIN + 1);
+    /* LLONG_MIN itself is UT_NS_INVALID. */
+    CU_ASSERT_EQUAL(ut_encode_time_ns(1677, 9, 21, 0, 12, 43, 145224192L,
+        &v), UT_BAD_ARG);
+    CU_ASSERT_EQUAL(ut_encode_time_ns(1600, 1, 1, 0, 0, 0, 0, &v),
+        UT_BAD_ARG);
+
+    CU_ASSERT_EQUAL(ut_decode_time_ns(LLONG_MIN + 1, &Y, &M, &D, &H, &MI, &S,
+        &NS), UT_SUCCESS);
+    CU_ASSERT(Y == 1677 && M == 9 && D == 21 && H == 0 && MI == 12 &&
+        S == 43 && NS == 145224193L);
+    CU_ASSERT_EQUAL(ut_decode_time_ns(UT_NS_INVALID, &Y, &M, &D, &H, &MI, &S,
+        &NS), UT_BAD_ARG);
+
+    /* Invalid components */
+    CU_ASSERT_EQUAL(ut_encode_time_ns(2024, 13, 1, 0, 0, 0, 0, &v),
+        UT_BAD_ARG);
+    CU_ASSERT_EQUAL(ut_encode_time_ns(2024, 1, 1, 24, 0, 0, 0, &v),
+        UT_BAD_ARG);
+    CU_ASSERT_EQUAL(ut_encode_time_ns(2024, 1, 1, 0, 0, 0, -1L, &v),
+        UT_BAD_ARG);
+    CU_ASSERT_EQUAL(ut_encode_time_ns(2024, 1, 1, 0, 0, 0, NS_PER_S, &v),
+        UT_BAD_ARG);
+    CU_ASSERT_EQUAL(ut_encode_time_ns(2024, 1, 1, 0, 0, 0, 0, NULL),
+        UT_BAD_ARG);
+}
+
+static void test_times_to_ns(void)
+{
+    ut_unit*     ms = ut_parse(unitSystem, "ms since 1970-01-01", UT_ASCII);
+    ut_unit*     days = ut_parse(unitSystem,
+        "days since 2000-01-01 00:00 +01:00", UT_ASCII);
+    const double values[] = {0, 1, -1.5, 0.000001, 1e300, NAN};
+    long long    ns[6];
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL(ms);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(days);
+
+    CU_ASSERT_EQUAL(ut_times_to_ns(ms, values, 6, ns), UT_BAD_ARG);
+    CU_ASSERT_EQUAL(ns[0], 0);
+    CU_ASSERT_EQUAL(ns[1], 1000000);
+    CU_ASSERT_EQUAL(ns[2], -1500000);
+    CU_ASSERT_EQUAL(ns[3], 1);
+    CU_ASSERT_EQUAL(ns[4], UT_NS_INVALID);
+    CU_ASSERT_EQUAL(ns[5], UT_NS_INVALID);
+
+    CU_ASSERT_EQUAL(ut_times_to_ns(days, values, 3, ns), UT_SUCCESS);
+    CU_ASSERT_EQUAL(ns[0], (946684800LL - 3600) * NS_PER_S);
+    CU_ASSERT_EQUAL(ns[1], (946684800LL - 3600 + 86400) * NS_PER_S);
+    CU_ASSERT_EQUAL(ns[2], (946684800LL - 3600 - 129600) * NS_PER_S);
+
+    /* Not a timestamp-unit, or an interval that isn't whole nanoseconds */
+    {
+        ut_unit* ps = ut_parse(unitSystem, "ps since 1970-01-01", UT_ASCII);
+
+        CU_ASSERT_EQUAL(ut_times_to_ns(second_unit, values, 1, ns),
+            UT_MEANINGLESS);
+        CU_ASSERT_PTR_NOT_NULL(ps);
+        CU_ASSERT_EQUAL(ut_times_to_ns(ps, values, 1, ns), UT_MEANINGLESS);
+        CU_ASSERT_EQUAL(ut_times_to_ns(NULL, values, 1, ns), UT_BAD_ARG);
+        ut_free(ps);
+    }
+
+    ut_free(ms);
+    ut_free(days);
+}
+
+static void test_counts_ns_round_trip(void)
+{
+    ut_unit*        us = ut_parse(unitSystem,
+        "us since 2024-01-15T12:30:15.123", UT_ASCII);
+    const long long counts[] = {0, 1, -1, 123456789012345LL, UT_NS_INVALID,
+        LLONG_MAX};
+    long long       ns[6];
+    long long       back[6];
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL(us);
+
+    CU_ASSERT_EQUAL(ut_counts_to_ns(us, counts, 6, ns), UT_BAD_ARG);
+    CU_ASSERT_EQUAL(ns[0], 1705321815123000000LL);
+    CU_ASSERT_EQUAL(ns[1], 1705321815123001000LL);
+    CU_ASSERT_EQUAL(ns[2], 1705321815122999000LL);
+    CU_ASSERT_EQUAL(ns[4], UT_NS_INVALID);
+    CU_ASSERT_EQUAL(ns[5], UT_NS_INVALID);
+
+    CU_ASSERT_EQUAL(ut_ns_to_counts(us, ns, 4, back), UT_SUCCESS);
+    for (int i = 0; i < 4; i++)
+        CU_ASSERT_EQUAL(back[i], counts[i]);
+
+    /* Times between intervals round toward negative infinity. */
+    ns[0] += 999;
+    ns[1] = ns[2] - 1;
+    CU_ASSERT_EQUAL(ut_ns_to_counts(us, ns, 2, back), UT_SUCCESS);
+    CU_ASSERT_EQUAL(back[0], 0);
+    CU_ASSERT_EQUAL(back[1], -2);
+
+    ut_free(us);
+}
+
 /* ---------------------------------------------------------------------- */
 /*                          main / registration                            */
 /* ---------------------------------------------------------------------- */
@@ -1998,6 +2474,25 @@ int main(const int argc, const char* const* argv)
     CU_ADD_TEST(s, test_decode_roundtrip_year_zero);
     CU_ADD_TEST(s, test_decode_roundtrip_dense_sweep);
 
+    /* 12. batch decoding */
+    CU_ADD_TEST(s, test_decode_times_hourly);
+    CU_ADD_TEST(s, test_decode_times_irregular);
+    CU_ADD_TEST(s, test_decode_times_bad_values);
+    CU_ADD_TEST(s, test_decode_times_tiny_negative);
+
+    /* 13. batch encoding */
+    CU_ADD_TEST(s, test_encode_times_matches_encode_time);
+    CU_ADD_TEST(s, test_encode_times_dates_only);
+    CU_ADD_TEST(s, test_encode_iso_times_accept);
+    CU_ADD_TEST(s, test_encode_iso_times_reject);
+
+    /* 14. 64-bit nanosecond times */
+    CU_ADD_TEST(s, test_time_ns_matches_encode_time);
+    CU_ADD_TEST(s, test_time_ns_epochs);
+    CU_ADD_TEST(s, test_time_ns_limits);
+    CU_ADD_TEST(s, test_times_to_ns);
+    CU_ADD_TEST(s, test_counts_ns_round_trip);
+
     /* Silence the (noisy, expected) error messages from reject tests. */
     ut_set_error_message_handler(ut_ignore);
 
@@ -0,0 +1,74 @@
+/*
+ * testEmbeddedDatabase.c — checks the compiled-in default unit-database.
+ *
+ * Built only with the UDUNITS_EMBED_DATABASE option.  The unit-system returned
+ * by ut_read_xml(NULL) must come from the compiled-in database -- the default
+ * database needn't even be installed -- and must agree with the one read from
+ * the XML database given as the argument.
+ *
+ * The program exits 0 if every comparison succeeds and 77 (skipped) if
+ * UDUNITS2_XML_PATH is set, because that overrides the compiled-in database.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "udunits2.h"
+
+static const char* const specs[] = {
+    "m", "km/h", "kg.m^2/s^3", "hPa", "degC", "K @ 273.15", "lg(re mW)",
+    "days since 2001-01-01", "furlong/fortnight", "°F", "µm",
+};
+#define NSPECS  (sizeof(specs)/sizeof(specs[0]))
+
+int
+main(int argc, char** argv)
+{
+    ut_system*  embedded;
+    ut_system*  xml;
+    int         failures = 0;
+    size_t      i;
+
+    if (getenv("UDUNITS2_XML_PATH") != NULL) {
+        (void)fprintf(stderr, "UDUNITS2_XML_PATH is set; skipping\n");
+        return 77;
+    }
+
+    ut_set_error_message_handler(ut_ignore);
+
+    embedded = ut_read_xml(NULL);
+    xml = ut_read_xml(argc > 1 ? argv[1] : NULL);
+    if (embedded == NULL || xml == NULL) {
+        (void)fprintf(stderr, "Couldn't read unit database\n");
+        return EXIT_FAILURE;
+    }
+
+    for (i = 0; i < NSPECS; i++) {
+        ut_unit*    a = ut_parse(embedded, specs[i], UT_UTF8);
+        ut_unit*    b = ut_parse(xml, specs[i], UT_UTF8);
+        char        bufA[128];
+        char        bufB[128];
+
+        if (a == NULL || b == NULL ||
+                ut_format(a, bufA, sizeof(bufA), UT_ASCII | UT_DEFINITION) < 0 ||
+                ut_format(b, bufB, sizeof(bufB), UT_ASCII | UT_DEFINITION) < 0 ||
+                strcmp(bufA, bufB) != 0) {
+            (void)fprintf(stderr, "Mismatch for \"%s\"\n", specs[i]);
+            failures++;
+        }
+        ut_free(a);
+        ut_free(b);
+    }
+
+    if (strcmp(ut_get_name(ut_lookup_unit_by_symbol(embedded, "m"), UT_ASCII),
+            "meter") != 0) {
+        (void)fprintf(stderr, "Unit-to-name map wasn't embedded\n");
+        failures++;
+    }
+
+    ut_free_system(xml);
+    ut_free_system(embedded);
+
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
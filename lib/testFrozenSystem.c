@@ -0,0 +1,242 @@
+/*
+ * testFrozenSystem.c — concurrency stress-test for a frozen unit-system.
+ *
+ * The unit database is read and frozen by ut_freeze_system(); then several
+ * threads concurrently parse, look up, convert, and format units of it and
+ * compare every result with the one obtained single-threaded beforehand.  Each
+ * thread also checks that its own status isn't disturbed by the others and
+ * concurrently acquires and releases the shared default unit-system.
+ *
+ * The comparisons catch gross corruption on their own, but data races are
+ * only reliably reported under ThreadSanitizer:
+ *
+ *   cmake -DUDUNITS_TSAN=ON ... && make testFrozenSystem
+ *   (or: ./configure --enable-tsan ... && make testFrozenSystem)
+ *   TSAN_OPTIONS=halt_on_error=1 ./testFrozenSystem udunits2.xml
+ *
+ * The program exits 0 if and only if every comparison succeeds.
+ */
+
+#include <math.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "udunits2.h"
+
+#define NTHREADS    8
+#define NROUNDS     200
+
+static const char* const specs[][2] = {   /* {unit, reference-unit} */
+    {"m",                           "km"},
+    {"km/h",                        "m/s"},
+    {"kg.m^2/s^3",                  "W"},
+    {"N/m^2",                       "hPa"},
+    {"degC",                        "degF"},
+    {"K @ 273.15",                  "K"},
+    {"lg(re mW)",                   "lg(re W)"},
+    {"days since 2001-01-01",       "hours since 2000-01-01"},
+    {"seconds since 1970-01-01T00:00:00Z", "days since 2001-01-01"},
+    {"furlong/fortnight",           "cm/min"},
+    {"mile^2",                      "acre"},
+    {"°F",                          "kelvin"},
+    {"µm",                          "inch"},
+};
+#define NSPECS      (sizeof(specs)/sizeof(specs[0]))
+
+static const char* const names[] = {
+    "meter", "kilogram", "second", "ampere", "kelvin", "mole", "candela",
+    "radian", "hertz", "newton", "pascal", "joule", "watt", "volt", "celsius",
+    "fahrenheit", "day", "hour", "inch", "foot",
+};
+#define NNAMES      (sizeof(names)/sizeof(names[0]))
+
+typedef struct {
+    char    formatted[128];
+    char    definition[128];    /* formatted with UT_DEFINITION */
+    double  value;              /* 1 converted to the reference-unit */
+} Expected;
+
+static ut_system*   sys;
+static ut_system*   shared;     /* the shared default unit-system */
+static unsigned long sharedToken; /* its reference's token */
+static Expected     expected[NSPECS];
+static ut_unit*     byName[NNAMES];
+static const char*  nameOf[NNAMES];   /* ut_get_name() of "byName" */
+
+static int
+silent_handler(const char* fmt, va_list args)
+{
+    (void)fmt;
+    (void)args;
+    return 0;
+}
+
+/*
+ * Computes the results for one specification.
+ *
+ * Returns:
+ *      0       Success.
+ *      -1      Failure.
+ */
+static int
+evaluate(const char* const spec[2], Expected* result)
+{
+    int         status = -1;
+    ut_unit*    unit = ut_parse(sys, spec[0], UT_UTF8);
+    ut_unit*    reference = ut_parse(sys, spec[1], UT_UTF8);
+
+    if (unit != NULL && reference != NULL &&
+            ut_format(unit, result->formatted, sizeof(result->formatted),
+                UT_UTF8) >= 0 &&
+            ut_format(unit, result->definition, sizeof(result->definition),
+                UT_ASCII | UT_DEFINITION) >= 0) {
+        cv_converter*   cv = ut_get_converter(unit, reference);
+
+        if (cv != NULL) {
+            result->value = cv_convert_double(cv, 1.0);
+            cv_free(cv);
+            status = 0;
+        }
+    }
+    ut_free(reference);
+    ut_free(unit);
+
+    return status;
+}
+
+static void*
+stress(void* arg)
+{
+    long        failures = 0;
+    int         round;
+
+    (void)arg;
+
+    for (round = 0; round < NROUNDS; round++) {
+        size_t  i;
+
+        for (i = 0; i < NSPECS; i++) {
+            Expected    actual;
+
+            if (evaluate(specs[i], &actual) ||
+                    ut_get_status() != UT_SUCCESS ||
+                    strcmp(actual.formatted, expected[i].formatted) ||
+                    strcmp(actual.definition, expected[i].definition) ||
+                    !(fabs(actual.value - expected[i].value) <=
+                        1e-12 * fabs(expected[i].value))) {
+                (void)fprintf(stderr, "Mismatch for \"%s\"\n", specs[i][0]);
+                failures++;
+            }
+        }
+
+        for (i = 0; i < NNAMES; i++) {
+            const ut_unit*  unit = ut_lookup_unit_by_name(sys, names[i]);
+            ut_unit*        copy = ut_get_unit_by_name(sys, names[i]);
+
+            if (unit != byName[i] || copy == NULL ||
+                    ut_compare(copy, unit) != 0 ||
+                    ut_get_name(unit, UT_ASCII) != nameOf[i]) {
+                (void)fprintf(stderr, "Mismatch for name \"%s\"\n", names[i]);
+                failures++;
+            }
+            ut_free(copy);
+        }
+
+        {
+            unsigned long   token;
+            ut_system*      acquired = ut_acquire_default_system(&token);
+
+            if (acquired != shared || token == sharedToken ||
+                    ut_release_default_system(acquired, token) != UT_SUCCESS) {
+                (void)fprintf(stderr, "Wrong shared default unit-system\n");
+                failures++;
+            }
+        }
+
+        /*
+         * A failure in this thread mustn't be seen by the others.
+         */
+        if (ut_map_name_to_unit("frozen_test", UT_ASCII, byName[0]) !=
+                UT_FROZEN || ut_get_status() != UT_FROZEN) {
+            (void)fprintf(stderr, "Frozen system was modified\n");
+            failures++;
+        }
+    }
+
+    return (void*)failures;
+}
+
+int
+main(int argc, char** argv)
+{
+    const char* xmlPath = (argc > 1) ? argv[1] : NULL;
+    pthread_t   threads[NTHREADS];
+    long        failures = 0;
+    size_t      i;
+
+    ut_set_error_message_handler(silent_handler);
+
+    if (xmlPath != NULL && setenv("UDUNITS2_XML_PATH", xmlPath, 1) != 0) {
+        (void)fprintf(stderr, "Couldn't set UDUNITS2_XML_PATH\n");
+        return EXIT_FAILURE;
+    }
+    shared = ut_acquire_default_system(&sharedToken);
+    if (shared == NULL) {
+        (void)fprintf(stderr, "Couldn't acquire default unit-system\n");
+        return EXIT_FAILURE;
+    }
+
+    sys = ut_read_xml(xmlPath);
+    if (sys == NULL) {
+        (void)fprintf(stderr, "Couldn't read unit database\n");
+        return EXIT_FAILURE;
+    }
+    if (ut_freeze_system(sys) != UT_SUCCESS) {
+        (void)fprintf(stderr, "Couldn't freeze unit-system\n");
+        return EXIT_FAILURE;
+    }
+
+    for (i = 0; i < NSPECS; i++) {
+        if (evaluate(specs[i], &expected[i])) {
+            (void)fprintf(stderr, "Couldn't evaluate \"%s\"\n", specs[i][0]);
+            return EXIT_FAILURE;
+        }
+    }
+    for (i = 0; i < NNAMES; i++) {
+        byName[i] = (ut_unit*)ut_lookup_unit_by_name(sys, names[i]);
+        if (byName[i] == NULL) {
+            (void)fprintf(stderr, "Unknown unit \"%s\"\n", names[i]);
+            return EXIT_FAILURE;
+        }
+        nameOf[i] = ut_get_name(byName[i], UT_ASCII);
+    }
+
+    for (i = 0; i < NTHREADS; i++) {
+        if (pthread_create(&threads[i], NULL, stress, NULL)) {
+            (void)fprintf(stderr, "Couldn't create thread\n");
+            return EXIT_FAILURE;
+        }
+    }
+    for (i = 0; i < NTHREADS; i++) {
+        void*   result;
+
+        if (pthread_join(threads[i], &result) == 0)
+            failures += (long)result;
+    }
+
+    ut_free_system(sys);
+    if (ut_release_default_system(shared, sharedToken) != UT_SUCCESS) {
+        (void)fprintf(stderr, "Couldn't release default unit-system\n");
+        failures++;
+    }
+
+    if (failures) {
+        (void)fprintf(stderr, "%ld failures\n", failures);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -207,6 +207,44 @@ test_utGetUnitBySymbol(void)
 }
 
 
+static void
+test_utLookupUnitByName(void)
+{
+    const ut_unit*	altMeter = ut_lookup_unit_by_name(unitSystem, "meter");
+
+    CU_ASSERT_PTR_NOT_NULL(altMeter);
+    CU_ASSERT_EQUAL(ut_compare(altMeter, meter), 0);
+    /* The same borrowed unit is returned every time */
+    CU_ASSERT_EQUAL(ut_lookup_unit_by_name(unitSystem, "METER"), altMeter);
+
+    CU_ASSERT_PTR_NULL(ut_lookup_unit_by_name(unitSystem, NULL));
+    CU_ASSERT_EQUAL(ut_get_status(), UT_BAD_ARG);
+
+    CU_ASSERT_PTR_NULL(ut_lookup_unit_by_name(NULL, "meter"));
+    CU_ASSERT_EQUAL(ut_get_status(), UT_BAD_ARG);
+
+    CU_ASSERT_PTR_NULL(ut_lookup_unit_by_name(unitSystem, "foo"));
+    CU_ASSERT_EQUAL(ut_get_status(), UT_SUCCESS);
+}
+
+
+static void
+test_utLookupUnitBySymbol(void)
+{
+    const ut_unit*	altMeter = ut_lookup_unit_by_symbol(unitSystem, "m");
+
+    CU_ASSERT_PTR_NOT_NULL(altMeter);
+    CU_ASSERT_EQUAL(ut_compare(altMeter, meter), 0);
+    CU_ASSERT_EQUAL(ut_lookup_unit_by_symbol(unitSystem, "m"), altMeter);
+
+    CU_ASSERT_PTR_NULL(ut_lookup_unit_by_symbol(unitSystem, NULL));
+    CU_ASSERT_EQUAL(ut_get_status(), UT_BAD_ARG);
+
+    CU_ASSERT_PTR_NULL(ut_lookup_unit_by_symbol(unitSystem, "M"));
+    CU_ASSERT_EQUAL(ut_get_status(), UT_SUCCESS);
+}
+
+
 static void
 test_utAddNamePrefix(void)
 {
@@ -505,6 +543,40 @@ test_utGetSymbol(void)
 }
 
 
+static void
+test_utGetSymbolEncodings(void)
+{
+    ut_unit*	angstrom = ut_scale(1e-10, meter);
+    const char*	symbol;
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL(angstrom);
+    CU_ASSERT_EQUAL(ut_map_unit_to_symbol(angstrom, "\xc5", UT_LATIN1),
+	UT_SUCCESS);
+
+    /* The UTF-8 form of a Latin-1 symbol is found without being added */
+    symbol = ut_get_symbol(angstrom, UT_UTF8);
+    CU_ASSERT_STRING_EQUAL(symbol, "\xc3\x85");
+    CU_ASSERT_PTR_EQUAL(ut_get_symbol(angstrom, UT_UTF8), symbol);
+    CU_ASSERT_STRING_EQUAL(ut_get_symbol(angstrom, UT_LATIN1), "\xc5");
+    CU_ASSERT_PTR_NULL(ut_get_symbol(angstrom, UT_ASCII));
+    CU_ASSERT_EQUAL(ut_get_status(), UT_SUCCESS);
+
+    CU_ASSERT_EQUAL(ut_map_unit_to_symbol(angstrom, "A", UT_ASCII),
+	UT_SUCCESS);
+    CU_ASSERT_STRING_EQUAL(ut_get_symbol(angstrom, UT_UTF8), "\xc3\x85");
+
+    /* Removing the Latin-1 symbol also removes its UTF-8 form */
+    CU_ASSERT_EQUAL(ut_unmap_unit_to_symbol(angstrom, UT_LATIN1), UT_SUCCESS);
+    CU_ASSERT_STRING_EQUAL(ut_get_symbol(angstrom, UT_UTF8), "A");
+    CU_ASSERT_STRING_EQUAL(ut_get_symbol(angstrom, UT_LATIN1), "A");
+
+    CU_ASSERT_EQUAL(ut_unmap_unit_to_symbol(angstrom, UT_ASCII), UT_SUCCESS);
+    CU_ASSERT_PTR_NULL(ut_get_symbol(angstrom, UT_UTF8));
+
+    ut_free(angstrom);
+}
+
+
 static void
 test_utMultiply(void)
 {
@@ -2323,7 +2395,7 @@ test_xml(void)
         ut_free_system(xmlSystem);
     }
 
-    xmlSystem = ut_read_xml("xmlFailure/noExist.xml");
+    xmlSystem = ut_read_xml("noSuchDatabase.xml");
     CU_ASSERT_PTR_NULL(xmlSystem);
     CU_ASSERT_EQUAL(ut_get_status(), UT_OPEN_ARG);
 
@@ -2445,6 +2517,1338 @@ test_timeResolution(void)
     ut_free(unit);
 }
 
+
+static void
+test_utFreezeSystem(void)
+{
+    ut_system*  system;
+    ut_unit*    meter;
+    ut_unit*    second;
+    ut_unit*    unit;
+    char        buf[128];
+
+    CU_ASSERT_EQUAL(ut_freeze_system(NULL), UT_BAD_ARG);
+
+    system = ut_new_system();
+    CU_ASSERT_PTR_NOT_NULL_FATAL(system);
+    meter = ut_new_base_unit(system);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(meter);
+    CU_ASSERT_EQUAL(ut_map_name_to_unit("meter", UT_ASCII, meter), UT_SUCCESS);
+    CU_ASSERT_EQUAL(ut_map_symbol_to_unit("m", UT_ASCII, meter), UT_SUCCESS);
+    CU_ASSERT_EQUAL(ut_map_unit_to_symbol(meter, "m", UT_ASCII), UT_SUCCESS);
+    CU_ASSERT_EQUAL(ut_add_symbol_prefix(system, "k", 1e3), UT_SUCCESS);
+    second = ut_new_base_unit(system);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(second);
+
+    CU_ASSERT_EQUAL(ut_freeze_system(system), UT_SUCCESS);
+    CU_ASSERT_EQUAL(ut_freeze_system(system), UT_SUCCESS);
+
+    /*
+     * Modifications are rejected.
+     */
+    CU_ASSERT_PTR_NULL(ut_new_base_unit(system));
+    CU_ASSERT_EQUAL(ut_get_status(), UT_FROZEN);
+    CU_ASSERT_PTR_NULL(ut_new_dimensionless_unit(system));
+    CU_ASSERT_EQUAL(ut_get_status(), UT_FROZEN);
+    CU_ASSERT_EQUAL(ut_map_name_to_unit("metre", UT_ASCII, meter), UT_FROZEN);
+    CU_ASSERT_EQUAL(ut_unmap_name_to_unit(system, "meter", UT_ASCII),
+        UT_FROZEN);
+    CU_ASSERT_EQUAL(ut_map_unit_to_name(meter, "meter", UT_ASCII), UT_FROZEN);
+    CU_ASSERT_EQUAL(ut_unmap_unit_to_symbol(meter, UT_ASCII), UT_FROZEN);
+    CU_ASSERT_EQUAL(ut_add_name_prefix(system, "kilo", 1e3), UT_FROZEN);
+    CU_ASSERT_EQUAL(ut_set_second(second), UT_FROZEN);
+
+    /*
+     * Reading is unaffected.
+     */
+    CU_ASSERT_EQUAL(ut_compare(ut_lookup_unit_by_name(system, "meter"), meter),
+        0);
+    CU_ASSERT_STRING_EQUAL(ut_get_symbol(meter, UT_ASCII), "m");
+    unit = ut_parse(system, "km", UT_ASCII);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(unit);
+    CU_ASSERT_EQUAL(ut_get_status(), UT_SUCCESS);
+    CU_ASSERT_EQUAL(ut_format(unit, buf, sizeof(buf), UT_ASCII), 6);
+    CU_ASSERT_STRING_EQUAL(buf, "1000 m");
+    CU_ASSERT_TRUE(ut_are_convertible(unit, meter));
+    ut_free(unit);
+
+    ut_free(meter);
+    ut_free(second);
+    ut_free_system(system);
+}
+
+
+static void
+test_binary(void)
+{
+    static const char* const	specs[] = {"m", "km/h", "kg.m^2/s^3", "hPa",
+	"degC", "K @ 273.15", "lg(re mW)", "dBZ", "days since 2001-01-01",
+	"seconds since 1970-01-01T00:00:00Z", "furlong/fortnight", "mile^2",
+	"percent", "°F", "µm", "h.kW"};
+    static const char* const	ids[] = {"meter", "kilogram", "second",
+	"radian", "hertz", "celsius", "fahrenheit", "day", "inch", "foot",
+	"degree", "knot", "m", "Pa", "°C", "Ω"};
+    static const unsigned	opts[] = {UT_ASCII, UT_ASCII | UT_NAMES,
+	UT_ASCII | UT_DEFINITION, UT_UTF8, UT_LATIN1 | UT_NAMES};
+    char			path[] = "/tmp/testUnits.binary.XXXXXX";
+    int				fd = mkstemp(path);
+    ut_system*			xmlSystem;
+    ut_system*			binSystem;
+    ut_status			status;
+    size_t			i;
+
+    CU_ASSERT_TRUE_FATAL(fd >= 0);
+    (void)close(fd);
+
+    CU_ASSERT_EQUAL(ut_write_binary(NULL, path), UT_BAD_ARG);
+    CU_ASSERT_PTR_NULL(ut_read_binary(NULL));
+    CU_ASSERT_EQUAL(ut_get_status(), UT_BAD_ARG);
+    CU_ASSERT_PTR_NULL(ut_read_binary("/nonexistent/units.bin"));
+    CU_ASSERT_EQUAL(ut_get_status(), UT_OPEN_ARG);
+    CU_ASSERT_PTR_NULL(ut_read_binary(path));	/* empty file */
+    CU_ASSERT_EQUAL(ut_get_status(), UT_PARSE);
+
+    xmlSystem = ut_read_xml(xmlPath);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(xmlSystem);
+    CU_ASSERT_EQUAL(ut_write_binary(xmlSystem, path), UT_SUCCESS);
+    binSystem = ut_read_binary(path);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(binSystem);
+    CU_ASSERT_EQUAL(ut_get_status(), UT_SUCCESS);
+
+    for (i = 0; i < sizeof(specs)/sizeof(specs[0]); i++) {
+	ut_unit*	xmlUnit = ut_parse(xmlSystem, specs[i], UT_UTF8);
+	ut_unit*	binUnit = ut_parse(binSystem, specs[i], UT_UTF8);
+	size_t		j;
+
+	CU_ASSERT_PTR_NOT_NULL_FATAL(xmlUnit);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(binUnit);
+
+	for (j = 0; j < sizeof(opts)/sizeof(opts[0]); j++) {
+	    char	xmlBuf[128];
+	    char	binBuf[128];
+	    int		n = ut_format(xmlUnit, xmlBuf, sizeof(xmlBuf), opts[j]);
+
+	    CU_ASSERT_EQUAL(ut_format(binUnit, binBuf, sizeof(binBuf), opts[j]),
+		n);
+	    if (n >= 0)
+		CU_ASSERT_STRING_EQUAL(binBuf, xmlBuf);
+	}
+
+	ut_free(binUnit);
+	ut_free(xmlUnit);
+    }
+
+    for (i = 0; i < sizeof(ids)/sizeof(ids[0]); i++) {
+	const ut_unit*	xmlUnit = ut_lookup_unit_by_name(xmlSystem, ids[i]);
+	const ut_unit*	binUnit = ut_lookup_unit_by_name(binSystem, ids[i]);
+
+	if (xmlUnit == NULL) {
+	    xmlUnit = ut_lookup_unit_by_symbol(xmlSystem, ids[i]);
+	    binUnit = ut_lookup_unit_by_symbol(binSystem, ids[i]);
+	}
+
+	CU_ASSERT_PTR_NOT_NULL_FATAL(xmlUnit);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(binUnit);
+	CU_ASSERT_EQUAL(ut_get_name(binUnit, UT_ASCII) == NULL,
+	    ut_get_name(xmlUnit, UT_ASCII) == NULL);
+	if (ut_get_name(xmlUnit, UT_UTF8) != NULL)
+	    CU_ASSERT_STRING_EQUAL(ut_get_name(binUnit, UT_UTF8),
+		ut_get_name(xmlUnit, UT_UTF8));
+	if (ut_get_symbol(xmlUnit, UT_UTF8) != NULL)
+	    CU_ASSERT_STRING_EQUAL(ut_get_symbol(binUnit, UT_UTF8),
+		ut_get_symbol(xmlUnit, UT_UTF8));
+	if (ut_get_symbol(xmlUnit, UT_LATIN1) != NULL)
+	    CU_ASSERT_STRING_EQUAL(ut_get_symbol(binUnit, UT_LATIN1),
+		ut_get_symbol(xmlUnit, UT_LATIN1));
+    }
+
+    ut_free_system(binSystem);
+
+    /*
+     * A file that isn't a binary unit-database is rejected.
+     */
+    CU_ASSERT_PTR_NULL(ut_read_binary(ut_get_path_xml(xmlPath, &status)));
+    CU_ASSERT_EQUAL(ut_get_status(), UT_PARSE);
+
+    ut_free_system(xmlSystem);
+    (void)unlink(path);
+}
+
+
+
+static void
+test_defaultSystem(void)
+{
+    const int	setPath = xmlPath != NULL &&
+	getenv("UDUNITS2_XML_PATH") == NULL;
+    ut_system*		first;
+    ut_system*		second;
+    ut_system*		third;
+    unsigned long	firstToken;
+    unsigned long	secondToken;
+    unsigned long	thirdToken;
+    ut_system*		reread;
+    unsigned long	rereadToken;
+
+    if (setPath)
+	CU_ASSERT_EQUAL_FATAL(setenv("UDUNITS2_XML_PATH", xmlPath, 1), 0);
+
+    CU_ASSERT_EQUAL(ut_release_default_system(NULL, 1), UT_BAD_ARG);
+    CU_ASSERT_PTR_NULL(ut_acquire_default_system(NULL));
+    CU_ASSERT_EQUAL(ut_get_status(), UT_BAD_ARG);
+
+    first = ut_acquire_default_system(&firstToken);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(first);
+    second = ut_acquire_default_system(&secondToken);
+    CU_ASSERT_PTR_EQUAL(second, first);
+    CU_ASSERT_NOT_EQUAL(secondToken, firstToken);
+    third = ut_acquire_default_system(&thirdToken);
+    CU_ASSERT_PTR_EQUAL(third, first);
+    CU_ASSERT_NOT_EQUAL(thirdToken, firstToken);
+    CU_ASSERT_NOT_EQUAL(thirdToken, secondToken);
+    CU_ASSERT_EQUAL(ut_release_default_system(first,
+	firstToken + secondToken + thirdToken), UT_BAD_ARG);
+
+    /*
+     * The shared unit-system is frozen.
+     */
+    CU_ASSERT_PTR_NULL(ut_new_base_unit(first));
+    CU_ASSERT_EQUAL(ut_get_status(), UT_FROZEN);
+    CU_ASSERT_PTR_NOT_NULL(ut_lookup_unit_by_name(first, "meter"));
+
+    /*
+     * A reference can be released only once, so a double release doesn't
+     * free the unit-system while others still hold it.
+     */
+    CU_ASSERT_EQUAL(ut_release_default_system(second, secondToken), UT_SUCCESS);
+    CU_ASSERT_EQUAL(ut_release_default_system(second, secondToken), UT_BAD_ARG);
+    CU_ASSERT_EQUAL(ut_release_default_system(second, secondToken), UT_BAD_ARG);
+    CU_ASSERT_PTR_NOT_NULL(ut_lookup_unit_by_name(first, "meter"));
+    CU_ASSERT_EQUAL(ut_release_default_system(third, thirdToken), UT_SUCCESS);
+    CU_ASSERT_PTR_NOT_NULL(ut_lookup_unit_by_name(first, "meter"));
+    CU_ASSERT_EQUAL(ut_release_default_system(first, firstToken), UT_SUCCESS);
+    CU_ASSERT_EQUAL(ut_release_default_system(first, firstToken), UT_BAD_ARG);
+
+    /*
+     * The default unit-system is reloaded after its last release, so a stale
+     * release of the old one is rejected even if the new one has the same
+     * address.
+     */
+    reread = ut_acquire_default_system(&rereadToken);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(reread);
+    CU_ASSERT_NOT_EQUAL(rereadToken, firstToken);
+    CU_ASSERT_EQUAL(ut_release_default_system(reread, firstToken), UT_BAD_ARG);
+    CU_ASSERT_EQUAL(ut_release_default_system(reread, rereadToken),
+	UT_SUCCESS);
+
+    if (setPath)
+	(void)unsetenv("UDUNITS2_XML_PATH");
+}
+
+
+
+/*
+ * Writes a file in a directory.
+ */
+static void
+writeFile(
+    const char* const	dir,
+    const char* const	name,
+    const char* const	content)
+{
+    char	path[512];
+    FILE*	file;
+
+    (void)snprintf(path, sizeof(path), "%s/%s", dir, name);
+    file = fopen(path, "w");
+    CU_ASSERT_PTR_NOT_NULL_FATAL(file);
+    CU_ASSERT_EQUAL(fputs(content, file) >= 0, 1);
+    CU_ASSERT_EQUAL(fclose(file), 0);
+}
+
+
+static void
+test_xmlImports(void)
+{
+    char	dir[] = "/tmp/testUnits.xml.XXXXXX";
+    char	path[512];
+    ut_system*	unitSys;
+    static const char* const	names[] = {"base.xml", "derived.xml",
+	"common.xml", "root.xml", "missing.xml", "bad.xml", "importsBad.xml"};
+    size_t		i;
+    ut_unit*	unit;
+    char	buf[128];
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL(mkdtemp(dir));
+
+    /*
+     * Definitions in later imports use identifiers of earlier ones even
+     * though the imported files are read concurrently.
+     */
+    writeFile(dir, "base.xml",
+	"<?xml version=\"1.0\" encoding=\"US-ASCII\"?>\n"
+	"<unit-system><unit><base/><name><singular>meter</singular></name>"
+	"<symbol>m</symbol></unit></unit-system>\n");
+    writeFile(dir, "derived.xml",
+	"<?xml version=\"1.0\" encoding=\"US-ASCII\"?>\n"
+	"<unit-system><unit><def>1000 m</def>"
+	"<name><singular>klick</singular></name></unit></unit-system>\n");
+    writeFile(dir, "common.xml",
+	"<?xml version=\"1.0\" encoding=\"US-ASCII\"?>\n"
+	"<unit-system><unit><def>2 klick</def>"
+	"<name><singular>twoklick</singular></name></unit></unit-system>\n");
+    writeFile(dir, "root.xml",
+	"<?xml version=\"1.0\" encoding=\"US-ASCII\"?>\n"
+	"<unit-system><import>base.xml</import><import>derived.xml</import>"
+	"<import>common.xml</import></unit-system>\n");
+    writeFile(dir, "missing.xml",
+	"<?xml version=\"1.0\" encoding=\"US-ASCII\"?>\n"
+	"<unit-system><import>base.xml</import><import>nonexistent.xml</import>"
+	"</unit-system>\n");
+    writeFile(dir, "bad.xml",
+	"<?xml version=\"1.0\" encoding=\"US-ASCII\"?>\n"
+	"<unit-system><unit><def>1 m</def></unit-system>\n");
+    writeFile(dir, "importsBad.xml",
+	"<?xml version=\"1.0\" encoding=\"US-ASCII\"?>\n"
+	"<unit-system><import>base.xml</import><import>bad.xml</import>"
+	"</unit-system>\n");
+
+    (void)snprintf(path, sizeof(path), "%s/root.xml", dir);
+    unitSys = ut_read_xml(path);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(unitSys);
+    unit = ut_parse(unitSys, "twoklick", UT_ASCII);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(unit);
+    CU_ASSERT_EQUAL(ut_format(unit, buf, sizeof(buf), UT_ASCII), 6);
+    CU_ASSERT_STRING_EQUAL(buf, "2000 m");
+    ut_free(unit);
+    ut_free_system(unitSys);
+
+    (void)snprintf(path, sizeof(path), "%s/missing.xml", dir);
+    CU_ASSERT_PTR_NULL(ut_read_xml(path));
+    CU_ASSERT_EQUAL(ut_get_status(), UT_PARSE);
+
+    (void)snprintf(path, sizeof(path), "%s/importsBad.xml", dir);
+    CU_ASSERT_PTR_NULL(ut_read_xml(path));
+    CU_ASSERT_EQUAL(ut_get_status(), UT_PARSE);
+
+    (void)snprintf(path, sizeof(path), "%s/nonexistent.xml", dir);
+    CU_ASSERT_PTR_NULL(ut_read_xml(path));
+    CU_ASSERT_EQUAL(ut_get_status(), UT_OPEN_ARG);
+
+    for (i = 0; i < sizeof(names)/sizeof(names[0]); i++) {
+	(void)snprintf(path, sizeof(path), "%s/%s", dir, names[i]);
+	(void)unlink(path);
+    }
+    (void)rmdir(dir);
+}
+
+
+static void
+test_readXmlLazy(void)
+{
+    char	dir[] = "/tmp/testUnits.lazy.XXXXXX";
+    char	path[512];
+    ut_system*	lazySystem;
+    ut_unit*	unit;
+    ut_unit*	watt;
+    cv_converter* converter;
+    char	buf[128];
+
+    ut_set_error_message_handler(ut_ignore);
+    lazySystem = ut_read_xml_lazy(xmlPath);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(lazySystem);
+
+    /*
+     * A deferred unit is created with its identifiers when first used.
+     */
+    unit = ut_parse(lazySystem, "kW", UT_ASCII);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(unit);
+    watt = ut_get_unit_by_name(lazySystem, "watts");
+    CU_ASSERT_PTR_NOT_NULL_FATAL(watt);
+    CU_ASSERT_STRING_EQUAL(ut_get_symbol(watt, UT_ASCII), "W");
+    converter = ut_get_converter(unit, watt);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(converter);
+    CU_ASSERT_EQUAL(cv_convert_double(converter, 1), 1000);
+    cv_free(converter);
+    ut_free(unit);
+    ut_free(watt);
+
+    CU_ASSERT_PTR_NOT_NULL(ut_lookup_unit_by_symbol(lazySystem, "h"));
+    CU_ASSERT_PTR_NULL(ut_lookup_unit_by_name(lazySystem, "nonexistent"));
+    CU_ASSERT_EQUAL(ut_get_status(), UT_SUCCESS);
+    CU_ASSERT_EQUAL(ut_freeze_system(lazySystem), UT_SUCCESS);
+    CU_ASSERT_PTR_NOT_NULL(ut_lookup_unit_by_name(lazySystem, "furlong"));
+    ut_free_system(lazySystem);
+
+    /*
+     * A deferred definition may reference a later one; one that can't be
+     * resolved is only noticed when used.
+     */
+    CU_ASSERT_PTR_NOT_NULL_FATAL(mkdtemp(dir));
+    writeFile(dir, "lazy.xml",
+	"<?xml version=\"1.0\" encoding=\"US-ASCII\"?>\n"
+	"<unit-system>"
+	"<unit><base/><name><singular>meter</singular></name>"
+	"<symbol>m</symbol></unit>"
+	"<unit><def>2 skip</def><name><singular>hop</singular></name></unit>"
+	"<unit><def>3 m</def><name><singular>skip</singular></name>"
+	"<symbol>sk</symbol></unit>"
+	"<unit><def>3 m</def><name><singular>trey</singular></name></unit>"
+	"<unit><def>pong</def><name><singular>ping</singular></name></unit>"
+	"<unit><def>ping</def><name><singular>pong</singular></name></unit>"
+	"</unit-system>\n");
+    (void)snprintf(path, sizeof(path), "%s/lazy.xml", dir);
+
+    CU_ASSERT_PTR_NULL(ut_read_xml(path));
+    CU_ASSERT_EQUAL(ut_get_status(), UT_PARSE);
+
+    lazySystem = ut_read_xml_lazy(path);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(lazySystem);
+    unit = ut_parse(lazySystem, "hops", UT_ASCII);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(unit);
+    CU_ASSERT_EQUAL(ut_format(unit, buf, sizeof(buf), UT_ASCII), 3);
+    CU_ASSERT_STRING_EQUAL(buf, "6 m");
+    ut_free(unit);
+    CU_ASSERT_STRING_EQUAL(ut_get_name(ut_lookup_unit_by_symbol(lazySystem,
+	"sk"), UT_ASCII), "skip");
+    /*
+     * "trey" can't be resolved because its unit already maps to "skip", so
+     * none of its identifiers may remain mapped.
+     */
+    CU_ASSERT_PTR_NULL(ut_lookup_unit_by_name(lazySystem, "trey"));
+    CU_ASSERT_PTR_NULL(ut_lookup_unit_by_name(lazySystem, "treys"));
+    CU_ASSERT_PTR_NULL(ut_lookup_unit_by_name(lazySystem, "trey"));
+    CU_ASSERT_PTR_NULL(ut_lookup_unit_by_name(lazySystem, "ping"));
+    CU_ASSERT_PTR_NULL(ut_parse(lazySystem, "pong", UT_ASCII));
+    CU_ASSERT_EQUAL(ut_freeze_system(lazySystem), UT_PARSE);
+    ut_free_system(lazySystem);
+
+    /*
+     * Unused deferred units are freed with the unit-system.
+     */
+    lazySystem = ut_read_xml_lazy(path);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(lazySystem);
+    ut_free_system(lazySystem);
+
+    (void)unlink(path);
+    (void)rmdir(dir);
+}
+
+
+static void
+test_overlaySystem(void)
+{
+    ut_system*		base;
+    ut_system*		overlay;
+    ut_system*		other;
+    ut_unit*		meter;
+    ut_unit*		widget;
+    ut_unit*		unit;
+    ut_unit*		sibling;
+    cv_converter*	converter;
+    char		buf[128];
+
+    CU_ASSERT_PTR_NULL(ut_new_overlay_system(NULL));
+    CU_ASSERT_EQUAL(ut_get_status(), UT_BAD_ARG);
+
+    base = ut_read_xml(xmlPath);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(base);
+    CU_ASSERT_PTR_NULL(ut_new_overlay_system(base));
+    CU_ASSERT_EQUAL(ut_get_status(), UT_BAD_ARG);
+    CU_ASSERT_EQUAL_FATAL(ut_freeze_system(base), UT_SUCCESS);
+    meter = ut_get_unit_by_name(base, "meter");
+    CU_ASSERT_PTR_NOT_NULL_FATAL(meter);
+
+    overlay = ut_new_overlay_system(base);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(overlay);
+    CU_ASSERT_PTR_NULL(ut_new_base_unit(overlay));
+    CU_ASSERT_EQUAL(ut_get_status(), UT_BAD_ARG);
+    CU_ASSERT_EQUAL(ut_write_binary(overlay, "/dev/null"), UT_BAD_ARG);
+
+    /*
+     * The units and prefixes of the base are visible.
+     */
+    unit = ut_parse(overlay, "km", UT_ASCII);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(unit);
+    CU_ASSERT_PTR_EQUAL(ut_get_system(unit), overlay);
+    CU_ASSERT_EQUAL(ut_format(unit, buf, sizeof(buf), UT_ASCII), 6);
+    CU_ASSERT_STRING_EQUAL(buf, "1000 m");
+    CU_ASSERT_TRUE(ut_same_system(unit, meter));
+    CU_ASSERT_TRUE(ut_are_convertible(unit, meter));
+    ut_free(unit);
+    unit = ut_parse(overlay, "m", UT_ASCII);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(unit);
+    CU_ASSERT_EQUAL(ut_compare(unit, meter), 0);
+    CU_ASSERT_STRING_EQUAL(ut_get_name(unit, UT_ASCII), "meter");
+    ut_free(unit);
+
+    /*
+     * Local additions don't modify the base.
+     */
+    widget = ut_parse(overlay, "3 m", UT_ASCII);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(widget);
+    CU_ASSERT_EQUAL(ut_map_name_to_unit("widget", UT_ASCII, widget),
+	UT_SUCCESS);
+    CU_ASSERT_EQUAL(ut_map_unit_to_name(widget, "widget", UT_ASCII),
+	UT_SUCCESS);
+    CU_ASSERT_EQUAL(ut_add_name_prefix(overlay, "myria", 1e4), UT_SUCCESS);
+    CU_ASSERT_STRING_EQUAL(ut_get_name(widget, UT_ASCII), "widget");
+
+    unit = ut_parse(overlay, "myriawidget", UT_ASCII);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(unit);
+    converter = ut_get_converter(unit, meter);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(converter);
+    CU_ASSERT_DOUBLE_EQUAL(cv_convert_double(converter, 1), 3e4, 1e-9);
+    cv_free(converter);
+    ut_free(unit);
+
+    unit = ut_parse(overlay, "widget/s", UT_ASCII);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(unit);
+    CU_ASSERT_PTR_EQUAL(ut_get_system(unit), overlay);
+    ut_free(unit);
+
+    CU_ASSERT_PTR_NULL(ut_get_unit_by_name(base, "widget"));
+    CU_ASSERT_PTR_NULL(ut_parse(base, "widget", UT_ASCII));
+    CU_ASSERT_EQUAL(ut_get_status(), UT_UNKNOWN);
+    CU_ASSERT_PTR_NULL(ut_parse(base, "myriameter", UT_ASCII));
+
+    /*
+     * An overlay's mapping hides that of the base.
+     */
+    CU_ASSERT_EQUAL(ut_map_name_to_unit("meter", UT_ASCII, widget),
+	UT_SUCCESS);
+    unit = ut_get_unit_by_name(overlay, "meter");
+    CU_ASSERT_PTR_NOT_NULL_FATAL(unit);
+    CU_ASSERT_EQUAL(ut_compare(unit, widget), 0);
+    ut_free(unit);
+    CU_ASSERT_EQUAL(ut_compare(ut_lookup_unit_by_name(base, "meter"), meter),
+	0);
+
+    /*
+     * Sibling overlays don't see each other's additions, but their units may
+     * be compared, combined, and converted between.
+     */
+    other = ut_new_overlay_system(base);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(other);
+    CU_ASSERT_PTR_NULL(ut_get_unit_by_name(other, "widget"));
+    unit = ut_parse(other, "m", UT_ASCII);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(unit);
+    sibling = ut_parse(overlay, "m", UT_ASCII);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(sibling);
+    CU_ASSERT_EQUAL(ut_compare(unit, sibling), 0);
+    CU_ASSERT_TRUE(ut_same_system(unit, sibling));
+    CU_ASSERT_TRUE(ut_are_convertible(unit, sibling));
+    CU_ASSERT_NOT_EQUAL(ut_compare(unit, widget), 0);
+    CU_ASSERT_TRUE(ut_same_system(unit, widget));
+    CU_ASSERT_TRUE(ut_are_convertible(unit, widget));
+    converter = ut_get_converter(widget, unit);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(converter);
+    CU_ASSERT_DOUBLE_EQUAL(cv_convert_double(converter, 1), 3, 1e-9);
+    cv_free(converter);
+    ut_free(sibling);
+    sibling = ut_multiply(unit, widget);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(sibling);
+    CU_ASSERT_PTR_EQUAL(ut_get_system(sibling), base);
+    ut_free(sibling);
+    ut_free(unit);
+    ut_free_system(other);
+
+    ut_free(widget);
+    ut_free_system(overlay);
+
+    /*
+     * The base is unaffected by freeing its overlays.
+     */
+    unit = ut_parse(base, "km", UT_ASCII);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(unit);
+    CU_ASSERT_TRUE(ut_are_convertible(unit, meter));
+    ut_free(unit);
+
+    ut_free(meter);
+    ut_free_system(base);
+}
+
+
+static void
+test_reloadXml(void)
+{
+    static const struct {
+	ut_id_change	change;
+	ut_id_type	type;
+	const char*	id;
+    }			expected[] = {
+	{UT_ID_REMOVED, UT_ID_NAME, "hop"},
+	{UT_ID_REMOVED, UT_ID_NAME, "hops"},
+	{UT_ID_ADDED, UT_ID_NAME, "jump"},
+	{UT_ID_ADDED, UT_ID_NAME, "jumps"},
+	{UT_ID_CHANGED, UT_ID_NAME, "skip"},
+	{UT_ID_CHANGED, UT_ID_NAME, "skips"},
+	{UT_ID_ADDED, UT_ID_SYMBOL, "j"},
+	{UT_ID_CHANGED, UT_ID_SYMBOL, "sk"},
+	{UT_ID_REMOVED, UT_ID_NAME_PREFIX, "centi"},
+	{UT_ID_ADDED, UT_ID_NAME_PREFIX, "mega"},
+	{UT_ID_ADDED, UT_ID_SYMBOL_PREFIX, "M"},
+	{UT_ID_REMOVED, UT_ID_SYMBOL_PREFIX, "c"},
+	{UT_ID_REMOVED, UT_ID_UNIT_NAME, "hop"},
+	{UT_ID_ADDED, UT_ID_UNIT_NAME, "jump"},
+	{UT_ID_CHANGED, UT_ID_UNIT_NAME, "skip"},
+	{UT_ID_ADDED, UT_ID_UNIT_SYMBOL, "j"},
+	{UT_ID_CHANGED, UT_ID_UNIT_SYMBOL, "sk"}};
+    char		dir[] = "/tmp/testUnits.reload.XXXXXX";
+    char		oldPath[512];
+    char		newPath[512];
+    char		badPath[512];
+    ut_system*		system;
+    ut_unit*		oldSkip;
+    ut_unit*		meter;
+    const char*		meterString;
+    ut_unit*		unit;
+    ut_diff*		diff;
+    char		buf[128];
+    size_t		i;
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL(mkdtemp(dir));
+    writeFile(dir, "old.xml",
+	"<?xml version=\"1.0\" encoding=\"US-ASCII\"?>\n"
+	"<unit-system>"
+	"<prefix><value>1e3</value><name>kilo</name><symbol>k</symbol>"
+	"</prefix>"
+	"<prefix><value>1e-2</value><name>centi</name><symbol>c</symbol>"
+	"</prefix>"
+	"<unit><base/><name><singular>meter</singular></name>"
+	"<symbol>m</symbol></unit>"
+	"<unit><def>3 m</def><name><singular>skip</singular></name>"
+	"<symbol>sk</symbol></unit>"
+	"<unit><def>2 m</def><name><singular>hop</singular></name></unit>"
+	"</unit-system>\n");
+    writeFile(dir, "new.xml",
+	"<?xml version=\"1.0\" encoding=\"US-ASCII\"?>\n"
+	"<unit-system>"
+	"<prefix><value>1e3</value><name>kilo</name><symbol>k</symbol>"
+	"</prefix>"
+	"<prefix><value>1e6</value><name>mega</name><symbol>M</symbol>"
+	"</prefix>"
+	"<unit><base/><name><singular>meter</singular></name>"
+	"<symbol>m</symbol></unit>"
+	"<unit><def>4 m</def><name><singular>skip</singular></name>"
+	"<symbol>sk</symbol></unit>"
+	"<unit><def>5 m</def><name><singular>jump</singular></name>"
+	"<symbol>j</symbol></unit>"
+	"</unit-system>\n");
+    writeFile(dir, "bad.xml",
+	"<?xml version=\"1.0\" encoding=\"US-ASCII\"?>\n"
+	"<unit-system>"
+	"<unit><base/><name><singular>meter</singular></name>"
+	"<symbol>m</symbol></unit>"
+	"<unit><base/><name><singular>candela</singular></name>"
+	"<symbol>cd</symbol></unit>"
+	"<unit><def>2 cd</def><name><singular>glow</singular></name></unit>"
+	"</unit-system>\n");
+    (void)snprintf(oldPath, sizeof(oldPath), "%s/old.xml", dir);
+    (void)snprintf(newPath, sizeof(newPath), "%s/new.xml", dir);
+    (void)snprintf(badPath, sizeof(badPath), "%s/bad.xml", dir);
+
+    CU_ASSERT_EQUAL(ut_reload_xml(NULL, newPath, NULL), UT_BAD_ARG);
+
+    system = ut_read_xml(oldPath);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(system);
+    oldSkip = ut_get_unit_by_name(system, "skip");
+    CU_ASSERT_PTR_NOT_NULL_FATAL(oldSkip);
+    meter = ut_get_unit_by_name(system, "meter");
+    CU_ASSERT_PTR_NOT_NULL_FATAL(meter);
+    CU_ASSERT_EQUAL(ut_enable_format_cache(system), UT_SUCCESS);
+    meterString = ut_get_format(meter, UT_ASCII);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(meterString);
+    CU_ASSERT_STRING_EQUAL(ut_get_format(oldSkip, UT_ASCII), "sk");
+
+    CU_ASSERT_EQUAL(ut_reload_xml(system, newPath, &diff), UT_SUCCESS);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(diff);
+    CU_ASSERT_EQUAL_FATAL(diff->count,
+	sizeof(expected)/sizeof(expected[0]));
+    for (i = 0; i < diff->count; i++) {
+	CU_ASSERT_EQUAL(diff->entries[i].change, expected[i].change);
+	CU_ASSERT_EQUAL(diff->entries[i].type, expected[i].type);
+	CU_ASSERT_STRING_EQUAL(diff->entries[i].id, expected[i].id);
+    }
+    ut_free_diff(diff);
+
+    /*
+     * Only the differences were applied.
+     */
+    CU_ASSERT_PTR_NULL(ut_lookup_unit_by_name(system, "hop"));
+    unit = ut_parse(system, "Mskip", UT_ASCII);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(unit);
+    CU_ASSERT_EQUAL(ut_format(unit, buf, sizeof(buf), UT_ASCII), 9);
+    CU_ASSERT_STRING_EQUAL(buf, "4000000 m");
+    ut_free(unit);
+    unit = ut_parse(system, "jump", UT_ASCII);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(unit);
+    CU_ASSERT_STRING_EQUAL(ut_get_symbol(unit, UT_ASCII), "j");
+    ut_free(unit);
+    CU_ASSERT_PTR_NULL(ut_parse(system, "cm", UT_ASCII));
+    CU_ASSERT_PTR_NOT_NULL(ut_lookup_unit_by_symbol(system, "m"));
+    CU_ASSERT_STRING_EQUAL(ut_get_name(ut_lookup_unit_by_symbol(system, "sk"),
+	UT_ASCII), "skip");
+
+    /*
+     * Only the cached strings of remapped units are formatted anew.
+     */
+    CU_ASSERT_PTR_EQUAL(ut_get_format(meter, UT_ASCII), meterString);
+    CU_ASSERT_STRING_EQUAL(ut_get_format(oldSkip, UT_ASCII), "3 m");
+    ut_free(meter);
+
+    /*
+     * Units obtained before the reload remain valid.
+     */
+    CU_ASSERT_EQUAL(ut_format(oldSkip, buf, sizeof(buf), UT_ASCII), 3);
+    CU_ASSERT_STRING_EQUAL(buf, "3 m");
+    CU_ASSERT_PTR_NULL(ut_get_name(oldSkip, UT_ASCII));
+    ut_free(oldSkip);
+
+    /*
+     * Reloading an unchanged database changes nothing.
+     */
+    CU_ASSERT_EQUAL(ut_reload_xml(system, newPath, &diff), UT_SUCCESS);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(diff);
+    CU_ASSERT_EQUAL(diff->count, 0);
+    ut_free_diff(diff);
+
+    /*
+     * A database with different base units can't be reloaded.
+     */
+    CU_ASSERT_EQUAL(ut_reload_xml(system, badPath, &diff), UT_MEANINGLESS);
+    CU_ASSERT_PTR_NULL(diff);
+    CU_ASSERT_PTR_NOT_NULL(ut_lookup_unit_by_name(system, "jump"));
+
+    CU_ASSERT_EQUAL(ut_freeze_system(system), UT_SUCCESS);
+    CU_ASSERT_EQUAL(ut_reload_xml(system, newPath, NULL), UT_FROZEN);
+    ut_free_system(system);
+
+    /*
+     * Every kind of unit of the default database is compared exactly.
+     */
+    system = ut_read_xml(xmlPath);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(system);
+    CU_ASSERT_EQUAL(ut_reload_xml(system, xmlPath, &diff), UT_SUCCESS);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(diff);
+    CU_ASSERT_EQUAL(diff->count, 0);
+    ut_free_diff(diff);
+    ut_free_system(system);
+
+    (void)unlink(oldPath);
+    (void)unlink(newPath);
+    (void)unlink(badPath);
+    (void)rmdir(dir);
+}
+
+
+static void
+test_readStats(void)
+{
+    ut_system*          system;
+    ut_read_stats       stats;
+
+    CU_ASSERT_EQUAL(ut_get_read_stats(NULL), UT_BAD_ARG);
+
+    system = ut_read_xml(xmlPath);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(system);
+    CU_ASSERT_EQUAL(ut_get_read_stats(&stats), UT_SUCCESS);
+    CU_ASSERT(stats.total > 0);
+    CU_ASSERT(stats.read.count > 0);
+    CU_ASSERT(stats.xml.count > 0);
+    CU_ASSERT(stats.define.count > 0);
+    CU_ASSERT(stats.derive.count > 0);
+    CU_ASSERT(stats.map.count > stats.define.count);
+    CU_ASSERT(stats.define.seconds + stats.derive.seconds + stats.map.seconds
+        <= stats.total);
+    ut_free_system(system);
+
+    system = ut_read_xml_lazy(xmlPath);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(system);
+    {
+        ut_read_stats   lazy;
+
+        CU_ASSERT_EQUAL(ut_get_read_stats(&lazy), UT_SUCCESS);
+        CU_ASSERT_EQUAL(lazy.read.count, stats.read.count);
+        CU_ASSERT_EQUAL(lazy.xml.count, stats.xml.count);
+        CU_ASSERT_EQUAL(lazy.define.count, stats.define.count);
+    }
+    ut_free_system(system);
+
+    /*
+     * A failed read is measured, too.
+     */
+    CU_ASSERT_PTR_NULL(ut_read_xml("noSuchDatabase.xml"));
+    CU_ASSERT_EQUAL(ut_get_read_stats(&stats), UT_SUCCESS);
+    CU_ASSERT(stats.total > 0);
+    CU_ASSERT_EQUAL(stats.define.count, 0);
+}
+
+
+static void
+test_memoryStats(void)
+{
+    ut_system*          system = ut_new_system();
+    ut_system*          overlay;
+    ut_memory_stats     stats;
+    ut_memory_stats     frozen;
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL(system);
+    CU_ASSERT_EQUAL(ut_get_memory_stats(NULL, &stats), UT_BAD_ARG);
+    CU_ASSERT_EQUAL(ut_get_memory_stats(system, NULL), UT_BAD_ARG);
+
+    /*
+     * A new unit-system has only the dimensionless unit one.
+     */
+    CU_ASSERT_EQUAL(ut_get_memory_stats(system, &stats), UT_SUCCESS);
+    CU_ASSERT_EQUAL(stats.system.count, 1);
+    CU_ASSERT_EQUAL(stats.units.count, 1);
+    CU_ASSERT_EQUAL(stats.products.count, 0);
+    CU_ASSERT_EQUAL(stats.idMaps.count, 0);
+    CU_ASSERT_EQUAL(stats.prefixes.count, 0);
+    CU_ASSERT_EQUAL(stats.deferred.count, 0);
+    ut_free_system(system);
+
+    system = ut_read_xml(xmlPath);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(system);
+    CU_ASSERT_EQUAL(ut_get_memory_stats(system, &stats), UT_SUCCESS);
+    CU_ASSERT(stats.units.count > stats.idMaps.count);
+    CU_ASSERT(stats.products.count > 0);
+    CU_ASSERT(stats.idMaps.count > 0);
+    CU_ASSERT(stats.prefixes.count > 0);
+    CU_ASSERT_EQUAL(stats.deferred.count, 0);
+    CU_ASSERT_EQUAL(stats.total, stats.system.bytes + stats.units.bytes +
+        stats.products.bytes + stats.converters.bytes + stats.idMaps.bytes +
+        stats.prefixes.bytes + stats.deferred.bytes);
+
+    /*
+     * Freezing caches the converters of the units.
+     */
+    CU_ASSERT_EQUAL(ut_freeze_system(system), UT_SUCCESS);
+    CU_ASSERT_EQUAL(ut_get_memory_stats(system, &frozen), UT_SUCCESS);
+    CU_ASSERT(frozen.converters.count > stats.converters.count);
+    CU_ASSERT_EQUAL(frozen.units.count, stats.units.count);
+    CU_ASSERT(frozen.total > stats.total);
+
+    /*
+     * An overlay owns only what's added to it.
+     */
+    overlay = ut_new_overlay_system(system);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(overlay);
+    CU_ASSERT_EQUAL(ut_get_memory_stats(overlay, &stats), UT_SUCCESS);
+    CU_ASSERT_EQUAL(stats.units.count, 1);
+    CU_ASSERT_EQUAL(stats.idMaps.count, 0);
+    {
+        ut_unit* const  meter = ut_get_unit_by_name(overlay, "meter");
+
+        CU_ASSERT_PTR_NOT_NULL_FATAL(meter);
+        CU_ASSERT_EQUAL(ut_map_name_to_unit("metre_alias", UT_ASCII, meter),
+            UT_SUCCESS);
+        CU_ASSERT_EQUAL(ut_get_memory_stats(overlay, &stats), UT_SUCCESS);
+        CU_ASSERT_EQUAL(stats.idMaps.count, 1);
+        CU_ASSERT_EQUAL(stats.units.count, 3);
+        ut_free(meter);
+    }
+    ut_free_system(overlay);
+    ut_free_system(system);
+
+    /*
+     * Deferred definitions are counted until they're resolved.
+     */
+    system = ut_read_xml_lazy(xmlPath);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(system);
+    CU_ASSERT_EQUAL(ut_get_memory_stats(system, &stats), UT_SUCCESS);
+    CU_ASSERT(stats.deferred.count > 0);
+    CU_ASSERT(stats.deferred.bytes > 0);
+    CU_ASSERT(stats.idMaps.count < frozen.idMaps.count);
+    CU_ASSERT_EQUAL(ut_freeze_system(system), UT_SUCCESS);
+    CU_ASSERT_EQUAL(ut_get_memory_stats(system, &stats), UT_SUCCESS);
+    CU_ASSERT_EQUAL(stats.deferred.count, 0);
+    CU_ASSERT_EQUAL(stats.deferred.bytes, 0);
+    ut_free_system(system);
+}
+
+
+static int      messageCount;
+
+static int
+countMessage(
+    const char* const   fmt,
+    va_list             args)
+{
+    messageCount++;
+
+    return 1;
+}
+
+
+static void
+test_errorMessages(void)
+{
+    ut_system*                  system = ut_read_xml(xmlPath);
+    ut_error_message_handler    prev;
+    ut_unit*                    meter;
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL(system);
+    meter = ut_get_unit_by_name(system, "meter");
+    CU_ASSERT_PTR_NOT_NULL_FATAL(meter);
+
+    prev = ut_set_error_message_handler(countMessage);
+    messageCount = 0;
+#ifndef UT_NO_ERROR_MESSAGES
+    CU_ASSERT_EQUAL(ut_handle_error_message("Message %d", 1), 1);
+    CU_ASSERT_EQUAL(messageCount, 1);
+    CU_ASSERT_PTR_NULL(ut_root(meter, 2));
+    CU_ASSERT_EQUAL(ut_get_status(), UT_MEANINGLESS);
+    CU_ASSERT_EQUAL(messageCount, 2);
+    CU_ASSERT_PTR_NULL(ut_parse(system, "meter @ 100 @ 10", UT_ASCII));
+    CU_ASSERT_EQUAL(ut_get_status(), UT_SYNTAX);
+    CU_ASSERT(messageCount > 2);
+#endif
+
+    /*
+     * Discarded messages aren't composed but the status is still set.
+     */
+    (void)ut_set_error_message_handler(ut_ignore);
+    messageCount = 0;
+    CU_ASSERT_EQUAL(ut_handle_error_message("Message %d", 1), 0);
+    CU_ASSERT_PTR_NULL(ut_root(meter, 2));
+    CU_ASSERT_EQUAL(ut_get_status(), UT_MEANINGLESS);
+    CU_ASSERT_PTR_NULL(ut_parse(system, "meter @ 100 @ 10", UT_ASCII));
+    CU_ASSERT_EQUAL(ut_get_status(), UT_SYNTAX);
+    CU_ASSERT_EQUAL(messageCount, 0);
+
+    /*
+     * A thread's own handler overrides the handler of the process.
+     */
+    CU_ASSERT_PTR_NULL(ut_set_thread_error_message_handler(countMessage));
+#ifndef UT_NO_ERROR_MESSAGES
+    CU_ASSERT_EQUAL(ut_handle_error_message("Message %d", 1), 1);
+    CU_ASSERT_EQUAL(messageCount, 1);
+#endif
+    CU_ASSERT_PTR_EQUAL(ut_set_error_message_handler(NULL), ut_ignore);
+    CU_ASSERT_PTR_EQUAL(ut_set_thread_error_message_handler(NULL),
+        countMessage);
+    CU_ASSERT_PTR_NULL(ut_set_thread_error_message_handler(NULL));
+    CU_ASSERT_EQUAL(ut_handle_error_message("Message %d", 1), 0);
+
+    CU_ASSERT_PTR_EQUAL(ut_set_error_message_handler(prev), ut_ignore);
+
+    ut_free(meter);
+    ut_free_system(system);
+}
+
+
+static void
+test_context(void)
+{
+    ut_context*         context;
+    ut_system*          system;
+    ut_unit*            meter;
+    ut_unit*            second;
+    cv_converter*       converter;
+    char                buf[32];
+
+    /*
+     * Creating a context doesn't clobber a pending status of the thread.
+     */
+    ut_set_status(UT_PARSE);
+    context = ut_new_context();
+    CU_ASSERT_PTR_NOT_NULL_FATAL(context);
+    CU_ASSERT_EQUAL(ut_get_status(), UT_PARSE);
+    CU_ASSERT_EQUAL(ut_get_context_status(context), UT_SUCCESS);
+    CU_ASSERT_PTR_NULL(ut_set_context_error_message_handler(context,
+        countMessage));
+
+    system = ut_read_xml_r(context, xmlPath);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(system);
+    CU_ASSERT_EQUAL(ut_get_context_status(context), UT_SUCCESS);
+    second = ut_get_unit_by_name(system, "second");
+    CU_ASSERT_PTR_NOT_NULL_FATAL(second);
+
+    /*
+     * A failure through the context is reported to the context only.
+     */
+    ut_set_status(UT_EXISTS);
+    messageCount = 0;
+    CU_ASSERT_PTR_NULL(ut_parse_r(context, system, "meter @ 100 @ 10",
+        UT_ASCII));
+    CU_ASSERT_EQUAL(ut_get_context_status(context), UT_SYNTAX);
+    CU_ASSERT_EQUAL(ut_get_status(), UT_EXISTS);
+#ifndef UT_NO_ERROR_MESSAGES
+    CU_ASSERT(messageCount > 0);
+#endif
+    CU_ASSERT_PTR_NULL(ut_set_thread_error_message_handler(NULL));
+
+    meter = ut_parse_r(context, system, "m", UT_ASCII);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(meter);
+    CU_ASSERT_EQUAL(ut_get_context_status(context), UT_SUCCESS);
+    CU_ASSERT_EQUAL(ut_format_r(context, meter, buf, sizeof(buf), UT_NAMES),
+        5);
+    CU_ASSERT_STRING_EQUAL(buf, "meter");
+
+    messageCount = 0;
+    CU_ASSERT_PTR_NULL(ut_get_converter_r(context, meter, second));
+    CU_ASSERT_EQUAL(ut_get_context_status(context), UT_MEANINGLESS);
+    converter = ut_get_converter_r(context, meter, meter);
+    CU_ASSERT_PTR_NOT_NULL(converter);
+    CU_ASSERT_EQUAL(ut_get_context_status(context), UT_SUCCESS);
+    CU_ASSERT_EQUAL(ut_get_status(), UT_EXISTS);
+    cv_free(converter);
+
+    CU_ASSERT_PTR_EQUAL(ut_set_context_error_message_handler(context, NULL),
+        countMessage);
+    CU_ASSERT_PTR_NULL(ut_parse_r(NULL, system, "m", UT_ASCII));
+    CU_ASSERT_EQUAL(ut_get_status(), UT_BAD_ARG);
+    CU_ASSERT_EQUAL(ut_get_context_status(NULL), UT_BAD_ARG);
+
+    ut_free(second);
+    ut_free(meter);
+    ut_free_system(system);
+    ut_free_context(context);
+}
+
+
+static void
+test_canonicalKey(void)
+{
+    ut_system*          system = ut_read_xml(xmlPath);
+    const char*         specs[] = {"m/s", "meter per second", "m.s-1",
+                            "m s-1"};
+    char                buf[128];
+    unsigned long long  hash;
+    ut_unit*            unit;
+    size_t              i;
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL(system);
+
+    unit = ut_parse(system, specs[0], UT_ASCII);
+    CU_ASSERT_EQUAL(ut_canonical_key(unit, buf, sizeof(buf)), 5);
+    CU_ASSERT_STRING_EQUAL(buf, "m.s-1");
+    hash = ut_canonical_hash(unit);
+    CU_ASSERT_NOT_EQUAL(hash, 0);
+    ut_free(unit);
+
+    for (i = 1; i < sizeof(specs)/sizeof(specs[0]); i++) {
+        unit = ut_parse(system, specs[i], UT_ASCII);
+        CU_ASSERT_PTR_NOT_NULL_FATAL(unit);
+        CU_ASSERT(ut_canonical_key(unit, buf, sizeof(buf)) > 0);
+        CU_ASSERT_STRING_EQUAL(buf, "m.s-1");
+        CU_ASSERT_EQUAL(ut_canonical_hash(unit), hash);
+        ut_free(unit);
+    }
+
+    unit = ut_get_unit_by_name(system, "meter");
+    CU_ASSERT(ut_canonical_key(unit, buf, sizeof(buf)) > 0);
+    CU_ASSERT_STRING_EQUAL(buf, "m");
+    ut_free(unit);
+
+    unit = ut_get_dimensionless_unit_one(system);
+    CU_ASSERT(ut_canonical_key(unit, buf, sizeof(buf)) > 0);
+    CU_ASSERT_STRING_EQUAL(buf, "1");
+
+    unit = ut_parse(system, "km", UT_ASCII);
+    CU_ASSERT(ut_canonical_key(unit, buf, sizeof(buf)) > 0);
+    CU_ASSERT_STRING_EQUAL(buf, "G(1000,0)m");
+    ut_free(unit);
+
+    unit = ut_parse(system, "degC", UT_ASCII);
+    CU_ASSERT(ut_canonical_key(unit, buf, sizeof(buf)) > 0);
+    CU_ASSERT_STRING_EQUAL(buf, "G(1,2402652809016115p-43)K");
+    ut_free(unit);
+
+    /*
+     * Non-product units and encodings.
+     */
+    unit = ut_parse(system, "\xb0" "C", UT_LATIN1);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(unit);
+    {
+        ut_unit* const  celsius = ut_parse(system, "degC", UT_ASCII);
+        ut_unit* const  kelvin = ut_get_unit_by_name(system, "kelvin");
+
+        CU_ASSERT(ut_canonical_key(unit, buf, sizeof(buf)) > 0);
+        CU_ASSERT_STRING_EQUAL(buf, "G(1,2402652809016115p-43)K");
+        CU_ASSERT_EQUAL(ut_canonical_hash(unit), ut_canonical_hash(celsius));
+        CU_ASSERT_NOT_EQUAL(ut_canonical_hash(unit),
+            ut_canonical_hash(kelvin));
+        ut_free(kelvin);
+        ut_free(celsius);
+        ut_free(unit);
+    }
+
+    unit = ut_parse(system, "hours since 2000-01-01", UT_ASCII);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(unit);
+    CU_ASSERT(ut_canonical_key(unit, buf, sizeof(buf)) > 0);
+    CU_ASSERT_EQUAL(buf[0], 'T');
+    ut_free(unit);
+
+    unit = ut_parse(system, "lg(re 1 mW)", UT_ASCII);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(unit);
+    CU_ASSERT(ut_canonical_key(unit, buf, sizeof(buf)) > 0);
+    CU_ASSERT_STRING_EQUAL(buf, "L(10)G(1152921504606847p-60,0)m2.kg.s-3");
+
+    /*
+     * Truncation.
+     */
+    CU_ASSERT_EQUAL(ut_canonical_key(unit, buf, 6), (int)strlen(
+        "L(10)G(1152921504606847p-60,0)m2.kg.s-3"));
+    CU_ASSERT_STRING_EQUAL(buf, "L(10)");
+    ut_free(unit);
+
+    /*
+     * A unit with a NaN or infinite number has neither a key nor a hash-value.
+     */
+    {
+        ut_unit* const  meter = ut_get_unit_by_name(system, "meter");
+        const double    bad[] = {NAN, INFINITY};
+
+        CU_ASSERT_PTR_NOT_NULL_FATAL(meter);
+        for (i = 0; i < sizeof(bad)/sizeof(bad[0]); i++) {
+            unit = ut_scale(bad[i], meter);
+            CU_ASSERT_PTR_NOT_NULL_FATAL(unit);
+            CU_ASSERT_EQUAL(ut_canonical_key(unit, buf, sizeof(buf)), -1);
+            CU_ASSERT_EQUAL(ut_get_status(), UT_CANT_FORMAT);
+            CU_ASSERT_EQUAL(ut_canonical_hash(unit), 0);
+            CU_ASSERT_EQUAL(ut_get_status(), UT_CANT_FORMAT);
+            ut_free(unit);
+
+            unit = ut_offset(meter, bad[i]);
+            CU_ASSERT_PTR_NOT_NULL_FATAL(unit);
+            CU_ASSERT_EQUAL(ut_canonical_key(unit, buf, sizeof(buf)), -1);
+            CU_ASSERT_EQUAL(ut_canonical_hash(unit), 0);
+            CU_ASSERT_EQUAL(ut_get_status(), UT_CANT_FORMAT);
+            ut_free(unit);
+        }
+        ut_free(meter);
+    }
+
+    CU_ASSERT_EQUAL(ut_canonical_key(NULL, buf, sizeof(buf)), -1);
+    CU_ASSERT_EQUAL(ut_get_status(), UT_BAD_ARG);
+    CU_ASSERT_EQUAL(ut_canonical_hash(NULL), 0);
+    CU_ASSERT_EQUAL(ut_get_status(), UT_BAD_ARG);
+
+    ut_free_system(system);
+}
+
+
+static void
+test_formatMany(void)
+{
+    ut_system*          system = ut_read_xml(xmlPath);
+    const ut_unit*      units[4];
+    ut_unit*            meter;
+    ut_unit*            kilometer;
+    ut_unit*            watt;
+    size_t              offsets[4];
+    char*               buf = NULL;
+    size_t              size = 0;
+    char*               prevBuf;
+    char                expect[128];
+    int                 i;
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL(system);
+    meter = ut_get_unit_by_name(system, "meter");
+    watt = ut_get_unit_by_name(system, "watt");
+    kilometer = ut_scale(1000, meter);
+    units[0] = meter;
+    units[1] = kilometer;
+    units[2] = watt;
+    units[3] = ut_get_dimensionless_unit_one(system);
+
+    CU_ASSERT_EQUAL(ut_format_many(units, 4, UT_ASCII, &buf, &size, offsets),
+        4);
+    CU_ASSERT_EQUAL(ut_get_status(), UT_SUCCESS);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(buf);
+    for (i = 0; i < 4; i++) {
+        CU_ASSERT(ut_format(units[i], expect, sizeof(expect), UT_ASCII) >= 0);
+        CU_ASSERT(offsets[i] < size);
+        CU_ASSERT_STRING_EQUAL(buf + offsets[i], expect);
+    }
+
+    /*
+     * A sufficiently large buffer isn't reallocated.
+     */
+    prevBuf = buf;
+    CU_ASSERT_EQUAL(ut_format_many(units, 4, UT_ASCII, &buf, &size, offsets),
+        4);
+    CU_ASSERT_PTR_EQUAL(buf, prevBuf);
+    CU_ASSERT_STRING_EQUAL(buf + offsets[3], "1");
+
+    CU_ASSERT_EQUAL(ut_format_many(units, 4, UT_NAMES, &buf, &size, offsets),
+        4);
+    CU_ASSERT_STRING_EQUAL(buf + offsets[0], "meter");
+    CU_ASSERT_STRING_EQUAL(buf + offsets[2], "watt");
+    free(buf);
+
+    /*
+     * A buffer that's too small is grown.
+     */
+    size = 3;
+    buf = malloc(size);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(buf);
+    CU_ASSERT_EQUAL(ut_format_many(units, 4, UT_ASCII, &buf, &size, offsets),
+        4);
+    CU_ASSERT(size > 3);
+    CU_ASSERT_STRING_EQUAL(buf + offsets[0], "m");
+    CU_ASSERT(ut_format(kilometer, expect, sizeof(expect), UT_ASCII) >= 0);
+    CU_ASSERT_STRING_EQUAL(buf + offsets[1], expect);
+    CU_ASSERT_STRING_EQUAL(buf + offsets[2], "W");
+
+    /*
+     * Failures.
+     */
+    CU_ASSERT_EQUAL(ut_format_many(units, 0, UT_ASCII, &buf, &size, offsets),
+        0);
+    CU_ASSERT_EQUAL(ut_get_status(), UT_SUCCESS);
+    CU_ASSERT_EQUAL(ut_format_many(NULL, 4, UT_ASCII, &buf, &size, offsets),
+        0);
+    CU_ASSERT_EQUAL(ut_get_status(), UT_BAD_ARG);
+    CU_ASSERT_EQUAL(ut_format_many(units, 4, UT_LATIN1 | UT_UTF8, &buf, &size,
+        offsets), 0);
+    CU_ASSERT_EQUAL(ut_get_status(), UT_BAD_ARG);
+    units[2] = NULL;
+    CU_ASSERT_EQUAL(ut_format_many(units, 4, UT_ASCII, &buf, &size, offsets),
+        2);
+    CU_ASSERT_EQUAL(ut_get_status(), UT_BAD_ARG);
+    CU_ASSERT_STRING_EQUAL(buf + offsets[0], "m");
+    free(buf);
+
+    ut_free(kilometer);
+    ut_free(watt);
+    ut_free(meter);
+    ut_free_system(system);
+}
+
+
+static void
+test_formatCache(void)
+{
+    ut_system*          system = ut_read_xml(xmlPath);
+    ut_unit*            meter;
+    ut_unit*            kilometer;
+    const char*         string;
+    const char*         scaled;
+    char                buf[128];
+    ut_memory_stats     stats;
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL(system);
+    meter = ut_get_unit_by_name(system, "meter");
+    CU_ASSERT_PTR_NOT_NULL_FATAL(meter);
+
+    CU_ASSERT_EQUAL(ut_enable_format_cache(NULL), UT_BAD_ARG);
+    CU_ASSERT_PTR_NULL(ut_get_format(meter, UT_ASCII));
+    CU_ASSERT_EQUAL(ut_get_status(), UT_BAD_ARG);
+
+    CU_ASSERT_EQUAL(ut_enable_format_cache(system), UT_SUCCESS);
+    CU_ASSERT_EQUAL(ut_enable_format_cache(system), UT_SUCCESS);
+    CU_ASSERT_PTR_NULL(ut_get_format(NULL, UT_ASCII));
+    CU_ASSERT_EQUAL(ut_get_status(), UT_BAD_ARG);
+    CU_ASSERT_PTR_NULL(ut_get_format(meter, UT_LATIN1 | UT_UTF8));
+    CU_ASSERT_EQUAL(ut_get_status(), UT_BAD_ARG);
+
+    string = ut_get_format(meter, UT_ASCII);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(string);
+    CU_ASSERT_STRING_EQUAL(string, "m");
+    CU_ASSERT_PTR_EQUAL(ut_get_format(meter, UT_ASCII), string);
+    CU_ASSERT_STRING_EQUAL(ut_get_format(meter, UT_ASCII | UT_NAMES),
+        "meter");
+
+    /*
+     * Equal units share the cached string.
+     */
+    {
+        ut_unit* const  m = ut_get_unit_by_symbol(system, "m");
+
+        CU_ASSERT_PTR_EQUAL(ut_get_format(m, UT_ASCII), string);
+        ut_free(m);
+    }
+
+    kilometer = ut_scale(1000, meter);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(kilometer);
+    scaled = ut_get_format(kilometer, UT_ASCII);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(scaled);
+    CU_ASSERT(ut_format(kilometer, buf, sizeof(buf), UT_ASCII) > 0);
+    CU_ASSERT_STRING_EQUAL(scaled, buf);
+
+    /*
+     * A new mapping makes the unit formatted anew.  Strings already returned
+     * stay valid.
+     */
+    CU_ASSERT_EQUAL(ut_map_unit_to_symbol(kilometer, "klick", UT_ASCII),
+        UT_SUCCESS);
+    CU_ASSERT_STRING_EQUAL(ut_get_format(kilometer, UT_ASCII), "klick");
+    CU_ASSERT_STRING_EQUAL(scaled, buf);
+    CU_ASSERT_STRING_EQUAL(ut_get_format(meter, UT_ASCII), "m");
+    CU_ASSERT_EQUAL(ut_unmap_unit_to_symbol(kilometer, UT_ASCII), UT_SUCCESS);
+    CU_ASSERT_PTR_EQUAL(ut_get_format(kilometer, UT_ASCII), scaled);
+
+    CU_ASSERT_EQUAL(ut_get_memory_stats(system, &stats), UT_SUCCESS);
+    CU_ASSERT(stats.formats.count >= 4);
+    CU_ASSERT(stats.formats.bytes > 0);
+
+    /*
+     * Changing the identifiers of an unrelated unit neither formats the cached
+     * units anew nor keeps more strings.
+     */
+    {
+        ut_unit* const      second = ut_get_unit_by_name(system, "second");
+        ut_unit* const      fortnight = ut_scale(1209600, second);
+        ut_memory_stats     after;
+
+        CU_ASSERT_PTR_NOT_NULL_FATAL(fortnight);
+        CU_ASSERT_EQUAL(ut_map_unit_to_symbol(fortnight, "ftn", UT_ASCII),
+            UT_SUCCESS);
+        CU_ASSERT_EQUAL(ut_unmap_unit_to_symbol(fortnight, UT_ASCII),
+            UT_SUCCESS);
+        CU_ASSERT_PTR_EQUAL(ut_get_format(meter, UT_ASCII), string);
+        CU_ASSERT_PTR_EQUAL(ut_get_format(kilometer, UT_ASCII), scaled);
+        CU_ASSERT_EQUAL(ut_get_memory_stats(system, &after), UT_SUCCESS);
+        CU_ASSERT_EQUAL(after.formats.count, stats.formats.count);
+        ut_free(fortnight);
+        ut_free(second);
+    }
+
+    /*
+     * The cache works for frozen unit-systems.
+     */
+    CU_ASSERT_EQUAL(ut_freeze_system(system), UT_SUCCESS);
+    CU_ASSERT_STRING_EQUAL(ut_get_format(kilometer, UT_ASCII | UT_NAMES),
+        "1000 meter");
+
+    ut_free(kilometer);
+    ut_free(meter);
+    ut_free_system(system);
+
+    /*
+     * Resolving deferred units maps their identifiers, which leaves the cached
+     * strings of other units alone.
+     */
+    system = ut_read_xml_lazy(xmlPath);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(system);
+    CU_ASSERT_EQUAL(ut_enable_format_cache(system), UT_SUCCESS);
+    meter = ut_get_unit_by_name(system, "meter");
+    CU_ASSERT_PTR_NOT_NULL_FATAL(meter);
+    string = ut_get_format(meter, UT_ASCII);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(string);
+    CU_ASSERT_EQUAL(ut_get_memory_stats(system, &stats), UT_SUCCESS);
+    {
+        static const char* const    names[] = {"watt", "hertz", "pascal",
+            "day"};
+        ut_memory_stats             after;
+        size_t                      i;
+
+        for (i = 0; i < sizeof(names)/sizeof(names[0]); i++)
+            CU_ASSERT_PTR_NOT_NULL(ut_lookup_unit_by_name(system, names[i]));
+
+        CU_ASSERT_PTR_EQUAL(ut_get_format(meter, UT_ASCII), string);
+        CU_ASSERT_EQUAL(ut_get_memory_stats(system, &after), UT_SUCCESS);
+        CU_ASSERT_EQUAL(after.formats.count, stats.formats.count);
+    }
+    ut_free(meter);
+    ut_free_system(system);
+}
+
+
 int
 main(
     const int           argc,
@@ -2466,6 +3870,8 @@ main(
 	    CU_ADD_TEST(testSuite, test_utNewDimensionlessUnit);
 	    CU_ADD_TEST(testSuite, test_utGetUnitByName);
 	    CU_ADD_TEST(testSuite, test_utGetUnitBySymbol);
+	    CU_ADD_TEST(testSuite, test_utLookupUnitByName);
+	    CU_ADD_TEST(testSuite, test_utLookupUnitBySymbol);
 	    CU_ADD_TEST(testSuite, test_utAddNamePrefix);
 	    CU_ADD_TEST(testSuite, test_utAddSymbolPrefix);
 	    CU_ADD_TEST(testSuite, test_utMapNameToUnit);
@@ -2483,6 +3889,7 @@ main(
 	    CU_ADD_TEST(testSuite, test_utMapUnitToName);
 	    CU_ADD_TEST(testSuite, test_utGetName);
 	    CU_ADD_TEST(testSuite, test_utGetSymbol);
+	    CU_ADD_TEST(testSuite, test_utGetSymbolEncodings);
 	    CU_ADD_TEST(testSuite, test_utToString);
 	    CU_ADD_TEST(testSuite, test_utGetDimensionlessUnitOne);
 	    CU_ADD_TEST(testSuite, test_utGetSystem);
@@ -2497,6 +3904,20 @@ main(
 	    CU_ADD_TEST(testSuite, test_visitor);
 	    CU_ADD_TEST(testSuite, test_xml);
 	    CU_ADD_TEST(testSuite, test_timeResolution);
+	    CU_ADD_TEST(testSuite, test_utFreezeSystem);
+	    CU_ADD_TEST(testSuite, test_binary);
+	    CU_ADD_TEST(testSuite, test_defaultSystem);
+	    CU_ADD_TEST(testSuite, test_xmlImports);
+	    CU_ADD_TEST(testSuite, test_readXmlLazy);
+	    CU_ADD_TEST(testSuite, test_overlaySystem);
+	    CU_ADD_TEST(testSuite, test_reloadXml);
+	    CU_ADD_TEST(testSuite, test_readStats);
+	    CU_ADD_TEST(testSuite, test_memoryStats);
+	    CU_ADD_TEST(testSuite, test_formatMany);
+	    CU_ADD_TEST(testSuite, test_canonicalKey);
+	    CU_ADD_TEST(testSuite, test_context);
+	    CU_ADD_TEST(testSuite, test_errorMessages);
+	    CU_ADD_TEST(testSuite, test_formatCache);
 	    /*
 	    */
 
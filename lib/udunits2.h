@@ -82,6 +82,7 @@ char* str,
 
 typedef struct ut_system	ut_system;
 typedef union ut_unit		ut_unit;
+typedef struct ut_context	ut_context;
 
 enum utStatus {
     UT_SUCCESS = 0,	/* Success */
@@ -99,7 +100,8 @@ enum utStatus {
     UT_OPEN_ARG,	/* Can't open argument-specified unit database */
     UT_OPEN_ENV,	/* Can't open environment-specified unit database */
     UT_OPEN_DEFAULT,	/* Can't open installed, default, unit database */
-    UT_PARSE		/* Error parsing unit specification */
+    UT_PARSE,		/* Error parsing unit specification */
+    UT_FROZEN		/* The unit-system is frozen */
 };
 typedef enum utStatus          ut_status;
 
@@ -107,7 +109,7 @@ typedef enum utStatus          ut_status;
 /*
  * STATUS CONVENTION
  *
- * This library maintains a single, global status value, readable with
+ * This library maintains a status value per thread, readable with
  * ut_get_status(). Functions that participate in the convention report the
  * outcome of *their own* call: UT_SUCCESS when they succeed, and a specific
  * failure code -- usually UT_BAD_ARG -- when they do not. Success is reported
@@ -123,7 +125,7 @@ typedef enum utStatus          ut_status;
  * as the authoritative failure signal, with the status as a secondary, in-sync
  * copy: a NaN return and UT_BAD_ARG always accompany one another. Of the two,
  * NaN is the one to prefer, since it is carried in the return value rather
- * than in global state.
+ * than in per-thread state.
  *
  * The ut_check_* and ut_encode_* families documented below follow this
  * convention, as do most other functions in this header that report a
@@ -141,6 +143,125 @@ typedef enum utEncoding        ut_encoding;
 #define UT_NAMES	4
 #define UT_DEFINITION	8
 
+/*
+ * The invalid time of the functions that use 64-bit integer nanoseconds (e.g.,
+ * ut_encode_time_ns()).  It's LLONG_MIN.
+ */
+#define UT_NS_INVALID	(-9223372036854775807LL - 1)
+
+/*
+ * Kinds of identifier that ut_reload_xml() reports.
+ */
+enum utIdType {
+    UT_ID_NAME = 0,		/* Name of a unit */
+    UT_ID_SYMBOL,		/* Symbol of a unit */
+    UT_ID_NAME_PREFIX,		/* Name-prefix (e.g., "mega") */
+    UT_ID_SYMBOL_PREFIX,	/* Symbol-prefix (e.g., "M") */
+    UT_ID_UNIT_NAME,		/* Name to which a unit maps (see
+				   ut_get_name()) */
+    UT_ID_UNIT_SYMBOL		/* Symbol to which a unit maps (see
+				   ut_get_symbol()) */
+};
+typedef enum utIdType		ut_id_type;
+
+/*
+ * Changes to an identifier that ut_reload_xml() reports.
+ */
+enum utIdChange {
+    UT_ID_ADDED = 0,		/* The identifier was added */
+    UT_ID_REMOVED,		/* The identifier was removed */
+    UT_ID_CHANGED		/* The identifier's unit or value changed */
+};
+typedef enum utIdChange		ut_id_change;
+
+/*
+ * A difference between a unit-system and a reloaded unit database:
+ */
+typedef struct {
+    ut_id_change	change;
+    ut_id_type		type;
+    const char*		id;	/* the identifier */
+} ut_id_diff;
+
+/*
+ * The differences applied by ut_reload_xml():
+ */
+typedef struct {
+    ut_id_diff*		entries;	/* sorted by type, then identifier */
+    size_t		count;		/* number of entries */
+} ut_diff;
+
+/*
+ * The wall-clock time and the amount of work of one phase of reading an XML
+ * unit database (see ut_get_read_stats()):
+ */
+typedef struct {
+    double		seconds;	/* wall-clock time in seconds */
+    unsigned long	count;		/* amount of work (see ut_read_stats) */
+} ut_phase_stats;
+
+/*
+ * Where the time of reading an XML unit database went:
+ */
+typedef struct {
+    ut_phase_stats	read;		/* opening and reading the files.  count
+					   is bytes. */
+    ut_phase_stats	xml;		/* tokenizing the files with expat.
+					   count is XML events. */
+    ut_phase_stats	define;		/* parsing unit definitions by
+					   ut_parse() or deferring them (see
+					   ut_read_xml_lazy()).  count is
+					   definitions. */
+    ut_phase_stats	derive;		/* forming plural names and the Latin-1,
+					   UTF-8, and non-breaking-space forms
+					   of identifiers.  count is
+					   identifiers. */
+    ut_phase_stats	map;		/* adding identifier mappings.  count
+					   is mappings. */
+    double		total;		/* wall-clock time of the whole read in
+					   seconds */
+} ut_read_stats;
+
+/*
+ * The memory that one category of objects of a unit-system takes (see
+ * ut_get_memory_stats()):
+ */
+typedef struct {
+    size_t		bytes;		/* bytes requested from malloc() */
+    size_t		count;		/* number of objects */
+} ut_memory_usage;
+
+/*
+ * Where the memory of a unit-system goes:
+ */
+typedef struct {
+    ut_memory_usage	system;		/* the unit-system itself and its
+					   array of basic-units */
+    ut_memory_usage	units;		/* units: the basic-units and the units
+					   that identifiers map to and from */
+    ut_memory_usage	products;	/* the basic-unit index and power
+					   arrays of product-units.  count is
+					   arrays. */
+    ut_memory_usage	converters;	/* converters cached by units */
+    ut_memory_usage	idMaps;		/* the hash-tables and entries of the
+					   identifier-to-unit and
+					   unit-to-identifier maps, including
+					   the identifiers.  count is
+					   entries. */
+    ut_memory_usage	prefixes;	/* the search-tree nodes of the
+					   prefixes, the list of prefixes, and
+					   their identifiers.  count is
+					   search-tree nodes. */
+    ut_memory_usage	deferred;	/* deferred unit-definitions (see
+					   ut_read_xml_lazy()), including their
+					   identifiers and look-up tables.
+					   count is deferred units. */
+    ut_memory_usage	formats;	/* the format cache (see
+					   ut_enable_format_cache()).  count
+					   is strings. */
+    size_t		total;		/* sum of the bytes of the above */
+} ut_memory_stats;
+
 
 /*
  * Data-structure for a visitor to a unit:
@@ -266,7 +387,10 @@ ut_get_path_xml(
  *	path	The pathname of the XML file or NULL.  If NULL, then the
  *		pathname specified by the environment variable UDUNITS2_XML_PATH
  *		is used if set; otherwise, the compile-time pathname of the
- *		installed, default, unit database is used.
+ *		installed, default, unit database is used.  If the library was
+ *		built with the default database compiled in (CMake option
+ *		UDUNITS_EMBED_DATABASE), then that database is used instead of
+ *		the installed one and no file is read.
  * Returns:
  *	NULL	Failure.  "ut_get_status()" will be
  *		    UT_OPEN_ARG		"path" is non-NULL but file couldn't be
@@ -289,6 +413,152 @@ ut_read_xml(
     const char*	path);
 
 
+/*
+ * Returns the unit-system corresponding to an XML file like ut_read_xml() but
+ * defers the parsing of unit definitions.  Base units, dimensionless units,
+ * and prefixes are created immediately; every other unit is recorded together
+ * with its names and symbols and is created the first time one of its
+ * identifiers is looked up -- directly or by ut_parse() -- which recursively
+ * creates the units that its definition references.  Start-up time and memory
+ * thus scale with the units that are actually used.
+ *
+ * Consequently, an invalid definition is reported when its unit is first used
+ * rather than by this function, a definition may reference a unit that's
+ * defined later in the database, definitions that override a prefixed unit
+ * aren't reported, and ut_get_name(), ut_get_symbol(), and ut_format() only
+ * know the identifiers of units that have been created.  ut_freeze_system()
+ * and ut_write_binary() create every deferred unit.
+ *
+ * Arguments:
+ *	path	As for ut_read_xml().
+ * Returns:
+ *	As for ut_read_xml().
+ */
+EXTERNL ut_system*
+ut_read_xml_lazy(
+    const char*	path);
+
+
+/*
+ * Brings a unit-system up to date with a changed XML unit database by applying
+ * only the differences: names, symbols, and prefixes that were added, that were
+ * removed, or whose unit or value changed.  The mappings from units to names
+ * and symbols, which ut_get_name(), ut_get_symbol(), and ut_format() use, are
+ * updated and reported likewise; of the strings cached by ut_get_format(), only
+ * those of the remapped units are formatted anew.  Units obtained from the
+ * unit-system before the call remain valid.  The base units and dimensionless
+ * units of the database must be those of the unit-system.
+ *
+ * Arguments:
+ *	system	Pointer to the unit-system.  It shall not be frozen.
+ *	path	As for ut_read_xml().
+ *	diff	NULL or pointer to the memory location to receive a pointer to
+ *		the differences that were applied.  The caller should pass
+ *		"*diff" to ut_free_diff() when it's no longer needed.
+ * Returns:
+ *	UT_SUCCESS	Success.
+ *	UT_BAD_ARG	"system" is NULL.
+ *	UT_FROZEN	"system" is frozen.
+ *	UT_MEANINGLESS	A base unit or dimensionless unit of the database or
+ *			of "system" isn't in the other.  "system" is
+ *			unchanged.
+ *	UT_PARSE	"system" has a deferred unit-definition (see
+ *			ut_read_xml_lazy()) that couldn't be parsed.  "system"
+ *			is unchanged.
+ *	UT_OS		Operating-system error.  See "errno".  "system" might
+ *			be partially updated.
+ *	else		As for ut_read_xml().  "system" is unchanged.
+ */
+EXTERNL ut_status
+ut_reload_xml(
+    ut_system* const	system,
+    const char* const	path,
+    ut_diff** const	diff);
+
+
+/*
+ * Frees the differences returned by ut_reload_xml().
+ *
+ * Arguments:
+ *	diff	Pointer to the differences or NULL.
+ */
+EXTERNL void
+ut_free_diff(
+    ut_diff* const	diff);
+
+
+/*
+ * Returns where the time went during the most recent call to ut_read_xml() or
+ * ut_read_xml_lazy() by the calling thread -- whether or not the call
+ * succeeded.  The files that a database imports are read and tokenized
+ * concurrently, so the "read" and "xml" times of a database with imports can
+ * add up to more than its "total" time.  When a file is mapped into memory,
+ * the actual reading of the file is counted as tokenizing.
+ *
+ * If the environment variable UDUNITS2_READ_STATS is set to a non-empty value,
+ * then ut_read_xml() and ut_read_xml_lazy() also print these statistics to the
+ * standard error stream.
+ *
+ * Arguments:
+ *	stats	Pointer to the statistics to be set.  Every member is zero if
+ *		the calling thread hasn't read an XML unit database.
+ * Returns:
+ *	UT_SUCCESS	Success.
+ *	UT_BAD_ARG	"stats" is NULL.
+ */
+EXTERNL ut_status
+ut_get_read_stats(
+    ut_read_stats* const	stats);
+
+
+/*
+ * Writes a unit-system to a binary unit-database.  Reading the database via
+ * ut_read_binary() yields an equivalent unit-system much faster than
+ * ut_read_xml() because nothing has to be parsed.  The file is specific to the
+ * byte-order and floating-point format of the host and to the version of the
+ * binary format.
+ *
+ * Arguments:
+ *	system		Pointer to the unit-system.
+ *	path		Pathname of the file to be written.  An existing file
+ *			is replaced.
+ * Returns:
+ *	UT_SUCCESS	Success.
+ *	UT_BAD_ARG	"system" or "path" is NULL, or "system" is an
+ *			overlay (see ut_new_overlay_system()).
+ *	UT_PARSE	A deferred unit-definition (see ut_read_xml_lazy())
+ *			couldn't be parsed.
+ *	UT_OS		Operating-system error.  See "errno".
+ */
+EXTERNL ut_status
+ut_write_binary(
+    const ut_system* const	system,
+    const char* const		path);
+
+
+/*
+ * Returns the unit-system of a binary unit-database written by
+ * ut_write_binary().  The file is mapped into memory and read in place.
+ *
+ * Arguments:
+ *	path	Pathname of the binary unit-database.
+ * Returns:
+ *	NULL	Failure.  "ut_get_status()" will be
+ *		    UT_BAD_ARG		"path" is NULL.
+ *		    UT_OPEN_ARG		The file couldn't be opened.  See
+ *					"errno" for reason.
+ *		    UT_PARSE		The file isn't a binary unit-database
+ *					of a supported version written by a
+ *					compatible host.
+ *		    UT_OS		Operating-system error.  See "errno".
+ *	else	Pointer to the unit-system.  The client should pass it to
+ *		ut_free_system() when it's no longer needed.
+ */
+EXTERNL ut_system*
+ut_read_binary(
+    const char* const	path);
+
+
 /*
  * Returns a new unit-system.  On success, the unit-system will only contain
  * the dimensionless unit one.  See "ut_get_dimensionless_unit_one()".
@@ -302,6 +572,34 @@ EXTERNL ut_system*
 ut_new_system(void);
 
 
+/*
+ * Returns a new unit-system that overlays a frozen unit-system.  The new
+ * unit-system has the units, prefixes, and identifiers of the overlaid one
+ * and may be given its own: mapping an identifier in the new unit-system
+ * leaves the overlaid one unchanged and hides any mapping of the identifier
+ * in it.  Units of the two unit-systems may be combined and converted between,
+ * as may units of two overlays of the same unit-system.
+ * The new unit-system can't have its own base-units or dimensionless-units.
+ *
+ * Creating an overlay is cheap: nothing of the overlaid unit-system is copied.
+ * Because the overlaid unit-system is frozen, any number of overlays of it may
+ * be used and freed concurrently.
+ *
+ * Arguments:
+ *	base	Pointer to the frozen unit-system to be overlaid.  It shall not
+ *		be freed until the new unit-system has been freed.
+ * Returns:
+ *	NULL	Failure.  "ut_get_status()" will be:
+ *		    UT_BAD_ARG	"base" is NULL or isn't frozen.
+ *		    UT_OS	Operating-system error.  See "errno".
+ *	else	Pointer to the new unit-system.  It should be passed to
+ *		ut_free_system() when it's no longer needed.
+ */
+EXTERNL ut_system*
+ut_new_overlay_system(
+    const ut_system* const	base);
+
+
 /*
  * Frees a unit-system.  All unit-to-identifier and identifier-to-unit mappings
  * will be removed.
@@ -315,6 +613,99 @@ ut_free_system(
     ut_system*	system);
 
 
+/*
+ * Freezes a unit-system.  All lazily-created state of the unit-system --
+ * including the units of deferred definitions (see ut_read_xml_lazy()) -- is
+ * created and all subsequent attempts to modify the unit-system (e.g., by
+ * adding a base unit, prefix, or identifier mapping) fail with UT_FROZEN.
+ * Afterwards, any number of threads may concurrently parse, look up, convert,
+ * and format units of the unit-system without synchronization.  Freezing a
+ * frozen unit-system has no effect.
+ *
+ * Arguments:
+ *	system		Pointer to the unit-system to be frozen.
+ * Returns:
+ *	UT_SUCCESS	Success.
+ *	UT_BAD_ARG	"system" is NULL.
+ *	UT_OS		Operating-system error.  See "errno".  The unit-system
+ *			isn't frozen.
+ *	UT_PARSE	A deferred unit-definition couldn't be parsed.  The
+ *			unit-system isn't frozen.
+ */
+EXTERNL ut_status
+ut_freeze_system(
+    ut_system*	system);
+
+
+/*
+ * Returns where the memory of a unit-system goes.  Only the memory that the
+ * unit-system owns is counted: not the units that the client obtained from it
+ * and, for an overlay (see ut_new_overlay_system()), not the unit-system that
+ * it overlays.  The bytes are those requested from the memory allocator and so
+ * don't include its overhead.  Search-tree nodes of prefixes are counted at the
+ * size of three pointers each.
+ *
+ * Arguments:
+ *	system	Pointer to the unit-system.
+ *	stats	Pointer to the statistics to be set.
+ * Returns:
+ *	UT_SUCCESS	Success.
+ *	UT_BAD_ARG	"system" or "stats" is NULL.
+ */
+EXTERNL ut_status
+ut_get_memory_stats(
+    const ut_system* const	system,
+    ut_memory_stats* const	stats);
+
+
+/*
+ * Returns a reference to the process-wide, shared default unit-system.  The
+ * first acquisition reads the default unit database as ut_read_xml(NULL) does
+ * and freezes the result (see ut_freeze_system()); later acquisitions return
+ * the same unit-system without reading anything.  This function is
+ * thread-safe.  Each successful call shall be matched by one call to
+ * ut_release_default_system() with the returned unit-system and token.
+ *
+ * Arguments:
+ *	token	Pointer to the token of the reference.  Set upon success.
+ *		Every acquisition gets a different token.
+ * Returns:
+ *	NULL	Failure.  "ut_get_status()" will be
+ *		    UT_BAD_ARG	"token" is NULL.
+ *		    UT_OS	Operating-system error.  See "errno".
+ *		    else	As for ut_read_xml() or ut_freeze_system().
+ *	else	Pointer to the frozen default unit-system.  It shall not be
+ *		passed to ut_free_system().
+ */
+EXTERNL ut_system*
+ut_acquire_default_system(
+    unsigned long* const	token);
+
+
+/*
+ * Releases a reference to the shared default unit-system.  The unit-system is
+ * freed when its last reference is released, so units obtained from it shall
+ * not be used after the release.  A release whose token isn't that of an
+ * unreleased reference is rejected: a reference can be released only once,
+ * and a reference to a default unit-system that has since been freed can't be
+ * released.  This function is thread-safe.
+ *
+ * Arguments:
+ *	system		Pointer to the unit-system returned by
+ *			ut_acquire_default_system().
+ *	token		The token returned with "system" by
+ *			ut_acquire_default_system().
+ * Returns:
+ *	UT_SUCCESS	Success.
+ *	UT_BAD_ARG	"system" and "token" aren't an unreleased reference to
+ *			the current shared default unit-system.
+ */
+EXTERNL ut_status
+ut_release_default_system(
+    ut_system* const		system,
+    const unsigned long		token);
+
+
 /*
  * Returns the unit-system to which a unit belongs.
  *
@@ -393,6 +784,53 @@ ut_get_unit_by_symbol(
     const char* const		symbol);
 
 
+/*
+ * Returns the unit with a given name from a unit-system without copying it.
+ * Name comparisons are case-insensitive.
+ *
+ * Arguments:
+ *	system	Pointer to the unit-system.
+ *	name	Pointer to the name of the unit to be returned.
+ * Returns:
+ *	NULL	Failure.  "ut_get_status()" will be
+ *		    UT_SUCCESS		"name" doesn't map to a unit of
+ *					"system".
+ *		    UT_BAD_ARG		"system" or "name" is NULL.
+ *	else	Pointer to the unit of the unit-system with the given name.
+ *		The unit belongs to the unit-system: it must not be passed to
+ *		ut_free() and it remains valid until "name" is unmapped or the
+ *		unit-system is freed.
+ */
+EXTERNL const ut_unit*
+ut_lookup_unit_by_name(
+    const ut_system* const	system,
+    const char* const		name);
+
+
+/*
+ * Returns the unit with a given symbol from a unit-system without copying it.
+ * Symbol comparisons are case-sensitive.
+ *
+ * Arguments:
+ *	system		Pointer to the unit-system.
+ *	symbol		Pointer to the symbol associated with the unit to be
+ *			returned.
+ * Returns:
+ *	NULL	Failure.  "ut_get_status()" will be
+ *		    UT_SUCCESS		"symbol" doesn't map to a unit of
+ *					"system".
+ *		    UT_BAD_ARG		"system" or "symbol" is NULL.
+ *	else	Pointer to the unit in the unit-system with the given symbol.
+ *		The unit belongs to the unit-system: it must not be passed to
+ *		ut_free() and it remains valid until "symbol" is unmapped or
+ *		the unit-system is freed.
+ */
+EXTERNL const ut_unit*
+ut_lookup_unit_by_symbol(
+    const ut_system* const	system,
+    const char* const		symbol);
+
+
 /*
  * Sets the "second" unit of a unit-system.  This function must be called before
  * the first call to "ut_offset_by_time()". ut_read_xml() calls this function if the
@@ -405,6 +843,7 @@ ut_get_unit_by_symbol(
  *	UT_EXISTS	The second unit of the unit-system to which "second"
  *			belongs is set to a different unit.
  *	UT_SUCCESS	Success.
+ *	UT_FROZEN	The unit-system is frozen.
  */
 EXTERNL ut_status
 ut_set_second(
@@ -430,6 +869,7 @@ ut_set_second(
  *	UT_BAD_ARG	"system" or "name" is NULL, or "value" is 0.
  *	UT_EXISTS	"name" already maps to a different value.
  *	UT_OS		Operating-system failure.  See "errno".
+ *	UT_FROZEN	The unit-system is frozen.
  */
 EXTERNL ut_status
 ut_add_name_prefix(
@@ -453,6 +893,7 @@ ut_add_name_prefix(
  *	UT_BAD_ARG	"value" is 0.
  *	UT_EXISTS	"symbol" already maps to a different value.
  *	UT_OS		Operating-system failure.  See "errno".
+ *	UT_FROZEN	The unit-system is frozen.
  */
 EXTERNL ut_status
 ut_add_symbol_prefix(
@@ -474,8 +915,10 @@ ut_add_symbol_prefix(
  *	system	Pointer to the unit-system to which to add the new base-unit.
  * Returns:
  *	NULL	Failure.  "ut_get_status()" will be
- *		    UT_BAD_ARG		"system" or "name" is NULL.
+ *		    UT_BAD_ARG		"system" or "name" is NULL or
+ *					"system" is an overlay.
  *		    UT_OS		Operating-system error.  See "errno".
+ *		    UT_FROZEN		"system" is frozen.
  *	else	Pointer to the new base-unit.  The pointer should be passed to
  *		ut_free() when the unit is no longer needed by the client (the
  *		unit will remain in the unit-system).
@@ -495,8 +938,9 @@ ut_new_base_unit(
  *		dimensionless-unit.
  * Returns:
  *	NULL	Failure.  "ut_get_status()" will be
- *		    UT_BAD_ARG		"system" is NULL.
+ *		    UT_BAD_ARG		"system" is NULL or is an overlay.
  *		    UT_OS		Operating-system error.  See "errno".
+ *		    UT_FROZEN		"system" is frozen.
  *	else	Pointer to the new dimensionless-unit.  The pointer should be
  *		passed to ut_free() when the unit is no longer needed by the
  *		client (the unit will remain in the unit-system).
@@ -576,6 +1020,7 @@ ut_get_name(
  *	UT_OS		Operating-system error.  See "errno".
  *	UT_EXISTS	"name" already maps to a different unit.
  *	UT_SUCCESS	Success.
+ *	UT_FROZEN	The unit-system is frozen.
  */
 EXTERNL ut_status
 ut_map_name_to_unit(
@@ -595,6 +1040,7 @@ ut_map_name_to_unit(
  * Returns:
  *	UT_SUCCESS	Success.
  *	UT_BAD_ARG	"system" or "name" is NULL.
+ *	UT_FROZEN	The unit-system is frozen.
  */
 EXTERNL ut_status
 ut_unmap_name_to_unit(
@@ -618,6 +1064,7 @@ ut_unmap_name_to_unit(
  *                      specified encoding.
  *	UT_OS		Operating-system error.  See "errno".
  *	UT_EXISTS	"unit" already maps to a name.
+ *	UT_FROZEN	The unit-system is frozen.
  */
 EXTERNL ut_status
 ut_map_unit_to_name(
@@ -636,6 +1083,7 @@ ut_map_unit_to_name(
  * Returns:
  *	UT_BAD_ARG	"unit" is NULL.
  *	UT_SUCCESS	Success.
+ *	UT_FROZEN	The unit-system is frozen.
  */
 EXTERNL ut_status
 ut_unmap_unit_to_name(
@@ -682,6 +1130,7 @@ ut_get_symbol(
  *	UT_OS		Operating-system error.  See "errno".
  *	UT_EXISTS	"symbol" already maps to a different unit.
  *	UT_SUCCESS	Success.
+ *	UT_FROZEN	The unit-system is frozen.
  */
 EXTERNL ut_status
 ut_map_symbol_to_unit(
@@ -701,6 +1150,7 @@ ut_map_symbol_to_unit(
  * Returns:
  *	UT_SUCCESS	Success.
  *	UT_BAD_ARG	"system" or "symbol" is NULL.
+ *	UT_FROZEN	The unit-system is frozen.
  */
 EXTERNL ut_status
 ut_unmap_symbol_to_unit(
@@ -723,6 +1173,7 @@ ut_unmap_symbol_to_unit(
  *	UT_BAD_ARG	"unit" or "symbol" is NULL.
  *	UT_OS		Operating-system error.  See "errno".
  *	UT_EXISTS	"unit" already maps to a symbol.
+ *	UT_FROZEN	The unit-system is frozen.
  */
 EXTERNL ut_status
 ut_map_unit_to_symbol(
@@ -742,6 +1193,7 @@ ut_map_unit_to_symbol(
  * Returns:
  *	UT_SUCCESS	Success.
  *	UT_BAD_ARG	"unit" is NULL.
+ *	UT_FROZEN	The unit-system is frozen.
  */
 EXTERNL ut_status
 ut_unmap_unit_to_symbol(
@@ -773,7 +1225,10 @@ ut_is_dimensionless(
 
 
 /*
- * Indicates if two units belong to the same unit-system.
+ * Indicates if two units belong to the same unit-system.  A unit-system and
+ * the unit-systems that overlay it, directly or indirectly (see
+ * ut_new_overlay_system()), are considered the same, so overlays of a common
+ * unit-system are too.
  *
  * Arguments:
  *	unit1		Pointer to a unit.
@@ -827,6 +1282,55 @@ ut_compare(
     const ut_unit* const	unit2);
 
 
+/*
+ * Returns the canonical key of a unit.  Units that are specified differently but
+ * have the same structure (e.g., "m/s", "meter per second", and "m.s-1") have
+ * the same key.  The key is formed from the ASCII identifiers of the basic-units
+ * and the numeric parameters of the unit, so it doesn't depend on the encoding
+ * and is the same in unit-systems whose basic-units have the same identifiers.
+ * It's much cheaper to obtain than the definition of the unit from
+ * ut_format().  May be called concurrently for the units of a frozen
+ * unit-system.
+ *
+ * Arguments:
+ *	unit		Pointer to the unit.
+ *	buf		Pointer to the buffer into which to print the key.
+ *	size		Size of the buffer in bytes.
+ * Returns:
+ *	-1		Failure:  "ut_get_status()" will be
+ *			    UT_BAD_ARG		"unit" or "buf" is NULL.
+ *			    UT_CANT_FORMAT	The key couldn't be printed.
+ *	else		Success.  Number of bytes that would be printed if
+ *			"size" were sufficiently large excluding the
+ *			terminating NUL.
+ */
+EXTERNL int
+ut_canonical_key(
+    const ut_unit* const	unit,
+    char* const			buf,
+    const size_t		size);
+
+
+/*
+ * Returns the 64-bit hash-value of the canonical key of a unit (see
+ * ut_canonical_key()) without forming the key.  Units with the same key have
+ * the same hash-value in every process.  May be called concurrently for the
+ * units of a frozen unit-system.
+ *
+ * Arguments:
+ *	unit		Pointer to the unit.
+ * Returns:
+ *	0		Failure.  "ut_get_status()" will be
+ *			    UT_BAD_ARG		"unit" is NULL.
+ *			    UT_CANT_FORMAT	The unit has no key (see
+ *						ut_canonical_key()).
+ *	else		The hash-value.  Only its low-order 64 bits are used.
+ */
+EXTERNL unsigned long long
+ut_canonical_hash(
+    const ut_unit* const	unit);
+
+
 /*
  * Indicates if numeric values in one unit are convertible to numeric values in
  * another unit via "ut_get_converter()".  In making this determination,
@@ -1210,6 +1714,101 @@ ut_format(
     unsigned		opts);
 
 
+/*
+ * Formats units back to back into a single, growable buffer.  The buffer is
+ * reallocated at most once.
+ *
+ * Arguments:
+ *	units		Pointer to the units to be formatted.
+ *	count		Number of units to be formatted.
+ *	opts		Formatting options.  See ut_format().
+ *	buf		Pointer to the pointer to the buffer.  "*buf" may be
+ *			NULL if "*size" is zero; otherwise, it must have been
+ *			allocated by malloc(3) and will be reallocated if it's
+ *			too small.  The client should free(3) "*buf" when it's
+ *			no longer needed.
+ *	size		Pointer to the size of "*buf" in bytes.  Set if "*buf"
+ *			is reallocated.
+ *	offsets		Pointer to "count" offsets.  On return, the NUL-
+ *			terminated string of "units[i]" starts at
+ *			"*buf + offsets[i]" for every "i" less than the
+ *			returned value.
+ * Returns:
+ *	count		Success.
+ *	else		Failure.  The number of units that were formatted
+ *			before the failure.  "ut_get_status()" will be
+ *			    UT_BAD_ARG		"units", "buf", "size", or
+ *						"offsets" is NULL, "*buf" is
+ *						NULL but "*size" isn't zero,
+ *						or both UT_LATIN1 and UT_UTF8
+ *						are specified.
+ *			    UT_BAD_ARG		"units[i]" is NULL, where "i"
+ *						is the returned value.
+ *			    UT_CANT_FORMAT	"units[i]" can't be formatted
+ *						in the desired manner, where
+ *						"i" is the returned value.
+ *			    UT_OS		Operating-system failure.  See
+ *						"errno".
+ */
+EXTERNL size_t
+ut_format_many(
+    const ut_unit* const* const	units,
+    const size_t		count,
+    const unsigned		opts,
+    char** const		buf,
+    size_t* const		size,
+    size_t* const		offsets);
+
+
+/*
+ * Enables the caching of formatted units of a unit-system by ut_get_format().
+ * Enabling an enabled cache has no effect.  Shall be called before the
+ * unit-system is shared between threads.
+ *
+ * Arguments:
+ *	system		Pointer to the unit-system.  May be frozen.
+ * Returns:
+ *	UT_SUCCESS	Success.
+ *	UT_BAD_ARG	"system" is NULL.
+ *	UT_OS		Operating-system error.  See "errno".
+ */
+EXTERNL ut_status
+ut_enable_format_cache(
+    ut_system* const	system);
+
+
+/*
+ * Returns a unit formatted as by ut_format() without copying.  The string is
+ * formatted once and cached by the unit-system of the unit; later calls with an
+ * equal unit and the same options return the same string.  Mapping or
+ * unmapping an identifier of a unit of the unit-system makes subsequent calls
+ * format the unit anew.  May be called concurrently for the units of a frozen
+ * unit-system.
+ *
+ * Arguments:
+ *	unit		Pointer to the unit.  Its unit-system shall have been
+ *			passed to ut_enable_format_cache().
+ *	opts		Formatting options.  See ut_format().
+ * Returns:
+ *	NULL		Failure.  "ut_get_status()" will be
+ *			    UT_BAD_ARG		"unit" is NULL, the format cache
+ *						of its unit-system isn't
+ *						enabled, or both UT_LATIN1 and
+ *						UT_UTF8 are specified.
+ *			    UT_CANT_FORMAT	"unit" can't be formatted in
+ *						the desired manner.
+ *			    UT_OS		Operating-system error.  See
+ *						"errno".
+ *	else		Pointer to the formatted unit.  It belongs to the
+ *			unit-system and is valid until the unit-system is
+ *			freed.
+ */
+EXTERNL const char*
+ut_get_format(
+    const ut_unit* const	unit,
+    const unsigned		opts);
+
+
 /*
  * Accepts a visitor to a unit.
  *
@@ -1359,6 +1958,77 @@ ut_encode_time(
     const double	second);
 
 
+/*
+ * Encodes times from one array per field.  Each encoded time is the same as
+ * ut_encode_time() returns for the fields.  Sequences of times (e.g., a column
+ * of timestamps) are encoded incrementally, so this is faster than calling
+ * ut_encode_time() for each time.
+ *
+ * Arguments:
+ *	year		Pointer to the years.
+ *	month		Pointer to the months.
+ *	day		Pointer to the days.
+ *	hour		Pointer to the hours or NULL, in which case they're 0.
+ *	minute		Pointer to the minutes or NULL, in which case they're 0.
+ *	second		Pointer to the seconds or NULL, in which case they're 0.
+ *	count		Number of times.  Each non-NULL array shall have "count"
+ *			elements.
+ *	values		Pointer to the encoded times.  Shall have "count"
+ *			elements.
+ * Returns:
+ *	UT_SUCCESS	Success.
+ *	UT_BAD_ARG	"year", "month", "day", or "values" is NULL or at least
+ *			one time couldn't be encoded (see ut_encode_time()), in
+ *			which case its value is NaN.  The other times are
+ *			encoded.
+ */
+EXTERNL ut_status
+ut_encode_times(
+    const int* const	year,
+    const int* const	month,
+    const int* const	day,
+    const int* const	hour,
+    const int* const	minute,
+    const double* const	second,
+    const size_t	count,
+    double* const	values);
+
+
+/*
+ * Encodes ISO 8601 timestamps (e.g., "2024-01-15T12:30:00Z" or
+ * "20240115T123000+0100") without going through the unit-string parser.  The
+ * components are validated by ut_check_date() and ut_check_clock(), and each
+ * encoded time is the same as the origin of "seconds since <timestamp>".
+ *
+ * Syntax (leading and trailing blanks are ignored):
+ *	timestamp	:= date ["Z" | ("T" | blank+) clock [blank* zone]]
+ *	date		:= [sign] Y+ "-" M[M] "-" D[D]		extended
+ *			 | [sign] YYYYMMDD			basic
+ *	clock		:= h[h] ":" m[m] [":" s[s] [fraction]]	extended
+ *			 | hh [mm [ss [fraction]]]		basic
+ *	fraction	:= ("." | ",") digit+
+ *	zone		:= "Z" | sign hh [[":"] mm]		at most 14:00,
+ *								not -00:00
+ *
+ * Arguments:
+ *	strings		Pointer to the timestamps.
+ *	count		Number of timestamps.
+ *	values		Pointer to the encoded times.  Shall have "count"
+ *			elements.
+ * Returns:
+ *	UT_SUCCESS	Success.
+ *	UT_BAD_ARG	"strings" or "values" is NULL.
+ *	UT_SYNTAX	At least one timestamp is NULL, malformed, or has an
+ *			invalid component, in which case its value is NaN.  The
+ *			other timestamps are encoded.
+ */
+EXTERNL ut_status
+ut_encode_iso_times(
+    const char* const* const	strings,
+    const size_t		count,
+    double* const		values);
+
+
 /*
  * Validates clock-time (time-of-day) components.
  *
@@ -1447,6 +2117,190 @@ ut_decode_time(
     double	*resolution);
 
 
+/*
+ * Decodes times from double-precision values into one array per field.  Each
+ * decoded time is the same as ut_decode_time() returns for the value.  Runs of
+ * non-decreasing values (e.g., the time-axis of a dataset) are decoded
+ * incrementally, so this is much faster than calling ut_decode_time() for each
+ * value.
+ *
+ * Arguments:
+ *	values		Pointer to the values to be decoded.
+ *	count		Number of values.
+ *	year		Pointer to the years.  Shall have "count" elements.
+ *	month		Pointer to the months.  Shall have "count" elements.
+ *	day		Pointer to the days.  Shall have "count" elements.
+ *	hour		Pointer to the hours.  Shall have "count" elements.
+ *	minute		Pointer to the minutes.  Shall have "count" elements.
+ *	second		Pointer to the seconds.  Shall have "count" elements.
+ * Returns:
+ *	UT_SUCCESS	Success.
+ *	UT_BAD_ARG	A pointer argument is NULL or at least one value isn't
+ *			finite or is outside the range of years within
+ *			+/-5,000,000.  The other values are decoded.  The
+ *			fields of such a value are 0 except for the second,
+ *			which is NaN.
+ */
+EXTERNL ut_status
+ut_decode_times(
+    const double* const	values,
+    const size_t	count,
+    int* const		year,
+    int* const		month,
+    int* const		day,
+    int* const		hour,
+    int* const		minute,
+    double* const	second);
+
+
+/*
+ * Encodes a time as the number of nanoseconds since 1970-01-01 00:00:00 UTC.
+ * The encoding is exact.  Its range is from 1677-09-21 00:12:43.145224193 to
+ * 2262-04-11 23:47:16.854775807.  Leap-seconds aren't counted, so
+ * 23:59:60 is the same as 00:00:00 of the next day.  The date and clock are
+ * validated by ut_check_date() and ut_check_clock().
+ *
+ * Arguments:
+ *	year		The year.
+ *	month		The month.
+ *	day		The day (1 = the first of the month).
+ *	hour		The hour.
+ *	minute		The minute.
+ *	second		The second.
+ *	nanosecond	The nanosecond (0-999999999).
+ *	value		Pointer to the encoded time.
+ * Returns:
+ *	UT_SUCCESS	Success.
+ *	UT_BAD_ARG	"value" is NULL, a component is invalid, or the time is
+ *			outside the range.
+ */
+EXTERNL ut_status
+ut_encode_time_ns(
+    int			year,
+    int			month,
+    int			day,
+    int			hour,
+    int			minute,
+    int			second,
+    long		nanosecond,
+    long long*		value);
+
+
+/*
+ * Decodes a time in nanoseconds since 1970-01-01 00:00:00 UTC (see
+ * ut_encode_time_ns()).  The decoding is exact and uses only integer
+ * arithmetic.
+ *
+ * Arguments:
+ *	value		The time to be decoded.
+ *	year		Pointer to the year.
+ *	month		Pointer to the month.
+ *	day		Pointer to the day.
+ *	hour		Pointer to the hour.
+ *	minute		Pointer to the minute.
+ *	second		Pointer to the second.
+ *	nanosecond	Pointer to the nanosecond.
+ * Returns:
+ *	UT_SUCCESS	Success.
+ *	UT_BAD_ARG	A pointer argument is NULL or "value" is UT_NS_INVALID.
+ */
+EXTERNL ut_status
+ut_decode_time_ns(
+    long long		value,
+    int*		year,
+    int*		month,
+    int*		day,
+    int*		hour,
+    int*		minute,
+    int*		second,
+    long*		nanosecond);
+
+
+/*
+ * Converts values in a timestamp-unit (e.g., "ms since 1970-01-01") to
+ * nanoseconds since 1970-01-01 00:00:00 UTC.  Whole values are converted
+ * exactly; fractional values are rounded to the nanosecond.  The interval of
+ * the unit must be a whole number of nanoseconds.  Because the origin of a
+ * timestamp-unit is an encoded time (see ut_encode_time()), it's rounded to
+ * the microsecond.
+ *
+ * Arguments:
+ *	unit		Pointer to the timestamp-unit.
+ *	values		Pointer to the values.
+ *	count		Number of values.
+ *	ns		Pointer to the times.  Shall have "count" elements.
+ * Returns:
+ *	UT_SUCCESS	Success.
+ *	UT_BAD_ARG	A pointer argument is NULL or at least one value isn't
+ *			finite or is outside the range of times, in which case
+ *			its time is UT_NS_INVALID.  The other values are
+ *			converted.
+ *	UT_MEANINGLESS	"unit" isn't a timestamp-unit, its interval isn't a
+ *			whole number of nanoseconds, or its origin is outside
+ *			the range of times.
+ */
+EXTERNL ut_status
+ut_times_to_ns(
+    const ut_unit* const	unit,
+    const double* const		values,
+    const size_t		count,
+    long long* const		ns);
+
+
+/*
+ * Converts integral values in a timestamp-unit (e.g., the 64-bit counts of
+ * "us since 1970-01-01") to nanoseconds since 1970-01-01 00:00:00 UTC.  The
+ * conversion is exact.  See ut_times_to_ns() for the requirements on the unit.
+ *
+ * Arguments:
+ *	unit		Pointer to the timestamp-unit.
+ *	counts		Pointer to the values.
+ *	count		Number of values.
+ *	ns		Pointer to the times.  Shall have "count" elements.
+ * Returns:
+ *	UT_SUCCESS	Success.
+ *	UT_BAD_ARG	A pointer argument is NULL or at least one value is
+ *			UT_NS_INVALID or is outside the range of times, in which
+ *			case its time is UT_NS_INVALID.  The other values are
+ *			converted.
+ *	UT_MEANINGLESS	See ut_times_to_ns().
+ */
+EXTERNL ut_status
+ut_counts_to_ns(
+    const ut_unit* const	unit,
+    const long long* const	counts,
+    const size_t		count,
+    long long* const		ns);
+
+
+/*
+ * Converts nanoseconds since 1970-01-01 00:00:00 UTC to integral values in a
+ * timestamp-unit.  Each value is the number of whole intervals of the unit
+ * from its origin to the time, rounded toward negative infinity, so the
+ * conversion is exact for times that are a whole number of intervals from the
+ * origin.  See ut_times_to_ns() for the requirements on the unit.
+ *
+ * Arguments:
+ *	unit		Pointer to the timestamp-unit.
+ *	ns		Pointer to the times.
+ *	count		Number of times.
+ *	counts		Pointer to the values.  Shall have "count" elements.
+ * Returns:
+ *	UT_SUCCESS	Success.
+ *	UT_BAD_ARG	A pointer argument is NULL or at least one time is
+ *			UT_NS_INVALID or its value is out of range, in which
+ *			case its value is UT_NS_INVALID.  The other times are
+ *			converted.
+ *	UT_MEANINGLESS	See ut_times_to_ns().
+ */
+EXTERNL ut_status
+ut_ns_to_counts(
+    const ut_unit* const	unit,
+    const long long* const	ns,
+    const size_t		count,
+    long long* const		counts);
+
+
 /******************************************************************************
  * Error Handling:
  ******************************************************************************/
@@ -1473,7 +2327,9 @@ ut_set_status(
 
 
 /*
- * Handles an error-message.
+ * Handles an error-message by passing the format and its arguments, unformatted,
+ * to the installed handler.  Does nothing if the handler is ut_ignore() or the
+ * library was built without error-messages.
  *
  * Arguments:
  *	fmt	The format for the error-message.
@@ -1481,7 +2337,7 @@ ut_set_status(
  * Returns:
  *	<0	An output error was encountered.
  *	else	The number of bytes of "fmt" and "arg" written excluding any
- *		terminating NUL.
+ *		terminating NUL.  0 if the message was discarded.
  */
 EXTERNL int
 ut_handle_error_message(
@@ -1490,8 +2346,11 @@ ut_handle_error_message(
 
 
 /*
- * Returns the previously-installed error-message handler and optionally
- * installs a new handler.  The initial handler is "ut_write_to_stderr()".
+ * Returns the previously-installed error-message handler of the process and
+ * optionally installs a new one.  The initial handler is "ut_write_to_stderr()".
+ * Threads that have their own handler (see
+ * ut_set_thread_error_message_handler()) aren't affected.  Should be called
+ * before other threads are started.
  *
  * Arguments:
  *      handler		NULL or pointer to the error-message handler.  If NULL,
@@ -1505,6 +2364,24 @@ ut_set_error_message_handler(
     ut_error_message_handler	handler);
 
 
+/*
+ * Sets or removes the calling thread's own error-message handler, which
+ * overrides the handler of the process (see ut_set_error_message_handler())
+ * for the calling thread only.
+ *
+ * Arguments:
+ *      handler		Pointer to the error-message handler of the calling
+ *			thread or NULL to have the thread use the handler of the
+ *			process again.
+ * Returns:
+ *	NULL		The calling thread didn't have its own handler.
+ *	else		Pointer to the previous handler of the calling thread.
+ */
+EXTERNL ut_error_message_handler
+ut_set_thread_error_message_handler(
+    ut_error_message_handler	handler);
+
+
 /*
  * Writes an error-message to the standard-error stream when received and
  * appends a newline.  This is the initial error-message handler.
@@ -1524,7 +2401,8 @@ ut_write_to_stderr(
 
 
 /*
- * Does nothing with an error-message.
+ * Does nothing with an error-message.  While it's the handler of a thread, the
+ * library doesn't compose error-messages for the thread at all.
  *
  * Arguments:
  *	fmt	The format for the error-message.
@@ -1538,6 +2416,106 @@ ut_ignore(
     va_list		args);
 
 
+/******************************************************************************
+ * Contexts:
+ ******************************************************************************/
+
+/*
+ * Returns a new context.  A function called through a context (e.g.,
+ * ut_parse_r()) uses the error-message handler of the context, saves its
+ * status in the context, and leaves the status and handler of the calling
+ * thread unchanged.  A context may be used by one thread at a time.
+ *
+ * Returns:
+ *	NULL	Failure.  "ut_get_status()" will be
+ *		    UT_OS	Operating-system error.  See "errno".
+ *	else	Pointer to the new context.  Its status is UT_SUCCESS and it
+ *		uses the handler of the calling thread, whose status is
+ *		unchanged.  The client should call ut_free_context() when it's
+ *		no longer needed.
+ */
+EXTERNL ut_context*
+ut_new_context(void);
+
+
+/*
+ * Frees a context.  Units, unit-systems, and converters that were obtained
+ * through the context are unaffected.
+ *
+ * Arguments:
+ *	context		Pointer to the context or NULL.
+ */
+EXTERNL void
+ut_free_context(
+    ut_context* const	context);
+
+
+/*
+ * Returns the status of the last call through a context.
+ *
+ * Arguments:
+ *	context		Pointer to the context.
+ * Returns:
+ *	UT_BAD_ARG	"context" is NULL.
+ *	else		The status of the last call through "context".
+ */
+EXTERNL ut_status
+ut_get_context_status(
+    const ut_context* const	context);
+
+
+/*
+ * Returns the previous error-message handler of a context and sets a new one.
+ *
+ * Arguments:
+ *	context		Pointer to the context.
+ *	handler		Pointer to the error-message handler for calls through
+ *			"context" or NULL to have them use the handler of the
+ *			calling thread.
+ * Returns:
+ *	NULL		The context used the handler of the calling thread or
+ *			"context" is NULL.
+ *	else		Pointer to the previous handler of the context.
+ */
+EXTERNL ut_error_message_handler
+ut_set_context_error_message_handler(
+    ut_context* const			context,
+    const ut_error_message_handler	handler);
+
+
+/*
+ * Variants of ut_read_xml(), ut_parse(), ut_format(), and ut_get_converter()
+ * that are called through a context.  They return what the original functions
+ * return.  Their status is obtained via ut_get_context_status().  If "context"
+ * is NULL, then they fail and "ut_get_status()" will be UT_BAD_ARG.
+ */
+EXTERNL ut_system*
+ut_read_xml_r(
+    ut_context* const	context,
+    const char* const	path);
+
+EXTERNL ut_unit*
+ut_parse_r(
+    ut_context* const		context,
+    const ut_system* const	system,
+    const char* const		string,
+    const ut_encoding		encoding);
+
+EXTERNL int
+ut_format_r(
+    ut_context* const		context,
+    const ut_unit* const	unit,
+    char*			buf,
+    size_t			size,
+    unsigned			opts);
+
+EXTERNL cv_converter*
+ut_get_converter_r(
+    ut_context* const	context,
+    ut_unit* const	from,
+    ut_unit* const	to);
+
+
 #ifdef __cplusplus
 }
 #endif
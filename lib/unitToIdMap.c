@@ -14,31 +14,38 @@
 #include "config.h"
 
 #include "udunits2.h"
-#include "unitAndId.h"
+#include "formatCache.h"
+#include "hashTable.h"
 #include "unitToIdMap.h"		/* this module's API */
-#include "systemMap.h"
+#include "unitcore.h"
 
 #include <assert.h>
 #include <errno.h>
-
-#ifdef _MSC_VER
-#include "tsearch.h"
-#else
-#include <search.h>
-#endif
-
 #include <stdlib.h>
 
 #include <string.h>
 
+#define ENCODING_COUNT	3		/* UT_ASCII, UT_LATIN1, UT_UTF8 */
+
+/*
+ * The identifiers of a unit.  "ids" holds the identifiers as they were mapped;
+ * "resolved" holds what a lookup in each encoding returns.  Both are indexed
+ * by encoding.
+ */
 typedef struct {
-    void*		ascii;
-    void*		latin1;
-    void*		utf8;
-} UnitToIdMap;
+    ut_unit*		unit;
+    char*		ids[ENCODING_COUNT];
+    char*		latin1AsUtf8;	/* UTF-8 form of ids[UT_LATIN1] */
+    const char*		resolved[ENCODING_COUNT];
+} UnitIds;
 
-static SystemMap*	systemToUnitToName = NULL;
-static SystemMap*	systemToUnitToSymbol = NULL;
+/*
+ * A unit-to-identifier map has one entry per unit, keyed on the unit's
+ * hash-value, so a lookup in any encoding is a single read-only probe.
+ */
+typedef struct {
+    HashTable*		table;
+} UnitToIdMap;
 
 
 /******************************************************************************
@@ -76,7 +83,7 @@ latin1ToUtf8(
 		*outp = *inp;
 	    }
 	    else {
-		*outp++ = (char)(0xC0U | ((unsigned)*inp >> 6));
+		*outp++ = (char)(0xC0U | ((unsigned char)*inp >> 6));
 		*outp = (char)(0x80U | (*inp & 0x3FU));
 	    }
 	}
@@ -165,37 +172,70 @@ adjustEncoding(
  * Internal Map Functions:
  ******************************************************************************/
 
+/*
+ * Returns the identifier that a lookup in a given encoding should return for
+ * an entry.  A Latin-1 lookup falls back to the ASCII identifier; a UTF-8
+ * lookup falls back to the UTF-8 form of the Latin-1 identifier and then to
+ * the ASCII identifier.
+ */
+static const char*
+resolveId(
+    const UnitIds* const	entry,
+    const ut_encoding		encoding)
+{
+    char* const*		ids = entry->ids;
+
+    return
+	encoding == UT_ASCII
+	    ? ids[UT_ASCII]
+	    : encoding == UT_LATIN1
+		? (ids[UT_LATIN1] != NULL ? ids[UT_LATIN1] : ids[UT_ASCII])
+		: ids[UT_UTF8] != NULL
+		    ? ids[UT_UTF8]
+		    : entry->latin1AsUtf8 != NULL
+			? entry->latin1AsUtf8
+			: ids[UT_ASCII];
+}
+
+
+/*
+ * Recomputes the identifiers that lookups return for an entry.  Must be called
+ * whenever the entry's mapped identifiers change.
+ */
+static void
+resolveIds(
+    UnitIds* const	entry)
+{
+    int		encoding;
+
+    for (encoding = 0; encoding < ENCODING_COUNT; encoding++)
+	entry->resolved[encoding] = resolveId(entry, (ut_encoding)encoding);
+}
+
+
 static int
 compareUnits(
     const void* const	entry1,
     const void* const	entry2)
 {
-    return ut_compare(((const UnitAndId*)entry1)->unit,
-	((const UnitAndId*)entry2)->unit);
+    return ut_compare(((const UnitIds*)entry1)->unit,
+	((const UnitIds*)entry2)->unit);
 }
 
 
-/*
- * Selects a unit-and-identifier tree corresponding to a given encoding.
- *
- * Arguments:
- *	map		The unit-to-id map.
- *	encoding	The encoding.
- * Returns:
- *	Pointer to the root of the unit-and-identifier tree in "map" that
- *	corresponds to "encoding".
- */
-static void**
-selectTree(
-    UnitToIdMap* const	unitToIdMap,
-    const ut_encoding	encoding)
+static void
+freeEntry(
+    void* const	entry)
 {
-    return
-	encoding == UT_ASCII
-	    ? &unitToIdMap->ascii
-	    : encoding == UT_LATIN1
-		? &unitToIdMap->latin1
-		: &unitToIdMap->utf8;
+    UnitIds* const	unitIds = (UnitIds*)entry;
+    int			encoding;
+
+    for (encoding = 0; encoding < ENCODING_COUNT; encoding++)
+	free(unitIds->ids[encoding]);
+
+    free(unitIds->latin1AsUtf8);
+    ut_free(unitIds->unit);
+    free(unitIds);
 }
 
 
@@ -209,12 +249,15 @@ selectTree(
 static UnitToIdMap*
 utimNew(void)
 {
-    UnitToIdMap* const	map = malloc(sizeof(UnitToIdMap));
+    UnitToIdMap*	map = malloc(sizeof(UnitToIdMap));
 
     if (map != NULL) {
-	map->ascii = NULL;
-	map->latin1 = NULL;
-	map->utf8 = NULL;
+	map->table = htNew();
+
+	if (map->table == NULL) {
+	    free(map);
+	    map = NULL;
+	}
     }
 
     return map;
@@ -232,27 +275,91 @@ utimFree(
     UnitToIdMap*	map)
 {
     if (map != NULL) {
-	ut_encoding	encodings[] = {UT_ASCII, UT_LATIN1, UT_UTF8};
-	int		i;
+	htFree(map->table, freeEntry);
+	free(map);
+    }
+}
+
+
+/*
+ * Returns the entry of a unit-to-identifier map that corresponds to a unit.
+ *
+ * Arguments:
+ *	map	The unit-to-identifier map.
+ *	unit	The unit to be used as the key in the search.
+ * Returns:
+ *	NULL	The map doesn't contain an entry corresponding to "unit".
+ *	else	Pointer to the entry corresponding to "unit".
+ */
+static UnitIds*
+utimFind(
+    const UnitToIdMap* const	map,
+    const ut_unit* const	unit)
+{
+    UnitIds	targetEntry;
+    UnitIds**	tableEntry;
 
-	for (i = 0; i < sizeof(encodings)/sizeof(encodings[0]); ++i) {
-	    void**	rootp = selectTree(map, encodings[i]);
+    targetEntry.unit = (ut_unit*)unit;
+    tableEntry = (UnitIds**)htFind(map->table, coreHash(unit), &targetEntry,
+	compareUnits);
 
-	    while (*rootp != NULL) {
-		UnitAndId*	uai = **(UnitAndId***)rootp;
+    return tableEntry == NULL ? NULL : *tableEntry;
+}
 
-		(void)tdelete(uai, rootp, compareUnits);
-		uaiFree(uai);
-	    }
+
+/*
+ * Returns the entry of a unit-to-identifier map that corresponds to a unit,
+ * creating an empty entry if necessary.
+ *
+ * Arguments:
+ *	map	The unit-to-identifier map.
+ *	unit	The unit.  May be freed upon return.
+ * Returns:
+ *	NULL	Failure.  "ut_get_status()" will be
+ *		    UT_OS	Operating-system error.  See "errno".
+ *	else	Pointer to the entry corresponding to "unit".
+ */
+static UnitIds*
+utimFindOrAdd(
+    UnitToIdMap* const		map,
+    const ut_unit* const	unit)
+{
+    UnitIds*	entry = utimFind(map, unit);
+
+    if (entry == NULL) {
+	entry = calloc(1, sizeof(UnitIds));
+
+	if (entry == NULL) {
+	    ut_set_status(UT_OS);
+	    ut_handle_error_message(strerror(errno));
+	    ut_handle_error_message("Couldn't allocate unit-to-identifier entry");
 	}
+	else {
+	    entry->unit = ut_clone(unit);
 
-	free(map);
+	    if (entry->unit == NULL) {
+		free(entry);
+		entry = NULL;
+	    }
+	    else if (htSearch(map->table, coreHash(unit), entry,
+		    compareUnits) == NULL) {
+		ut_set_status(UT_OS);
+		ut_handle_error_message(strerror(errno));
+		ut_handle_error_message("Couldn't add hash-table entry");
+		freeEntry(entry);
+		entry = NULL;
+	    }
+	}
     }
+
+    return entry;
 }
 
 
 /*
- * Adds an entry to a unit-to-identifier map.
+ * Adds an identifier to a unit-to-identifier map.  Every form of the
+ * identifier that a lookup might need is computed here so that lookups never
+ * modify the map.
  *
  * Arguments:
  *	map		Pointer to unit-to-identifier map.
@@ -284,39 +391,66 @@ utimAdd(
 	ut_handle_error_message("Identifier not in given encoding");
     }
     else {
-	UnitAndId*	targetEntry = uaiNew(unit, id);
+	UnitIds* const	entry = utimFindOrAdd(map, unit);
 
-	if (targetEntry == NULL) {
-            status = ut_get_status();
-        }
-        else {
-	    void**	rootp = selectTree(map, encoding);
+	if (encoding != UT_ASCII && encoding != UT_LATIN1)
+	    encoding = UT_UTF8;
 
-	    UnitAndId**	treeEntry = tsearch(targetEntry, rootp, compareUnits);
+	if (entry == NULL) {
+	    status = ut_get_status();
+	}
+	else if (entry->ids[encoding] != NULL) {
+	    if (strcmp(entry->ids[encoding], id) == 0) {
+		status = UT_SUCCESS;
+	    }
+	    else {
+		status = UT_EXISTS;
+		ut_set_status(status);
+		ut_handle_error_message("Unit already maps to \"%s\"",
+		    entry->ids[encoding]);
+	    }
+	}
+	else {
+	    char* const	copy = strdup(id);
+	    char*	utf8 = NULL;
 
-	    if (treeEntry == NULL) {
+	    if (copy != NULL && encoding == UT_LATIN1)
+		utf8 = latin1ToUtf8(id);
+
+	    if (copy == NULL || (encoding == UT_LATIN1 && utf8 == NULL)) {
 		status = UT_OS;
-                ut_set_status(status);
+		ut_set_status(status);
 		ut_handle_error_message(strerror(errno));
-		ut_handle_error_message("Couldn't add search-tree entry");
-		uaiFree(targetEntry);
+		ut_handle_error_message("Couldn't copy identifier");
+		free(copy);
+
+		/*
+		 * Don't leave an entry that utimFindOrAdd() just created
+		 * without any identifier:  lookups would find the unit but no
+		 * identifier rather than no entry.
+		 */
+		if (entry->ids[UT_ASCII] == NULL &&
+			entry->ids[UT_LATIN1] == NULL &&
+			entry->ids[UT_UTF8] == NULL) {
+		    (void)htRemove(map->table, coreHash(unit), entry,
+			compareUnits);
+		    freeEntry(entry);
+		}
 	    }
 	    else {
-		if (strcmp((*treeEntry)->id, id) != 0) {
-		    status = UT_EXISTS;
-                    ut_set_status(status);
-		    ut_handle_error_message("Unit already maps to \"%s\"",
-			(*treeEntry)->id);
-		}
-		else {
-		    status = UT_SUCCESS;
+		entry->ids[encoding] = copy;
+
+		if (utf8 != NULL) {
+		    free(entry->latin1AsUtf8);
+		    entry->latin1AsUtf8 = utf8;
 		}
 
-                if (targetEntry != *treeEntry)
-                    uaiFree(targetEntry);
+		resolveIds(entry);
+		fcInvalidate(unit);
+		status = UT_SUCCESS;
 	    }
-	}				/* "targetEntry" allocated */
-    }					/* valid arguments */
+	}
+    }
 
     return status;
 }
@@ -338,148 +472,38 @@ utimRemove(
     const ut_unit*	unit,
     ut_encoding		encoding)
 {
-    UnitAndId		targetEntry;
-    UnitAndId**		treeEntry;
+    UnitIds*		entry;
 
     assert(map != NULL);
     assert(unit != NULL);
 
-    targetEntry.unit = (ut_unit*)unit;
-    treeEntry = tfind(&targetEntry, selectTree(map, encoding), compareUnits);
-
-    if (treeEntry != NULL && *treeEntry != NULL) {
-	UnitAndId*	uai = *treeEntry;
-
-	(void)tdelete(uai, selectTree(map, encoding), compareUnits);
-	uaiFree(uai);
-    }
-
-    return UT_SUCCESS;
-}
-
-
-/*
- * Returns the unit-and-identifier whose ASCII identifier corresponding to a
- * unit.
- *
- * Arguments:
- *	map	The unit-to-identifier map.
- *	unit	The unit to be used as the key in the search.
- * Returns:
- *	NULL	The map doesn't contain an entry corresponding to "unit" whose
- *		identifier is in ASCII.
- *	else	Pointer to the entry corresponding to "unit" whose identifier is
- *		in ASCII.
- */
-static UnitAndId*
-utimFindAsciiByUnit(
-    UnitToIdMap* const	map,
-    const ut_unit* const	unit)
-{
-    UnitAndId	targetEntry;
-    UnitAndId**	treeEntry;
-
-    targetEntry.unit = (ut_unit*)unit;
-    treeEntry = tfind(&targetEntry, &map->ascii, compareUnits);
-
-    return treeEntry == NULL ? NULL : *treeEntry;
-}
-
-
-/*
- * Finds a unit-search-entry with a Latin-1 identifier correcponding to a unit.
- *
- * Arguments:
- *	map	The unit-to-identifier map.
- *	unit	The unit to be used as the key in the search.
- * Returns:
- *	NULL	The map doesn't contain an entry corresponding to "unit" whose
- *		identifier is in Latin-1.
- *	else	Pointer to the entry corresponding to "unit" whose identifier is
- *		in Latin-1 (and might, actually, be in ASCII).
- */
-static UnitAndId*
-utimFindLatin1ByUnit(
-    UnitToIdMap* const	map,
-    const ut_unit* const	unit)
-{
-    UnitAndId	targetEntry;
-    UnitAndId**	treeEntry;
-
-    targetEntry.unit = (ut_unit*)unit;
-    treeEntry = tfind(&targetEntry, &map->latin1, compareUnits);
+    entry = utimFind(map, unit);
 
-    if (treeEntry == NULL)
-	treeEntry = tfind(&targetEntry, &map->ascii, compareUnits);
-
-    return treeEntry == NULL ? NULL : *treeEntry;
-}
+    if (encoding != UT_ASCII && encoding != UT_LATIN1)
+	encoding = UT_UTF8;
 
+    if (entry != NULL) {
+	free(entry->ids[encoding]);
+	entry->ids[encoding] = NULL;
 
-/*
- * Finds an entry with a UTF-8 identifier corresponding to a unit.
- *
- * Arguments:
- *	map	The unit-to-identifier map.
- *	unit	The unit to be used as the key in the search.
- * Returns:
- *	NULL	The map doesn't contain an entry corresponding to "unit" whose
- *		identifier is in UTF-8.
- *	else	Pointer to the entry corresponding to "unit" whose identifier is
- *		in UTF-8 (and might, actually, be in ASCII).
- */
-static UnitAndId*
-utimFindUtf8ByUnit(
-    UnitToIdMap* const	        map,
-    const ut_unit* const	unit)
-{
-    UnitAndId	targetEntry;
-    UnitAndId**	treeEntry = NULL;	/* failure */
-
-    targetEntry.unit = (ut_unit*)unit;
-    treeEntry = tfind(&targetEntry, &map->utf8, compareUnits);
-
-    if (treeEntry == NULL) {
-	treeEntry = tfind(&targetEntry, &map->latin1, compareUnits);
+	if (encoding == UT_LATIN1) {
+	    free(entry->latin1AsUtf8);
+	    entry->latin1AsUtf8 = NULL;
+	}
 
-	if (treeEntry == NULL) {
-	    treeEntry = tfind(&targetEntry, &map->ascii, compareUnits);
+	if (entry->ids[UT_ASCII] == NULL && entry->ids[UT_LATIN1] == NULL &&
+		entry->ids[UT_UTF8] == NULL) {
+	    (void)htRemove(map->table, coreHash(unit), entry, compareUnits);
+	    freeEntry(entry);
 	}
 	else {
-	    /*
-	     * Create the UTF-8 version of the Latin-1 identifier and add it to
-	     * the UTF-8 unit-to-id map so that it will be found next time.
-	     */
-	    char* const	id = latin1ToUtf8((*treeEntry)->id);
-
-	    if (id == NULL) {
-		ut_set_status(UT_OS);
-		ut_handle_error_message(strerror(errno));
-		ut_handle_error_message(
-		    "Couldn't convert identifier from ISO-8859-1 to UTF-8");
-		treeEntry = NULL;
-	    }
-	    else {
-		UnitAndId*	newEntry = uaiNew(unit, id);
-
-		if (newEntry != NULL) {
-		    treeEntry = tsearch(newEntry, &map->utf8, compareUnits);
-
-		    if (treeEntry == NULL) {
-			uaiFree(newEntry);
-			ut_set_status(UT_OS);
-			ut_handle_error_message(strerror(errno));
-			ut_handle_error_message(
-                            "Couldn't add unit-and-identifier to search-tree");
-		    }
-		}
+	    resolveIds(entry);
+	}
 
-		free(id);
-	    }				/* UTF-8 identifier created */
-	}				/* found Latin-1 identifier */
-    }					/* no UTF-8 identifier */
+	fcInvalidate(unit);
+    }
 
-    return treeEntry == NULL ? NULL : *treeEntry;
+    return UT_SUCCESS;
 }
 
 
@@ -487,8 +511,7 @@ utimFindUtf8ByUnit(
  * Adds an entry to the unit-to-identifier map associated with a unit-system.
  *
  * Arguments:
- *	sytemMap	Address of the pointer to the
- *			system-to-unit-to-identifier map.
+ *	mapId		Identifier of the unit-system's unit-to-identifier map.
  *	unit		The unit.  May be freed upon return.
  *	id		The identifier.  May be freed upon return.
  *	encoding	The ostensible encoding of "id".
@@ -498,48 +521,37 @@ utimFindUtf8ByUnit(
  *	UT_OS		Operating-system error.  See "errno".
  *	UT_EXISTS	"unit" already maps to a different identifier.
  *	UT_SUCCESS	Success.
+ *	UT_FROZEN	The unit-system is frozen.
  */
 static ut_status
 mapUnitToId(
-    SystemMap** const		systemMap,
+    const SystemMapId		mapId,
     const ut_unit* const	unit,
     const char* const		id,
     ut_encoding			encoding)
 {
     ut_status		status;
 
-    assert(systemMap != NULL);
-
     if (unit == NULL || id == NULL) {
 	status = UT_BAD_ARG;
     }
+    else if (coreIsFrozen(ut_get_system(unit))) {
+	status = UT_FROZEN;
+	ut_handle_error_message("Unit-system is frozen");
+    }
     else {
-	if (*systemMap == NULL) {
-	    *systemMap = smNew();
-
-	    if (*systemMap == NULL)
-		status = UT_OS;
-	}
+	UnitToIdMap** const	unitToIdMap =
+	    (UnitToIdMap**)coreGetSystemMap(ut_get_system(unit), mapId);
 
-	if (*systemMap != NULL) {
-	    UnitToIdMap** const	unitToIdMap =
-		(UnitToIdMap**)smSearch(*systemMap, ut_get_system(unit));
+	if (*unitToIdMap == NULL) {
+	    *unitToIdMap = utimNew();
 
-	    if (unitToIdMap == NULL) {
+	    if (*unitToIdMap == NULL)
 		status = UT_OS;
-	    }
-	    else {
-		if (*unitToIdMap == NULL) {
-		    *unitToIdMap = utimNew();
-
-		    if (*unitToIdMap == NULL)
-			status = UT_OS;
-		}
-
-		if (*unitToIdMap != NULL)
-		    status = utimAdd(*unitToIdMap, unit, id, encoding);
-	    }
 	}
+
+	if (*unitToIdMap != NULL)
+	    status = utimAdd(*unitToIdMap, unit, id, encoding);
     }
 
     return status;
@@ -551,33 +563,37 @@ mapUnitToId(
  * unit-system.
  *
  * Arguments:
- *	sytemMap	Pointer to the system-to-unit-to-identifier map.
+ *	mapId		Identifier of the unit-system's unit-to-identifier map.
  *	unit		The unit.  May be freed upon return.
  *	encoding	The ostensible encoding of "id".
  * Returns:
- *	UT_BAD_ARG	"systemMap" is NULL.
  *	UT_BAD_ARG	"unit" is NULL.
  *	UT_SUCCESS	Success.
+ *	UT_FROZEN	The unit-system is frozen.
  */
 static ut_status
 unmapUnitToId(
-    SystemMap* const		systemMap,
+    const SystemMapId		mapId,
     const ut_unit* const	unit,
     ut_encoding			encoding)
 {
     ut_status		status;
 
-    if (systemMap == NULL || unit == NULL) {
+    if (unit == NULL) {
 	status = UT_BAD_ARG;
     }
+    else if (coreIsFrozen(ut_get_system(unit))) {
+	status = UT_FROZEN;
+	ut_handle_error_message("Unit-system is frozen");
+    }
     else {
-	UnitToIdMap** const	unitToIdMap =
-	    (UnitToIdMap**)smFind(systemMap, ut_get_system(unit));
+	UnitToIdMap* const	unitToIdMap =
+	    *(UnitToIdMap**)coreGetSystemMap(ut_get_system(unit), mapId);
 
 	status =
-	    (unitToIdMap == NULL || *unitToIdMap == NULL)
+	    unitToIdMap == NULL
 		? UT_SUCCESS
-		: utimRemove(*unitToIdMap, unit, encoding);
+		: utimRemove(unitToIdMap, unit, encoding);
     }
 
     return status;
@@ -589,7 +605,7 @@ unmapUnitToId(
  * a unit-system maps.
  *
  * Arguments:
- *	systemMap	Pointer to the system-to-unit-to-id map.
+ *	mapId		Identifier of the unit-system's unit-to-identifier map.
  *	unit		Pointer to the unit whose identifier should be returned.
  *	encoding	The desired encoding of the identifier.
  * Returns:
@@ -600,9 +616,9 @@ unmapUnitToId(
  */
 static const char*
 getId(
-    SystemMap* const	systemMap,
+    const SystemMapId		mapId,
     const ut_unit* const	unit,
-    const ut_encoding	encoding)
+    const ut_encoding		encoding)
 {
     const char*	id = NULL;		/* failure */
 
@@ -611,19 +627,25 @@ getId(
 	ut_handle_error_message("NULL unit argument");
     }
     else {
-	UnitToIdMap** const	unitToId =
-	    (UnitToIdMap**)smFind(systemMap, ut_get_system(unit));
-
-	if (unitToId != NULL) {
-	    UnitAndId*	mapEntry =
-		encoding == UT_LATIN1
-		    ? utimFindLatin1ByUnit(*unitToId, unit)
-		    : encoding == UT_UTF8
-			? utimFindUtf8ByUnit(*unitToId, unit)
-			: utimFindAsciiByUnit(*unitToId, unit);
-
-	    if (mapEntry != NULL)
-		id = mapEntry->id;
+	const ut_system*	system;
+
+	/*
+	 * An overlay's own mappings hide those of the unit-system it overlays.
+	 */
+	for (system = ut_get_system(unit); id == NULL && system != NULL;
+		system = coreGetBaseSystem(system)) {
+	    UnitToIdMap* const	unitToId =
+		*(UnitToIdMap**)coreGetSystemMap(system, mapId);
+
+	    if (unitToId != NULL) {
+		const UnitIds* const	mapEntry = utimFind(unitToId, unit);
+
+		if (mapEntry != NULL)
+		    id = mapEntry->resolved[
+			encoding == UT_LATIN1 || encoding == UT_UTF8
+			    ? encoding
+			    : UT_ASCII];
+	    }
 	}
     }
 
@@ -651,6 +673,7 @@ getId(
  *                      specified encoding.
  *	UT_OS		Operating-system error.  See "errno".
  *	UT_EXISTS	"unit" already maps to a name.
+ *	UT_FROZEN	The unit-system is frozen.
  */
 ut_status
 ut_map_unit_to_name(
@@ -658,7 +681,7 @@ ut_map_unit_to_name(
     const char* const		name,
     ut_encoding			encoding)
 {
-    ut_set_status(mapUnitToId(&systemToUnitToName, unit, name, encoding));
+    ut_set_status(mapUnitToId(SYSTEM_UNIT_TO_NAME, unit, name, encoding));
 
     return ut_get_status();
 }
@@ -674,13 +697,14 @@ ut_map_unit_to_name(
  * Returns:
  *	UT_BAD_ARG	"unit" is NULL.
  *	UT_SUCCESS	Success.
+ *	UT_FROZEN	The unit-system is frozen.
  */
 ut_status
 ut_unmap_unit_to_name(
     const ut_unit* const	unit,
     ut_encoding			encoding)
 {
-    ut_set_status(unmapUnitToId(systemToUnitToName, unit, encoding));
+    ut_set_status(unmapUnitToId(SYSTEM_UNIT_TO_NAME, unit, encoding));
 
     return ut_get_status();
 }
@@ -700,6 +724,7 @@ ut_unmap_unit_to_name(
  *	UT_BAD_ARG	"unit" or "symbol" is NULL.
  *	UT_OS		Operating-system error.  See "errno".
  *	UT_EXISTS	"unit" already maps to a symbol.
+ *	UT_FROZEN	The unit-system is frozen.
  */
 ut_status
 ut_map_unit_to_symbol(
@@ -707,7 +732,7 @@ ut_map_unit_to_symbol(
     const char* const		symbol,
     ut_encoding			encoding)
 {
-    ut_set_status(mapUnitToId(&systemToUnitToSymbol, unit, symbol, encoding));
+    ut_set_status(mapUnitToId(SYSTEM_UNIT_TO_SYMBOL, unit, symbol, encoding));
 
     return ut_get_status();
 }
@@ -724,13 +749,14 @@ ut_map_unit_to_symbol(
  * Returns:
  *	UT_SUCCESS	Success.
  *	UT_BAD_ARG	"unit" is NULL.
+ *	UT_FROZEN	The unit-system is frozen.
  */
 ut_status
 ut_unmap_unit_to_symbol(
     const ut_unit* const	unit,
     ut_encoding			encoding)
 {
-    ut_set_status(unmapUnitToId(systemToUnitToSymbol, unit, encoding));
+    ut_set_status(unmapUnitToId(SYSTEM_UNIT_TO_SYMBOL, unit, encoding));
 
     return ut_get_status();
 }
@@ -757,7 +783,7 @@ ut_get_name(
 {
     ut_set_status(UT_SUCCESS);
 
-    return getId(systemToUnitToName, unit, encoding);
+    return getId(SYSTEM_UNIT_TO_NAME, unit, encoding);
 }
 
 
@@ -782,7 +808,71 @@ ut_get_symbol(
 {
     ut_set_status(UT_SUCCESS);
 
-    return getId(systemToUnitToSymbol, unit, encoding);
+    return getId(SYSTEM_UNIT_TO_SYMBOL, unit, encoding);
+}
+
+
+typedef struct {
+    int		(*action)(const ut_unit*, ut_encoding, const char*, void*);
+    void*	arg;
+} WalkArg;
+
+
+static int
+walkEntry(
+    void* const	entry,
+    void* const	arg)
+{
+    const UnitIds* const	unitIds = (const UnitIds*)entry;
+    const WalkArg* const	walkArg = (const WalkArg*)arg;
+    int				status = 0;
+    int				encoding;
+
+    for (encoding = 0; encoding < ENCODING_COUNT && status == 0; encoding++)
+	if (unitIds->ids[encoding] != NULL)
+	    status = walkArg->action(unitIds->unit, (ut_encoding)encoding,
+		unitIds->ids[encoding], walkArg->arg);
+
+    return status;
+}
+
+
+/*
+ * Calls a function on every mapping of a unit-to-identifier map of a
+ * unit-system in unspecified order.  Only the identifiers as they were mapped
+ * are visited -- not the ones derived from them for other encodings.
+ *
+ * Arguments:
+ *	system		Pointer to the unit-system.
+ *	mapId		SYSTEM_UNIT_TO_NAME or SYSTEM_UNIT_TO_SYMBOL.
+ *	action		Pointer to the function to call with a unit, an
+ *			encoding, the identifier to which the unit maps in that
+ *			encoding, and "arg".  It must not modify the map.
+ *			Iteration stops at the first non-zero return-value.
+ *	arg		Argument passed to "action".
+ * Returns:
+ *	0		"action" returned 0 for every mapping.
+ *	else		The first non-zero value returned by "action".
+ */
+int
+utimWalk(
+    const ut_system* const	system,
+    const SystemMapId		mapId,
+    int				(*action)(const ut_unit* unit,
+					  ut_encoding encoding,
+					  const char* id, void* arg),
+    void* const			arg)
+{
+    UnitToIdMap* const	unitToId =
+	*(UnitToIdMap**)coreGetSystemMap(system, mapId);
+    WalkArg		walkArg;
+
+    assert(mapId == SYSTEM_UNIT_TO_NAME || mapId == SYSTEM_UNIT_TO_SYMBOL);
+
+    walkArg.action = action;
+    walkArg.arg = arg;
+
+    return unitToId == NULL ? 0 : htWalk(unitToId->table, walkEntry, &walkArg);
 }
 
 
@@ -798,22 +888,70 @@ utimFreeSystem(
     ut_system*	system)
 {
     if (system != NULL) {
-	SystemMap*	systemMaps[2];
-	int		i;
-
-	systemMaps[0] = systemToUnitToName;
-	systemMaps[1] = systemToUnitToSymbol;
+	const SystemMapId	mapIds[] = {SYSTEM_UNIT_TO_NAME,
+				    SYSTEM_UNIT_TO_SYMBOL};
+	int			i;
 
 	for (i = 0; i < 2; i++) {
-	    if (systemMaps[i] != NULL) {
-		UnitToIdMap** const	unitToId =
-		    (UnitToIdMap**)smFind(systemMaps[i], system);
+	    UnitToIdMap** const	unitToId =
+		(UnitToIdMap**)coreGetSystemMap(system, mapIds[i]);
 
-		if (unitToId != NULL)
-		    utimFree(*unitToId);
+	    utimFree(*unitToId);
+	    *unitToId = NULL;
+	}
+    }
+}
 
-		smRemove(systemMaps[i], system);
-	    }
+
+static int
+addEntryMemory(
+    void* const	entry,
+    void* const	arg)
+{
+    const UnitIds* const	unitIds = (const UnitIds*)entry;
+    ut_memory_stats* const	stats = (ut_memory_stats*)arg;
+    int				encoding;
+
+    stats->idMaps.bytes += sizeof(UnitIds);
+    stats->idMaps.count++;
+
+    for (encoding = 0; encoding < ENCODING_COUNT; encoding++)
+	if (unitIds->ids[encoding] != NULL)
+	    stats->idMaps.bytes += strlen(unitIds->ids[encoding]) + 1;
+
+    if (unitIds->latin1AsUtf8 != NULL)
+	stats->idMaps.bytes += strlen(unitIds->latin1AsUtf8) + 1;
+
+    coreAddUnitMemory(unitIds->unit, stats);
+
+    return 0;
+}
+
+
+/*
+ * Adds the memory of the unit-to-identifier maps of a unit-system to the memory
+ * statistics of the unit-system.
+ *
+ * Arguments:
+ *	system		Pointer to the unit-system.
+ *	stats		Pointer to the statistics to be augmented.
+ */
+void
+utimGetMemory(
+    const ut_system* const	system,
+    ut_memory_stats* const	stats)
+{
+    const SystemMapId	mapIds[] = {SYSTEM_UNIT_TO_NAME, SYSTEM_UNIT_TO_SYMBOL};
+    int			i;
+
+    for (i = 0; i < 2; i++) {
+	const UnitToIdMap* const	unitToId =
+	    *(UnitToIdMap**)coreGetSystemMap(system, mapIds[i]);
+
+	if (unitToId != NULL) {
+	    stats->idMaps.bytes += sizeof(UnitToIdMap) +
+		htGetMemory(unitToId->table);
+	    (void)htWalk(unitToId->table, addEntryMemory, stats);
 	}
     }
 }
@@ -8,11 +8,41 @@
 #ifndef UT_UNIT_TO_ID_MAP_H_INCLUDED
 #define UT_UNIT_TO_ID_MAP_H_INCLUDED
 
+#include "udunits2.h"
+#include "unitcore.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 
+/*
+ * Calls a function on every mapping of a unit-to-identifier map of a
+ * unit-system in unspecified order.  Only the identifiers as they were mapped
+ * are visited.
+ *
+ * Arguments:
+ *	system		Pointer to the unit-system.
+ *	mapId		SYSTEM_UNIT_TO_NAME or SYSTEM_UNIT_TO_SYMBOL.
+ *	action		Pointer to the function to call with a unit, an
+ *			encoding, the identifier to which the unit maps in that
+ *			encoding, and "arg".  Iteration stops at the first
+ *			non-zero return-value.
+ *	arg		Argument passed to "action".
+ * Returns:
+ *	0		"action" returned 0 for every mapping.
+ *	else		The first non-zero value returned by "action".
+ */
+int
+utimWalk(
+    const ut_system* const	system,
+    const SystemMapId		mapId,
+    int				(*action)(const ut_unit* unit,
+					  ut_encoding encoding,
+					  const char* id, void* arg),
+    void* const			arg);
+
+
 /*
  * Frees resources associated with a unit-system.
  *
@@ -25,6 +55,20 @@ utimFreeSystem(
     ut_system*	system);
 
 
+/*
+ * Adds the memory of the unit-to-identifier maps of a unit-system to the memory
+ * statistics of the unit-system (see ut_get_memory_stats()).
+ *
+ * Arguments:
+ *	system		Pointer to the unit-system.
+ *	stats		Pointer to the statistics to be augmented.
+ */
+void
+utimGetMemory(
+    const ut_system* const	system,
+    ut_memory_stats* const	stats);
+
+
 #ifdef __cplusplus
 }
 #endif
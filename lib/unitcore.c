@@ -39,6 +39,10 @@
 
 #include "udunits2.h"		/* this module's API */
 #include "converter.h"
+#include "converterMemory.h"
+#include "errorMessages.h"
+#include "hashTable.h"
+#include "unitcore.h"
 
 #include <assert.h>
 #include <ctype.h>
@@ -89,6 +93,10 @@ struct ut_system {
     ut_unit*		one;		/* the dimensionless-unit one */
     BasicUnit**		basicUnits;
     int			basicCount;
+    void*		maps[SYSTEM_MAP_COUNT];	/* owned by other modules */
+    const ut_system*	base;		/* overlaid unit-system or NULL */
+    const ut_system*	root;		/* self or root of "base" */
+    int			frozen;		/* see ut_freeze_system() */
 };
 
 typedef struct {
@@ -100,6 +108,10 @@ typedef struct {
      * belong to the same unit system.
      */
     int			(*compare)(const ut_unit*, const ut_unit*);
+    /*
+     * Units that compare equal have the same hash-value.
+     */
+    uint64_t		(*hash)(const ut_unit*);
     ut_unit*		(*multiply)(const ut_unit*, const ut_unit*);
     ut_unit*		(*raise)(const ut_unit*, const int power);
     ut_unit*		(*root)(const ut_unit*, const int root);
@@ -136,6 +148,7 @@ typedef enum {
 #define FREE(unit)	((unit)->common.ops->free(unit))
 #define COMPARE(unit1, unit2) \
 			((unit1)->common.ops->compare(unit1, unit2))
+#define HASH(unit)	((unit)->common.ops->hash(unit))
 #define ENSURE_CONVERTER_TO_PRODUCT(unit) \
 			((unit)->common.toProduct != NULL || \
 			(unit)->common.ops->initConverterToProduct(unit) == 0)
@@ -221,6 +234,8 @@ static ProductUnit*	productNew(
     const int			count);
 static void		productFree(
     ut_unit* const		unit);
+static uint64_t		productHash(
+    const ut_unit* const	unit);
 static ut_unit*		productMultiply(
     const ut_unit* const	unit1,
     const ut_unit* const	unit2);
@@ -390,12 +405,11 @@ gregorianDateToJulianDay(year, month, day)
 static long
 getJuldayOrigin()
 {
-    static long juldayOrigin;
-
-    if (juldayOrigin == 0)
-	juldayOrigin = gregorianDateToJulianDay(2001, 1, 1);
-
-    return juldayOrigin;
+    /*
+     * Computed on every call rather than cached in a static variable so that
+     * concurrent callers don't race.
+     */
+    return gregorianDateToJulianDay(2001, 1, 1);
 }
 
 /*
@@ -737,6 +751,118 @@ ut_encode_time(
 }
 
 
+/*
+ * Encodes times from one array per field.  Each encoded time is the same as
+ * ut_encode_time() returns for the fields.  The Julian day number of a date
+ * in the same month as the date before it is obtained from the previous one
+ * rather than computed afresh, so sequences of times (e.g., a column of
+ * timestamps) are encoded incrementally.
+ *
+ * Arguments:
+ *	year		Pointer to the years.
+ *	month		Pointer to the months.
+ *	day		Pointer to the days.
+ *	hour		Pointer to the hours or NULL, in which case they're 0.
+ *	minute		Pointer to the minutes or NULL, in which case they're 0.
+ *	second		Pointer to the seconds or NULL, in which case they're 0.
+ *	count		Number of times.  Each non-NULL array shall have "count"
+ *			elements.
+ *	values		Pointer to the encoded times.  Shall have "count"
+ *			elements.
+ * Returns:
+ *	UT_SUCCESS	Success.
+ *	UT_BAD_ARG	"year", "month", "day", or "values" is NULL or at least
+ *			one time couldn't be encoded (see ut_encode_time()), in
+ *			which case its value is NaN.  The other times are
+ *			encoded.
+ */
+ut_status
+ut_encode_times(
+    const int* const	year,
+    const int* const	month,
+    const int* const	day,
+    const int* const	hour,
+    const int* const	minute,
+    const double* const	second,
+    const size_t	count,
+    double* const	values)
+{
+    if (count > 0 &&
+	    (year == NULL || month == NULL || day == NULL || values == NULL)) {
+	ut_set_status(UT_BAD_ARG);
+	ut_handle_error_message("ut_encode_times(): NULL argument");
+    }
+    else {
+	const long	origin = getJuldayOrigin();
+	long		julday = 0;
+	int		prevYear = 0;
+	int		prevMonth = 0;	/* 0 => no previous date */
+	int		prevDay = 0;
+	size_t		nbad = 0;
+	size_t		i;
+
+	for (i = 0; i < count; i++) {
+	    const int		y = year[i];
+	    const int		mo = month[i];
+	    const int		d = day[i];
+	    const int		h = hour == NULL ? 0 : hour[i];
+	    const int		mi = minute == NULL ? 0 : minute[i];
+	    const double	sec = second == NULL ? 0 : second[i];
+	    double		date;
+	    double		clock;
+
+	    if (y < -UT_YEAR_ABS_MAX || y > UT_YEAR_ABS_MAX) {
+		date = NAN;
+		prevMonth = 0;
+	    }
+	    else {
+		/*
+		 * Within a month other than the Gregorian cutover, the Julian
+		 * day number of a day of the month (1-31) is linear in the day.
+		 */
+		if (prevMonth != 0 && y == prevYear && mo == prevMonth &&
+			d >= 1 && d <= 31 &&
+			!(y == 1582 && mo == 10)) {
+		    julday += d - prevDay;
+		}
+		else {
+		    julday = gregorianDateToJulianDay(y, mo, d);
+		}
+
+		prevYear = y;
+		prevMonth = mo >= 1 && mo <= 12 && d >= 1 && d <= 31 ? mo : 0;
+		prevDay = d;
+		date = 86400.0 * (julday - origin);
+	    }
+
+	    /* The bounds and arithmetic of ut_encode_clock(). */
+	    clock = h <= -24 || h >= 24 || mi <= -60 || mi >= 60 ||
+		    !(fabs(sec) <= 62)
+		? NAN
+		: ((double)h*60 + mi)*60 + sec;
+
+	    values[i] = date + clock;
+
+	    if (!isfinite(values[i])) {
+		values[i] = NAN;
+		nbad++;
+	    }
+	}
+
+	if (nbad == 0) {
+	    ut_set_status(UT_SUCCESS);
+	}
+	else {
+	    ut_set_status(UT_BAD_ARG);
+	    ut_handle_error_message("ut_encode_times(): %lu time(s) couldn't "
+		"be encoded", (unsigned long)nbad);
+	}
+    }
+
+    return ut_get_status();
+}
+
+
 /*
  * Decodes a time from a double-precision value.
  *
@@ -798,6 +924,183 @@ ut_decode_time(
 }
 
 
+/*
+ * Julian day number of October 15, 1582:  the first day of the Gregorian
+ * calendar in julianDayToGregorianDate().
+ */
+#define GREGORIAN_JULDAY	2299161
+
+/*
+ * Absolute cap on the values decoded by ut_decode_times():  the encoded times
+ * of years within +/-UT_YEAR_ABS_MAX with some slack.  The number of days of
+ * such a value fits in an int.
+ */
+#define DECODE_ABS_MAX		(86400.0 * 366 * UT_YEAR_ABS_MAX)
+
+
+/*
+ * Returns the number of days in a month of the Gregorian calendar.
+ *
+ * Arguments:
+ *	year	The year.
+ *	month	The month (1-12).
+ * Returns:
+ *	The number of days in the month.
+ */
+static int
+gregorianMonthLength(
+    const int	year,
+    const int	month)
+{
+    static const int	lengths[12] = {
+	31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31
+    };
+
+    return month == 2 && year % 4 == 0 && (year % 100 != 0 || year % 400 == 0)
+	? 29
+	: lengths[month-1];
+}
+
+
+/*
+ * Decodes times from double-precision values.  Each decoded time is the same
+ * as ut_decode_time() returns for the value.  The output is in one array per
+ * field rather than one structure per time.
+ *
+ * The clock-time of all values is computed first by a loop without branches.
+ * The dates are computed next:  a value whose day follows the day of the
+ * previous value by at most a month has its date stepped forward from the
+ * previous date rather than computed from its Julian day number, so
+ * non-decreasing sequences of times (e.g., the time-axis of a dataset) are
+ * decoded incrementally.
+ *
+ * Arguments:
+ *	values		Pointer to the values to be decoded.
+ *	count		Number of values.
+ *	year		Pointer to the years.  Shall have "count" elements.
+ *	month		Pointer to the months.  Shall have "count" elements.
+ *	day		Pointer to the days.  Shall have "count" elements.
+ *	hour		Pointer to the hours.  Shall have "count" elements.
+ *	minute		Pointer to the minutes.  Shall have "count" elements.
+ *	second		Pointer to the seconds.  Shall have "count" elements.
+ * Returns:
+ *	UT_SUCCESS	Success.
+ *	UT_BAD_ARG	A pointer argument is NULL or at least one value isn't
+ *			finite or is outside the range of years within
+ *			+/-5,000,000.  The other values are decoded.  The
+ *			fields of such a value are 0 except for the second,
+ *			which is NaN.
+ */
+ut_status
+ut_decode_times(
+    const double* const	values,
+    const size_t	count,
+    int* const		year,
+    int* const		month,
+    int* const		day,
+    int* const		hour,
+    int* const		minute,
+    double* const	second)
+{
+    if (count > 0 && (values == NULL || year == NULL || month == NULL ||
+	    day == NULL || hour == NULL || minute == NULL || second == NULL)) {
+	ut_set_status(UT_BAD_ARG);
+	ut_handle_error_message("ut_decode_times(): NULL argument");
+    }
+    else {
+	const long	origin = getJuldayOrigin();
+	long		prevJulday = LONG_MIN;
+	int		y = 0;
+	int		mo = 0;
+	int		d = 0;
+	size_t		nbad = 0;
+	size_t		i;
+
+	/*
+	 * Clock-times.  The number of days relative to the origin is saved in
+	 * "day" for the next loop; INT_MIN marks a value that can't be
+	 * decoded.  The arithmetic is exactly that of ut_decode_time():  the
+	 * excess seconds are in [0, 86400) or a tiny negative value, and
+	 * removing whole hours and minutes from it is exact.  The whole days are
+	 * subtracted as an integer, as there, so that -0 stays -0.  A tiny negative
+	 * value rounds to an excess of exactly 86400, which is carried into the
+	 * next day.
+	 */
+	for (i = 0; i < count; i++) {
+	    const int		ok = fabs(values[i]) <= DECODE_ABS_MAX;
+	    const double	value = ok ? values[i] : 0;
+	    const double	floorDays = floor(value/86400.0);
+	    const double	rawExcess = value -
+		(double)((long long)floorDays * 86400);
+	    const int		carry = rawExcess >= 86400.0;
+	    const double	days = floorDays + carry;
+	    const double	excess = carry ? rawExcess - 86400.0 : rawExcess;
+	    const int		secs = (int)excess;
+	    const int		h = secs / 3600;
+	    const int		m = (secs - h * 3600) / 60;
+
+	    day[i] = ok ? (int)days : INT_MIN;
+	    hour[i] = h;
+	    minute[i] = m;
+	    second[i] = ok ? excess - (h * 3600 + m * 60) : NAN;
+	}
+
+	/*
+	 * Dates.
+	 */
+	for (i = 0; i < count; i++) {
+	    long	julday;
+
+	    if (day[i] == INT_MIN) {
+		year[i] = month[i] = day[i] = 0;
+		nbad++;
+		continue;
+	    }
+
+	    julday = origin + day[i];
+
+	    if (julday != prevJulday) {
+		if (prevJulday >= GREGORIAN_JULDAY && julday > prevJulday &&
+			julday - prevJulday <= 31) {
+		    int	length;
+
+		    d += (int)(julday - prevJulday);
+
+		    while (d > (length = gregorianMonthLength(y, mo))) {
+			d -= length;
+
+			if (++mo > 12) {
+			    mo = 1;
+			    y++;
+			}
+		    }
+		}
+		else {
+		    julianDayToGregorianDate(julday, &y, &mo, &d);
+		}
+
+		prevJulday = julday;
+	    }
+
+	    year[i] = y;
+	    month[i] = mo;
+	    day[i] = d;
+	}
+
+	if (nbad == 0) {
+	    ut_set_status(UT_SUCCESS);
+	}
+	else {
+	    ut_set_status(UT_BAD_ARG);
+	    ut_handle_error_message("ut_decode_times(): %lu value(s) couldn't "
+		"be decoded", (unsigned long)nbad);
+	}
+    }
+
+    return ut_get_status();
+}
+
+
 /******************************************************************************
  * Parameters common to all types of units:
  ******************************************************************************/
@@ -965,6 +1268,21 @@ basicCompare(
 }
 
 
+/*
+ * A basic-unit compares equal to its equivalent product-unit; consequently,
+ * it hashes as that product-unit.
+ */
+static uint64_t
+basicHash(
+    const ut_unit* const	unit)
+{
+    assert(unit != NULL);
+    assert(IS_BASIC(unit));
+
+    return productHash((const ut_unit*)unit->basic.product);
+}
+
+
 /*
  * Multiplies a basic-unit by another unit.
  *
@@ -1106,6 +1424,7 @@ static UnitOps	basicOps = {
     basicClone,
     basicFree,
     basicCompare,
+    basicHash,
     basicMultiply,
     basicRaise,
     basicRoot,
@@ -1279,6 +1598,28 @@ productCompare(
 }
 
 
+static uint64_t
+productHash(
+    const ut_unit* const	unit)
+{
+    const ProductUnit* const	product = &unit->product;
+    uint64_t			hash = htHashMix(htHashString(""), PRODUCT);
+    int				i;
+
+    assert(unit != NULL);
+    assert(IS_PRODUCT(unit));
+
+    hash = htHashMix(hash, (uint64_t)product->count);
+
+    for (i = 0; i < product->count; ++i) {
+	hash = htHashMix(hash, (uint64_t)product->indexes[i]);
+	hash = htHashMix(hash, (uint64_t)product->powers[i]);
+    }
+
+    return hash;
+}
+
+
 static void
 productReallyFree(
     ut_unit* const	unit)
@@ -1347,9 +1688,11 @@ productMultiply(
 	    result = unit1->common.system->one;
 	}
 	else {
-	    static short*		indexes = NULL;
-
-	    indexes = realloc(indexes, sizeof(short)*sumCount);
+	    /*
+	     * The arrays are allocated per call rather than cached so that
+	     * concurrent multiplications in different threads don't collide.
+	     */
+	    short* const	indexes = malloc(2*sizeof(short)*sumCount);
 
 	    if (indexes == NULL) {
 		ut_set_status(UT_OS);
@@ -1358,54 +1701,44 @@ productMultiply(
 		    "Couldn't allocate %d-element index array", sumCount);
 	    }
 	    else {
-		static short*	powers = NULL;
-
-		powers = realloc(powers, sizeof(short)*sumCount);
-
-		if (powers == NULL) {
-		    ut_set_status(UT_OS);
-		    ut_handle_error_message(strerror(errno));
-		    ut_handle_error_message("productMultiply(): "
-			"Couldn't allocate %d-element power array",
-			sumCount);
-		}
-		else {
-		    int				count = 0;
-		    int				i1 = 0;
-		    int				i2 = 0;
-
-		    while (i1 < count1 || i2 < count2) {
-			if (i1 >= count1) {
-			    indexes[count] = indexes2[i2];
-			    powers[count++] = powers2[i2++];
-			}
-			else if (i2 >= count2) {
-			    indexes[count] = indexes1[i1];
-			    powers[count++] = powers1[i1++];
-			}
-			else if (indexes1[i1] > indexes2[i2]) {
-			    indexes[count] = indexes2[i2];
-			    powers[count++] = powers2[i2++];
-			}
-			else if (indexes1[i1] < indexes2[i2]) {
+		short* const	powers = indexes + sumCount;
+		int		count = 0;
+		int		i1 = 0;
+		int		i2 = 0;
+
+		while (i1 < count1 || i2 < count2) {
+		    if (i1 >= count1) {
+			indexes[count] = indexes2[i2];
+			powers[count++] = powers2[i2++];
+		    }
+		    else if (i2 >= count2) {
+			indexes[count] = indexes1[i1];
+			powers[count++] = powers1[i1++];
+		    }
+		    else if (indexes1[i1] > indexes2[i2]) {
+			indexes[count] = indexes2[i2];
+			powers[count++] = powers2[i2++];
+		    }
+		    else if (indexes1[i1] < indexes2[i2]) {
+			indexes[count] = indexes1[i1];
+			powers[count++] = powers1[i1++];
+		    }
+		    else {
+			if (powers1[i1] != -powers2[i2]) {
 			    indexes[count] = indexes1[i1];
-			    powers[count++] = powers1[i1++];
+			    powers[count++] = powers1[i1] + powers2[i2];
 			}
-			else {
-			    if (powers1[i1] != -powers2[i2]) {
-				indexes[count] = indexes1[i1];
-				powers[count++] = powers1[i1] + powers2[i2];
-			    }
 
-			    i1++;
-			    i2++;
-			}
+			i1++;
+			i2++;
 		    }
+		}
 
-		    result = (ut_unit*)productNew(unit1->common.system,
-			indexes, powers, count);
-		}			/* "powers" re-allocated */
-	    }				/* "indexes" re-allocated */
+		result = (ut_unit*)productNew(unit1->common.system,
+		    indexes, powers, count);
+
+		free(indexes);
+	    }				/* "indexes" allocated */
 	}				/* "sumCount > 0" */
     }					/* "unit2" is a product-unit */
 
@@ -1529,7 +1862,8 @@ productRoot(
             if (i < count) {
                 char buf[80];
 
-                if (ut_format(unit, buf, sizeof(buf), UT_ASCII) == -1) {
+                if (!errMessagesWanted() ||
+                        ut_format(unit, buf, sizeof(buf), UT_ASCII) == -1) {
                     ut_set_status(UT_MEANINGLESS);
                     ut_handle_error_message("productRoot(): "
                         "Can't take root of unit");
@@ -1774,6 +2108,7 @@ static UnitOps	productOps = {
     productClone,
     productFree,
     productCompare,
+    productHash,
     productMultiply,
     productRaise,
     productRoot,
@@ -1966,6 +2301,22 @@ galileanCompare(
 }
 
 
+static uint64_t
+galileanHash(
+    const ut_unit* const	unit)
+{
+    uint64_t	hash = htHashMix(htHashString(""), GALILEAN);
+
+    assert(unit != NULL);
+    assert(IS_GALILEAN(unit));
+
+    hash = htHashDouble(hash, unit->galilean.offset);
+    hash = htHashDouble(hash, unit->galilean.scale);
+
+    return htHashMix(hash, HASH(unit->galilean.unit));
+}
+
+
 static void
 galileanFree(
     ut_unit* const	unit)
@@ -2246,6 +2597,7 @@ static UnitOps	galileanOps = {
     galileanClone,
     galileanFree,
     galileanCompare,
+    galileanHash,
     galileanMultiply,
     galileanRaise,
     galileanRoot,
@@ -2421,6 +2773,21 @@ timestampCompare(
 }
 
 
+static uint64_t
+timestampHash(
+    const ut_unit* const	unit)
+{
+    uint64_t	hash = htHashMix(htHashString(""), TIMESTAMP);
+
+    assert(unit != NULL);
+    assert(IS_TIMESTAMP(unit));
+
+    hash = htHashDouble(hash, unit->timestamp.origin);
+
+    return htHashMix(hash, HASH(unit->timestamp.unit));
+}
+
+
 static void
 timestampFree(
     ut_unit* const	unit)
@@ -2580,6 +2947,7 @@ static UnitOps	timestampOps = {
     timestampClone,
     timestampFree,
     timestampCompare,
+    timestampHash,
     timestampMultiply,
     timestampRaise,
     timestampRoot,
@@ -2707,6 +3075,21 @@ logCompare(
 }
 
 
+static uint64_t
+logHash(
+    const ut_unit* const	unit)
+{
+    uint64_t	hash = htHashMix(htHashString(""), LOG);
+
+    assert(unit != NULL);
+    assert(IS_LOG(unit));
+
+    hash = htHashMix(hash, HASH(unit->log.reference));
+
+    return htHashDouble(hash, unit->log.base);
+}
+
+
 static void
 logFree(
     ut_unit* const	unit)
@@ -2959,6 +3342,7 @@ static UnitOps	logOps = {
     logClone,
     logFree,
     logCompare,
+    logHash,
     logMultiply,
     logRaise,
     logRoot,
@@ -2997,10 +3381,18 @@ ut_new_system(void)
 	    sizeof(ut_system));
     }
     else {
+	int	i;
+
 	system->second = NULL;
 	system->basicUnits = NULL;
 	system->basicCount = 0;
 
+	for (i = 0; i < SYSTEM_MAP_COUNT; i++)
+	    system->maps[i] = NULL;
+
+	system->base = NULL;
+	system->root = system;
+	system->frozen = 0;
 	system->one = (ut_unit*)productNew(system, NULL, NULL, 0);
 
 	if (ut_get_status() != UT_SUCCESS) {
@@ -3015,6 +3407,70 @@ ut_new_system(void)
 }
 
 
+/*
+ * Returns a new unit-system that overlays a frozen unit-system.  The new
+ * unit-system has the units, prefixes, and identifiers of the overlaid one
+ * and may be given its own: mapping an identifier in the new unit-system
+ * leaves the overlaid one unchanged and hides any mapping of the identifier
+ * in it.  Units of the two unit-systems may be combined and converted between.
+ * The new unit-system can't have its own base-units or dimensionless-units.
+ *
+ * Creating an overlay is cheap: nothing of the overlaid unit-system is copied.
+ * Because the overlaid unit-system is frozen, any number of overlays of it may
+ * be used and freed concurrently.
+ *
+ * Arguments:
+ *	base	Pointer to the frozen unit-system to be overlaid.  It shall not
+ *		be freed until the new unit-system has been freed.
+ * Returns:
+ *	NULL	Failure.  "ut_get_status()" will be:
+ *		    UT_BAD_ARG	"base" is NULL or isn't frozen.
+ *		    UT_OS	Operating-system error.  See "errno".
+ *	else	Pointer to the new unit-system.  It should be passed to
+ *		ut_free_system() when it's no longer needed.
+ */
+ut_system*
+ut_new_overlay_system(
+    const ut_system* const	base)
+{
+    ut_system*	system = NULL;
+
+    ut_set_status(UT_SUCCESS);
+
+    if (base == NULL) {
+	ut_set_status(UT_BAD_ARG);
+	ut_handle_error_message(
+	    "ut_new_overlay_system(): NULL unit-system argument");
+    }
+    else if (!base->frozen) {
+	ut_set_status(UT_BAD_ARG);
+	ut_handle_error_message(
+	    "ut_new_overlay_system(): Overlaid unit-system isn't frozen");
+    }
+    else {
+	system = ut_new_system();
+
+	if (system == NULL) {
+	    ut_handle_error_message(
+		"ut_new_overlay_system(): Couldn't create unit-system");
+	}
+	else {
+	    /*
+	     * The basic-units and second are those of the overlaid unit-system
+	     * and aren't freed with this one.
+	     */
+	    system->second = base->second;
+	    system->basicUnits = base->basicUnits;
+	    system->basicCount = base->basicCount;
+	    system->base = base;
+	    system->root = base->root;
+	}
+    }
+
+    return system;
+}
+
+
 /*
  * Frees resources associated with a unit-system by this module.
  *
@@ -3026,14 +3482,17 @@ coreFreeSystem(
     ut_system*	system)
 {
     if (system != NULL) {
-	int	i;
+	if (system->base == NULL) {
+	    int	i;
 
-	for (i = 0; i < system->basicCount; ++i)
-	    basicFree((ut_unit*)system->basicUnits[i]);
+	    for (i = 0; i < system->basicCount; ++i)
+		basicFree((ut_unit*)system->basicUnits[i]);
 
-	free(system->basicUnits);
+	    free(system->basicUnits);
+	}
 
-	if (system->second != NULL)
+	if (system->second != NULL &&
+		(system->base == NULL || system->second != system->base->second))
 	    FREE(system->second);
 
 	if (system->one != NULL)
@@ -3044,6 +3503,189 @@ coreFreeSystem(
 }
 
 
+/*
+ * Initializes the lazily-created state of a unit (i.e., its converters to and
+ * from its underlying product-unit) so that subsequent use of the unit doesn't
+ * modify it.
+ *
+ * Arguments:
+ *	unit	Pointer to the unit.  Shall not be NULL.
+ * Returns:
+ *	UT_SUCCESS	Success.
+ *	else		Failure.  ut_handle_error_message() was called.
+ */
+ut_status
+coreInitUnit(
+    ut_unit* const	unit)
+{
+    ut_status	status = UT_SUCCESS;
+
+    assert(unit != NULL);
+
+    if (IS_TIMESTAMP(unit)) {
+	/*
+	 * Timestamp units have no converters of their own; ut_get_converter()
+	 * uses those of the underlying unit.
+	 */
+	status = coreInitUnit(unit->timestamp.unit);
+    }
+    else if (!ENSURE_CONVERTER_TO_PRODUCT(unit) ||
+	    !ENSURE_CONVERTER_FROM_PRODUCT(unit)) {
+	status = ut_get_status() == UT_SUCCESS ? UT_OS : ut_get_status();
+	ut_handle_error_message(
+	    "coreInitUnit(): Couldn't initialize converters of unit");
+    }
+
+    return status;
+}
+
+
+/*
+ * Freezes the part of a unit-system that this module owns: the converters of
+ * its basic-units (and their product-units), of the dimensionless unit one,
+ * and of its second are initialized and subsequent modifications are
+ * rejected.
+ *
+ * Arguments:
+ *	system		Pointer to the unit-system.  Shall not be NULL.
+ * Returns:
+ *	UT_SUCCESS	Success.
+ *	else		Failure.  The unit-system isn't frozen.
+ */
+ut_status
+coreFreezeSystem(
+    ut_system* const	system)
+{
+    ut_status	status = coreInitUnit(system->one);
+    int		i;
+
+    /*
+     * The basic-units of an overlay are those of its frozen base.
+     */
+    for (i = 0; status == UT_SUCCESS && system->base == NULL &&
+	    i < system->basicCount; i++) {
+	status = coreInitUnit((ut_unit*)system->basicUnits[i]);
+
+	if (status == UT_SUCCESS)
+	    status = coreInitUnit((ut_unit*)system->basicUnits[i]->product);
+    }
+
+    if (status == UT_SUCCESS && system->second != NULL)
+	status = coreInitUnit(system->second);
+
+    if (status == UT_SUCCESS)
+	system->frozen = 1;
+
+    return status;
+}
+
+
+/*
+ * Indicates whether a unit-system is frozen.
+ *
+ * Arguments:
+ *	system		Pointer to the unit-system.  Shall not be NULL.
+ * Returns:
+ *	0		The unit-system may be modified.
+ *	else		The unit-system is frozen.
+ */
+int
+coreIsFrozen(
+    const ut_system* const	system)
+{
+    return system->frozen;
+}
+
+
+/*
+ * Returns the unit-system that a unit-system overlays.
+ *
+ * Arguments:
+ *	system		Pointer to the unit-system.  Shall not be NULL.
+ * Returns:
+ *	NULL		"system" doesn't overlay a unit-system.
+ *	else		Pointer to the overlaid unit-system.
+ */
+const ut_system*
+coreGetBaseSystem(
+    const ut_system* const	system)
+{
+    return system->base;
+}
+
+
+/*
+ * Makes a unit belong to a unit-system that has the same root as the
+ * unit-system to which the unit belongs: usually one that overlays it, directly
+ * or indirectly, or that unit-system itself.
+ * Identifiers that are subsequently mapped to or from the unit are then added
+ * to the overlay rather than to the frozen unit-system that it overlays.
+ *
+ * Arguments:
+ *	system		Pointer to the unit-system.  Shall not be NULL.
+ *	unit		Pointer to a unit that the client owns.  Shall not be
+ *			NULL.
+ * Returns:
+ *	Pointer to the unit.  It will differ from "unit" if "unit" is the
+ *	dimensionless unit one of another unit-system, in which case it's that
+ *	of "system".
+ */
+ut_unit*
+coreAdoptUnit(
+    const ut_system* const	system,
+    ut_unit* const		unit)
+{
+    if (unit == unit->common.system->one)
+	return system->one;
+
+    unit->common.system = (ut_system*)system;
+
+    switch (unit->common.type) {
+    case BASIC:
+	unit->basic.product = (ProductUnit*)coreAdoptUnit(system,
+	    (ut_unit*)unit->basic.product);
+	break;
+    case GALILEAN:
+	unit->galilean.unit = coreAdoptUnit(system, unit->galilean.unit);
+	break;
+    case TIMESTAMP:
+	unit->timestamp.unit = coreAdoptUnit(system, unit->timestamp.unit);
+	break;
+    case LOG:
+	unit->log.reference = coreAdoptUnit(system, unit->log.reference);
+	break;
+    default:
+	break;
+    }
+
+    return unit;
+}
+
+
+/*
+ * Returns the address of the slot in a unit-system that holds one of the maps
+ * that other modules associate with the unit-system.  The slot is NULL until
+ * the owning module sets it and must be cleared by that module's part of
+ * ut_free_system().
+ *
+ * Arguments:
+ *	system	Pointer to the unit-system.  Shall not be NULL.
+ *	id	Identifier of the map.
+ * Returns:
+ *	Address of the map-slot.
+ */
+void**
+coreGetSystemMap(
+    const ut_system* const	system,
+    const SystemMapId		id)
+{
+    assert(system != NULL);
+    assert(id >= 0 && id < SYSTEM_MAP_COUNT);
+
+    return &((ut_system*)system)->maps[id];
+}
+
+
 /*
  * Returns the dimensionless-unit one of a unit-system.
  *
@@ -3111,7 +3753,55 @@ ut_get_system(
 
 
 /*
- * Indicates if two units belong to the same unit-system.
+ * Returns the unit-system in which the units of two unit-systems may be
+ * combined: the unit-system itself if they're the same; the one that
+ * overlays the other, directly or indirectly; or, for overlays of a common
+ * unit-system, the nearest unit-system that they both overlay.  This is the
+ * rule of ut_compare(), which orders units by the root of their unit-system.
+ *
+ * Arguments:
+ *	system1		Pointer to a unit-system.
+ *	system2		Pointer to another unit-system.
+ * Returns:
+ *	NULL		The unit-systems are unrelated (have different roots).
+ *	else		Pointer to the common unit-system.
+ */
+static ut_system*
+commonSystem(
+    ut_system* const	system1,
+    ut_system* const	system2)
+{
+    const ut_system*	system;
+    const ut_system*	ancestor;
+
+    if (system1->root != system2->root)
+	return NULL;
+
+    for (system = system2; system != NULL; system = system->base)
+	if (system == system1)
+	    return system2;
+
+    for (system = system1; system != NULL; system = system->base)
+	if (system == system2)
+	    return system1;
+
+    /*
+     * The unit-systems are sibling overlays.  Because they have the same
+     * root, the loops terminate.  The common unit-system is frozen, so units
+     * may belong to it (see coreAdoptUnit()).
+     */
+    for (ancestor = system1->base; ; ancestor = ancestor->base)
+	for (system = system2->base; system != NULL; system = system->base)
+	    if (system == ancestor)
+		return (ut_system*)ancestor;
+}
+
+
+/*
+ * Indicates if two units belong to the same unit-system.  A unit-system and
+ * the unit-systems that overlay it, directly or indirectly (see
+ * ut_new_overlay_system()), are considered the same, so overlays of a common
+ * unit-system are too.
  *
  * Arguments:
  *	unit1		Pointer to a unit.
@@ -3137,7 +3827,8 @@ ut_same_system(
     }
     else {
 	ut_set_status(UT_SUCCESS);
-	sameSystem = unit1->common.system == unit2->common.system;
+	sameSystem = commonSystem(unit1->common.system, unit2->common.system)
+	    != NULL;
     }
 
     return sameSystem;
@@ -3154,6 +3845,7 @@ ut_same_system(
  * Returns:
  *	NULL	Failure.  "ut_get_status()" will be
  *		    UT_BAD_ARG		"system" is NULL.
+ *		    UT_FROZEN		"system" is frozen.
  *		    UT_OS		Operating-system error.  See "errno".
  *	else	Pointer to the new base-unit.
  */
@@ -3168,6 +3860,15 @@ newBasicUnit(
 	ut_set_status(UT_BAD_ARG);
 	ut_handle_error_message("newBasicUnit(): NULL unit-system argument");
     }
+    else if (system->frozen) {
+	ut_set_status(UT_FROZEN);
+	ut_handle_error_message("newBasicUnit(): Unit-system is frozen");
+    }
+    else if (system->base != NULL) {
+	ut_set_status(UT_BAD_ARG);
+	ut_handle_error_message(
+	    "newBasicUnit(): Unit-system is an overlay");
+    }
     else {
 	basicUnit = basicNew(system, isDimensionless, system->basicCount);
 
@@ -3221,7 +3922,9 @@ newBasicUnit(
  *	system	Pointer to the unit-system to which to add the new base-unit.
  * Returns:
  *	NULL	Failure.  "ut_get_status()" will be
- *		    UT_BAD_ARG		"system" or "name" is NULL.
+ *		    UT_BAD_ARG		"system" or "name" is NULL or
+ *					"system" is an overlay.
+ *		    UT_FROZEN		"system" is frozen.
  *		    UT_OS		Operating-system error.  See "errno".
  *	else	Pointer to the new base-unit.  The pointer should be passed to
  *		ut_free() when the unit is no longer needed by the client (the
@@ -3247,7 +3950,8 @@ ut_new_base_unit(
  *		dimensionless-unit.
  * Returns:
  *	NULL	Failure.  "ut_get_status()" will be
- *		    UT_BAD_ARG		"system" is NULL.
+ *		    UT_BAD_ARG		"system" is NULL or is an overlay.
+ *		    UT_FROZEN		"system" is frozen.
  *		    UT_OS		Operating-system error.  See "errno".
  *	else	Pointer to the new dimensionless-unit.  The pointer should be
  *		passed to ut_free() when the unit is no longer needed by the
@@ -3272,6 +3976,7 @@ ut_new_dimensionless_unit(
  *	UT_BAD_ARG	"second" is NULL.
  *	UT_EXISTS	The second unit of the unit-system to which "second"
  *			belongs is set to a different unit.
+ *	UT_FROZEN	The unit-system to which "second" belongs is frozen.
  *	UT_SUCCESS	Success.
  */
 ut_status
@@ -3288,7 +3993,11 @@ ut_set_second(
     else {
 	ut_system*	system = second->common.system;
 
-	if (system->second == NULL) {
+	if (system->frozen) {
+	    ut_set_status(UT_FROZEN);
+	    ut_handle_error_message("ut_set_second(): Unit-system is frozen");
+	}
+	else if (system->second == NULL) {
 	    system->second = CLONE(second);
 	}
 	else {
@@ -3341,16 +4050,16 @@ ut_compare(
     else if (unit2 == NULL) {
 	cmp = 1;
     }
-    else if (unit1->common.system < unit2->common.system) {
+    else if (unit1->common.system->root < unit2->common.system->root) {
 	cmp = -1;
     }
-    else if (unit1->common.system > unit2->common.system) {
+    else if (unit1->common.system->root > unit2->common.system->root) {
 	cmp = 1;
     }
     else {
 	/*
 	 * NB: The comparison function is called if and only if the units
-	 * belong to the same unit-system.
+	 * belong to the same unit-system or to overlays of it.
 	 */
 	cmp = COMPARE(unit1, unit2);
     }
@@ -3359,6 +4068,346 @@ ut_compare(
 }
 
 
+/*
+ * Returns the hash-value of a unit.  Units of the same unit-system for which
+ * ut_compare() returns 0 have the same hash-value.
+ *
+ * Arguments:
+ *	unit	Pointer to the unit.  Shall not be NULL.
+ * Returns:
+ *	The hash-value of "unit".
+ */
+uint64_t
+coreHash(
+    const ut_unit* const	unit)
+{
+    assert(unit != NULL);
+
+    return HASH(unit);
+}
+
+
+/*
+ * Returns the number of basic-units of a unit-system.
+ *
+ * Arguments:
+ *	system	Pointer to the unit-system.  Shall not be NULL.
+ * Returns:
+ *	The number of basic-units in "system".
+ */
+int
+coreGetBasicCount(
+    const ut_system* const	system)
+{
+    assert(system != NULL);
+
+    return system->basicCount;
+}
+
+
+/*
+ * Returns a basic-unit of a unit-system.
+ *
+ * Arguments:
+ *	system	Pointer to the unit-system.  Shall not be NULL.
+ *	index	Index of the basic-unit.  Shall be less than
+ *		coreGetBasicCount(system).
+ * Returns:
+ *	Pointer to the basic-unit.  It belongs to "system".
+ */
+const ut_unit*
+coreGetBasicUnit(
+    const ut_system* const	system,
+    const int			index)
+{
+    assert(system != NULL);
+    assert(index >= 0 && index < system->basicCount);
+
+    return (const ut_unit*)system->basicUnits[index];
+}
+
+
+/*
+ * Returns the "second" unit of a unit-system.
+ *
+ * Arguments:
+ *	system	Pointer to the unit-system.  Shall not be NULL.
+ * Returns:
+ *	NULL	The second unit of "system" isn't set.
+ *	else	Pointer to the second unit.  It belongs to "system".
+ */
+const ut_unit*
+coreGetSecond(
+    const ut_system* const	system)
+{
+    assert(system != NULL);
+
+    return system->second;
+}
+
+
+/*
+ * Describes the structure of a unit.
+ *
+ * Arguments:
+ *	unit		Pointer to the unit.  Shall not be NULL.
+ *	description	Pointer to the description to be set.  Its pointers
+ *			refer to "unit" and are valid while "unit" is.
+ */
+void
+coreDescribeUnit(
+    const ut_unit* const	unit,
+    CoreUnitDescription* const	description)
+{
+    assert(unit != NULL);
+    assert(description != NULL);
+
+    (void)memset(description, 0, sizeof(*description));
+
+    switch (unit->common.type) {
+    case BASIC:
+	description->kind = CORE_BASIC;
+	description->index = unit->basic.index;
+	description->isDimensionless = unit->basic.isDimensionless;
+	break;
+    case PRODUCT:
+	description->kind = CORE_PRODUCT;
+	description->count = unit->product.count;
+	description->indexes = unit->product.indexes;
+	description->powers = unit->product.powers;
+	break;
+    case GALILEAN:
+	description->kind = CORE_GALILEAN;
+	description->unit = unit->galilean.unit;
+	description->value = unit->galilean.scale;
+	description->offset = unit->galilean.offset;
+	break;
+    case TIMESTAMP:
+	description->kind = CORE_TIMESTAMP;
+	description->unit = unit->timestamp.unit;
+	description->value = unit->timestamp.origin;
+	break;
+    case LOG:
+	description->kind = CORE_LOG;
+	description->unit = unit->log.reference;
+	description->value = unit->log.base;
+	break;
+    }
+}
+
+
+/*
+ * Returns a new unit from its description (see coreDescribeUnit()).  The
+ * basic-units and the second unit that the description refers to must already
+ * exist in the unit-system.
+ *
+ * Arguments:
+ *	system		Pointer to the unit-system of the new unit.  Shall not
+ *			be NULL.
+ *	description	Pointer to the description of the unit.  Its "unit"
+ *			member, if relevant, shall belong to "system".
+ * Returns:
+ *	NULL		Failure.  "ut_get_status()" will be:
+ *			    UT_BAD_ARG		The description is invalid.
+ *			    UT_OS		Operating-system error.  See
+ *						"errno".
+ *			    UT_MEANINGLESS	A timestamp-unit was described
+ *						whose underlying unit isn't a
+ *						unit of time.
+ *			    UT_NO_SECOND	A timestamp-unit was described
+ *						but "system" doesn't have a
+ *						second unit.
+ *	else		Pointer to the new unit.  The client should pass it to
+ *			ut_free() when it's no longer needed.
+ */
+ut_unit*
+coreNewUnit(
+    ut_system* const			system,
+    const CoreUnitDescription* const	description)
+{
+    ut_unit*	unit = NULL;		/* failure */
+    const char*	problem = NULL;
+
+    assert(system != NULL);
+    assert(description != NULL);
+
+    switch (description->kind) {
+    case CORE_BASIC:
+	if (description->index < 0 ||
+		description->index >= system->basicCount) {
+	    problem = "Invalid basic-unit index";
+	}
+	else {
+	    unit = CLONE((ut_unit*)system->basicUnits[description->index]);
+	}
+	break;
+    case CORE_PRODUCT: {
+	int	i;
+
+	for (i = 0; i < description->count; i++) {
+	    if (description->indexes[i] < 0 ||
+		    description->indexes[i] >= system->basicCount ||
+		    (i > 0 &&
+			description->indexes[i] <= description->indexes[i-1]) ||
+		    description->powers[i] == 0) {
+		problem = "Invalid product-unit";
+		break;
+	    }
+	}
+
+	if (problem == NULL)
+	    unit = description->count == 0
+		? CLONE(system->one)
+		: (ut_unit*)productNew(system, description->indexes,
+		    description->powers, description->count);
+	break;
+    }
+    case CORE_GALILEAN:
+	if (description->unit == NULL ||
+		description->unit->common.system != system ||
+		IS_GALILEAN(description->unit) || description->value == 0) {
+	    problem = "Invalid Galilean unit";
+	}
+	else {
+	    unit = galileanNew(description->value, description->unit,
+		description->offset);
+	}
+	break;
+    case CORE_TIMESTAMP:
+	if (description->unit == NULL ||
+		description->unit->common.system != system ||
+		IS_TIMESTAMP(description->unit)) {
+	    problem = "Invalid timestamp unit";
+	}
+	else {
+	    unit = timestampNewOrigin(description->unit, description->value);
+
+	    if (unit == NULL && ut_get_status() == UT_SUCCESS)
+		ut_set_status(UT_MEANINGLESS);
+	}
+	break;
+    case CORE_LOG:
+	if (description->unit == NULL ||
+		description->unit->common.system != system ||
+		!(description->value > 1)) {
+	    problem = "Invalid logarithmic unit";
+	}
+	else {
+	    unit = logNew(description->value, description->unit);
+	}
+	break;
+    default:
+	problem = "Unknown kind of unit";
+    }
+
+    if (problem != NULL) {
+	ut_set_status(UT_BAD_ARG);
+	ut_handle_error_message("coreNewUnit(): %s", problem);
+    }
+
+    return unit;
+}
+
+/*
+ * Adds the memory of a unit that belongs to a unit-system to the memory
+ * statistics of the unit-system.  The units, product arrays, and converters
+ * that the unit owns are included.
+ *
+ * Arguments:
+ *	unit	Pointer to the unit or NULL.
+ *	stats	Pointer to the statistics to be augmented.
+ */
+void
+coreAddUnitMemory(
+    const ut_unit* const	unit,
+    ut_memory_stats* const	stats)
+{
+    /*
+     * The dimensionless unit one is shared by its clones and is counted once
+     * by coreGetSystemMemory().
+     */
+    if (unit != NULL && unit != unit->common.system->one) {
+	size_t	size;
+
+	stats->converters.bytes +=
+	    cvGetMemory(unit->common.toProduct, &stats->converters.count) +
+	    cvGetMemory(unit->common.fromProduct, &stats->converters.count);
+
+	switch (unit->common.type) {
+	case BASIC:
+	    size = sizeof(BasicUnit);
+	    coreAddUnitMemory((const ut_unit*)unit->basic.product, stats);
+	    break;
+	case PRODUCT:
+	    size = sizeof(ProductUnit);
+
+	    if (unit->product.count > 0) {
+		stats->products.bytes += 2*sizeof(short)*unit->product.count;
+		stats->products.count++;
+	    }
+	    break;
+	case GALILEAN:
+	    size = sizeof(GalileanUnit);
+	    coreAddUnitMemory(unit->galilean.unit, stats);
+	    break;
+	case TIMESTAMP:
+	    size = sizeof(TimestampUnit);
+	    coreAddUnitMemory(unit->timestamp.unit, stats);
+	    break;
+	default:
+	    assert(IS_LOG(unit));
+	    size = sizeof(LogUnit);
+	    coreAddUnitMemory(unit->log.reference, stats);
+	}
+
+	stats->units.bytes += size;
+	stats->units.count++;
+    }
+}
+
+
+/*
+ * Adds the memory that the unit-core module owns for a unit-system -- the
+ * unit-system itself, its basic-units, its dimensionless unit one, and its
+ * second -- to the memory statistics of the unit-system.
+ *
+ * Arguments:
+ *	system	Pointer to the unit-system.  Shall not be NULL.
+ *	stats	Pointer to the statistics to be augmented.
+ */
+void
+coreGetSystemMemory(
+    const ut_system* const	system,
+    ut_memory_stats* const	stats)
+{
+    assert(system != NULL);
+
+    stats->system.bytes += sizeof(ut_system);
+    stats->system.count++;
+
+    /*
+     * The basic-units and second of an overlay belong to its base.
+     */
+    if (system->base == NULL) {
+	int	i;
+
+	stats->system.bytes += sizeof(BasicUnit*)*system->basicCount;
+
+	for (i = 0; i < system->basicCount; i++)
+	    coreAddUnitMemory((const ut_unit*)system->basicUnits[i], stats);
+    }
+
+    if (system->base == NULL || system->second != system->base->second)
+	coreAddUnitMemory(system->second, stats);
+
+    stats->units.bytes += sizeof(ProductUnit);
+    stats->units.count++;
+    stats->converters.bytes +=
+	cvGetMemory(system->one->common.toProduct, &stats->converters.count) +
+	cvGetMemory(system->one->common.fromProduct, &stats->converters.count);
+}
+
+
 /*
  * Returns a unit equivalent to another unit scaled by a numeric factor,
  * e.g.,
@@ -3511,6 +4560,7 @@ ut_multiply(
     const ut_unit* const	unit2)
 {
     ut_unit*	result = NULL;	/* failure */
+    ut_system*	system;
 
     ut_set_status(UT_SUCCESS);
 
@@ -3518,13 +4568,17 @@ ut_multiply(
 	ut_set_status(UT_BAD_ARG);
 	ut_handle_error_message("ut_multiply(): NULL argument");
     }
-    else if (unit1->common.system != unit2->common.system) {
+    else if ((system = commonSystem(unit1->common.system,
+	    unit2->common.system)) == NULL) {
 	ut_set_status(UT_NOT_SAME_SYSTEM);
 	ut_handle_error_message(
             "ut_multiply(): Units in different unit-systems");
     }
     else {
 	result = MULTIPLY(unit1, unit2);
+
+	if (result != NULL && result->common.system != system)
+	    result = coreAdoptUnit(system, result);
     }
 
     return result;
@@ -3579,6 +4633,7 @@ ut_divide(
     const ut_unit* const	denom)
 {
     ut_unit*	result = NULL;		/* failure */
+    ut_system*	system;
 
     ut_set_status(UT_SUCCESS);
 
@@ -3586,7 +4641,8 @@ ut_divide(
 	ut_set_status(UT_BAD_ARG);
 	ut_handle_error_message("ut_divide(): NULL argument");
     }
-    else if (numer->common.system != denom->common.system) {
+    else if ((system = commonSystem(numer->common.system,
+	    denom->common.system)) == NULL) {
 	ut_set_status(UT_NOT_SAME_SYSTEM);
 	ut_handle_error_message("ut_divide(): Units in different unit-systems");
     }
@@ -3596,6 +4652,9 @@ ut_divide(
 	if (inverse != NULL) {
 	    result = MULTIPLY(numer, inverse);
 
+	    if (result != NULL && result->common.system != system)
+		result = coreAdoptUnit(system, result);
+
 	    ut_free(inverse);
 	}
     }
@@ -3787,7 +4846,8 @@ ut_are_convertible(
 	ut_set_status(UT_BAD_ARG);
 	ut_handle_error_message("ut_are_convertible(): NULL unit argument");
     }
-    else if (unit1->common.system != unit2->common.system) {
+    else if (commonSystem(unit1->common.system, unit2->common.system)
+	    == NULL) {
 	ut_set_status(UT_NOT_SAME_SYSTEM);
 	ut_handle_error_message(
 	    "ut_are_convertible(): Units in different unit-systems");
@@ -3845,7 +4905,7 @@ ut_get_converter(
 	ut_set_status(UT_BAD_ARG);
 	ut_handle_error_message("ut_get_converter(): NULL unit argument");
     }
-    else if (from->common.system != to->common.system) {
+    else if (commonSystem(from->common.system, to->common.system) == NULL) {
 	ut_set_status(UT_NOT_SAME_SYSTEM);
 	ut_handle_error_message(
 	    "ut_get_converter(): Units in different unit-systems");
@@ -0,0 +1,295 @@
+/*
+ * Copyright 2020 University Corporation for Atmospheric Research
+ *
+ * This file is part of the UDUNITS-2 package.  See the file COPYRIGHT
+ * in the top-level source-directory of the package for copying and
+ * redistribution conditions.
+ */
+/*
+ * Library-internal functions of the unit-core module.
+ */
+#ifndef UT_UNITCORE_H_INCLUDED
+#define UT_UNITCORE_H_INCLUDED
+
+#include "udunits2.h"
+
+#include <stdint.h>
+
+/*
+ * Identifiers of the maps that other modules associate with a unit-system.
+ */
+typedef enum {
+    SYSTEM_NAME_TO_UNIT = 0,	/* idToUnitMap.c */
+    SYSTEM_SYMBOL_TO_UNIT,	/* idToUnitMap.c */
+    SYSTEM_UNIT_TO_NAME,	/* unitToIdMap.c */
+    SYSTEM_UNIT_TO_SYMBOL,	/* unitToIdMap.c */
+    SYSTEM_NAME_PREFIXES,	/* prefix.c */
+    SYSTEM_SYMBOL_PREFIXES,	/* prefix.c */
+    SYSTEM_DEFERRED_UNITS,	/* lazyUnits.c */
+    SYSTEM_FORMAT_CACHE,	/* formatCache.c */
+    SYSTEM_MAP_COUNT
+} SystemMapId;
+
+/*
+ * Kinds of units (see coreDescribeUnit()).
+ */
+typedef enum {
+    CORE_BASIC = 0,
+    CORE_PRODUCT,
+    CORE_GALILEAN,
+    CORE_TIMESTAMP,
+    CORE_LOG
+} CoreUnitKind;
+
+/*
+ * The structure of a unit: enough to re-create it in a unit-system with the
+ * same basic-units.
+ */
+typedef struct {
+    CoreUnitKind	kind;
+    int			index;		/* basic: index in the unit-system */
+    int			isDimensionless;/* basic */
+    int			count;		/* product: number of basic-units */
+    const short*	indexes;	/* product: increasing basic-unit indexes */
+    const short*	powers;		/* product: non-zero powers */
+    const ut_unit*	unit;		/* galilean, timestamp: underlying unit;
+					 * log: reference unit */
+    double		value;		/* galilean: scale; timestamp: origin;
+					 * log: base */
+    double		offset;		/* galilean */
+} CoreUnitDescription;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ * Returns the unit-system that a unit-system overlays.
+ *
+ * Arguments:
+ *	system		Pointer to the unit-system.  Shall not be NULL.
+ * Returns:
+ *	NULL		"system" doesn't overlay a unit-system.
+ *	else		Pointer to the overlaid unit-system.
+ */
+const ut_system*
+coreGetBaseSystem(
+    const ut_system* const	system);
+
+
+/*
+ * Makes a unit belong to a unit-system that overlays, directly or indirectly,
+ * the unit-system to which the unit belongs.
+ *
+ * Arguments:
+ *	system		Pointer to the unit-system.  Shall not be NULL.
+ *	unit		Pointer to a unit that the client owns.  Shall not be
+ *			NULL.
+ * Returns:
+ *	Pointer to the unit.  It will differ from "unit" if "unit" is the
+ *	dimensionless unit one of another unit-system.
+ */
+ut_unit*
+coreAdoptUnit(
+    const ut_system* const	system,
+    ut_unit* const		unit);
+
+
+/*
+ * Returns the address of the slot in a unit-system that holds one of the maps
+ * that other modules associate with the unit-system.  The slot is NULL until
+ * the owning module sets it and must be cleared by that module's part of
+ * ut_free_system().
+ *
+ * Arguments:
+ *	system	Pointer to the unit-system.  Shall not be NULL.
+ *	id	Identifier of the map.
+ * Returns:
+ *	Address of the map-slot.
+ */
+void**
+coreGetSystemMap(
+    const ut_system* const	system,
+    const SystemMapId		id);
+
+
+/*
+ * Returns the hash-value of a unit.  Units of the same unit-system for which
+ * ut_compare() returns 0 have the same hash-value.
+ *
+ * Arguments:
+ *	unit	Pointer to the unit.  Shall not be NULL.
+ * Returns:
+ *	The hash-value of "unit".
+ */
+uint64_t
+coreHash(
+    const ut_unit* const	unit);
+
+
+/*
+ * Returns the number of basic-units of a unit-system.
+ *
+ * Arguments:
+ *	system	Pointer to the unit-system.  Shall not be NULL.
+ * Returns:
+ *	The number of basic-units in "system".
+ */
+int
+coreGetBasicCount(
+    const ut_system* const	system);
+
+
+/*
+ * Returns a basic-unit of a unit-system.
+ *
+ * Arguments:
+ *	system	Pointer to the unit-system.  Shall not be NULL.
+ *	index	Index of the basic-unit.  Shall be less than
+ *		coreGetBasicCount(system).
+ * Returns:
+ *	Pointer to the basic-unit.  It belongs to "system".
+ */
+const ut_unit*
+coreGetBasicUnit(
+    const ut_system* const	system,
+    const int			index);
+
+
+/*
+ * Returns the "second" unit of a unit-system.
+ *
+ * Arguments:
+ *	system	Pointer to the unit-system.  Shall not be NULL.
+ * Returns:
+ *	NULL	The second unit of "system" isn't set.
+ *	else	Pointer to the second unit.  It belongs to "system".
+ */
+const ut_unit*
+coreGetSecond(
+    const ut_system* const	system);
+
+
+/*
+ * Describes the structure of a unit.
+ *
+ * Arguments:
+ *	unit		Pointer to the unit.  Shall not be NULL.
+ *	description	Pointer to the description to be set.  Its pointers
+ *			refer to "unit" and are valid while "unit" is.
+ */
+void
+coreDescribeUnit(
+    const ut_unit* const	unit,
+    CoreUnitDescription* const	description);
+
+
+/*
+ * Returns a new unit from its description (see coreDescribeUnit()).
+ *
+ * Arguments:
+ *	system		Pointer to the unit-system of the new unit.  Shall not
+ *			be NULL.
+ *	description	Pointer to the description of the unit.
+ * Returns:
+ *	NULL		Failure.  "ut_get_status()" will be UT_BAD_ARG,
+ *			UT_OS, UT_MEANINGLESS, or UT_NO_SECOND.
+ *	else		Pointer to the new unit.
+ */
+ut_unit*
+coreNewUnit(
+    ut_system* const			system,
+    const CoreUnitDescription* const	description);
+
+
+/*
+ * Frees resources associated with a unit-system by the unit-core module.
+ *
+ * Arguments:
+ *	system		Pointer to the unit-system.
+ */
+void
+coreFreeSystem(
+    ut_system*	system);
+
+
+/*
+ * Initializes the lazily-created state of a unit so that subsequent use of the
+ * unit doesn't modify it.
+ *
+ * Arguments:
+ *	unit	Pointer to the unit.  Shall not be NULL.
+ * Returns:
+ *	UT_SUCCESS	Success.
+ *	else		Failure.
+ */
+ut_status
+coreInitUnit(
+    ut_unit* const	unit);
+
+
+/*
+ * Freezes the part of a unit-system that the unit-core module owns.
+ *
+ * Arguments:
+ *	system		Pointer to the unit-system.  Shall not be NULL.
+ * Returns:
+ *	UT_SUCCESS	Success.
+ *	else		Failure.  The unit-system isn't frozen.
+ */
+ut_status
+coreFreezeSystem(
+    ut_system* const	system);
+
+
+/*
+ * Indicates whether a unit-system is frozen (see ut_freeze_system()).  The
+ * modules that own parts of a unit-system reject changes to a frozen one with
+ * UT_FROZEN.
+ *
+ * Arguments:
+ *	system		Pointer to the unit-system.  Shall not be NULL.
+ * Returns:
+ *	0		The unit-system may be modified.
+ *	else		The unit-system is frozen.
+ */
+int
+coreIsFrozen(
+    const ut_system* const	system);
+
+
+/*
+ * Adds the memory of a unit that belongs to a unit-system to the memory
+ * statistics of the unit-system (see ut_get_memory_stats()).  The units,
+ * product arrays, and converters that the unit owns are included.
+ *
+ * Arguments:
+ *	unit	Pointer to the unit or NULL.
+ *	stats	Pointer to the statistics to be augmented.
+ */
+void
+coreAddUnitMemory(
+    const ut_unit* const	unit,
+    ut_memory_stats* const	stats);
+
+
+/*
+ * Adds the memory that the unit-core module owns for a unit-system to the
+ * memory statistics of the unit-system.
+ *
+ * Arguments:
+ *	system	Pointer to the unit-system.  Shall not be NULL.
+ *	stats	Pointer to the statistics to be augmented.
+ */
+void
+coreGetSystemMemory(
+    const ut_system* const	system,
+    ut_memory_stats* const	stats);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,186 @@
+/*
+ * Copyright 2020 University Corporation for Atmospheric Research
+ *
+ * This file is part of the UDUNITS-2 package.  See the file COPYRIGHT
+ * in the top-level source-directory of the package for copying and
+ * redistribution conditions.
+ */
+/*
+ * The process-wide, shared, reference-counted default unit-system.  Each
+ * acquisition gets its own token, so a reference can be released only once.
+ *
+ * This module is thread-safe.
+ */
+
+/*LINTLIBRARY*/
+
+#include "config.h"
+
+#include "udunits2.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+
+static SRWLOCK		lock = SRWLOCK_INIT;
+#   define LOCK()	AcquireSRWLockExclusive(&lock)
+#   define UNLOCK()	ReleaseSRWLockExclusive(&lock)
+#else
+#include <pthread.h>
+
+static pthread_mutex_t	lock = PTHREAD_MUTEX_INITIALIZER;
+#   define LOCK()	(void)pthread_mutex_lock(&lock)
+#   define UNLOCK()	(void)pthread_mutex_unlock(&lock)
+#endif
+
+static ut_system*	defaultSystem;	/* guarded by "lock" */
+static unsigned long*	tokens;		/* unreleased references; guarded by
+					 * "lock" */
+static size_t		tokenCount;	/* guarded by "lock" */
+static size_t		tokenCapacity;	/* guarded by "lock" */
+static unsigned long	lastToken;	/* guarded by "lock" */
+
+
+/*
+ * Returns a reference to the shared default unit-system.  The first
+ * acquisition reads the default unit database via ut_read_xml(NULL) and freezes
+ * the result; later ones return the same unit-system.  Each successful call
+ * shall be matched by one call to ut_release_default_system() with the
+ * returned unit-system and token.
+ *
+ * Arguments:
+ *	token	Pointer to the token of the reference.  Set upon success.
+ *		Every acquisition gets a different token.
+ * Returns:
+ *	NULL	Failure.  "ut_get_status()" will be
+ *		    UT_BAD_ARG	"token" is NULL.
+ *		    UT_OS	Operating-system error.  See "errno".
+ *		    else	As for ut_read_xml() or ut_freeze_system().
+ *	else	Pointer to the frozen default unit-system.  It shall not be
+ *		passed to ut_free_system().
+ */
+ut_system*
+ut_acquire_default_system(
+    unsigned long* const	token)
+{
+    ut_system*	system = NULL;
+
+    ut_set_status(UT_SUCCESS);
+
+    if (token == NULL) {
+	ut_set_status(UT_BAD_ARG);
+	ut_handle_error_message(
+	    "ut_acquire_default_system(): NULL token argument");
+	return NULL;
+    }
+
+    LOCK();
+
+    if (tokenCount == tokenCapacity) {
+	const size_t		capacity =
+	    tokenCapacity == 0 ? 8 : 2 * tokenCapacity;
+	unsigned long* const	newTokens = (unsigned long*)realloc(tokens,
+	    capacity * sizeof(unsigned long));
+
+	if (newTokens == NULL) {
+	    ut_set_status(UT_OS);
+	    ut_handle_error_message(strerror(errno));
+	    ut_handle_error_message(
+		"ut_acquire_default_system(): Couldn't allocate token");
+	}
+	else {
+	    tokens = newTokens;
+	    tokenCapacity = capacity;
+	}
+    }
+
+    if (tokenCount < tokenCapacity) {
+	if (defaultSystem == NULL) {
+	    ut_system* const	newSystem = ut_read_xml(NULL);
+
+	    if (newSystem != NULL) {
+		if (ut_freeze_system(newSystem) == UT_SUCCESS) {
+		    defaultSystem = newSystem;
+		}
+		else {
+		    const ut_status	status = ut_get_status();
+
+		    ut_free_system(newSystem);
+		    ut_set_status(status);
+		}
+	    }
+	}
+
+	if (defaultSystem != NULL) {
+	    if (++lastToken == 0)
+		lastToken = 1;
+	    tokens[tokenCount++] = lastToken;
+	    *token = lastToken;
+	    system = defaultSystem;
+	}
+    }
+
+    UNLOCK();
+
+    return system;
+}
+
+
+/*
+ * Releases a reference to the shared default unit-system.  The unit-system is
+ * freed when its last reference is released; units obtained from it shall not
+ * be used afterwards.  A release whose token isn't that of an unreleased
+ * reference is rejected.  This includes a second release of the same reference
+ * and a release of a reference to a default unit-system that has since been
+ * freed, even if a new one has been read at the same address.
+ *
+ * Arguments:
+ *	system		Pointer to the unit-system returned by
+ *			ut_acquire_default_system().
+ *	token		The token returned with "system" by
+ *			ut_acquire_default_system().
+ * Returns:
+ *	UT_SUCCESS	Success.
+ *	UT_BAD_ARG	"system" and "token" aren't an unreleased reference to
+ *			the current shared default unit-system.
+ */
+ut_status
+ut_release_default_system(
+    ut_system* const		system,
+    const unsigned long		token)
+{
+    size_t	i = 0;
+
+    ut_set_status(UT_SUCCESS);
+    LOCK();
+
+    if (system != NULL && system == defaultSystem) {
+	while (i < tokenCount && tokens[i] != token)
+	    i++;
+    }
+
+    if (system == NULL || system != defaultSystem || i == tokenCount) {
+	ut_set_status(UT_BAD_ARG);
+	ut_handle_error_message(
+	    "ut_release_default_system(): Not an unreleased reference to the "
+	    "current default unit-system");
+    }
+    else {
+	tokens[i] = tokens[--tokenCount];
+
+	if (tokenCount == 0) {
+	    ut_free_system(defaultSystem);
+	    defaultSystem = NULL;
+	    free(tokens);
+	    tokens = NULL;
+	    tokenCapacity = 0;
+	}
+    }
+
+    UNLOCK();
+
+    return ut_get_status();
+}
@@ -11,10 +11,12 @@
 #include "config.h"
 
 #include "udunits2.h"
+#include "formatCache.h"
 #include "idToUnitMap.h"
+#include "lazyUnits.h"
+#include "prefix.h"
 #include "unitToIdMap.h"
-
-extern void coreFreeSystem(ut_system* system);
+#include "unitcore.h"
 
 
 /*
@@ -30,8 +32,11 @@ ut_free_system(
     ut_system*	system)
 {
     if (system != NULL) {
+	fcFreeSystem(system);
+	luFreeSystem(system);
 	itumFreeSystem(system);
 	utimFreeSystem(system);
+	utFreeSystemPrefixes(system);
 	coreFreeSystem(system);
     }
 }
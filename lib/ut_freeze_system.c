@@ -0,0 +1,60 @@
+/*
+ * Copyright 2020 University Corporation for Atmospheric Research
+ *
+ * This file is part of the UDUNITS-2 package.  See the file COPYRIGHT
+ * in the top-level source-directory of the package for copying and
+ * redistribution conditions.
+ */
+
+/*LINTLIBRARY*/
+
+#include "config.h"
+
+#include "udunits2.h"
+#include "idToUnitMap.h"
+#include "lazyUnits.h"
+#include "unitcore.h"
+
+
+/*
+ * Freezes a unit-system.  All lazily-created state of the unit-system and of
+ * the units that its identifiers map to is created -- including the units of
+ * deferred definitions (see ut_read_xml_lazy()) -- and all subsequent attempts
+ * to modify the unit-system fail with UT_FROZEN.  Afterwards, any number of
+ * threads may concurrently parse, look up, convert, and format units of the
+ * unit-system without synchronization.  Freezing a frozen unit-system has no
+ * effect.
+ *
+ * Arguments:
+ *	system		Pointer to the unit-system to be frozen.
+ * Returns:
+ *	UT_SUCCESS	Success.
+ *	UT_BAD_ARG	"system" is NULL.
+ *	UT_OS		Operating-system error.  See "errno".  The
+ *			unit-system isn't frozen.
+ *	UT_PARSE	A deferred unit-definition couldn't be parsed.  The
+ *			unit-system isn't frozen.
+ */
+ut_status
+ut_freeze_system(
+    ut_system* const	system)
+{
+    ut_set_status(UT_SUCCESS);
+
+    if (system == NULL) {
+	ut_set_status(UT_BAD_ARG);
+	ut_handle_error_message("ut_freeze_system(): NULL unit-system argument");
+    }
+    else if (!coreIsFrozen(system)) {
+	ut_status	status = luFreezeSystem(system);
+
+	if (status == UT_SUCCESS)
+	    status = itumFreezeSystem(system);
+	if (status == UT_SUCCESS)
+	    status = coreFreezeSystem(system);
+
+	ut_set_status(status);
+    }
+
+    return ut_get_status();
+}
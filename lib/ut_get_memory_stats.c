@@ -0,0 +1,63 @@
+/*
+ * Copyright 2020 University Corporation for Atmospheric Research
+ *
+ * This file is part of the UDUNITS-2 package.  See the file COPYRIGHT
+ * in the top-level source-directory of the package for copying and
+ * redistribution conditions.
+ */
+
+/*LINTLIBRARY*/
+
+#include "config.h"
+
+#include "udunits2.h"
+#include "formatCache.h"
+#include "idToUnitMap.h"
+#include "lazyUnits.h"
+#include "prefix.h"
+#include "unitToIdMap.h"
+#include "unitcore.h"
+
+#include <string.h>
+
+
+/*
+ * Returns where the memory of a unit-system goes.  Each module that owns part
+ * of the unit-system adds the memory of that part.
+ *
+ * Arguments:
+ *	system		Pointer to the unit-system.
+ *	stats		Pointer to the statistics to be set.
+ * Returns:
+ *	UT_SUCCESS	Success.
+ *	UT_BAD_ARG	"system" or "stats" is NULL.
+ */
+ut_status
+ut_get_memory_stats(
+    const ut_system* const	system,
+    ut_memory_stats* const	stats)
+{
+    ut_set_status(UT_SUCCESS);
+
+    if (system == NULL || stats == NULL) {
+	ut_set_status(UT_BAD_ARG);
+	ut_handle_error_message("ut_get_memory_stats(): NULL argument");
+    }
+    else {
+	(void)memset(stats, 0, sizeof(*stats));
+
+	coreGetSystemMemory(system, stats);
+	itumGetMemory(system, stats);
+	utimGetMemory(system, stats);
+	utGetPrefixMemory(system, stats);
+	luGetMemory(system, stats);
+	fcGetMemory(system, stats);
+
+	stats->total = stats->system.bytes + stats->units.bytes +
+	    stats->products.bytes + stats->converters.bytes +
+	    stats->idMaps.bytes + stats->prefixes.bytes +
+	    stats->deferred.bytes + stats->formats.bytes;
+    }
+
+    return ut_get_status();
+}
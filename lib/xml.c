@@ -6,8 +6,9 @@
  * redistribution conditions.
  */
 /*
- * This module is thread-compatible but not thread-safe.  Multi-threaded
- * access must be externally synchronized.
+ * The state of a read is thread-local, so different threads may read unit
+ * databases concurrently.  Modifying a unit-system that's shared by threads
+ * must be externally synchronized.
  */
 
 /*LINTLIBRARY*/
@@ -32,6 +33,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #ifndef _MSC_VER
 #include <strings.h>
 #include <unistd.h>
@@ -47,6 +49,17 @@
 #include <windows.h>
 #endif
 #include <expat.h>
+#ifndef _WIN32
+#include <pthread.h>
+#include <sys/mman.h>
+#endif
+
+#include "lazyUnits.h"
+
+#ifdef UT_EMBEDDED_DATABASE
+#include "binary.h"
+#include "embeddedDatabase.h"
+#endif
 
 #ifndef DLL_UDUNITS2
 #   define XML_STATIC
@@ -58,9 +71,11 @@
 
 #define NAME_SIZE 128
 #define ACCUMULATE_TEXT \
-    XML_SetCharacterDataHandler(currFile->parser, accumulateText)
+    (currFile->accumulate = 1)
 #define IGNORE_TEXT \
-    XML_SetCharacterDataHandler(currFile->parser, NULL)
+    (currFile->accumulate = 0)
+#define HAVE_UNIT \
+    (currFile->unit != NULL || currFile->lazy != NULL)
 
 typedef enum {
     START,
@@ -72,18 +87,77 @@ typedef enum {
     ALIAS_NAME
 } ElementType;
 
+/*
+ * An event of a recorded XML file (see recordXml()).
+ */
+typedef enum {
+    EVENT_DECL,                         /* XML declaration; string is encoding */
+    EVENT_START,                        /* start-tag; string is element name */
+    EVENT_END,                          /* end-tag; string is element name */
+    EVENT_TEXT                          /* character data */
+} EventType;
+
+typedef struct {
+    EventType   type;
+    int         line;
+    int         column;
+    int         length;                 /* number of bytes of text */
+    size_t      offset;                 /* of NUL-terminated string in "strings" */
+} Event;
+
+/*
+ * The XML events of a file in document order.  Recording a file involves only
+ * the file and expat, so files can be recorded concurrently; the unit-system
+ * is modified only when the events are replayed (see replayXml()).
+ */
+typedef struct {
+    Event*      events;
+    size_t      count;
+    size_t      capacity;
+    char*       strings;
+    size_t      size;
+    size_t      stringCapacity;
+    ut_status   status;                 /* UT_SUCCESS, UT_OPEN_ARG, UT_OS, or
+                                           UT_PARSE */
+    int         errnum;                 /* "errno" if UT_OPEN_ARG or UT_OS */
+    enum XML_Error xmlError;            /* if UT_PARSE */
+    int         line;                   /* of error */
+    int         column;                 /* of error */
+    size_t      nread;                  /* number of bytes read */
+    double      readTime;               /* seconds spent reading the file */
+    double      xmlTime;                /* seconds spent in expat */
+} Recording;
+
+/*
+ * A file whose recording was started concurrently before it's needed.
+ */
+typedef struct Prefetch {
+    struct Prefetch*    next;
+    char*               path;
+    Recording           recording;
+    int                 started;        /* recording thread was started */
+#ifndef _WIN32
+    pthread_t           thread;
+#endif
+} Prefetch;
+
 typedef struct {
     const char* path;
+    const char* base;                   /* directory of "path" */
     char	singular[NAME_SIZE];
     char	plural[NAME_SIZE];
     char        symbol[NAME_SIZE];
     double      value;
-    XML_Parser  parser;
+    Prefetch*   prefetch;               /* recordings of imported files */
     ut_unit*	unit;
+    LazyUnit*   lazy;                   /* deferred unit of <def> */
     ElementType context;
     ut_encoding xmlEncoding;
     ut_encoding textEncoding;
-    int         fd;
+    int         line;                   /* of current event */
+    int         column;                 /* of current event */
+    int         accumulate;             /* accumulate text? */
+    int         stopped;                /* stop replaying? */
     int         skipDepth;
     int		prefixAdded;
     int         haveValue;
@@ -105,35 +179,107 @@ typedef struct {
 static ut_status readXml(
     const char* const   path);
 
-static File*            currFile = NULL;
-static ut_system*	unitSystem = NULL;
-static char*            text = NULL;
-static size_t           nbytes = 0; /// Number of characters excluding NUL
+#ifndef UT_THREAD_LOCAL
+#   define UT_THREAD_LOCAL
+#endif
 
+/*
+ * State of the calling thread's read.  Reads by different threads are
+ * independent.
+ */
+static UT_THREAD_LOCAL File*            currFile = NULL;
+static UT_THREAD_LOCAL ut_system*       unitSystem = NULL;
+static UT_THREAD_LOCAL int              deferDefinitions = 0; /* see ut_read_xml_lazy() */
+static UT_THREAD_LOCAL char*            text = NULL;
+static UT_THREAD_LOCAL size_t           nbytes = 0; /// Number of characters excluding NUL
+static UT_THREAD_LOCAL size_t           textCapacity = 0; /// Size of "text" in bytes
 
 /*
- * Returns the plural form of a name.
+ * Statistics of the calling thread's most recent read (see
+ * ut_get_read_stats()).
+ */
+static UT_THREAD_LOCAL ut_read_stats    readStats;
+
+
+/*
+ * Returns a monotonic wall-clock time in seconds.
+ */
+static double
+wallTime(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER       frequency;
+    LARGE_INTEGER       counter;
+
+    (void)QueryPerformanceFrequency(&frequency);
+    (void)QueryPerformanceCounter(&counter);
+
+    return (double)counter.QuadPart / frequency.QuadPart;
+#else
+    struct timespec     now;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec + now.tv_nsec * 1e-9;
+#endif
+}
+
+
+/*
+ * Adds one unit of work to a phase of the current read.
+ *
+ * Arguments:
+ *      phase           Pointer to the phase.
+ *      start           Value of wallTime() when the work started.
+ */
+static void
+phaseAdd(
+    ut_phase_stats* const       phase,
+    const double                start)
+{
+    phase->seconds += wallTime() - start;
+    phase->count++;
+}
+
+
+/*
+ * Stops the replay of the current XML file, if any.
+ */
+static void
+stopParsing(void)
+{
+    if (currFile != NULL)
+        currFile->stopped = 1;
+}
+
+
+/*
+ * Forms the plural of a name in a caller-supplied buffer.
  *
  * Arguments:
  *      singular        Pointer to the singular form of a name.
+ *      buf             Pointer to the output buffer.
+ *      size            Size of "buf" in bytes.
  * Returns:
- *      Pointer to the plural form of "singular".  Client must not free.  May be
- *      overwritten by subsequent calls.
+ *      NULL            Failure.  "ut_get_status()" will be
+ *          UT_SYNTAX   "singular" is too long for "buf".
+ *      else            Pointer to the plural form of "singular" (i.e., "buf").
  */
-const char*
-ut_form_plural(
-    const char*	singular)
+static const char*
+formPlural(
+    const char* const   singular,
+    char* const         buf,
+    const size_t        size)
 {
-    static char	buf[NAME_SIZE];
     const char*	plural = NULL;		/* failure */
 
     if (singular != NULL) {
         size_t length = strlen(singular);
 
-	if (length + 3 >= sizeof(buf)) {
+	if (length + 3 >= size) {
             ut_set_status(UT_SYNTAX);
 	    ut_handle_error_message("Singular form is too long");
-	    XML_StopParser(currFile->parser, 0);
+	    stopParsing();
 	}
 	else if (length > 0) {
 	    (void)strcpy(buf, singular);
@@ -177,6 +323,25 @@ ut_form_plural(
 }
 
 
+/*
+ * Returns the plural form of a name.
+ *
+ * Arguments:
+ *      singular        Pointer to the singular form of a name.
+ * Returns:
+ *      Pointer to the plural form of "singular".  Client must not free.  May be
+ *      overwritten by subsequent calls from the same thread.
+ */
+const char*
+ut_form_plural(
+    const char*	singular)
+{
+    static UT_THREAD_LOCAL char buf[NAME_SIZE];
+
+    return formPlural(singular, buf, sizeof(buf));
+}
+
+
 /*
  * Substitutes one substring for all occurrences another in a string.
  *
@@ -475,6 +640,7 @@ makeDerivatives(
     Identifiers*        ids)
 {
     int                 success = 1;
+    const double        start = wallTime();
 
     assert(id != NULL);
     assert(ids != NULL);
@@ -525,6 +691,8 @@ makeDerivatives(
         }
     }
 
+    phaseAdd(&readStats.derive, start);
+
     return success;
 }
 
@@ -551,6 +719,7 @@ mapUnitToId(
     int                 success = 0;             /* failure */
     ut_status           (*func)(const ut_unit*, const char*, ut_encoding);
     const char*         desc;
+    const double        start = wallTime();
 
     if (isName) {
         func = ut_map_unit_to_name;
@@ -561,7 +730,9 @@ mapUnitToId(
         desc = "symbol";
     }
 
-    if (func(unit, id, encoding) != UT_SUCCESS) {
+    if ((currFile->lazy != NULL
+                ? luMapUnitToId(currFile->lazy, id, encoding, isName)
+                : func(unit, id, encoding)) != UT_SUCCESS) {
         ut_set_status(UT_PARSE);
         ut_handle_error_message("Couldn't map unit to %s \"%s\"", desc, id);
     }
@@ -569,6 +740,8 @@ mapUnitToId(
         success = 1;
     }
 
+    phaseAdd(&readStats.map, start);
+
     return success;
 }
 
@@ -679,49 +852,75 @@ mapIdToUnit(
     const int	        isName)
 {
     int		success = 0;		/* failure */
-    ut_unit*	prev = ut_get_unit_by_name(unitSystem, id);
+    ut_unit*	prev = NULL;
+    const char*	deferred = NULL;
+    const double	start = wallTime();
 
-    if (prev == NULL)
-	prev = ut_get_unit_by_symbol(unitSystem, id);
+    /*
+     * Deferred units are checked first so that the check doesn't resolve them.
+     */
+    if (deferDefinitions) {
+        deferred = luGetDefinition(unitSystem, SYSTEM_NAME_TO_UNIT, id);
+
+        if (deferred == NULL)
+            deferred = luGetDefinition(unitSystem, SYSTEM_SYMBOL_TO_UNIT, id);
+    }
+
+    if (deferred == NULL) {
+        prev = ut_get_unit_by_name(unitSystem, id);
 
-    if (prev != NULL) {
+        if (prev == NULL)
+            prev = ut_get_unit_by_symbol(unitSystem, id);
+    }
+
+    if (prev != NULL || deferred != NULL) {
 	char	buf[128];
-	int	nchar = ut_format(prev, buf, sizeof(buf),
+	int	nchar = prev == NULL ? -1 : ut_format(prev, buf, sizeof(buf),
 	    UT_ASCII | UT_DEFINITION | UT_NAMES);
 
         ut_set_status(UT_PARSE);
 	ut_handle_error_message(
 	    "Duplicate definition for \"%s\" at \"%s\":%d", id,
-            currFile->path, XML_GetCurrentLineNumber(currFile->parser));
+            currFile->path, currFile->line);
 
-	if (nchar < 0)
+	if (nchar < 0 && prev != NULL)
 	    nchar =
                 ut_format(prev, buf, sizeof(buf), UT_ASCII | UT_DEFINITION);
 
-	if (nchar >= 0 && nchar < sizeof(buf)) {
+	if (deferred != NULL) {
+            ut_set_status(UT_PARSE);
+	    ut_handle_error_message("Previous definition was \"%s\"",
+                deferred);
+	}
+	else if (nchar >= 0 && nchar < sizeof(buf)) {
 	    buf[nchar] = 0;
 
             ut_set_status(UT_PARSE);
 	    ut_handle_error_message("Previous definition was \"%s\"", buf);
 	}
 
-        XML_StopParser(currFile->parser, 0);
+        stopParsing();
     }
     else {
 	/*
 	 * Take prefixes into account for a prior definition by using
-         * ut_parse().
+         * ut_parse().  Not done when deferring definitions because the parse
+         * would resolve the deferred units of the prefixed identifier.
 	 */
-	prev = ut_parse(unitSystem, id, encoding);
+	if (!deferDefinitions)
+            prev = ut_parse(unitSystem, id, encoding);
 
-	if ((isName
+	if ((currFile->lazy != NULL
+                    ? luMapIdToUnit(unitSystem, currFile->lazy, id, encoding,
+                        isName)
+                    : isName
                     ? ut_map_name_to_unit(id, encoding, unit)
                     : ut_map_symbol_to_unit(id, encoding, unit))
                 != UT_SUCCESS) {
             ut_set_status(UT_PARSE);
 	    ut_handle_error_message("Couldn't map %s \"%s\" to unit",
 		isName ? "name" : "symbol", id);
-	    XML_StopParser(currFile->parser, 0);
+	    stopParsing();
 	}
 	else {
 	    if (prev != NULL) {
@@ -738,7 +937,7 @@ mapIdToUnit(
 		    ut_handle_error_message("Definition of \"%s\" in \"%s\", "
                         "line %d, overrides prefixed-unit", id,
                         currFile->path,
-			XML_GetCurrentLineNumber(currFile->parser));
+			currFile->line);
 		}
 		else {
 		    buf[nchar] = 0;
@@ -747,7 +946,7 @@ mapIdToUnit(
 		    ut_handle_error_message("Definition of \"%s\" in \"%s\", "
                         "line %d, overrides prefixed-unit \"%s\"",
                         id, currFile->path,
-                        XML_GetCurrentLineNumber(currFile->parser), buf);
+                        currFile->line, buf);
 		}
 	    }
 
@@ -757,6 +956,8 @@ mapIdToUnit(
 
     ut_free(prev);                      /* NULL safe */
 
+    phaseAdd(&readStats.map, start);
+
     return success;
 }
 
@@ -904,8 +1105,12 @@ fileInit(
     file->xmlEncoding = UT_ASCII;
     file->textEncoding = UT_ASCII;
     file->unit = NULL;
-    file->fd = -1;
-    file->parser = NULL;
+    file->lazy = NULL;
+    file->prefetch = NULL;
+    file->line = 0;
+    file->column = 0;
+    file->accumulate = 0;
+    file->stopped = 0;
     file->isBase = 0;
     file->isDimensionless = 0;
     file->haveValue = 0;
@@ -913,6 +1118,7 @@ fileInit(
     file->nameSeen = 0;
     file->symbolSeen = 0;
     file->path = NULL;
+    file->base = NULL;
     (void)memset(file->singular, 0, sizeof(file->singular));
     (void)memset(file->plural, 0, sizeof(file->plural));
     (void)memset(file->symbol, 0, sizeof(file->symbol));
@@ -944,29 +1150,48 @@ accumulateText(
     const char*		string,		/* input text in UTF-8 */
     int			len)
 {
-    char*	tmp = realloc(text, nbytes + len + 1);
+    const size_t        size = nbytes + len + 1;
 
-    if (tmp == NULL) {
-        ut_set_status(UT_OS);
-	ut_handle_error_message(strerror(errno));
-	ut_handle_error_message("Couldn't reallocate %lu-byte text buffer",
-	    nbytes+len+1);
-	XML_StopParser(currFile->parser, 0);
-    }
-    else {
-        int     i;
+    /*
+     * The buffer is reused by every element and grows geometrically, so it's
+     * rarely reallocated.
+     */
+    if (size > textCapacity) {
+        size_t  capacity = textCapacity == 0 ? 256 : textCapacity;
+        char*   tmp;
+
+        while (capacity < size)
+            capacity *= 2;
+
+        tmp = realloc(text, capacity);
+
+        if (tmp == NULL) {
+            ut_set_status(UT_OS);
+            ut_handle_error_message(strerror(errno));
+            ut_handle_error_message("Couldn't reallocate %lu-byte text buffer",
+                (unsigned long)capacity);
+            stopParsing();
+            return;
+        }
 
         text = tmp;
+        textCapacity = capacity;
+    }
 
-        for (i = 0; i < len; i++) {
-            text[nbytes++] = string[i];
+    if (currFile->textEncoding == UT_ASCII) {
+        int     i;
 
-            if (!IS_ASCII(string[i]))
+        for (i = 0; i < len; i++) {
+            if (!IS_ASCII(string[i])) {
                 currFile->textEncoding = UT_UTF8;
+                break;
+            }
         }
-
-	text[nbytes] = 0;
     }
+
+    (void)memcpy(text + nbytes, string, len);
+    nbytes += len;
+    text[nbytes] = 0;
 }
 
 
@@ -992,7 +1217,7 @@ convertText(void)
         if (*cp) {
             ut_set_status(UT_SYNTAX);
             ut_handle_error_message("Character isn't US-ASCII: %#x", *cp);
-            XML_StopParser(currFile->parser, 0);
+            stopParsing();
 
             success = 0;
         }
@@ -1018,7 +1243,7 @@ convertText(void)
                     ut_handle_error_message(
                         "Character is not representable in ISO-8859-1 "
                         "(Latin-1): %d", 1+(int)((char*)out - text));
-                    XML_StopParser(currFile->parser, 0);
+                    stopParsing();
 
                     success = 0;
 
@@ -1048,7 +1273,7 @@ startUnitSystem(
     if (currFile->context != START) {
 	ut_set_status(UT_PARSE);
 	ut_handle_error_message("Wrong place for <unit-system> element");
-	XML_StopParser(currFile->parser, 0);
+	stopParsing();
     }
 
     currFile->context = UNIT_SYSTEM;
@@ -1095,7 +1320,7 @@ endPrefix(
     if (!currFile->haveValue || !currFile->prefixAdded) {
         ut_set_status(UT_PARSE);
 	ut_handle_error_message("Prefix incompletely specified");
-	XML_StopParser(currFile->parser, 0);
+	stopParsing();
     }
     else {
 	currFile->haveValue = 0;
@@ -1116,11 +1341,12 @@ startUnit(
     if (currFile->context != UNIT_SYSTEM) {
         ut_set_status(UT_PARSE);
 	ut_handle_error_message("Wrong place for <unit> element");
-	XML_StopParser(currFile->parser, 0);
+	stopParsing();
     }
     else {
 	ut_free(currFile->unit);
 	currFile->unit = NULL;
+	currFile->lazy = NULL;
 	currFile->isBase = 0;
 	currFile->isDimensionless = 0;
         currFile->singular[0] = 0;
@@ -1145,17 +1371,18 @@ endUnit(
         if (!currFile->nameSeen) {
             ut_set_status(UT_PARSE);
             ut_handle_error_message("Base unit needs a name");
-            XML_StopParser(currFile->parser, 0);
+            stopParsing();
         }
         if (!currFile->symbolSeen) {
             ut_set_status(UT_PARSE);
             ut_handle_error_message("Base unit needs a symbol");
-            XML_StopParser(currFile->parser, 0);
+            stopParsing();
         }
     }
 
     ut_free(currFile->unit);
     currFile->unit = NULL;
+    currFile->lazy = NULL;
     currFile->context = UNIT_SYSTEM;
 }
 
@@ -1171,24 +1398,24 @@ startBase(
     if (currFile->context != UNIT) {
         ut_set_status(UT_PARSE);
 	ut_handle_error_message("Wrong place for <base> element");
-	XML_StopParser(currFile->parser, 0);
+	stopParsing();
     }
     else {
 	if (currFile->isDimensionless) {
             ut_set_status(UT_PARSE);
 	    ut_handle_error_message(
 		"<dimensionless> and <base> are mutually exclusive");
-	    XML_StopParser(currFile->parser, 0);
+	    stopParsing();
 	}
-	else if (currFile->unit != NULL) {
+	else if (HAVE_UNIT) {
             ut_set_status(UT_PARSE);
 	    ut_handle_error_message("<base> and <def> are mutually exclusive");
-	    XML_StopParser(currFile->parser, 0);
+	    stopParsing();
 	}
 	else if (currFile->isBase) {
             ut_set_status(UT_PARSE);
 	    ut_handle_error_message("<base> element already seen");
-	    XML_StopParser(currFile->parser, 0);
+	    stopParsing();
 	}
     }
 }
@@ -1206,7 +1433,7 @@ endBase(
     if (currFile->unit == NULL) {
         ut_set_status(UT_PARSE);
 	ut_handle_error_message("Couldn't create new base unit");
-	XML_StopParser(currFile->parser, 0);
+	stopParsing();
     }
     else {
 	currFile->isBase = 1;
@@ -1225,25 +1452,25 @@ startDimensionless(
     if (currFile->context != UNIT) {
         ut_set_status(UT_PARSE);
 	ut_handle_error_message("Wrong place for <dimensionless> element");
-	XML_StopParser(currFile->parser, 0);
+	stopParsing();
     }
     else {
 	if (currFile->isBase) {
             ut_set_status(UT_PARSE);
 	    ut_handle_error_message(
 		"<dimensionless> and <base> are mutually exclusive");
-	    XML_StopParser(currFile->parser, 0);
+	    stopParsing();
 	}
-	else if (currFile->unit != NULL) {
+	else if (HAVE_UNIT) {
             ut_set_status(UT_PARSE);
 	    ut_handle_error_message(
 		"<dimensionless> and <def> are mutually exclusive");
-	    XML_StopParser(currFile->parser, 0);
+	    stopParsing();
 	}
 	else if (currFile->isDimensionless) {
             ut_set_status(UT_PARSE);
 	    ut_handle_error_message("<dimensionless> element already seen");
-	    XML_StopParser(currFile->parser, 0);
+	    stopParsing();
 	}
     }
 }
@@ -1261,7 +1488,7 @@ endDimensionless(
     if (currFile->unit == NULL) {
         ut_set_status(UT_PARSE);
 	ut_handle_error_message("Couldn't create new dimensionless unit");
-	XML_StopParser(currFile->parser, 0);
+	stopParsing();
     }
     else {
 	currFile->isDimensionless = 1;
@@ -1280,24 +1507,24 @@ startDef(
     if (currFile->context != UNIT) {
         ut_set_status(UT_PARSE);
 	ut_handle_error_message("Wrong place for <def> element");
-	XML_StopParser(currFile->parser, 0);
+	stopParsing();
     }
     else if (currFile->isBase) {
         ut_set_status(UT_PARSE);
 	ut_handle_error_message(
 	    "<base> and <def> are mutually exclusive");
-	XML_StopParser(currFile->parser, 0);
+	stopParsing();
     }
     else if (currFile->isDimensionless) {
         ut_set_status(UT_PARSE);
 	ut_handle_error_message(
 	    "<dimensionless> and <def> are mutually exclusive");
-	XML_StopParser(currFile->parser, 0);
+	stopParsing();
     }
-    else if (currFile->unit != NULL) {
+    else if (HAVE_UNIT) {
         ut_set_status(UT_PARSE);
 	ut_handle_error_message("<def> element already seen");
-	XML_StopParser(currFile->parser, 0);
+	stopParsing();
     }
     else {
 	clearText();
@@ -1313,10 +1540,21 @@ static void
 endDef(
     void*		data)
 {
+    const double	start = wallTime();
+
     if (nbytes == 0) {
         ut_set_status(UT_PARSE);
 	ut_handle_error_message("Empty unit definition");
-	XML_StopParser(currFile->parser, 0);
+	stopParsing();
+    }
+    else if (deferDefinitions) {
+        currFile->lazy = luNew(unitSystem, text, currFile->textEncoding);
+
+        if (currFile->lazy == NULL) {
+	    ut_handle_error_message(
+                "Couldn't defer unit specification \"%s\"", text);
+	    stopParsing();
+        }
     }
     else {
 	currFile->unit = ut_parse(unitSystem, text, currFile->textEncoding);
@@ -1325,9 +1563,11 @@ endDef(
             ut_set_status(UT_PARSE);
 	    ut_handle_error_message(
                 "Couldn't parse unit specification \"%s\"", text);
-	    XML_StopParser(currFile->parser, 0);
+	    stopParsing();
 	}
     }
+
+    phaseAdd(&readStats.define, start);
 }
 
 
@@ -1343,7 +1583,7 @@ startName(
         if (!currFile->haveValue) {
             ut_set_status(UT_PARSE);
             ut_handle_error_message("No previous <value> element");
-            XML_StopParser(currFile->parser, 0);
+            stopParsing();
         }
         else {
             clearText();
@@ -1351,11 +1591,11 @@ startName(
         }
     }
     else if (currFile->context == UNIT || currFile->context == ALIASES) {
-        if (currFile->unit == NULL) {
+        if (!HAVE_UNIT) {
             ut_set_status(UT_PARSE);
             ut_handle_error_message(
                 "No previous <base>, <dimensionless>, or <def> element");
-            XML_StopParser(currFile->parser, 0);
+            stopParsing();
         }
         else {
             currFile->noPLural = 0;
@@ -1368,7 +1608,7 @@ startName(
     else {
         ut_set_status(UT_PARSE);
         ut_handle_error_message("Wrong place for <name> element");
-        XML_StopParser(currFile->parser, 0);
+        stopParsing();
     }
 }
 
@@ -1384,7 +1624,7 @@ endName(
 	if (!currFile->haveValue) {
             ut_set_status(UT_PARSE);
 	    ut_handle_error_message("No previous <value> element");
-	    XML_StopParser(currFile->parser, 0);
+	    stopParsing();
 	}
 	else {
 	    if (ut_add_name_prefix(unitSystem, text, currFile->value) !=
@@ -1393,7 +1633,7 @@ endName(
 		ut_handle_error_message(
 		    "Couldn't map name-prefix \"%s\" to value %g", text,
                     currFile->value);
-		XML_StopParser(currFile->parser, 0);
+		stopParsing();
 	    }
 	    else {
 		currFile->prefixAdded = 1;
@@ -1404,28 +1644,33 @@ endName(
         if (currFile->singular[0] == 0) {
             ut_set_status(UT_PARSE);
             ut_handle_error_message("<name> needs a <singular>");
-            XML_StopParser(currFile->parser, 0);
+            stopParsing();
         }
         else {
             if (!mapUnitAndName(currFile->unit, currFile->singular,
                     currFile->textEncoding)) {
-                XML_StopParser(currFile->parser, 0);
+                stopParsing();
             }
             else {
                 if (!currFile->noPLural) {
+                    char        buf[NAME_SIZE];
                     const char* plural = NULL;
 
                     if (currFile->plural[0] != 0) {
                         plural = currFile->plural;
                     }
                     else if (currFile->singular[0] != 0) {
-                        plural = ut_form_plural(currFile->singular);
+                        const double    start = wallTime();
+
+                        plural = formPlural(currFile->singular, buf,
+                                            sizeof(buf));
+                        phaseAdd(&readStats.derive, start);
 
                         if (plural == NULL) {
                             ut_set_status(UT_PARSE);
                             ut_handle_error_message("Couldn't form plural of "
                                 "\"%s\"", currFile->singular);
-                            XML_StopParser(currFile->parser, 0);
+                            stopParsing();
                         }
                     }
 
@@ -1436,15 +1681,18 @@ endName(
                          */
                         if (!mapNamesToUnit(plural, currFile->textEncoding,
                                 currFile->unit)) {
-                            XML_StopParser(currFile->parser, 0);
+                            stopParsing();
                         }
                     }
                 }                       /* <noplural/> not specified */
                 if (strcmp(currFile->singular, "second") == 0) {
-                    if (ut_set_second(currFile->unit) != UT_SUCCESS) {
+                    if (currFile->lazy != NULL) {
+                        luSetSecond(currFile->lazy);
+                    }
+                    else if (ut_set_second(currFile->unit) != UT_SUCCESS) {
                         ut_handle_error_message(
                             "Couldn't set \"second\" unit in unit-system");
-                        XML_StopParser(currFile->parser, 0);
+                        stopParsing();
                     }
                 }                       /* unit was 'second' unit */
             }                           /* unit mapped to singular name */
@@ -1457,35 +1705,40 @@ endName(
 	if (currFile->singular[0] == 0) {
             ut_set_status(UT_PARSE);
             ut_handle_error_message("<name> needs a <singular>");
-            XML_StopParser(currFile->parser, 0);
+            stopParsing();
         }
         else {
             if (!mapNamesToUnit(currFile->singular, currFile->textEncoding,
                     currFile->unit)) {
-                XML_StopParser(currFile->parser, 0);
+                stopParsing();
             }
 
             if (!currFile->noPLural) {
+                char        buf[NAME_SIZE];
                 const char* plural = NULL;
 
                 if (currFile->plural[0] != 0) {
                     plural = currFile->plural;
                 }
                 else if (currFile->singular[0] != 0) {
-                    plural = ut_form_plural(currFile->singular);
+                    const double    start = wallTime();
+
+                    plural = formPlural(currFile->singular, buf,
+                                        sizeof(buf));
+                    phaseAdd(&readStats.derive, start);
 
                     if (plural == NULL) {
                         ut_set_status(UT_PARSE);
                         ut_handle_error_message("Couldn't form plural of "
                             "\"%s\"", currFile->singular);
-                        XML_StopParser(currFile->parser, 0);
+                        stopParsing();
                     }
                 }
 
                 if (plural != NULL) {
                     if (!mapNamesToUnit(plural, currFile->textEncoding,
                             currFile->unit))
-                        XML_StopParser(currFile->parser, 0);
+                        stopParsing();
                 }
             }                           /* <noplural> not specified */
         }                               /* singular name specified */
@@ -1509,12 +1762,12 @@ startSingular(
     if (currFile->context != UNIT_NAME && currFile->context != ALIAS_NAME) {
         ut_set_status(UT_PARSE);
 	ut_handle_error_message("Wrong place for <singular> element");
-	XML_StopParser(currFile->parser, 0);
+	stopParsing();
     }
     else if (currFile->singular[0] != 0) {
         ut_set_status(UT_PARSE);
 	ut_handle_error_message("<singular> element already seen");
-	XML_StopParser(currFile->parser, 0);
+	stopParsing();
     }
     else {
 	clearText();
@@ -1533,7 +1786,7 @@ endSingular(
     if (nbytes >= NAME_SIZE) {
         ut_set_status(UT_PARSE);
         ut_handle_error_message("Name \"%s\" is too long", text);
-        XML_StopParser(currFile->parser, 0);
+        stopParsing();
     }
     else {
         (void)strncpy(currFile->singular, text, NAME_SIZE);
@@ -1552,12 +1805,12 @@ startPlural(
     if (currFile->context != UNIT_NAME && currFile->context != ALIAS_NAME ) {
         ut_set_status(UT_PARSE);
 	ut_handle_error_message("Wrong place for <plural> element");
-	XML_StopParser(currFile->parser, 0);
+	stopParsing();
     }
     else if (currFile->noPLural || currFile->plural[0] != 0) {
         ut_set_status(UT_PARSE);
 	ut_handle_error_message("<plural> or <noplural> element already seen");
-	XML_StopParser(currFile->parser, 0);
+	stopParsing();
     }
     else {
 	clearText();
@@ -1576,12 +1829,12 @@ endPlural(
     if (nbytes == 0) {
         ut_set_status(UT_PARSE);
         ut_handle_error_message("Empty <plural> element");
-        XML_StopParser(currFile->parser, 0);
+        stopParsing();
     }
     else if (nbytes >= NAME_SIZE) {
         ut_set_status(UT_PARSE);
         ut_handle_error_message("Plural name \"%s\" is too long", text);
-        XML_StopParser(currFile->parser, 0);
+        stopParsing();
     }
     else {
         (void)strncpy(currFile->plural, text, NAME_SIZE);
@@ -1600,12 +1853,12 @@ startNoPlural(
     if (currFile->context != UNIT_NAME && currFile->context != ALIAS_NAME) {
         ut_set_status(UT_PARSE);
 	ut_handle_error_message("Wrong place for <noplural> element");
-	XML_StopParser(currFile->parser, 0);
+	stopParsing();
     }
     else if (currFile->plural[0] != 0) {
         ut_set_status(UT_PARSE);
 	ut_handle_error_message("<plural> element already seen");
-	XML_StopParser(currFile->parser, 0);
+	stopParsing();
     }
 }
 
@@ -1633,7 +1886,7 @@ startSymbol(
         if (!currFile->haveValue) {
             ut_set_status(UT_PARSE);
             ut_handle_error_message("No previous <value> element");
-            XML_StopParser(currFile->parser, 0);
+            stopParsing();
         }
         else {
             clearText();
@@ -1641,11 +1894,11 @@ startSymbol(
         }
     }
     else if (currFile->context == UNIT || currFile->context == ALIASES) {
-        if (currFile->unit == NULL) {
+        if (!HAVE_UNIT) {
             ut_set_status(UT_PARSE);
             ut_handle_error_message(
                 "No previous <base>, <dimensionless>, or <def> element");
-            XML_StopParser(currFile->parser, 0);
+            stopParsing();
         }
         else {
             clearText();
@@ -1655,7 +1908,7 @@ startSymbol(
     else {
         ut_set_status(UT_PARSE);
         ut_handle_error_message("Wrong place for <symbol> element");
-        XML_StopParser(currFile->parser, 0);
+        stopParsing();
     }
 }
 
@@ -1674,7 +1927,7 @@ endSymbol(
             ut_handle_error_message(
                 "Couldn't map symbol-prefix \"%s\" to value %g",
                 text, currFile->value);
-            XML_StopParser(currFile->parser, 0);
+            stopParsing();
         }
         else {
             currFile->prefixAdded = 1;
@@ -1682,13 +1935,13 @@ endSymbol(
     }
     else if (currFile->context == UNIT) {
         if (!mapUnitAndSymbol(currFile->unit, text, currFile->textEncoding))
-            XML_StopParser(currFile->parser, 0);
+            stopParsing();
 
         currFile->symbolSeen = 1;
     }
     else if (currFile->context == ALIASES) {
         if (!mapSymbolsToUnit(text, currFile->textEncoding, currFile->unit))
-            XML_StopParser(currFile->parser, 0);
+            stopParsing();
     }
 }
 
@@ -1704,12 +1957,12 @@ startValue(
     if (currFile->context != PREFIX) {
         ut_set_status(UT_PARSE);
 	ut_handle_error_message("Wrong place for <value> element");
-	XML_StopParser(currFile->parser, 0);
+	stopParsing();
     }
     else if (currFile->haveValue) {
         ut_set_status(UT_PARSE);
 	ut_handle_error_message("<value> element already seen");
-	XML_StopParser(currFile->parser, 0);
+	stopParsing();
     }
     else {
 	clearText();
@@ -1735,12 +1988,12 @@ endValue(
 	ut_handle_error_message(strerror(errno));
 	ut_handle_error_message("Couldn't decode numeric prefix value \"%s\"",
             text);
-	XML_StopParser(currFile->parser, 0);
+	stopParsing();
     }
     else if (*endPtr != 0) {
         ut_set_status(UT_PARSE);
 	ut_handle_error_message("Invalid numeric prefix value \"%s\"", text);
-	XML_StopParser(currFile->parser, 0);
+	stopParsing();
     }
     else {
 	currFile->haveValue = 1;
@@ -1759,7 +2012,7 @@ startAliases(
     if (currFile->context != UNIT) {
         ut_set_status(UT_PARSE);
 	ut_handle_error_message("Wrong place for <aliases> element");
-	XML_StopParser(currFile->parser, 0);
+	stopParsing();
     }
 
     currFile->context = ALIASES;
@@ -1788,7 +2041,7 @@ startImport(
     if (currFile->context != UNIT_SYSTEM) {
         ut_set_status(UT_PARSE);
 	ut_handle_error_message("Wrong place for <import> element");
-	XML_StopParser(currFile->parser, 0);
+	stopParsing();
     }
     else {
 	clearText();
@@ -1797,6 +2050,49 @@ startImport(
 }
 
 
+/*
+ * Returns the pathname of an imported XML file.
+ *
+ * Arguments:
+ *      base            Directory of the importing file.
+ *      name            Content of the <import> element.
+ *      buf             Buffer for the pathname if "name" is relative.
+ *      size            Size of "buf" in bytes.
+ * Returns:
+ *      NULL    The pathname doesn't fit in "buf".  "errno" will be
+ *              ENAMETOOLONG.
+ *      else    Pointer to the pathname: either "name" or "buf".
+ */
+static const char*
+importPath(
+    const char* const   base,
+    const char* const   name,
+    char* const         buf,
+    const size_t        size)
+{
+    int nchar;
+
+    if (name[0] == '/')
+        return name;
+
+    nchar = snprintf(buf, size,
+#ifdef _MSC_VER
+        // The directory pathname has a trailing backslash on Windows
+        "%s%s",
+#else
+        "%s/%s",
+#endif
+        base, name);
+
+    if (nchar < 0 || (size_t)nchar >= size) {
+        errno = ENAMETOOLONG;
+        return NULL;
+    }
+
+    return buf;
+}
+
+
 /*
  * Handles the end of an <import> element.
  */
@@ -1804,30 +2100,22 @@ static void
 endImport(
     void*		data)
 {
-    char        buf[PATH_MAX];
-    const char* path;
+    char                buf[PATH_MAX];
+    const char* const   path = importPath(currFile->base, text, buf,
+        sizeof(buf));
 
-    if (text[0] == '/') {
-        path = text;
+    if (path == NULL) {
+        ut_set_status(UT_OS);
+        ut_handle_error_message(strerror(errno));
+        ut_handle_error_message("Pathname of imported file \"%s\" is too long",
+            text);
     }
     else {
-        (void)snprintf(buf, sizeof(buf),
-#ifdef _MSC_VER
-            // The directory pathname has a trailing backslash on Windows
-            "%s%s",
-#else
-            "%s/%s",
-#endif
-            XML_GetBase(currFile->parser), text);
-
-        buf[sizeof(buf)-1] = 0;
-        path = buf;
+        ut_set_status(readXml(path));
     }
 
-    ut_set_status(readXml(path));
-
     if (ut_get_status() != UT_SUCCESS)
-        XML_StopParser(currFile->parser, 0);
+        stopParsing();
 }
 
 
@@ -1946,7 +2234,7 @@ endElement(
 	else {
             ut_set_status(UT_PARSE);
 	    ut_handle_error_message("Unknown element \"<%s>\"", name);
-	    XML_StopParser(currFile->parser, 0);
+	    stopParsing();
 	}
     }
 
@@ -1964,7 +2252,10 @@ declareXml(
     const char*	encoding,
     int		standalone)
 {
-    if (strcasecmp(encoding, "US-ASCII") == 0) {
+    if (encoding == NULL) {
+	currFile->xmlEncoding = UT_UTF8;	/* the XML default */
+    }
+    else if (strcasecmp(encoding, "US-ASCII") == 0) {
 	currFile->xmlEncoding = UT_ASCII;
     }
     else if (strcasecmp(encoding, "ISO-8859-1") == 0) {
@@ -1976,17 +2267,536 @@ declareXml(
     else {
         ut_set_status(UT_PARSE);
 	ut_handle_error_message("Unknown XML encoding \"%s\"", encoding);
-	XML_StopParser(currFile->parser, 0);
+	stopParsing();
+    }
+}
+
+
+/******************************************************************************
+ * Recording and replaying XML files:
+ ******************************************************************************/
+
+
+/*
+ * Initializes a recording to the empty state.
+ */
+static void
+recordingInit(
+    Recording* const    recording)
+{
+    (void)memset(recording, 0, sizeof(*recording));
+    recording->status = UT_SUCCESS;
+}
+
+
+/*
+ * Frees the resources of a recording.
+ */
+static void
+recordingFree(
+    Recording* const    recording)
+{
+    free(recording->events);
+    free(recording->strings);
+    recordingInit(recording);
+}
+
+
+/*
+ * Appends a string to the strings of a recording.
+ *
+ * Returns:
+ *      0       Success.  "*offset" is set.
+ *      -1      Failure.  See "errno".
+ */
+static int
+appendString(
+    Recording* const    recording,
+    const char* const   string,
+    const int           length,
+    size_t* const       offset)
+{
+    const size_t        size = recording->size + length + 1;
+
+    if (size > recording->stringCapacity) {
+        size_t  capacity = recording->stringCapacity == 0
+            ? BUFSIZ
+            : recording->stringCapacity;
+        char*   strings;
+
+        while (capacity < size)
+            capacity *= 2;
+
+        strings = realloc(recording->strings, capacity);
+
+        if (strings == NULL)
+            return -1;
+
+        recording->strings = strings;
+        recording->stringCapacity = capacity;
+    }
+
+    (void)memcpy(recording->strings + recording->size, string, length);
+    recording->strings[recording->size + length] = 0;
+    *offset = recording->size;
+    recording->size = size;
+
+    return 0;
+}
+
+
+/*
+ * Appends an event to a recording.  Consecutive character data is combined
+ * into one event.
+ *
+ * Arguments:
+ *      parser          Pointer to the expat parser.  Its user-data is the
+ *                      recording.
+ *      type            Type of the event.
+ *      string          The string of the event or NULL.
+ *      length          Number of bytes in "string".
+ */
+static void
+appendEvent(
+    XML_Parser          parser,
+    const EventType     type,
+    const char* const   string,
+    const int           length)
+{
+    Recording* const    recording = XML_GetUserData(parser);
+    size_t              offset = 0;
+    int                 failure;
+
+    if (type == EVENT_TEXT && recording->count > 0 &&
+            recording->events[recording->count-1].type == EVENT_TEXT) {
+        /*
+         * The previous text is the last string, so overwriting its NUL
+         * extends it.
+         */
+        recording->size--;
+        failure = appendString(recording, string, length, &offset);
+
+        if (!failure)
+            recording->events[recording->count-1].length += length;
+    }
+    else {
+        failure = string != NULL &&
+            appendString(recording, string, length, &offset);
+
+        if (!failure && recording->count == recording->capacity) {
+            size_t      capacity = recording->capacity == 0
+                ? 1024
+                : 2*recording->capacity;
+            Event*      events = realloc(recording->events,
+                capacity*sizeof(Event));
+
+            if (events == NULL) {
+                failure = 1;
+            }
+            else {
+                recording->events = events;
+                recording->capacity = capacity;
+            }
+        }
+
+        if (!failure) {
+            Event* const        event = recording->events + recording->count++;
+
+            event->type = type;
+            event->line = (int)XML_GetCurrentLineNumber(parser);
+            event->column = (int)XML_GetCurrentColumnNumber(parser);
+            event->length = string == NULL ? -1 : length;
+            event->offset = offset;
+        }
+    }
+
+    if (failure) {
+        recording->status = UT_OS;
+        recording->errnum = errno;
+        XML_StopParser(parser, 0);
+    }
+}
+
+
+static void
+recordDecl(
+    void*               data,
+    const XML_Char*     version,
+    const XML_Char*     encoding,
+    int                 standalone)
+{
+    appendEvent(data, EVENT_DECL, encoding,
+        encoding == NULL ? 0 : (int)strlen(encoding));
+}
+
+
+static void
+recordStart(
+    void*               data,
+    const XML_Char*     name,
+    const XML_Char**    atts)
+{
+    appendEvent(data, EVENT_START, name, (int)strlen(name));
+}
+
+
+static void
+recordEnd(
+    void*               data,
+    const XML_Char*     name)
+{
+    appendEvent(data, EVENT_END, name, (int)strlen(name));
+}
+
+
+static void
+recordText(
+    void*               data,
+    const XML_Char*     string,
+    int                 length)
+{
+    appendEvent(data, EVENT_TEXT, string, length);
+}
+
+
+/*
+ * Saves the result of an expat parse call in a recording.
+ */
+static void
+recordStatus(
+    XML_Parser              parser,
+    const enum XML_Status   status,
+    Recording* const        recording)
+{
+    if (status != XML_STATUS_OK && recording->status == UT_SUCCESS) {
+        recording->status = UT_PARSE;
+        recording->xmlError = XML_GetErrorCode(parser);
+    }
+}
+
+
+/*
+ * Parses a regular file with a single call to expat.  The file is mapped into
+ * memory if possible; otherwise, it's read into expat's own buffer so that it's
+ * not copied.
+ *
+ * Arguments:
+ *      parser          Pointer to the expat parser.
+ *      fd              File descriptor of the file.
+ *      size            Size of the file in bytes.  Shall be positive and no
+ *                      greater than INT_MAX.
+ *      recording       Pointer to the recording.
+ */
+static void
+parseWhole(
+    XML_Parser          parser,
+    const int           fd,
+    const size_t        size,
+    Recording* const    recording)
+{
+    char*       buf;
+    double      start = wallTime();
+
+#ifndef _WIN32
+    buf = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    if (buf != MAP_FAILED) {
+        recording->readTime += wallTime() - start;
+        recording->nread += size;
+        start = wallTime();
+        recordStatus(parser, XML_Parse(parser, buf, (int)size, 1), recording);
+        recording->xmlTime += wallTime() - start;
+        (void)munmap(buf, size);
+        return;
+    }
+#endif
+
+    buf = XML_GetBuffer(parser, (int)size);
+
+    if (buf == NULL) {
+        recording->status = UT_OS;
+        recording->errnum = ENOMEM;
+    }
+    else {
+        size_t  nread = 0;
+
+        while (nread < size) {
+            const int   n = read(fd, buf + nread, size - nread);
+
+            if (n <= 0) {
+                if (n < 0) {
+                    recording->status = UT_OS;
+                    recording->errnum = errno;
+                }
+                break;
+            }
+
+            nread += n;
+        }
+
+        recording->readTime += wallTime() - start;
+        recording->nread += nread;
+
+        if (recording->status == UT_SUCCESS) {
+            start = wallTime();
+            recordStatus(parser, XML_ParseBuffer(parser, (int)nread, 1),
+                recording);
+            recording->xmlTime += wallTime() - start;
+        }
     }
 }
 
 
 /*
- * Reads an XML file into the unit-system with the given XML parser.
+ * Parses a file of unknown size by reading it directly into expat's buffer.
+ *
+ * Arguments:
+ *      parser          Pointer to the expat parser.
+ *      fd              File descriptor of the file.
+ *      recording       Pointer to the recording.
+ */
+static void
+parseStream(
+    XML_Parser          parser,
+    const int           fd,
+    Recording* const    recording)
+{
+    int nbytes;
+
+    do {
+        void* const     buf = XML_GetBuffer(parser, BUFSIZ);
+
+        if (buf == NULL) {
+            recording->status = UT_OS;
+            recording->errnum = ENOMEM;
+            break;
+        }
+
+        double          start = wallTime();
+
+        nbytes = read(fd, buf, BUFSIZ);
+        recording->readTime += wallTime() - start;
+
+        if (nbytes < 0) {
+            recording->status = UT_OS;
+            recording->errnum = errno;
+        }
+        else {
+            recording->nread += nbytes;
+            start = wallTime();
+            recordStatus(parser, XML_ParseBuffer(parser, nbytes, nbytes == 0),
+                recording);
+            recording->xmlTime += wallTime() - start;
+        }
+    } while (recording->status == UT_SUCCESS && nbytes > 0);
+}
+
+
+/*
+ * Records the XML events of a file.  Only the file, expat, and the recording
+ * are accessed, so this function may be called concurrently for different
+ * recordings.  Failures are saved in the recording rather than reported.
  *
  * Arguments:
- *      parser          Pointer to the XML parser.
  *      path            Pointer to the pathname of the XML file.
+ *      recording       Pointer to the empty recording.
+ */
+static void
+recordXml(
+    const char* const   path,
+    Recording* const    recording)
+{
+    XML_Parser  parser = XML_ParserCreate(NULL);
+
+    if (parser == NULL) {
+        recording->status = UT_OS;
+        recording->errnum = errno;
+    }
+    else {
+        const double    start = wallTime();
+        int             fd = open(path, O_RDONLY);
+
+        recording->readTime += wallTime() - start;
+
+        if (fd == -1) {
+            recording->status = UT_OPEN_ARG;
+            recording->errnum = errno;
+        }
+        else {
+            struct stat info;
+
+            XML_SetUserData(parser, recording);
+            XML_UseParserAsHandlerArg(parser);
+            XML_SetXmlDeclHandler(parser, recordDecl);
+            XML_SetElementHandler(parser, recordStart, recordEnd);
+            XML_SetCharacterDataHandler(parser, recordText);
+
+            if (fstat(fd, &info) == 0 &&
+                    (info.st_mode & S_IFMT) == S_IFREG &&
+                    info.st_size > 0 && info.st_size <= INT_MAX) {
+                parseWhole(parser, fd, (size_t)info.st_size, recording);
+            }
+            else {
+                parseStream(parser, fd, recording);
+            }
+
+            recording->line = (int)XML_GetCurrentLineNumber(parser);
+            recording->column = (int)XML_GetCurrentColumnNumber(parser);
+
+            (void)close(fd);
+        }
+
+        XML_ParserFree(parser);
+    }
+}
+
+
+#ifndef _WIN32
+static void*
+recordPrefetch(
+    void* const arg)
+{
+    Prefetch* const     prefetch = arg;
+
+    recordXml(prefetch->path, &prefetch->recording);
+
+    return NULL;
+}
+#endif
+
+
+/*
+ * Starts recording, concurrently, the files imported by a recorded XML file.
+ * Their definitions depend on each other only through the identifiers that
+ * they use, so only their replay must be in document order (see replayXml());
+ * reading and tokenizing them can overlap.  On platforms without POSIX threads
+ * nothing is started and imported files are recorded when they're replayed.
+ *
+ * Arguments:
+ *      recording       Pointer to the recording of the importing file.
+ *      base            Directory of the importing file.
+ * Returns:
+ *      Pointer to the list of started recordings.  May be NULL.  The caller
+ *      should pass it to prefetchFree().
+ */
+static Prefetch*
+prefetchImports(
+    const Recording* const      recording,
+    const char* const           base)
+{
+    Prefetch*   list = NULL;
+#ifndef _WIN32
+    Prefetch**  tail = &list;
+    size_t      i;
+
+    for (i = 0; i + 2 < recording->count; i++) {
+        const Event* const      event = recording->events + i;
+
+        if (event[0].type == EVENT_START && event[1].type == EVENT_TEXT &&
+                event[2].type == EVENT_END &&
+                strcasecmp(recording->strings + event[0].offset, "import")
+                    == 0) {
+            char                buf[PATH_MAX];
+            const char* const   path = importPath(base,
+                recording->strings + event[1].offset, buf, sizeof(buf));
+            Prefetch* const     prefetch = path == NULL
+                ? NULL  /* endImport() will report the error */
+                : malloc(sizeof(Prefetch));
+
+            if (prefetch != NULL) {
+                prefetch->path = strdup(path);
+                prefetch->next = NULL;
+                recordingInit(&prefetch->recording);
+                prefetch->started = prefetch->path != NULL &&
+                    pthread_create(&prefetch->thread, NULL, recordPrefetch,
+                        prefetch) == 0;
+
+                if (!prefetch->started) {
+                    free(prefetch->path);
+                    free(prefetch);
+                }
+                else {
+                    *tail = prefetch;
+                    tail = &prefetch->next;
+                }
+            }
+        }
+    }
+#endif
+
+    return list;
+}
+
+
+/*
+ * Returns the recording of a file from a list of started recordings, waiting
+ * for the recording to complete if necessary.  Each recording is returned at
+ * most once.
+ *
+ * Arguments:
+ *      list            Pointer to the list or NULL.
+ *      path            Pathname of the file.
+ * Returns:
+ *      NULL            The file's recording wasn't started.
+ *      else            Pointer to the completed recording.  It belongs to
+ *                      "list".
+ */
+static Recording*
+prefetchTake(
+    Prefetch*           list,
+    const char* const   path)
+{
+    for (; list != NULL; list = list->next) {
+        if (list->started && strcmp(list->path, path) == 0) {
+#ifndef _WIN32
+            (void)pthread_join(list->thread, NULL);
+#endif
+            list->started = 0;
+
+            return &list->recording;
+        }
+    }
+
+    return NULL;
+}
+
+
+/*
+ * Frees a list of started recordings, waiting for any that are incomplete.
+ *
+ * Arguments:
+ *      list            Pointer to the list or NULL.
+ */
+static void
+prefetchFree(
+    Prefetch*   list)
+{
+    while (list != NULL) {
+        Prefetch* const next = list->next;
+
+#ifndef _WIN32
+        if (list->started)
+            (void)pthread_join(list->thread, NULL);
+#endif
+        recordingFree(&list->recording);
+        free(list->path);
+        free(list);
+        list = next;
+    }
+}
+
+
+/*
+ * Replays a recorded XML file into the unit-system.  The recorded events are
+ * passed to the element handlers in document order, so the definitions are
+ * resolved as if the file were being parsed.
+ *
+ * Arguments:
+ *      path            Pointer to the pathname of the XML file.
+ *      base            Pointer to the directory of the XML file.
+ *      recording       Pointer to the recording of the XML file.
+ *      prefetch        Pointer to the started recordings of imported files or
+ *                      NULL.
  * Returns:
  *      UT_SUCCESS      Success.
  *      UT_OPEN_ARG     File "path" couldn't be opened.  See "errno".
@@ -1994,76 +2804,90 @@ declareXml(
  *      UT_PARSE        Parse failure.
  */
 static ut_status
-readXmlWithParser(
-    XML_Parser          parser,
-    const char* const   path)
+replayXml(
+    const char* const           path,
+    const char* const           base,
+    const Recording* const      recording,
+    Prefetch* const             prefetch)
 {
-    ut_status   status = UT_SUCCESS;    /* success */
-    File        file;
-
-    assert(parser != NULL);
-    assert(path != NULL);
-
-    fileInit(&file);
-
-    file.fd = open(path, O_RDONLY);
+    ut_status   status = recording->status;
 
-    if (file.fd == -1) {
-        status = UT_OPEN_ARG;
+    if (status == UT_OPEN_ARG) {
         ut_set_status(status);
-        ut_handle_error_message(strerror(errno));
+        ut_handle_error_message(strerror(recording->errnum));
         ut_handle_error_message("Couldn't open file \"%s\"", path);
     }
     else {
-        int	        nbytes;
+        const XML_Char* noAtts[1] = {NULL};
+        File            file;
         File* const     prevFile = currFile;
+        size_t          i;
 
+        fileInit(&file);
         file.path = path;
-        file.parser = parser;
+        file.base = base;
+        file.prefetch = prefetch;
         currFile = &file;
 
-        do {
-            char	buf[BUFSIZ];	/* from <stdio.h> */
-
-            nbytes = read(file.fd, buf, sizeof(buf));
-
-            if (nbytes < 0) {
-                status = UT_OS;
-                ut_set_status(status);
-                ut_handle_error_message(strerror(errno));
-            }
-            else {
-                if (XML_Parse(file.parser, buf, nbytes, nbytes == 0)
-                        != XML_STATUS_OK) {
-                    status = UT_PARSE;
-                    ut_set_status(status);
-                    ut_handle_error_message(
-                        XML_ErrorString(XML_GetErrorCode(file.parser)));
-                }
+        readStats.read.seconds += recording->readTime;
+        readStats.read.count += recording->nread;
+        readStats.xml.seconds += recording->xmlTime;
+        readStats.xml.count += recording->count;
+
+        for (i = 0; i < recording->count && !file.stopped; i++) {
+            const Event* const  event = recording->events + i;
+            const char* const   string = recording->strings + event->offset;
+
+            file.line = event->line;
+            file.column = event->column;
+
+            switch (event->type) {
+            case EVENT_DECL:
+                declareXml(NULL, NULL, event->length < 0 ? NULL : string, -1);
+                break;
+            case EVENT_START:
+                startElement(NULL, string, noAtts);
+                break;
+            case EVENT_END:
+                endElement(NULL, string);
+                break;
+            case EVENT_TEXT:
+                if (file.accumulate)
+                    accumulateText(NULL, string, event->length);
+                break;
             }
-        } while (status == UT_SUCCESS && nbytes > 0);
+        }
 
-        if (status != UT_SUCCESS) {
+        if (file.stopped) {
+            status = UT_PARSE;
+            ut_set_status(status);
+            ut_handle_error_message(XML_ErrorString(XML_ERROR_ABORTED));
+            ut_handle_error_message("File \"%s\", line %d, column %d",
+                path, file.line, file.column);
+        }
+        else if (status != UT_SUCCESS) {
             /*
              * Parsing of the XML file terminated prematurely.
              */
+            ut_set_status(status);
+            ut_handle_error_message(status == UT_PARSE
+                ? XML_ErrorString(recording->xmlError)
+                : strerror(recording->errnum));
             ut_handle_error_message("File \"%s\", line %d, column %d",
-                path, XML_GetCurrentLineNumber(file.parser),
-                XML_GetCurrentColumnNumber(file.parser));
+                path, recording->line, recording->column);
         }
 
+        ut_free(file.unit);
         currFile = prevFile;
-
-        (void)close(file.fd);
-        file.fd = -1;
-    }                                   /* "file.fd" open */
+    }
 
     return status;
 }
 
 
 /*
- * Reads an XML file into the unit-system.
+ * Reads an XML file into the unit-system.  If the file is the unit database
+ * itself, then the files that it imports are recorded concurrently.
  *
  * Arguments:
  *      path            Pointer to the pathname of the XML file.
@@ -2077,51 +2901,46 @@ static ut_status
 readXml(
     const char* const   path)
 {
-    ut_status       status;
-    XML_Parser      parser = XML_ParserCreate(NULL);
+    ut_status   status;
+    Prefetch*   prefetch = currFile == NULL ? NULL : currFile->prefetch;
+    Prefetch*   started = NULL;
+    Recording*  recording = prefetchTake(prefetch, path);
+    Recording   local;
+    char        base[PATH_MAX];
 
-    if (parser == NULL) {
-        status = UT_OS;
-        ut_set_status(status);
-        ut_handle_error_message(strerror(errno));
-        ut_handle_error_message("Couldn't create XML parser");
-    }
-    else {
-        char base[PATH_MAX];
 #ifdef _MSC_VER
-        {
-            char drive[_MAX_DRIVE+1]; // Will have trailing colon
-            char directory[_MAX_DIR+1]; // Will have trailing backslash
-            _splitpath(path, drive, directory, NULL, NULL);
-            (void)snprintf(base, sizeof(base), "%s%s", drive, directory);
-            base[sizeof(base)-1] = 0;
-        }
+    {
+        char drive[_MAX_DRIVE+1]; // Will have trailing colon
+        char directory[_MAX_DIR+1]; // Will have trailing backslash
+        _splitpath(path, drive, directory, NULL, NULL);
+        (void)snprintf(base, sizeof(base), "%s%s", drive, directory);
+        base[sizeof(base)-1] = 0;
+    }
 #else
-        {
-            // Temporary buffer used because `dirname()` modifies its argument
-            char tmp[strlen(path)+1];
-            (void)strcpy(tmp, path);
-            (void)strncpy(base, dirname(tmp), sizeof(base));
-            base[sizeof(base)-1] = 0;
-        }
+    {
+        // Temporary buffer used because `dirname()` modifies its argument
+        char tmp[strlen(path)+1];
+        (void)strcpy(tmp, path);
+        (void)strncpy(base, dirname(tmp), sizeof(base));
+        base[sizeof(base)-1] = 0;
+    }
 #endif
 
-        if (XML_SetBase(parser, base) != XML_STATUS_OK) {
-            status = UT_OS;
-            ut_set_status(status);
-            ut_handle_error_message(strerror(errno));
-            ut_handle_error_message("XML_SetBase(\"%s\") failure", base);
-        }
-        else {
-            XML_SetXmlDeclHandler(parser, declareXml);
-            XML_SetElementHandler(parser, startElement, endElement);
-            XML_SetCharacterDataHandler(parser, NULL);
+    if (recording == NULL) {
+        recordingInit(&local);
+        recordXml(path, &local);
+        recording = &local;
+
+        if (currFile == NULL)
+            prefetch = started = prefetchImports(recording, base);
+    }
 
-            status = readXmlWithParser(parser, path);
-        }                           /* parser "base" set */
+    status = replayXml(path, base, recording, prefetch);
 
-        XML_ParserFree(parser);
-    }                               /* parser != NULL */
+    prefetchFree(started);
+
+    if (recording == &local)
+        recordingFree(&local);
 
     return status;
 }
@@ -2131,8 +2950,9 @@ readXml(
 static const char*
 default_udunits2_xml_path()
 {
-    // Returned absolute pathname of XML database
-    static char absXmlPathname[PATH_MAX];
+    // Returned absolute pathname of XML database.  Thread-local so that
+    // concurrent first calls don't race.
+    static UT_THREAD_LOCAL char absXmlPathname[PATH_MAX];
 
     if (absXmlPathname[0] == 0) {
         const char* prefix = NULL; // Installation directory
@@ -2225,6 +3045,150 @@ ut_get_path_xml(
 }
 
 
+/*
+ * Returns the unit-system corresponding to an XML file.
+ *
+ * Arguments:
+ *      path            The pathname of the XML file or NULL.  See
+ *                      ut_read_xml().
+ *      defer           Whether or not to defer the parsing of unit
+ *                      definitions.  See ut_read_xml_lazy().
+ * Returns:
+ *      NULL            Failure.  See ut_read_xml().
+ *      else            Pointer to the unit-system defined by "path".
+ */
+static ut_system*
+loadSystem(
+    const char* const   path,
+    const int           defer)
+{
+    ut_set_status(UT_SUCCESS);
+
+#ifdef UT_EMBEDDED_DATABASE
+    /*
+     * The compiled-in default database needs neither file I/O nor parsing.
+     */
+    if (path == NULL && getenv("UDUNITS2_XML_PATH") == NULL) {
+        const char*     problem;
+        ut_system*      system = binReadImage(utEmbeddedDatabase,
+                utEmbeddedDatabaseSize, &problem);
+
+        if (system == NULL)
+            ut_handle_error_message("ut_read_xml(): Embedded database: %s",
+                    problem);
+
+        return system;
+    }
+#endif
+
+    unitSystem = ut_new_system();
+
+    if (unitSystem == NULL) {
+        ut_handle_error_message("Couldn't create new unit-system");
+    }
+    else {
+        ut_status       status;
+        ut_status       openError;
+
+        deferDefinitions = defer;
+        status = readXml(ut_get_path_xml(path, &openError));
+        deferDefinitions = 0;
+
+        free(text);
+        text = NULL;
+        nbytes = textCapacity = 0;
+
+        if (status == UT_OPEN_ARG) {
+            status = openError;
+        }
+        if (status != UT_SUCCESS) {
+            ut_free_system(unitSystem);
+            unitSystem = NULL;
+        }
+
+        ut_set_status(status);
+    }				        /* unitSystem != NULL */
+
+    return unitSystem;
+}
+
+
+/*
+ * Prints the statistics of the current read to the standard error stream.
+ *
+ * Arguments:
+ *      path            The pathname of the XML file or NULL.  See
+ *                      ut_read_xml().
+ */
+static void
+reportStats(
+    const char* const   path)
+{
+    static const struct {
+        const char*     name;
+        size_t          offset;
+        const char*     unit;
+    } phases[] = {
+        {"read", offsetof(ut_read_stats, read), "bytes"},
+        {"xml", offsetof(ut_read_stats, xml), "events"},
+        {"define", offsetof(ut_read_stats, define), "definitions"},
+        {"derive", offsetof(ut_read_stats, derive), "identifiers"},
+        {"map", offsetof(ut_read_stats, map), "mappings"},
+    };
+    ut_status   openStatus;
+    size_t      i;
+
+    (void)fprintf(stderr, "udunits2: Read \"%s\" in %.3f ms\n",
+        ut_get_path_xml(path, &openStatus), readStats.total * 1e3);
+
+    for (i = 0; i < sizeof(phases)/sizeof(phases[0]); i++) {
+        const ut_phase_stats* const     phase = (const ut_phase_stats*)
+            ((const char*)&readStats + phases[i].offset);
+
+        (void)fprintf(stderr, "    %-8s %10.3f ms %10lu %s\n", phases[i].name,
+            phase->seconds * 1e3, phase->count, phases[i].unit);
+    }
+}
+
+
+/*
+ * Returns the unit-system corresponding to an XML file and records where the
+ * time went (see ut_get_read_stats()).
+ *
+ * Arguments:
+ *      path            The pathname of the XML file or NULL.  See
+ *                      ut_read_xml().
+ *      defer           Whether or not to defer the parsing of unit
+ *                      definitions.  See ut_read_xml_lazy().
+ * Returns:
+ *      NULL            Failure.  See ut_read_xml().
+ *      else            Pointer to the unit-system defined by "path".
+ */
+static ut_system*
+readSystem(
+    const char* const   path,
+    const int           defer)
+{
+    const double        start = wallTime();
+    const char* const   report = getenv("UDUNITS2_READ_STATS");
+    ut_system*          system;
+
+    (void)memset(&readStats, 0, sizeof(readStats));
+
+    system = loadSystem(path, defer);
+    readStats.total = wallTime() - start;
+
+    if (report != NULL && report[0] != 0) {
+        const ut_status status = ut_get_status();
+
+        reportStats(path);
+        ut_set_status(status);
+    }
+
+    return system;
+}
+
+
 /**
  * Returns the unit-system corresponding to an XML file.  This is the usual way
  * that a client will obtain a unit-system.
@@ -2232,7 +3196,9 @@ ut_get_path_xml(
  * @param path	The pathname of the XML file or NULL.  If NULL, then the
  *              pathname specified by the environment variable UDUNITS2_XML_PATH
  *              is used if set; otherwise, the compile-time pathname of the
- *              installed, default, unit database is used.
+ *              installed, default, unit database is used. If the library was
+ *              built with the default database compiled in, then that
+ *              database is used instead of the installed one.
  * @retval NULL Failure. "ut_get_status()" will be one of the following:
  *	                UT_OPEN_ARG     "path" is non-NULL but file couldn't be
  *	                                opened. See "errno" for reason.
@@ -2251,29 +3217,49 @@ ut_system*
 ut_read_xml(
     const char*	path)
 {
-    ut_set_status(UT_SUCCESS);
-
-    unitSystem = ut_new_system();
+    return readSystem(path, 0);
+}
 
-    if (unitSystem == NULL) {
-        ut_handle_error_message("Couldn't create new unit-system");
-    }
-    else {
-        ut_status       status;
-        ut_status       openError;
 
-        status = readXml(ut_get_path_xml(path, &openError));
+/**
+ * Returns the unit-system corresponding to an XML file like ut_read_xml() but
+ * defers the parsing of unit definitions until their units are first looked
+ * up.  Base units, dimensionless units, and prefixes are created immediately.
+ *
+ * @param path  As for ut_read_xml().
+ * @retval NULL Failure. "ut_get_status()" will be as for ut_read_xml().
+ * @return      Pointer to the unit-system defined by "path".
+ */
+ut_system*
+ut_read_xml_lazy(
+    const char*	path)
+{
+    return readSystem(path, 1);
+}
 
-        if (status == UT_OPEN_ARG) {
-            status = openError;
-        }
-        if (status != UT_SUCCESS) {
-            ut_free_system(unitSystem);
-            unitSystem = NULL;
-        }
 
-        ut_set_status(status);
-    }				        /* unitSystem != NULL */
+/*
+ * Returns where the time went during the calling thread's most recent read of
+ * an XML unit database.
+ *
+ * Arguments:
+ *      stats           Pointer to the statistics to be set.
+ * Returns:
+ *      UT_SUCCESS      Success.
+ *      UT_BAD_ARG      "stats" is NULL.
+ */
+ut_status
+ut_get_read_stats(
+    ut_read_stats* const        stats)
+{
+    if (stats == NULL) {
+        ut_set_status(UT_BAD_ARG);
+        ut_handle_error_message("ut_get_read_stats(): NULL argument");
+    }
+    else {
+        *stats = readStats;
+        ut_set_status(UT_SUCCESS);
+    }
 
-    return unitSystem;
+    return ut_get_status();
 }
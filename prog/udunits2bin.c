@@ -0,0 +1,162 @@
+/*
+ * Copyright 2020 University Corporation for Atmospheric Research. All rights
+ * reserved.
+ *
+ * This file is part of the UDUNITS-2 package.  See the file COPYRIGHT
+ * in the top-level source-directory of the package for copying and
+ * redistribution conditions.
+ */
+/*
+ * This program converts an XML unit database into a binary unit database that
+ * ut_read_binary() can read.
+ */
+
+#include "config.h"
+
+#ifdef _MSC_VER
+#include "XGetOpt.h"
+#endif
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _MSC_VER
+#include <libgen.h>
+#include <unistd.h>
+#endif
+#include <udunits2.h>
+
+static char             _progname[1024];
+static const char*	_xmlPath = NULL; /* use default path */
+static const char*	_binPath; /* output pathname */
+static int		_exitStatus = EXIT_FAILURE;
+
+static void
+usage(void)
+{
+    ut_status    status;
+    const char * default_xml = ut_get_path_xml(NULL, &status);
+
+    (void)fprintf(stderr,
+"Usage:\n"
+"    %s -h\n"
+"    %s [-x <XML_file>] <binary_file>\n"
+"\n"
+"where:\n"
+"    -h             Help.  Print this message.\n"
+"    -x <XML_file>  XML database file. Default is \"%s\".\n"
+"    <binary_file>  Binary database file to be written.\n",
+        _progname, _progname, default_xml);
+}
+
+/**
+ * Prints an error-message to the standard error stream.
+ *
+ * @param format        The format for the error-message. It shouldn't have a
+ *                      trailing newline.
+ * @param ...           Arguments referenced by the format.
+ */
+static void
+errMsg(
+    const char* const   format,
+    ...)
+{
+    (void)fprintf(stderr, "%s: ", _progname);
+    {
+        va_list     ap;
+
+        va_start(ap, format);
+        (void)vfprintf(stderr, format, ap);
+        va_end(ap);
+    }
+    (void)fputc('\n', stderr);
+}
+
+static int
+decodeCommandLine(
+    int         argc,
+    char**      argv)
+{
+    int		c;
+    int		success = 0;
+
+#ifndef _MSC_VER
+    char* filename = basename(argv[0]);
+
+    if (strlen(filename)+1 > sizeof(_progname))
+        filename = "udunits2bin";
+
+    (void)strcpy(_progname, filename);
+#else
+    (void)strcpy(_progname, "udunits2bin");
+#endif
+
+    while ((c = getopt(argc, argv, "hx:")) != -1) {
+	switch (c) {
+	    case 'x':
+		_xmlPath = optarg;
+		continue;
+	    case 'h':
+		_exitStatus = EXIT_SUCCESS;
+		/*FALLTHROUGH*/
+	    case '?':
+		usage();
+		break;
+	    default:
+		errMsg("Unknown option \"%c\"", c);
+		usage();
+	}
+
+	break;
+    }
+
+    if (c == -1) {
+        if (optind + 1 != argc) {
+            errMsg("One binary database file must be specified");
+            usage();
+        }
+        else {
+            _binPath = argv[optind];
+            success = 1;
+        }
+    }
+
+    return success;
+}
+
+int
+main(
+    const int		argc,
+    char**	argv)
+{
+    if (decodeCommandLine(argc, argv)) {
+        ut_system*  system;
+
+        /*
+         * Overridden prefixed-units are expected in the default database.
+         */
+        (void)ut_set_error_message_handler(ut_ignore);
+        system = ut_read_xml(_xmlPath);
+        (void)ut_set_error_message_handler(ut_write_to_stderr);
+
+        if (system == NULL) {
+            ut_status   status;
+
+            errMsg("Couldn't initialize unit-system from database \"%s\"",
+                ut_get_path_xml(_xmlPath, &status));
+        }
+        else {
+            if (ut_write_binary(system, _binPath) != UT_SUCCESS) {
+                errMsg("Couldn't write binary database \"%s\"", _binPath);
+            }
+            else {
+                _exitStatus = EXIT_SUCCESS;
+            }
+
+            ut_free_system(system);
+        }
+    }
+
+    return _exitStatus;
+}